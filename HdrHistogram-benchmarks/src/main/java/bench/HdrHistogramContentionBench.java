@@ -0,0 +1,220 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package bench;
+
+import org.HdrHistogram.*;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.locks.LockSupport;
+
+/*
+  Measures recording throughput and writer latency under contention, with concurrent recording threads
+  (writers) sharing a histogram or recorder, optionally alongside a reader thread that concurrently queries
+  the histogram or takes interval histograms (flipping the recorder's phase).
+
+  Writers record values from a realistic latency series (see HistogramData), each starting at a different
+  point in the series. Results are reported both as throughput and as sampled per-operation time, such that
+  the writer tail latency percentiles (e.g. p0.99, p0.9999) reflect the impact of concurrent interval flips.
+
+  The "warmup" group measures writer latency while a shared packed histogram (or recorder) is still growing its
+  storage: a resetter thread replaces the shared histogram with a freshly allocated one every flipIntervalUsec,
+  such that writers keep recording into histograms that are still populating new value ranges.
+
+  The number of writer (and reader) threads in each group are set with JMH's -tg option, given in the
+  order of the group's methods (readers first, then writers). E.g. for 8 writers and a single reader:
+    $ java -jar target/benchmarks.jar HdrHistogramContentionBench.recorder -tg 1,8
+
+  Run all benchmarks:
+    $ java -jar target/benchmarks.jar
+
+  Run selected benchmarks:
+    $ java -jar target/benchmarks.jar (regexp)
+
+  Run the profiling (Linux only):
+     $ java -Djmh.perfasm.events=cycles,cache-misses -jar target/benchmarks.jar -f 1 -prof perfasm
+ */
+@Warmup(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+@Measurement(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+@Fork(3)
+@BenchmarkMode({Mode.Throughput, Mode.SampleTime})
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+
+public class HdrHistogramContentionBench {
+    static final long highestTrackableValue = 3600L * 1000 * 1000; // e.g. for 1 hr in usec units
+    static final int numberOfSignificantValueDigits = 3;
+
+    @State(Scope.Group)
+    public static class SharedHistogram {
+        @Param({"ConcurrentHistogram", "AtomicHistogram", "SynchronizedHistogram", "PackedConcurrentHistogram"})
+        String histogramClassName;
+
+        AbstractHistogram histogram;
+
+        @Setup
+        public void setup() throws Exception {
+            Class<?> histogramClass = Class.forName("org.HdrHistogram." + histogramClassName);
+            histogram = (AbstractHistogram) histogramClass.getConstructor(long.class, int.class)
+                    .newInstance(highestTrackableValue, numberOfSignificantValueDigits);
+        }
+    }
+
+    @State(Scope.Group)
+    public static class SharedRecorder {
+        @Param({"Recorder", "PackedRecorder", "StripedRecorder", "WriteCombiningRecorder"})
+        String recorderKind;
+
+        @Param({"1000", "100000"})
+        long flipIntervalUsec;
+
+        Recorder recorder;
+
+        @Setup
+        public void setup() {
+            if (recorderKind.equals("Recorder")) {
+                recorder = new Recorder(numberOfSignificantValueDigits);
+            } else if (recorderKind.equals("PackedRecorder")) {
+                recorder = new Recorder(numberOfSignificantValueDigits, true);
+            } else if (recorderKind.equals("StripedRecorder")) {
+                recorder = new Recorder(1, highestTrackableValue, numberOfSignificantValueDigits,
+                        Runtime.getRuntime().availableProcessors());
+            } else if (recorderKind.equals("WriteCombiningRecorder")) {
+                recorder = new Recorder(numberOfSignificantValueDigits, false, 256);
+            } else {
+                throw new IllegalArgumentException("Unknown recorder kind: " + recorderKind);
+            }
+        }
+    }
+
+    @State(Scope.Group)
+    public static class WarmingHistogram {
+        @Param({"PackedConcurrentHistogram", "ConcurrentHistogram"})
+        String histogramClassName;
+
+        @Param({"1000", "100000"})
+        long flipIntervalUsec;
+
+        volatile AbstractHistogram histogram;
+
+        AbstractHistogram newHistogram() throws Exception {
+            Class<?> histogramClass = Class.forName("org.HdrHistogram." + histogramClassName);
+            return (AbstractHistogram) histogramClass.getConstructor(long.class, int.class)
+                    .newInstance(highestTrackableValue, numberOfSignificantValueDigits);
+        }
+
+        @Setup
+        public void setup() throws Exception {
+            histogram = newHistogram();
+        }
+    }
+
+    @State(Scope.Thread)
+    public static class ValueStream {
+        @Param({"case1", "sumOfjHiccupLines", "cubic"})
+        String latencySeriesName;
+
+        long[] values;
+        int i;
+
+        @Setup
+        public void setup(ThreadParams threadParams) {
+            int count = 0;
+            for (long value : HistogramData.data.get(latencySeriesName)) {
+                count++;
+            }
+            values = new long[count];
+            count = 0;
+            for (long value : HistogramData.data.get(latencySeriesName)) {
+                values[count++] = value;
+            }
+            // Spread writers across the series, so they do not all hit the same counts at the same time:
+            i = (int) (((long) threadParams.getThreadIndex() * values.length) / threadParams.getThreadCount());
+        }
+
+        long nextValue() {
+            if (i >= values.length) {
+                i = 0;
+            }
+            return values[i++];
+        }
+    }
+
+    @State(Scope.Thread)
+    public static class IntervalHistogramHolder {
+        Histogram intervalHistogram;
+    }
+
+    // Writers only:
+
+    @Benchmark
+    @Group("histogramWriters")
+    @GroupThreads(4)
+    public void histogramWritersRecord(SharedHistogram shared, ValueStream stream) {
+        shared.histogram.recordValue(stream.nextValue());
+    }
+
+    @Benchmark
+    @Group("recorderWriters")
+    @GroupThreads(4)
+    public void recorderWritersRecord(SharedRecorder shared, ValueStream stream) {
+        shared.recorder.recordValue(stream.nextValue());
+    }
+
+    // Writers alongside a reader querying the shared histogram:
+
+    @Benchmark
+    @Group("histogram")
+    @GroupThreads(1)
+    public double histogramRead(SharedHistogram shared) {
+        return shared.histogram.getValueAtPercentile(99.0);
+    }
+
+    @Benchmark
+    @Group("histogram")
+    @GroupThreads(4)
+    public void histogramRecord(SharedHistogram shared, ValueStream stream) {
+        shared.histogram.recordValue(stream.nextValue());
+    }
+
+    // Writers alongside a reader taking an interval histogram (flipping phase) every flipIntervalUsec:
+
+    @Benchmark
+    @Group("recorder")
+    @GroupThreads(1)
+    public Histogram recorderFlip(SharedRecorder shared, IntervalHistogramHolder holder) {
+        LockSupport.parkNanos(shared.flipIntervalUsec * 1000L);
+        holder.intervalHistogram = shared.recorder.getIntervalHistogram(holder.intervalHistogram);
+        return holder.intervalHistogram;
+    }
+
+    @Benchmark
+    @Group("recorder")
+    @GroupThreads(4)
+    public void recorderRecord(SharedRecorder shared, ValueStream stream) {
+        shared.recorder.recordValue(stream.nextValue());
+    }
+
+    // Writers recording into histograms that are still growing, alongside a thread replacing the shared histogram
+    // with a fresh one every flipIntervalUsec:
+
+    @Benchmark
+    @Group("warmup")
+    @GroupThreads(1)
+    public AbstractHistogram warmupReplace(WarmingHistogram shared) throws Exception {
+        LockSupport.parkNanos(shared.flipIntervalUsec * 1000L);
+        shared.histogram = shared.newHistogram();
+        return shared.histogram;
+    }
+
+    @Benchmark
+    @Group("warmup")
+    @GroupThreads(4)
+    public void warmupRecord(WarmingHistogram shared, ValueStream stream) {
+        shared.histogram.recordValue(stream.nextValue());
+    }
+}
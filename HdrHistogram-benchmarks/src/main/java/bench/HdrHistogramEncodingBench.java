@@ -23,6 +23,9 @@ import java.util.zip.DataFormatException;
 
   Run the profiling (Linux only):
      $ java -Djmh.perfasm.events=cycles,cache-misses -jar target/benchmarks.jar -f 1 -prof perfasm
+
+  Run with allocation profiling:
+     $ java -jar target/benchmarks.jar HdrHistogramEncodingBench -prof gc
  */
 @Warmup(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
 @Measurement(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
@@ -38,21 +41,47 @@ public class HdrHistogramEncodingBench {
     @Param({ "2", "3" })
     int numberOfSignificantValueDigits;
 
+    // Force decoded histograms to cover (at least) 1 hour in usec units, as log readers typically do:
+    static final long minBarForHighestTrackableValue = 3600L * 1000 * 1000;
+
     AbstractHistogram histogram;
     SkinnyHistogram skinnyHistogram;
+    DoubleHistogram doubleHistogram;
+    PackedHistogram packedHistogram;
+    Histogram accumulatingHistogram;
 
     ByteBuffer buffer;
+    ByteBuffer doubleBuffer;
+    ByteBuffer encodedBuffer;
+    ByteBuffer compressedBuffer;
+    ByteBuffer doubleCompressedBuffer;
+    ByteBuffer packedCompressedBuffer;
 
     @Setup
     public void setup() throws NoSuchMethodException {
         histogram = new Histogram(numberOfSignificantValueDigits);
         skinnyHistogram = new SkinnyHistogram(numberOfSignificantValueDigits);
         Iterable<Long> latencySeries = HistogramData.data.get(latencySeriesName);
+        doubleHistogram = new DoubleHistogram(numberOfSignificantValueDigits);
+        packedHistogram = new PackedHistogram(numberOfSignificantValueDigits);
         for (long latency : latencySeries) {
             histogram.recordValue(latency);
             skinnyHistogram.recordValue(latency);
+            doubleHistogram.recordValue(latency / 1000.0);
+            packedHistogram.recordValue(latency);
         }
+        accumulatingHistogram = new Histogram(numberOfSignificantValueDigits);
         buffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+        doubleBuffer = ByteBuffer.allocate(doubleHistogram.getNeededByteBufferCapacity());
+
+        encodedBuffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+        histogram.encodeIntoByteBuffer(encodedBuffer);
+        compressedBuffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+        histogram.encodeIntoCompressedByteBuffer(compressedBuffer);
+        doubleCompressedBuffer = ByteBuffer.allocate(doubleHistogram.getNeededByteBufferCapacity());
+        doubleHistogram.encodeIntoCompressedByteBuffer(doubleCompressedBuffer);
+        packedCompressedBuffer = ByteBuffer.allocate(packedHistogram.getNeededByteBufferCapacity());
+        packedHistogram.encodeIntoCompressedByteBuffer(packedCompressedBuffer);
     }
 
     @Benchmark
@@ -74,4 +103,74 @@ public class HdrHistogramEncodingBench {
         buffer.rewind();
         Histogram.decodeFromCompressedByteBuffer(buffer, 0);
     }
+
+    @Benchmark
+    public int encodeIntoByteBuffer() {
+        buffer.clear();
+        return histogram.encodeIntoByteBuffer(buffer);
+    }
+
+    @Benchmark
+    public Histogram decodeFromByteBuffer() {
+        encodedBuffer.rewind();
+        return Histogram.decodeFromByteBuffer(encodedBuffer, 0);
+    }
+
+    @Benchmark
+    public Histogram decodeFromCompressedByteBuffer() throws DataFormatException {
+        compressedBuffer.rewind();
+        return Histogram.decodeFromCompressedByteBuffer(compressedBuffer, 0);
+    }
+
+    @Benchmark
+    public Histogram decodeFromCompressedByteBufferWithMinBar() throws DataFormatException {
+        compressedBuffer.rewind();
+        return Histogram.decodeFromCompressedByteBuffer(compressedBuffer, minBarForHighestTrackableValue);
+    }
+
+    @Benchmark
+    public Histogram decodeFromCompressedByteBufferAndAdd() throws DataFormatException {
+        compressedBuffer.rewind();
+        Histogram decoded = Histogram.decodeFromCompressedByteBuffer(compressedBuffer, 0);
+        accumulatingHistogram.add(decoded);
+        return accumulatingHistogram;
+    }
+
+    @Benchmark
+    public Histogram addFromCompressedByteBuffer() throws DataFormatException {
+        compressedBuffer.rewind();
+        accumulatingHistogram.addFromCompressedByteBuffer(compressedBuffer);
+        return accumulatingHistogram;
+    }
+
+    @Benchmark
+    public int doubleEncodeIntoCompressedByteBuffer() {
+        doubleBuffer.clear();
+        return doubleHistogram.encodeIntoCompressedByteBuffer(doubleBuffer);
+    }
+
+    @Benchmark
+    public DoubleHistogram doubleDecodeFromCompressedByteBuffer() throws DataFormatException {
+        doubleCompressedBuffer.rewind();
+        return DoubleHistogram.decodeFromCompressedByteBuffer(doubleCompressedBuffer, 0);
+    }
+
+    @Benchmark
+    public int packedEncodeIntoCompressedByteBuffer() {
+        buffer.clear();
+        return packedHistogram.encodeIntoCompressedByteBuffer(buffer);
+    }
+
+    @Benchmark
+    public PackedHistogram packedDecodeFromCompressedByteBuffer() throws DataFormatException {
+        packedCompressedBuffer.rewind();
+        return PackedHistogram.decodeFromCompressedByteBuffer(packedCompressedBuffer, 0);
+    }
+
+    // Cross-type decoding: a Histogram's encoding decoded into a PackedHistogram:
+    @Benchmark
+    public PackedHistogram packedDecodeFromHistogramCompressedByteBuffer() throws DataFormatException {
+        compressedBuffer.rewind();
+        return PackedHistogram.decodeFromCompressedByteBuffer(compressedBuffer, 0);
+    }
 }
@@ -0,0 +1,145 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package bench;
+
+import org.HdrHistogram.*;
+import org.openjdk.jmh.annotations.*;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
+import java.util.concurrent.TimeUnit;
+import java.util.zip.DataFormatException;
+
+/*
+  Measures the end to end paths of histogram logs: encode, Base64 and log write on the writing side, and
+  log read, Base64, decode and add on the reading side. Each log benchmark invocation writes (or reads)
+  a log of intervalsPerLog interval histograms, and is reported per interval. All paths are measured through
+  the library's public API, so the Base64 and log formatting share of a log path is the difference between it
+  and the matching encode (or decode) benchmark.
+
+  Run all benchmarks:
+    $ java -jar target/benchmarks.jar HdrHistogramLogBench
+
+  Run with allocation profiling:
+     $ java -jar target/benchmarks.jar HdrHistogramLogBench -prof gc
+ */
+@Warmup(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+@Measurement(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+@Fork(3)
+@State(Scope.Thread)
+
+public class HdrHistogramLogBench {
+    static final int intervalsPerLog = 100;
+
+    @Param({"case1", "sparsed2", "quadratic", "longestjHiccupLine", "sumOfjHiccupLines"})
+    String latencySeriesName;
+
+    @Param({"Histogram", "DoubleHistogram", "PackedHistogram"})
+    String histogramType;
+
+    @Param({ "3" })
+    int numberOfSignificantValueDigits;
+
+    EncodableHistogram intervalHistogram;
+    ByteBuffer compressedBuffer;
+    ByteBuffer encodedIntervalBuffer;
+
+    ByteArrayOutputStream logOutputStream;
+    HistogramLogWriter logWriter;
+    byte[] logBytes;
+
+    Histogram accumulatedHistogram;
+    DoubleHistogram accumulatedDoubleHistogram;
+
+    @Setup
+    public void setup() {
+        Iterable<Long> latencySeries = HistogramData.data.get(latencySeriesName);
+        if (histogramType.equals("DoubleHistogram")) {
+            DoubleHistogram histogram = new DoubleHistogram(numberOfSignificantValueDigits);
+            for (long latency : latencySeries) {
+                histogram.recordValue(latency / 1000.0);
+            }
+            intervalHistogram = histogram;
+        } else {
+            AbstractHistogram histogram = histogramType.equals("PackedHistogram") ?
+                    new PackedHistogram(numberOfSignificantValueDigits) :
+                    new Histogram(numberOfSignificantValueDigits);
+            for (long latency : latencySeries) {
+                histogram.recordValue(latency);
+            }
+            intervalHistogram = histogram;
+        }
+
+        compressedBuffer = ByteBuffer.allocate(intervalHistogram.getNeededByteBufferCapacity());
+        intervalHistogram.encodeIntoCompressedByteBuffer(compressedBuffer, 9);
+        compressedBuffer.flip();
+        encodedIntervalBuffer = compressedBuffer.slice();
+        compressedBuffer = ByteBuffer.allocate(intervalHistogram.getNeededByteBufferCapacity());
+
+        logOutputStream = new ByteArrayOutputStream();
+        logWriter = new HistogramLogWriter(logOutputStream);
+        writeLog();
+        logBytes = logOutputStream.toByteArray();
+
+        accumulatedHistogram = new Histogram(numberOfSignificantValueDigits);
+        accumulatedDoubleHistogram = new DoubleHistogram(numberOfSignificantValueDigits);
+    }
+
+    private void writeLog() {
+        logOutputStream.reset();
+        logWriter.outputLogFormatVersion();
+        logWriter.outputLegend();
+        for (int i = 0; i < intervalsPerLog; i++) {
+            logWriter.outputIntervalHistogram(i, i + 1, intervalHistogram);
+        }
+    }
+
+    @Benchmark
+    public int encodeIntoCompressedByteBuffer() {
+        compressedBuffer.clear();
+        return intervalHistogram.encodeIntoCompressedByteBuffer(compressedBuffer, 9);
+    }
+
+    @Benchmark
+    public EncodableHistogram decodeFromCompressedByteBuffer() throws DataFormatException {
+        encodedIntervalBuffer.rewind();
+        if (histogramType.equals("DoubleHistogram")) {
+            return DoubleHistogram.decodeFromCompressedByteBuffer(encodedIntervalBuffer, 0);
+        } else if (histogramType.equals("PackedHistogram")) {
+            return PackedHistogram.decodeFromCompressedByteBuffer(encodedIntervalBuffer, 0);
+        }
+        return Histogram.decodeFromCompressedByteBuffer(encodedIntervalBuffer, 0);
+    }
+
+    // encode -> Base64 -> log write:
+    @Benchmark
+    @OperationsPerInvocation(intervalsPerLog)
+    public int logWrite() {
+        writeLog();
+        return logOutputStream.size();
+    }
+
+    // log read -> Base64 -> decode -> add:
+    @Benchmark
+    @OperationsPerInvocation(intervalsPerLog)
+    public long logReadDecodeAndAdd() {
+        HistogramLogReader reader = new HistogramLogReader(new ByteArrayInputStream(logBytes));
+        accumulatedHistogram.reset();
+        accumulatedDoubleHistogram.reset();
+        EncodableHistogram histogram;
+        while ((histogram = reader.nextIntervalHistogram()) != null) {
+            if (histogram instanceof DoubleHistogram) {
+                accumulatedDoubleHistogram.add((DoubleHistogram) histogram);
+            } else {
+                accumulatedHistogram.add((AbstractHistogram) histogram);
+            }
+        }
+        return accumulatedHistogram.getTotalCount() + accumulatedDoubleHistogram.getTotalCount();
+    }
+}
@@ -16,6 +16,7 @@ import org.openjdk.jmh.annotations.Measurement;
 import org.openjdk.jmh.annotations.Scope;
 import org.openjdk.jmh.annotations.Setup;
 import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Threads;
 import org.openjdk.jmh.annotations.Warmup;
 
 import java.lang.reflect.Constructor;
@@ -43,6 +44,8 @@ public class HdrHistogramRecordingBench {
     static final long testValueLevel = 12340;
 
     AbstractHistogram histogram;
+    Histogram plainHistogram;
+    ThreeDigitHistogram threeDigitHistogram;
     AbstractHistogram synchronizedHistogram;
     AbstractHistogram atomicHistogram;
     AbstractHistogram concurrentHistogram;
@@ -54,9 +57,27 @@ public class HdrHistogramRecordingBench {
 
     int i;
 
+    // Recorders shared by all benchmark threads, for measuring contended recording throughput:
+    @State(Scope.Benchmark)
+    public static class SharedRecorders {
+        static final int writeCombiningBufferLength = 256;
+
+        Recorder recorder;
+        Recorder writeCombiningRecorder;
+
+        @Setup
+        public void setup() {
+            recorder = new Recorder(numberOfSignificantValueDigits);
+            writeCombiningRecorder =
+                    new Recorder(numberOfSignificantValueDigits, false, writeCombiningBufferLength);
+        }
+    }
+
     @Setup
     public void setup() throws NoSuchMethodException {
         histogram = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
+        plainHistogram = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
+        threeDigitHistogram = new ThreeDigitHistogram(highestTrackableValue);
         synchronizedHistogram = new SynchronizedHistogram(highestTrackableValue, numberOfSignificantValueDigits);
         atomicHistogram = new AtomicHistogram(highestTrackableValue, numberOfSignificantValueDigits);
         concurrentHistogram = new ConcurrentHistogram(highestTrackableValue, numberOfSignificantValueDigits);
@@ -72,6 +93,28 @@ public class HdrHistogramRecordingBench {
         histogram.recordValue(testValueLevel + (i++ & 0x800));
     }
 
+    // Compare recording into a Histogram and into a ThreeDigitHistogram (of the same configuration), through
+    // their concrete types:
+    @Benchmark
+    public void rawPlainHistogramRecordingSpeed() {
+        plainHistogram.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    public void rawThreeDigitHistogramRecordingSpeed() {
+        threeDigitHistogram.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    public long plainHistogramGetCountAtValueSpeed() {
+        return plainHistogram.getCountAtValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    public long threeDigitHistogramGetCountAtValueSpeed() {
+        return threeDigitHistogram.getCountAtValue(testValueLevel + (i++ & 0x800));
+    }
+
     @Benchmark
     public void rawSynchroniedRecordingSpeed() {
         synchronizedHistogram.recordValue(testValueLevel + (i++ & 0x800));
@@ -116,4 +159,52 @@ public class HdrHistogramRecordingBench {
         singleWriterDoubleRecorder.recordValue(testValueLevel + (i++ & 0x800));
     }
 
+    @Benchmark
+    @Threads(1)
+    public void contendedRecorderRecordingSpeed1Threads(SharedRecorders shared) {
+        shared.recorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    @Threads(8)
+    public void contendedRecorderRecordingSpeed8Threads(SharedRecorders shared) {
+        shared.recorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    @Threads(32)
+    public void contendedRecorderRecordingSpeed32Threads(SharedRecorders shared) {
+        shared.recorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    @Threads(64)
+    public void contendedRecorderRecordingSpeed64Threads(SharedRecorders shared) {
+        shared.recorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    @Threads(1)
+    public void contendedWriteCombiningRecorderRecordingSpeed1Threads(SharedRecorders shared) {
+        shared.writeCombiningRecorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    @Threads(8)
+    public void contendedWriteCombiningRecorderRecordingSpeed8Threads(SharedRecorders shared) {
+        shared.writeCombiningRecorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    @Threads(32)
+    public void contendedWriteCombiningRecorderRecordingSpeed32Threads(SharedRecorders shared) {
+        shared.writeCombiningRecorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
+    @Benchmark
+    @Threads(64)
+    public void contendedWriteCombiningRecorderRecordingSpeed64Threads(SharedRecorders shared) {
+        shared.writeCombiningRecorder.recordValue(testValueLevel + (i++ & 0x800));
+    }
+
 }
@@ -11,6 +11,7 @@ import java.io.*;
 import java.lang.reflect.Constructor;
 import java.lang.reflect.InvocationTargetException;
 import java.nio.ByteBuffer;
+import java.nio.LongBuffer;
 import java.util.Iterator;
 import java.util.Locale;
 import java.util.concurrent.atomic.AtomicLong;
@@ -56,11 +57,14 @@ abstract class AbstractHistogramBase extends EncodableHistogram {
     double integerToDoubleValueConversionRatio = 1.0;
     double doubleToIntegerValueConversionRatio = 1.0;
 
-    PercentileIterator percentileIterator;
     RecordedValuesIterator recordedValuesIterator;
 
     ByteBuffer intermediateUncompressedByteBuffer = null;
-    byte[] intermediateUncompressedByteArray = null;
+
+    boolean cumulativeCountIndexEnabled = false;
+    long[] cumulativeCountIndex = null;
+    int cumulativeCountIndexBlockMagnitude;
+    int cumulativeCountIndexCoveredLength;
 
     double getIntegerToDoubleValueConversionRatio() {
         return integerToDoubleValueConversionRatio;
@@ -124,6 +128,10 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
     long unitMagnitudeMask;
     volatile long maxValue = 0;
     volatile long minNonZeroValue = Long.MAX_VALUE;
+    /**
+     * Cleared on every counts modification, set when the cumulative count index is (re)built
+     */
+    boolean cumulativeCountIndexIsValid = false;
 
     private static final AtomicLongFieldUpdater<AbstractHistogram> maxValueUpdater =
             AtomicLongFieldUpdater.newUpdater(AbstractHistogram.class, "maxValue");
@@ -183,6 +191,60 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
 
     abstract void resize(long newHighestTrackableValue);
 
+    //
+    // Optional, counts-type dependent direct counts array kernels. Subclasses that keep their counts in a plain
+    // array may override these to add/subtract an identically laid out histogram of the same counts type in a
+    // single tight pass over the counts arrays (without per-element virtual calls or index normalization).
+    // Callers only use these when both histograms share the same counts array length, meaning, and
+    // normalizing index offset:
+    //
+
+    /**
+     * Add the counts of an identically laid out histogram directly into this histogram's counts array.
+     * Does not modify the total count or the tracked min/max values.
+     * @param otherHistogram The other histogram
+     * @return the total count added, or -1 if a direct add is not supported for the two histograms
+     */
+    long addCountsArrayDirectly(final AbstractHistogram otherHistogram) {
+        return -1;
+    }
+
+    /**
+     * Subtract the counts of an identically laid out histogram directly from this histogram's counts array,
+     * and re-establish the total count and the tracked min/max values in the same pass. Must not modify this
+     * histogram if any of the other histogram's counts is larger than this one's.
+     * @param otherHistogram The other histogram
+     * @return true if the subtraction was performed, false if it was not (and this histogram was not modified)
+     */
+    boolean subtractCountsArrayDirectly(final AbstractHistogram otherHistogram) {
+        return false;
+    }
+
+    /**
+     * Increment the counts at the indexes of a batch of values, stopping at the first value that is negative
+     * or whose index falls outside of the counts array. Does not modify the total count or the tracked
+     * min/max values. May be overridden by subclasses to increment the counts in a single tight pass
+     * (e.g. with a single synchronization or critical section for the whole batch).
+     * @param values The array containing the values
+     * @param offset The offset in the array of the first value
+     * @param length The number of values
+     * @return the number of values (from the start of the batch) whose counts were incremented
+     */
+    int incrementCountsAtValues(final long[] values, final int offset, final int length) {
+        for (int i = 0; i < length; i++) {
+            final long value = values[offset + i];
+            if (value < 0) {
+                return i;
+            }
+            try {
+                incrementCountAtIndex(countsArrayIndex(value));
+            } catch (IndexOutOfBoundsException ex) {
+                return i;
+            }
+        }
+        return length;
+    }
+
     /**
      * Get the total count of all recorded values in the histogram
      * @return the total count of all recorded values in the histogram
@@ -351,7 +413,6 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         // subtract the bits that would be used by the largest value in bucket 0.
         leadingZeroCountBase = 64 - unitMagnitude - subBucketCountMagnitude;
 
-        percentileIterator = new PercentileIterator(this, 1);
         recordedValuesIterator = new RecordedValuesIterator(this);
     }
 
@@ -507,6 +568,94 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
     }
 
     // Package-internal support for converting and recording double values into integer histograms:
+    /**
+     * Record a batch of values in the histogram. Equivalent to recording each of the values with
+     * {@link #recordValue(long)}, but with the counts incremented in a single (counts-type dependent) pass,
+     * and with the total count and the tracked min/max values updated once for the whole batch.
+     *
+     * @param values The array containing the values to be recorded
+     * @param offset The offset in the array of the first value to be recorded
+     * @param length The number of values to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value cannot be covered by the histogram's range
+     * (in which case the values preceding it in the batch will have been recorded)
+     */
+    @Override
+    public void recordValues(final long[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        if ((offset < 0) || (length < 0) || (offset > values.length - length)) {
+            throw new IndexOutOfBoundsException("offset " + offset + " and length " + length +
+                    " out of bounds for values array of length " + values.length);
+        }
+        int recordedCount = 0;
+        try {
+            while (recordedCount < length) {
+                recordedCount += incrementCountsAtValues(values, offset + recordedCount, length - recordedCount);
+                if (recordedCount < length) {
+                    // Record the value that stopped the batch individually (auto-resizing to cover it, or throwing):
+                    final long value = values[offset + recordedCount];
+                    final int countsIndex = countsArrayIndex(value);
+                    try {
+                        incrementCountAtIndex(countsIndex);
+                    } catch (IndexOutOfBoundsException ex) {
+                        handleRecordException(1, value, ex);
+                    }
+                    recordedCount++;
+                }
+            }
+        } finally {
+            updateMinMaxAndTotalCountForValues(values, offset, recordedCount);
+        }
+    }
+
+    /**
+     * Record a batch of values in the histogram, consisting of the values remaining in a buffer. Equivalent to
+     * {@link #recordValues(long[], int, int)}. The buffer's position is advanced to its limit.
+     *
+     * @param values The buffer containing the values to be recorded (from its position to its limit)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value cannot be covered by the histogram's range
+     */
+    @Override
+    public void recordValues(final LongBuffer values) throws ArrayIndexOutOfBoundsException {
+        if (values.hasArray()) {
+            recordValues(values.array(), values.arrayOffset() + values.position(), values.remaining());
+            values.position(values.limit());
+            return;
+        }
+        final long[] batch = new long[Math.min(values.remaining(), 1024)];
+        while (values.hasRemaining()) {
+            final int batchLength = Math.min(values.remaining(), batch.length);
+            values.get(batch, 0, batchLength);
+            recordValues(batch, 0, batchLength);
+        }
+    }
+
+    private void updateMinMaxAndTotalCountForValues(final long[] values, final int offset, final int length) {
+        if (length == 0) {
+            return;
+        }
+        long batchMaxValue = 0;
+        long batchMinNonZeroValue = Long.MAX_VALUE;
+        for (int i = offset; i < offset + length; i++) {
+            final long value = values[i];
+            if (value > batchMaxValue) {
+                batchMaxValue = value;
+            }
+            if ((value < batchMinNonZeroValue) && (value != 0)) {
+                batchMinNonZeroValue = value;
+            }
+        }
+        if (batchMaxValue > maxValue) {
+            updatedMaxValue(batchMaxValue);
+        }
+        if (batchMinNonZeroValue < minNonZeroValue) {
+            updateMinNonZeroValue(batchMinNonZeroValue);
+        }
+        addToTotalCount(length);
+        if (cumulativeCountIndexIsValid) {
+            cumulativeCountIndexIsValid = false;
+        }
+    }
+
     void recordConvertedDoubleValue(final double value) {
         long integerValue = (long) (value * doubleToIntegerValueConversionRatio);
         recordValue(integerValue);
@@ -553,6 +702,10 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         }
         updateMinAndMax(value);
         addToTotalCount(count);
+        if (cumulativeCountIndexIsValid) {
+            // (only store when needed, to avoid writing to a shared line on every concurrent recording)
+            cumulativeCountIndexIsValid = false;
+        }
     }
 
     private void recordSingleValue(final long value) throws ArrayIndexOutOfBoundsException {
@@ -564,6 +717,9 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         }
         updateMinAndMax(value);
         incrementTotalCount();
+        if (cumulativeCountIndexIsValid) {
+            cumulativeCountIndexIsValid = false;
+        }
     }
 
     private void handleRecordException(final long count, final long value, Exception ex) {
@@ -620,6 +776,7 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
     @Override
     public void reset() {
         clearCounts();
+        cumulativeCountIndexIsValid = false;
         resetMaxValue(0);
         resetMinNonZeroValue(Long.MAX_VALUE);
         setNormalizingIndexOffset(0);
@@ -731,21 +888,25 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
             }
             resize(otherHistogram.getMaxValue());
         }
-        if ((bucketCount == otherHistogram.bucketCount) &&
-                (subBucketCount == otherHistogram.subBucketCount) &&
-                (unitMagnitude == otherHistogram.unitMagnitude) &&
-                (getNormalizingIndexOffset() == otherHistogram.getNormalizingIndexOffset()) &&
+        if (hasMatchingCountsArrayLayout(otherHistogram) &&
                 !(otherHistogram instanceof ConcurrentHistogram) ) {
             // Counts arrays are of the same length and meaning, so we can just iterate and add directly:
-            long observedOtherTotalCount = 0;
-            for (int i = 0; i < otherHistogram.countsArrayLength; i++) {
-                long otherCount = otherHistogram.getCountAtIndex(i);
-                if (otherCount > 0) {
-                    addToCountAtIndex(i, otherCount);
-                    observedOtherTotalCount += otherCount;
+            long observedOtherTotalCount = addCountsArrayDirectly(otherHistogram);
+            if (observedOtherTotalCount < 0) {
+                // No direct counts array kernel for this combination, add through the counts accessors
+                // (covering only the other histogram's populated span):
+                observedOtherTotalCount = 0;
+                final int otherHighestPopulatedIndex = otherHistogram.getHighestPopulatedIndex();
+                for (int i = otherHistogram.getLowestPopulatedIndex(); i <= otherHighestPopulatedIndex; i++) {
+                    long otherCount = otherHistogram.getCountAtIndex(i);
+                    if (otherCount > 0) {
+                        addToCountAtIndex(i, otherCount);
+                        observedOtherTotalCount += otherCount;
+                    }
                 }
             }
             setTotalCount(getTotalCount() + observedOtherTotalCount);
+            cumulativeCountIndexIsValid = false;
             updatedMaxValue(Math.max(getMaxValue(), otherHistogram.getMaxValue()));
             updateMinNonZeroValue(Math.min(getMinNonZeroValue(), otherHistogram.getMinNonZeroValue()));
         } else {
@@ -759,7 +920,7 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
             recordValueWithCount(otherHistogram.valueFromIndex(otherMaxIndex), otherCount);
 
             // Record the remaining values, up to but not including the max value:
-            for (int i = 0; i < otherMaxIndex; i++) {
+            for (int i = otherHistogram.getLowestPopulatedIndex(); i < otherMaxIndex; i++) {
                 otherCount = otherHistogram.getCountAtIndex(i);
                 if (otherCount > 0) {
                     recordValueWithCount(otherHistogram.valueFromIndex(i), otherCount);
@@ -786,7 +947,13 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
             throw new IllegalArgumentException(
                     "The other histogram includes values that do not fit in this histogram's range.");
         }
-        for (int i = 0; i < otherHistogram.countsArrayLength; i++) {
+        if (hasMatchingCountsArrayLayout(otherHistogram) && subtractCountsArrayDirectly(otherHistogram)) {
+            // Counts, total count, and min/max values were all established by the direct subtraction:
+            cumulativeCountIndexIsValid = false;
+            return;
+        }
+        final int otherHighestPopulatedIndex = otherHistogram.getHighestPopulatedIndex();
+        for (int i = otherHistogram.getLowestPopulatedIndex(); i <= otherHighestPopulatedIndex; i++) {
             long otherCount = otherHistogram.getCountAtIndex(i);
             if (otherCount > 0) {
                 long otherValue = otherHistogram.valueFromIndex(i);
@@ -799,10 +966,18 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         }
         // With subtraction, the max and minNonZero values could have changed:
         if ((getCountAtValue(getMaxValue()) <= 0) || getCountAtValue(getMinNonZeroValue()) <= 0) {
-            establishInternalTackingValues();
+            establishInternalTackingValues(getHighestPopulatedIndex() + 1);
         }
     }
 
+    boolean hasMatchingCountsArrayLayout(final AbstractHistogram otherHistogram) {
+        return (bucketCount == otherHistogram.bucketCount) &&
+                (subBucketCount == otherHistogram.subBucketCount) &&
+                (unitMagnitude == otherHistogram.unitMagnitude) &&
+                (countsArrayLength == otherHistogram.countsArrayLength) &&
+                (getNormalizingIndexOffset() == otherHistogram.getNormalizingIndexOffset());
+    }
+
     /**
      * Add the contents of another histogram to this one, while correcting the incoming data for coordinated omission.
      * <p>
@@ -891,6 +1066,7 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
 
         // Perform the shift:
         shiftNormalizingIndexByOffset(shiftAmount, lowestHalfBucketPopulated, newIntegerToDoubleValueConversionRatio);
+        cumulativeCountIndexIsValid = false;
 
         // adjust min, max:
         updateMinAndMax(maxValueBeforeShift << numberOfBinaryOrdersOfMagnitude);
@@ -1027,6 +1203,7 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
 
         // move normalizingIndexOffset
         shiftNormalizingIndexByOffset(-shiftAmount, false, newIntegerToDoubleValueConversionRatio);
+        cumulativeCountIndexIsValid = false;
 
         // adjust min, max:
         updateMinAndMax(maxValueBeforeShift >> numberOfBinaryOrdersOfMagnitude);
@@ -1430,27 +1607,115 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
      * in the histogram are either larger than or equivalent to. Returns 0 if no recorded values exist.
      */
     public long getValueAtPercentile(final double percentile) {
+        final long countAtPercentile = countAtPercentile(percentile, getTotalCount());
+        long totalToCurrentIndex = 0;
+        int startIndex = 0;
+        final long[] index = getCumulativeCountIndex();
+        if (index != null) {
+            // Binary search for the first block whose cumulative count reaches countAtPercentile, and
+            // only scan the counts within that block:
+            int block = findCumulativeCountIndexBlock(index, countAtPercentile);
+            if (block < 0) {
+                return 0;
+            }
+            if (block > 0) {
+                totalToCurrentIndex = index[block - 1];
+            }
+            startIndex = block << cumulativeCountIndexBlockMagnitude;
+        }
+        for (int i = startIndex; i < countsArrayLength; i++) {
+            totalToCurrentIndex += getCountAtIndex(i);
+            if (totalToCurrentIndex >= countAtPercentile) {
+                long valueAtIndex = valueFromIndex(i);
+                return (percentile == 0.0) ?
+                        lowestEquivalentValue(valueAtIndex) :
+                        highestEquivalentValue(valueAtIndex);
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Derive the count that the value at a given percentile must reach, for a given total count
+     * @param percentile The percentile
+     * @param totalCount The total count of the histogram
+     * @return The count at the percentile (always at least 1, so as to reach the first recorded entry)
+     */
+    static long countAtPercentile(final double percentile, final long totalCount) {
         // Truncate to 0..100%, and remove 1 ulp to avoid roundoff overruns into next bucket when we
         // subsequently round up to the nearest integer:
         double requestedPercentile =
                 Math.min(Math.max(Math.nextAfter(percentile, Double.NEGATIVE_INFINITY), 0.0D), 100.0D);
         // derive the count at the requested percentile. We round up to nearest integer to ensure that the
         // largest value that the requested percentile of overall recorded values is <= is actually included.
-        double fpCountAtPercentile = (requestedPercentile * getTotalCount()) / 100.0D;
+        double fpCountAtPercentile = (requestedPercentile * totalCount) / 100.0D;
         long countAtPercentile = (long)(Math.ceil(fpCountAtPercentile)); // round up
 
-        countAtPercentile = Math.max(countAtPercentile, 1); // Make sure we at least reach the first recorded entry
+        return Math.max(countAtPercentile, 1); // Make sure we at least reach the first recorded entry
+    }
+
+    /**
+     * Get the values at a given set of percentiles, in a single pass over the histogram's counts.
+     * <p>
+     * valuesAtPercentiles[i] will be set to the value that {@link #getValueAtPercentile}
+     * would return for sortedPercentiles[i]. The percentiles must be provided in ascending order.
+     * No allocation is performed, making this form suitable for repeatedly extracting a fixed set of
+     * percentiles from many histograms.
+     *
+     * @param sortedPercentiles The percentiles for which to return the associated values, in ascending order
+     * @param valuesAtPercentiles The array to fill with the values at the requested percentiles. Must be at
+     *                            least as long as sortedPercentiles.
+     * @throws IllegalArgumentException if sortedPercentiles is not sorted in ascending order, or if
+     * valuesAtPercentiles is shorter than sortedPercentiles
+     */
+    public void getValuesAtPercentiles(final double[] sortedPercentiles, final long[] valuesAtPercentiles) {
+        getValuesAtPercentiles(sortedPercentiles, valuesAtPercentiles, null, 1.0);
+    }
+
+    /**
+     * Fill either longValues or (when longValues is null) doubleValues with the values at the given
+     * percentiles, scaling double values by valueConversionRatio. Used by DoubleHistogram to avoid
+     * intermediate storage.
+     */
+    void getValuesAtPercentiles(final double[] sortedPercentiles,
+                                final long[] longValues,
+                                final double[] doubleValues,
+                                final double valueConversionRatio) {
+        final int outputLength = (longValues != null) ? longValues.length : doubleValues.length;
+        if (outputLength < sortedPercentiles.length) {
+            throw new IllegalArgumentException("The values array (length " + outputLength +
+                    ") is shorter than the percentiles array (length " + sortedPercentiles.length + ")");
+        }
+        final long totalCount = getTotalCount();
         long totalToCurrentIndex = 0;
-        for (int i = 0; i < countsArrayLength; i++) {
-            totalToCurrentIndex += getCountAtIndex(i);
+        int nextIndex = 0;
+        double previousPercentile = Double.NEGATIVE_INFINITY;
+        for (int j = 0; j < sortedPercentiles.length; j++) {
+            final double percentile = sortedPercentiles[j];
+            if (percentile < previousPercentile) {
+                throw new IllegalArgumentException("Percentiles must be sorted in ascending order");
+            }
+            previousPercentile = percentile;
+            final long countAtPercentile = countAtPercentile(percentile, totalCount);
+            // Since counts at percentiles are non-decreasing, the index that satisfied the previous
+            // percentile is where the search for this one resumes:
+            while ((totalToCurrentIndex < countAtPercentile) && (nextIndex < countsArrayLength)) {
+                totalToCurrentIndex += getCountAtIndex(nextIndex);
+                nextIndex++;
+            }
+            long valueAtPercentile = 0;
             if (totalToCurrentIndex >= countAtPercentile) {
-                long valueAtIndex = valueFromIndex(i);
-                return (percentile == 0.0) ?
+                long valueAtIndex = valueFromIndex(nextIndex - 1);
+                valueAtPercentile = (percentile == 0.0) ?
                         lowestEquivalentValue(valueAtIndex) :
                         highestEquivalentValue(valueAtIndex);
             }
+            if (longValues != null) {
+                longValues[j] = valueAtPercentile;
+            } else {
+                doubleValues[j] = valueAtPercentile * valueConversionRatio;
+            }
         }
-        return 0;
     }
 
     /**
@@ -1470,6 +1735,10 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
             return 100.0;
         }
         final int targetIndex = Math.min(countsArrayIndex(value), (countsArrayLength - 1));
+        final long[] index = getCumulativeCountIndex();
+        if (index != null) {
+            return (100.0 * getCumulativeCountAtIndex(index, targetIndex)) / getTotalCount();
+        }
         long totalToCurrentIndex = 0;
         for (int i = 0; i <= targetIndex; i++) {
             totalToCurrentIndex += getCountAtIndex(i);
@@ -1491,6 +1760,14 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
     public long getCountBetweenValues(final long lowValue, final long highValue) throws ArrayIndexOutOfBoundsException {
         final int lowIndex = Math.max(0, countsArrayIndex(lowValue));
         final int highIndex = Math.min(countsArrayIndex(highValue), (countsArrayLength - 1));
+        final long[] index = getCumulativeCountIndex();
+        if (index != null) {
+            if (lowIndex > highIndex) {
+                return 0;
+            }
+            long countBelowLowIndex = (lowIndex > 0) ? getCumulativeCountAtIndex(index, lowIndex - 1) : 0;
+            return getCumulativeCountAtIndex(index, highIndex) - countBelowLowIndex;
+        }
         long count = 0;
         for (int i = lowIndex ; i <= highIndex; i++) {
             count += getCountAtIndex(i);
@@ -1510,6 +1787,119 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         return getCountAtIndex(index);
     }
 
+    // Cumulative count index support:
+    //
+    // When enabled, a lazily built index holding the cumulative count at the end of each fixed-size block of
+    // the counts array is used by {@link #getValueAtPercentile}, {@link #getPercentileAtOrBelowValue} and
+    // {@link #getCountBetweenValues}, which then only need to scan (at most) a single block of counts per query.
+    // The index is invalidated by any modification of the histogram's counts, and rebuilt on the next query.
+
+    static final int CUMULATIVE_COUNT_INDEX_BLOCK_MAGNITUDE = 6;
+
+    /**
+     * Indicate whether or not the cumulative count index is enabled for this histogram.
+     * @return true if the cumulative count index is enabled
+     */
+    public boolean isCumulativeCountIndexEnabled() {
+        return cumulativeCountIndexEnabled;
+    }
+
+    /**
+     * Control whether or not the histogram will maintain a cumulative count index in support of value and
+     * percentile queries.
+     * <p>
+     * When enabled, the first query made after the histogram's contents have been modified will build an index
+     * of cumulative counts over fixed-size blocks of the counts array (a single linear pass). Subsequent queries
+     * made while the contents remain unmodified (e.g. asking for many percentiles of the same interval histogram)
+     * will binary-search the index and only scan a single block of counts, rather than walking the counts array
+     * from its start. The index is discarded when disabled.
+     * <p>
+     * The index is only useful for histograms that are queried many times between modifications, and that are
+     * not being concurrently modified while being queried.
+     *
+     * @param enabled cumulative count index setting
+     */
+    public void setCumulativeCountIndexEnabled(final boolean enabled) {
+        cumulativeCountIndexEnabled = enabled;
+        cumulativeCountIndexIsValid = false;
+        if (!enabled) {
+            cumulativeCountIndex = null;
+        }
+    }
+
+    private long[] getCumulativeCountIndex() {
+        if (!cumulativeCountIndexEnabled) {
+            return null;
+        }
+        if (cumulativeCountIndexIsValid && (cumulativeCountIndexCoveredLength == countsArrayLength)) {
+            return cumulativeCountIndex;
+        }
+        return buildCumulativeCountIndex();
+    }
+
+    private long[] buildCumulativeCountIndex() {
+        final int blockMagnitude = Math.min(CUMULATIVE_COUNT_INDEX_BLOCK_MAGNITUDE, subBucketHalfCountMagnitude);
+        final int blockLength = 1 << blockMagnitude;
+        final int lengthToCover = countsArrayLength;
+        final int numberOfBlocks = (lengthToCover + blockLength - 1) >> blockMagnitude;
+        long[] index = cumulativeCountIndex;
+        if ((index == null) || (index.length != numberOfBlocks)) {
+            index = new long[numberOfBlocks];
+        }
+        // Mark the index valid before scanning, such that any modification made during the scan will
+        // leave it invalid:
+        cumulativeCountIndexIsValid = true;
+        long totalToCurrentIndex = 0;
+        int i = 0;
+        for (int block = 0; block < numberOfBlocks; block++) {
+            final int blockEnd = Math.min(i + blockLength, lengthToCover);
+            for (; i < blockEnd; i++) {
+                totalToCurrentIndex += getCountAtIndex(i);
+            }
+            index[block] = totalToCurrentIndex;
+        }
+        cumulativeCountIndexBlockMagnitude = blockMagnitude;
+        cumulativeCountIndexCoveredLength = lengthToCover;
+        cumulativeCountIndex = index;
+        return index;
+    }
+
+    /**
+     * Find the lowest block whose cumulative count is {@literal >=} the given count.
+     * @return the block number, or -1 if the total count of all blocks is lower than the given count
+     */
+    private static int findCumulativeCountIndexBlock(final long[] index, final long count) {
+        int low = 0;
+        int high = index.length - 1;
+        if ((high < 0) || (index[high] < count)) {
+            return -1;
+        }
+        while (low < high) {
+            final int mid = (low + high) >>> 1;
+            if (index[mid] >= count) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return low;
+    }
+
+    /**
+     * Get the sum of the counts at all indexes up to and including the given index.
+     */
+    private long getCumulativeCountAtIndex(final long[] index, final int countsIndex) {
+        if (countsIndex < 0) {
+            return 0;
+        }
+        final int block = countsIndex >> cumulativeCountIndexBlockMagnitude;
+        long totalToCurrentIndex = (block > 0) ? index[block - 1] : 0;
+        for (int i = block << cumulativeCountIndexBlockMagnitude; i <= countsIndex; i++) {
+            totalToCurrentIndex += getCountAtIndex(i);
+        }
+        return totalToCurrentIndex;
+    }
+
     //   #### ######## ######## ########     ###    ######## ####  #######  ##    ##
     //    ##     ##    ##       ##     ##   ## ##      ##     ##  ##     ## ###   ##
     //    ##     ##    ##       ##     ##  ##   ##     ##     ##  ##     ## ####  ##
@@ -1591,6 +1981,142 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         return new AllValues(this);
     }
 
+    // Visitor-style iteration support:
+    //
+    // The forEach* methods visit the same steps as the corresponding iterators, but deliver them as primitive
+    // arguments to a callback, with no HistogramIterationValue (or iterator) involved. With a monomorphic callback,
+    // the JIT can inline the callback into the loop, making these the cheapest way to walk a histogram's contents.
+
+    /**
+     * Visit all recorded histogram values, in the same steps as {@link #recordedValues()} iterates through them:
+     * each non-zero recorded value count is passed to the consumer, in increasing value order, along with its
+     * (highest equivalent) value.
+     *
+     * @param consumer The consumer to pass each recorded value level to
+     */
+    public void forEachRecordedValue(final RecordedValueConsumer consumer) {
+        final long totalCount = getTotalCount();
+        final int highestPopulatedIndex = getHighestPopulatedIndex();
+        long totalCountToCurrentIndex = 0;
+        for (int index = getLowestPopulatedIndex();
+             (index <= highestPopulatedIndex) && (totalCountToCurrentIndex < totalCount); index++) {
+            final long countAtIndex = getCountAtIndex(index);
+            if (countAtIndex != 0) {
+                totalCountToCurrentIndex += countAtIndex;
+                consumer.accept(highestEquivalentValue(valueFromIndex(index)), countAtIndex);
+            }
+        }
+    }
+
+    /**
+     * Visit histogram values according to percentile levels, in the same steps as
+     * {@link #percentiles(int)} iterates through them: starting at 0% and reducing their distance to 100%
+     * according to the <i>percentileTicksPerHalfDistance</i> parameter, ultimately reaching 100% when all
+     * recorded histogram values are exhausted.
+     *
+     * @param percentileTicksPerHalfDistance The number of iteration steps per half-distance to 100%.
+     * @param consumer The consumer to pass each percentile iteration step to
+     */
+    public void forEachPercentile(final int percentileTicksPerHalfDistance, final PercentileConsumer consumer) {
+        final long totalCount = getTotalCount();
+        if (totalCount == 0) {
+            return;
+        }
+        final int highestPopulatedIndex = getHighestPopulatedIndex();
+        double percentileLevelToIterateTo = 0.0;
+        long totalCountToCurrentIndex = 0;
+        long valueIteratedTo = 0;
+        for (int index = getLowestPopulatedIndex();
+             (index <= highestPopulatedIndex) && (totalCountToCurrentIndex < totalCount); index++) {
+            final long countAtIndex = getCountAtIndex(index);
+            if (countAtIndex == 0) {
+                continue;
+            }
+            totalCountToCurrentIndex += countAtIndex;
+            valueIteratedTo = highestEquivalentValue(valueFromIndex(index));
+            final double currentPercentile = (100.0 * (double) totalCountToCurrentIndex) / totalCount;
+            // Emit every percentile level reached at this value (once all counts have been reached, only the
+            // additional last step to 100% remains):
+            while (currentPercentile >= percentileLevelToIterateTo) {
+                consumer.accept(valueIteratedTo, percentileLevelToIterateTo, totalCountToCurrentIndex);
+                percentileLevelToIterateTo =
+                        PercentileIterator.nextPercentileLevel(percentileLevelToIterateTo, percentileTicksPerHalfDistance);
+                if (totalCountToCurrentIndex >= totalCount) {
+                    break;
+                }
+            }
+        }
+        // One additional last step to 100%:
+        consumer.accept(valueIteratedTo, 100.0, totalCountToCurrentIndex);
+    }
+
+    /**
+     * Visit histogram values using linear steps, in the same steps as {@link #linearBucketValues(long)}
+     * iterates through them: steps of <i>valueUnitsPerBucket</i> in size, terminating when all recorded histogram
+     * values are exhausted.
+     *
+     * @param valueUnitsPerBucket The size (in value units) of the linear buckets to use
+     * @param consumer The consumer to pass each bucket to
+     */
+    public void forEachLinearBucket(final long valueUnitsPerBucket, final BucketConsumer consumer) {
+        final long totalCount = getTotalCount();
+        long currentStepHighestValueReportingLevel = valueUnitsPerBucket - 1;
+        long currentStepLowestValueReportingLevel = lowestEquivalentValue(currentStepHighestValueReportingLevel);
+        long totalCountToPrevIndex = 0;
+        long totalCountToCurrentIndex = getCountAtIndex(0);
+        int index = 0;
+        while ((totalCountToPrevIndex < totalCount) ||
+                (currentStepHighestValueReportingLevel < valueFromIndex(index + 1))) {
+            // Move through the indexes until we hit the next reporting level:
+            while ((valueFromIndex(index) < currentStepLowestValueReportingLevel) &&
+                    (index < countsArrayLength - 1)) {
+                index++;
+                totalCountToCurrentIndex += getCountAtIndex(index);
+            }
+            consumer.accept(currentStepHighestValueReportingLevel,
+                    totalCountToCurrentIndex - totalCountToPrevIndex, totalCountToCurrentIndex);
+            totalCountToPrevIndex = totalCountToCurrentIndex;
+            currentStepHighestValueReportingLevel += valueUnitsPerBucket;
+            currentStepLowestValueReportingLevel = lowestEquivalentValue(currentStepHighestValueReportingLevel);
+        }
+    }
+
+    /**
+     * Visit histogram values at logarithmically increasing levels, in the same steps as
+     * {@link #logarithmicBucketValues(long, double)} iterates through them: steps that start at
+     * <i>valueUnitsInFirstBucket</i> and increase exponentially according to <i>logBase</i>, terminating when
+     * all recorded histogram values are exhausted.
+     *
+     * @param valueUnitsInFirstBucket The size (in value units) of the first bucket in the iteration
+     * @param logBase The multiplier by which bucket sizes will grow in each iteration step
+     * @param consumer The consumer to pass each bucket to
+     */
+    public void forEachLogarithmicBucket(final long valueUnitsInFirstBucket, final double logBase,
+                                         final BucketConsumer consumer) {
+        final long totalCount = getTotalCount();
+        double nextValueReportingLevel = valueUnitsInFirstBucket;
+        long currentStepHighestValueReportingLevel = ((long) nextValueReportingLevel) - 1;
+        long currentStepLowestValueReportingLevel = lowestEquivalentValue(currentStepHighestValueReportingLevel);
+        long totalCountToPrevIndex = 0;
+        long totalCountToCurrentIndex = getCountAtIndex(0);
+        int index = 0;
+        while ((totalCountToPrevIndex < totalCount) ||
+                (lowestEquivalentValue((long) nextValueReportingLevel) < valueFromIndex(index + 1))) {
+            // Move through the indexes until we hit the next reporting level:
+            while ((valueFromIndex(index) < currentStepLowestValueReportingLevel) &&
+                    (index < countsArrayLength - 1)) {
+                index++;
+                totalCountToCurrentIndex += getCountAtIndex(index);
+            }
+            consumer.accept(currentStepHighestValueReportingLevel,
+                    totalCountToCurrentIndex - totalCountToPrevIndex, totalCountToCurrentIndex);
+            totalCountToPrevIndex = totalCountToCurrentIndex;
+            nextValueReportingLevel *= logBase;
+            currentStepHighestValueReportingLevel = ((long) nextValueReportingLevel) - 1;
+            currentStepLowestValueReportingLevel = lowestEquivalentValue(currentStepHighestValueReportingLevel);
+        }
+    }
+
     // Percentile iterator support:
 
     /**
@@ -1782,34 +2308,12 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
             printStream.format("%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
         }
 
-        PercentileIterator iterator = percentileIterator;
-        iterator.reset(percentileTicksPerHalfDistance);
-
-        String percentileFormatString;
-        String lastLinePercentileFormatString;
-        if (useCsvFormat) {
-            percentileFormatString = "%." + numberOfSignificantValueDigits + "f,%.12f,%d,%.2f\n";
-            lastLinePercentileFormatString = "%." + numberOfSignificantValueDigits + "f,%.12f,%d,Infinity\n";
-        } else {
-            percentileFormatString = "%12." + numberOfSignificantValueDigits + "f %2.12f %10d %14.2f\n";
-            lastLinePercentileFormatString = "%12." + numberOfSignificantValueDigits + "f %2.12f %10d\n";
-        }
-
-        while (iterator.hasNext()) {
-            HistogramIterationValue iterationValue = iterator.next();
-            if (iterationValue.getPercentileLevelIteratedTo() != 100.0D) {
-                printStream.format(Locale.US, percentileFormatString,
-                        iterationValue.getValueIteratedTo() / outputValueUnitScalingRatio,
-                        iterationValue.getPercentileLevelIteratedTo()/100.0D,
-                        iterationValue.getTotalCountToThisValue(),
-                        1/(1.0D - (iterationValue.getPercentileLevelIteratedTo()/100.0D)) );
-            } else {
-                printStream.format(Locale.US, lastLinePercentileFormatString,
-                        iterationValue.getValueIteratedTo() / outputValueUnitScalingRatio,
-                        iterationValue.getPercentileLevelIteratedTo()/100.0D,
-                        iterationValue.getTotalCountToThisValue());
-            }
-        }
+        // Format the percentile lines without a Formatter, producing the same text as the
+        // "%12.{digits}f %2.12f %10d %14.2f" (or csv "%.{digits}f,%.12f,%d,%.2f") formats would:
+        final PercentileDistributionFormatter formatter = new PercentileDistributionFormatter(
+                numberOfSignificantValueDigits, outputValueUnitScalingRatio, useCsvFormat);
+        forEachPercentile(percentileTicksPerHalfDistance, formatter);
+        printStream.append(formatter.getOutput());
 
         if (!useCsvFormat) {
             // Calculate and output mean and std. deviation.
@@ -1950,7 +2454,20 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
     private static final int V2EncodingCookieBase = 0x1c849303;
     private static final int V2CompressedEncodingCookieBase = 0x1c849304;
 
+    // Codec-identified compressed encodings (see HistogramCompressionCodec) wrap a V2 encoding:
+    private static final int V2CodecCompressedEncodingCookieBase = 0x1c84930a;
+    private static final int CODEC_COMPRESSED_ENCODING_HEADER_SIZE = 16;
+    // Bounds on the uncompressed length of a codec compressed encoding (well beyond any codec's actual ratio):
+    private static final int MAX_CODEC_COMPRESSION_RATIO = 4096;
+    private static final int MIN_CODEC_UNCOMPRESSED_LENGTH_BOUND = 64 * 1024;
+
+    // Delta encodings (see encodeDeltaIntoCompressedByteBuffer) of the difference from a base histogram:
+    private static final int V2DeltaEncodingCookieBase = 0x1c84930b;
+    private static final int V2DeltaCompressedEncodingCookieBase = 0x1c84930c;
+    private static final int DELTA_COMPRESSED_ENCODING_HEADER_SIZE = 40;
+
     private static final int V2maxWordSizeInBytes = 9; // LEB128-64b9B + ZigZag require up to 9 bytes per word
+    private static final int DECODING_BLOCK_LENGTH = 256; // V2 words are decoded in blocks of up to this many
 
     private static final int encodingCookieBase = V2EncodingCookieBase;
     private static final int compressedEncodingCookieBase = V2CompressedEncodingCookieBase;
@@ -1963,6 +2480,18 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         return compressedEncodingCookieBase | 0x10; // LSBit of wordSize byte indicates TLZE Encoding
     }
 
+    private int getCodecCompressedEncodingCookie() {
+        return V2CodecCompressedEncodingCookieBase | 0x10; // LSBit of wordSize byte indicates TLZE Encoding
+    }
+
+    private int getDeltaEncodingCookie() {
+        return V2DeltaEncodingCookieBase | 0x10; // LSBit of wordSize byte indicates TLZE Encoding
+    }
+
+    private int getDeltaCompressedEncodingCookie() {
+        return V2DeltaCompressedEncodingCookieBase | 0x10; // LSBit of wordSize byte indicates TLZE Encoding
+    }
+
     private static int getCookieBase(final int cookie) {
         return (cookie & ~0xf0);
     }
@@ -1989,13 +2518,7 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
                     getNeededByteBufferCapacity(relevantLength) + " bytes");
         }
         int initialPosition = buffer.position();
-        buffer.putInt(getEncodingCookie());
-        buffer.putInt(0); // Placeholder for payload length in bytes.
-        buffer.putInt(getNormalizingIndexOffset());
-        buffer.putInt(numberOfSignificantValueDigits);
-        buffer.putLong(lowestDiscernibleValue);
-        buffer.putLong(highestTrackableValue);
-        buffer.putDouble(getIntegerToDoubleValueConversionRatio());
+        putEncodingHeader(buffer, 0); // Placeholder for payload length in bytes.
 
         int payloadStartPosition = buffer.position();
         fillBufferFromCountsArray(buffer);
@@ -2005,8 +2528,27 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         return buffer.position() - initialPosition;
     }
 
+    private void putEncodingHeader(final ByteBuffer buffer, final int payloadLengthInBytes) {
+        putEncodingHeader(buffer, getEncodingCookie(), payloadLengthInBytes);
+    }
+
+    private void putEncodingHeader(final ByteBuffer buffer, final int cookie, final int payloadLengthInBytes) {
+        buffer.putInt(cookie);
+        buffer.putInt(payloadLengthInBytes);
+        buffer.putInt(getNormalizingIndexOffset());
+        buffer.putInt(numberOfSignificantValueDigits);
+        buffer.putLong(lowestDiscernibleValue);
+        buffer.putLong(highestTrackableValue);
+        buffer.putDouble(getIntegerToDoubleValueConversionRatio());
+    }
+
     /**
      * Encode this histogram in compressed form into a byte array
+     * <p>
+     * The uncompressed encoding is produced in a single pass over the counts, into the current thread's
+     * reusable deflater (see {@link SharedDeflater}), rather than into a full sized intermediate buffer
+     * held by this histogram.
+     *
      * @param targetBuffer The buffer to encode into
      * @param compressionLevel Compression level (for java.util.zip.Deflater).
      * @return The number of bytes written to the buffer
@@ -2015,47 +2557,20 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
     synchronized public int encodeIntoCompressedByteBuffer(
             final ByteBuffer targetBuffer,
             final int compressionLevel) {
-        int neededCapacity = getNeededByteBufferCapacity(countsArrayLength);
-        if (intermediateUncompressedByteBuffer == null || intermediateUncompressedByteBuffer.capacity() < neededCapacity) {
-            intermediateUncompressedByteBuffer = ByteBuffer.allocate(neededCapacity).order(BIG_ENDIAN);
-        }
-        intermediateUncompressedByteBuffer.clear();
+        final SharedDeflater sharedDeflater = SharedDeflater.get();
         int initialTargetPosition = targetBuffer.position();
 
-        final int uncompressedLength = encodeIntoByteBuffer(intermediateUncompressedByteBuffer);
-        targetBuffer.putInt(getCompressedEncodingCookie());
+        final ByteBuffer uncompressedBuffer = sharedDeflater.startUncompressedEncoding();
+        putEncodingHeader(uncompressedBuffer, 0); // Placeholder for payload length in bytes.
+        fillBufferFromCountsArray(uncompressedBuffer, countsArrayIndex(getMaxValue()) + 1, sharedDeflater);
+        // The payload length is only known once the counts were encoded (in the same pass), so record it now:
+        final ByteBuffer encodedBuffer = sharedDeflater.ensureUncompressedRoom(0);
+        encodedBuffer.putInt(4, encodedBuffer.position() - ENCODING_HEADER_SIZE);
 
+        targetBuffer.putInt(getCompressedEncodingCookie());
         targetBuffer.putInt(0); // Placeholder for compressed contents length
 
-        Deflater compressor = new Deflater(compressionLevel);
-        compressor.setInput(intermediateUncompressedByteBuffer.array(), 0, uncompressedLength);
-        compressor.finish();
-
-        byte[] targetArray;
-
-        if (targetBuffer.hasArray()) {
-            targetArray = targetBuffer.array();
-        } else {
-            if (intermediateUncompressedByteArray == null ||
-                intermediateUncompressedByteArray.length < targetBuffer.capacity()) {
-                intermediateUncompressedByteArray = new byte[targetBuffer.capacity()];
-            }
-            targetArray = intermediateUncompressedByteArray;
-        }
-
-        int compressedTargetOffset = initialTargetPosition + 8;
-        int compressedDataLength =
-            compressor.deflate(
-                targetArray,
-                compressedTargetOffset,
-                targetArray.length - compressedTargetOffset
-            );
-        compressor.end();
-
-        if (!targetBuffer.hasArray()) {
-            targetBuffer.put(targetArray, compressedTargetOffset, compressedDataLength);
-        }
-
+        int compressedDataLength = sharedDeflater.deflateUncompressedEncoding(targetBuffer, compressionLevel);
         targetBuffer.putInt(initialTargetPosition + 4, compressedDataLength); // Record the compressed length
         int bytesWritten = compressedDataLength + 8;
         targetBuffer.position(initialTargetPosition + bytesWritten);
@@ -2071,6 +2586,60 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         return encodeIntoCompressedByteBuffer(targetBuffer, Deflater.DEFAULT_COMPRESSION);
     }
 
+    /**
+     * Encode this histogram in compressed form into a byte array, using the given compression codec.
+     * <p>
+     * {@link HistogramCompressionCodecs#DEFLATE} encodings use the original compressed encoding format.
+     * Encodings using other codecs identify their codec, and can only be decoded where it is available
+     * (see {@link HistogramCompressionCodecs}).
+     *
+     * @param targetBuffer The buffer to encode into
+     * @param codec The compression codec to use
+     * @param compressionLevel Compression level (codec specific, e.g. for java.util.zip.Deflater).
+     * @return The number of bytes written to the buffer
+     */
+    @Override
+    synchronized public int encodeIntoCompressedByteBuffer(
+            final ByteBuffer targetBuffer,
+            final HistogramCompressionCodec codec,
+            final int compressionLevel) {
+        if (codec.getCodecId() == HistogramCompressionCodecs.DEFLATE_CODEC_ID) {
+            return encodeIntoCompressedByteBuffer(targetBuffer, compressionLevel);
+        }
+        int neededCapacity = getNeededByteBufferCapacity(countsArrayLength);
+        if (intermediateUncompressedByteBuffer == null || intermediateUncompressedByteBuffer.capacity() < neededCapacity) {
+            intermediateUncompressedByteBuffer = ByteBuffer.allocate(neededCapacity).order(BIG_ENDIAN);
+        }
+        intermediateUncompressedByteBuffer.clear();
+        int initialTargetPosition = targetBuffer.position();
+
+        final int uncompressedLength = encodeIntoByteBuffer(intermediateUncompressedByteBuffer);
+        intermediateUncompressedByteBuffer.flip();
+
+        targetBuffer.putInt(getCodecCompressedEncodingCookie());
+        targetBuffer.putInt(codec.getCodecId());
+        targetBuffer.putInt(uncompressedLength);
+        targetBuffer.putInt(0); // Placeholder for compressed contents length
+
+        int compressedDataLength = codec.compress(intermediateUncompressedByteBuffer, targetBuffer, compressionLevel);
+
+        targetBuffer.putInt(initialTargetPosition + 12, compressedDataLength); // Record the compressed length
+        int bytesWritten = compressedDataLength + CODEC_COMPRESSED_ENCODING_HEADER_SIZE;
+        targetBuffer.position(initialTargetPosition + bytesWritten);
+        return bytesWritten;
+    }
+
+    /**
+     * Get the capacity needed to encode this histogram in compressed form, using the given compression codec,
+     * into a ByteBuffer
+     * @param codec The compression codec to be used
+     * @return the capacity needed to encode this histogram in compressed form into a ByteBuffer
+     */
+    @Override
+    public int getNeededCompressedByteBufferCapacity(final HistogramCompressionCodec codec) {
+        return codec.getMaxCompressedLength(getNeededByteBufferCapacity()) + CODEC_COMPRESSED_ENCODING_HEADER_SIZE;
+    }
+
     private static final Class[] constructorArgsTypes = {Long.TYPE, Long.TYPE, Integer.TYPE};
 
     static <T extends AbstractHistogram> T decodeFromByteBuffer(
@@ -2191,47 +2760,88 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
 
         int dstIndex = 0;
         int endPosition = sourceBuffer.position() + lengthInBytes;
-        while (sourceBuffer.position() < endPosition) {
-            long count;
-            int zerosCount = 0;
-            if (wordSizeInBytes == V2maxWordSizeInBytes) {
-                // V2 encoding format uses a long encoded in a ZigZag LEB128 format (up to V2maxWordSizeInBytes):
-                count = ZigZagEncoding.getLong(sourceBuffer);
-                if (count < 0) {
-                    long zc = -count;
-                    if (zc > Integer.MAX_VALUE) {
-                        throw new IllegalArgumentException(
-                                "An encoded zero count of > Integer.MAX_VALUE was encountered in the source");
+        if (wordSizeInBytes == V2maxWordSizeInBytes) {
+            // V2 encoding format uses longs encoded in a ZigZag LEB128 format (up to V2maxWordSizeInBytes),
+            // which are decoded (and then validated and set) a block at a time:
+            final long[] words = new long[DECODING_BLOCK_LENGTH];
+            while (sourceBuffer.position() < endPosition) {
+                final int wordCount = ZigZagEncoding.getLongs(sourceBuffer, endPosition, words);
+                for (int i = 0; i < wordCount; i++) {
+                    final long count = words[i];
+                    if (count < 0) {
+                        if (-count > Integer.MAX_VALUE) {
+                            throw new IllegalArgumentException(
+                                    "An encoded zero count of > Integer.MAX_VALUE was encountered in the source");
+                        }
+                    } else if (count > maxAllowableCountInHistogram) {
+                        throw encodedCountTooLargeException(count);
                     }
-                    zerosCount = (int) zc;
                 }
-            } else {
-                // decoding V1 and V0 encoding formats depends on indicated word size:
-                count =
-                        ((wordSizeInBytes == 2) ? sourceBuffer.getShort() :
-                                ((wordSizeInBytes == 4) ? sourceBuffer.getInt() :
-                                        sourceBuffer.getLong()
-                                )
-                        );
+                dstIndex = setCountsFromDecodedWords(words, wordCount, dstIndex);
             }
+            return dstIndex; // this is the destination length
+        }
+        while (sourceBuffer.position() < endPosition) {
+            // decoding V1 and V0 encoding formats depends on indicated word size:
+            final long count =
+                    ((wordSizeInBytes == 2) ? sourceBuffer.getShort() :
+                            ((wordSizeInBytes == 4) ? sourceBuffer.getInt() :
+                                    sourceBuffer.getLong()
+                            )
+                    );
             if (count > maxAllowableCountInHistogram) {
-                throw new IllegalArgumentException(
-                        "An encoded count (" + count +
-                        ") does not fit in the Histogram's (" +
-                        this.wordSizeInBytes + " bytes) was encountered in the source");
+                throw encodedCountTooLargeException(count);
             }
-            if (zerosCount > 0) {
-                dstIndex += zerosCount; // No need to set zeros in array. Just skip them.
+            setCountAtIndex(dstIndex++, count);
+        }
+        return dstIndex; // this is the destination length
+    }
+
+    private IllegalArgumentException encodedCountTooLargeException(final long count) {
+        return new IllegalArgumentException(
+                "An encoded count (" + count +
+                ") does not fit in the Histogram's (" +
+                this.wordSizeInBytes + " bytes) was encountered in the source");
+    }
+
+    /**
+     * Set the counts held in a block of (validated) V2 encoded words into the (zero) counts array, starting at
+     * dstIndex. Non-negative words are counts, and negative words are runs of zero counts, which are skipped.
+     * Subclasses may override this to set the counts directly into their counts arrays.
+     * @param words The decoded words
+     * @param wordCount The number of words in the block
+     * @param dstIndex The counts index of the first word
+     * @return the counts index following the last word
+     */
+    int setCountsFromDecodedWords(final long[] words, final int wordCount, int dstIndex) {
+        for (int i = 0; i < wordCount; i++) {
+            final long count = words[i];
+            if (count < 0) {
+                dstIndex += (int) -count; // No need to set zeros in array. Just skip them.
             } else {
                 setCountAtIndex(dstIndex++, count);
             }
         }
-        return dstIndex; // this is the destination length
+        return dstIndex;
     }
 
     synchronized void fillBufferFromCountsArray(ByteBuffer buffer) {
-        final int countsLimit = countsArrayIndex(maxValue) + 1;
+        fillBufferFromCountsArray(buffer, countsArrayIndex(maxValue) + 1, null);
+    }
+
+    /**
+     * Fill a buffer with the V2 encoding of the counts array, up to (but not including) countsLimit.
+     * @param buffer The buffer to encode into
+     * @param countsLimit The length of the counts array range to encode
+     * @param sharedDeflater If non-null, buffer is this deflater's uncompressed buffer, and will be grown
+     *                          whenever it does not have the room for another encoded word
+     */
+    synchronized void fillBufferFromCountsArray(final ByteBuffer buffer, final int countsLimit,
+                                                final SharedDeflater sharedDeflater) {
+        ByteBuffer targetBuffer = buffer;
         int srcIndex = 0;
+        // Counts below the lowest populated index are known to be zero, and need not be visited:
+        final int lowestPopulatedIndex = Math.min(getLowestPopulatedIndex(), countsLimit);
 
         while (srcIndex < countsLimit) {
             // V2 encoding format uses a ZigZag LEB128-64b9B encoded long. Positive values are counts,
@@ -2247,15 +2857,22 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
             long zerosCount = 0;
             if (count == 0) {
                 zerosCount = 1;
+                if (srcIndex < lowestPopulatedIndex) {
+                    zerosCount += lowestPopulatedIndex - srcIndex;
+                    srcIndex = lowestPopulatedIndex;
+                }
                 while ((srcIndex < countsLimit) && (getCountAtIndex(srcIndex) == 0)) {
                     zerosCount++;
                     srcIndex++;
                 }
             }
+            if (sharedDeflater != null) {
+                targetBuffer = sharedDeflater.ensureUncompressedRoom(V2maxWordSizeInBytes);
+            }
             if (zerosCount > 1) {
-                ZigZagEncoding.putLong(buffer, -zerosCount);
+                ZigZagEncoding.putLong(targetBuffer, -zerosCount);
             } else {
-                ZigZagEncoding.putLong(buffer, count);
+                ZigZagEncoding.putLong(targetBuffer, count);
             }
         }
     }
@@ -2267,6 +2884,9 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
             throws DataFormatException {
         int initialTargetPosition = buffer.position();
         final int cookie = buffer.getInt();
+        if (getCookieBase(cookie) == V2CodecCompressedEncodingCookieBase) {
+            return decodeFromCodecCompressedByteBuffer(buffer, histogramClass, minBarForHighestTrackableValue);
+        }
         final int headerSize;
         if ((getCookieBase(cookie) == compressedEncodingCookieBase) ||
                 (getCookieBase(cookie) == V1CompressedEncodingCookieBase)) {
@@ -2281,7 +2901,8 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         final Inflater decompressor = new Inflater();
 
         if (buffer.hasArray()) {
-            decompressor.setInput(buffer.array(), initialTargetPosition + 8, lengthOfCompressedContents);
+            decompressor.setInput(buffer.array(), buffer.arrayOffset() + initialTargetPosition + 8,
+                    lengthOfCompressedContents);
         } else {
             byte[] compressedContents = new byte[lengthOfCompressedContents];
             buffer.get(compressedContents);
@@ -2298,6 +2919,507 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         return histogram;
     }
 
+    private static <T extends AbstractHistogram> T decodeFromCodecCompressedByteBuffer(
+            final ByteBuffer buffer,
+            final Class<T> histogramClass,
+            final long minBarForHighestTrackableValue)
+            throws DataFormatException {
+        final HistogramCompressionCodec codec = HistogramCompressionCodecs.forCodecId(buffer.getInt());
+        final int uncompressedLength = buffer.getInt();
+        final int lengthOfCompressedContents = buffer.getInt();
+        if ((uncompressedLength < ENCODING_HEADER_SIZE) || (lengthOfCompressedContents < 0) ||
+                (lengthOfCompressedContents > buffer.remaining())) {
+            throw new IllegalArgumentException("The buffer does not contain the full compressed Histogram");
+        }
+        verifyCodecUncompressedLength(uncompressedLength, lengthOfCompressedContents);
+
+        final ByteBuffer compressedContents = buffer.slice();
+        compressedContents.limit(lengthOfCompressedContents);
+        final ByteBuffer uncompressedBuffer = ByteBuffer.allocate(uncompressedLength).order(BIG_ENDIAN);
+        codec.decompress(compressedContents, uncompressedBuffer);
+        buffer.position(buffer.position() + lengthOfCompressedContents);
+        uncompressedBuffer.flip();
+
+        return decodeFromByteBuffer(uncompressedBuffer, histogramClass, minBarForHighestTrackableValue, null);
+    }
+
+    /**
+     * Add the contents of a histogram encoded in a ByteBuffer (e.g. via {@link #encodeIntoByteBuffer}) to this
+     * histogram. The encoded counts are decoded straight into this histogram's counts, without constructing
+     * an intermediate histogram. The encoded histogram may differ from this one in its value range, precision,
+     * unit magnitude, and normalizing index offset.
+     * <p>
+     * The encoded form does not include start/end timestamps, so this histogram's timestamps are not modified.
+     *
+     * @param buffer The buffer to decode from (starting at its current position)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if values in the encoded histogram are higher than
+     * highestTrackableValue (in which case some of the encoded counts may have already been added)
+     * @throws IllegalArgumentException if the buffer does not contain an (uncompressed) encoded histogram
+     */
+    public void addFromEncodedByteBuffer(final ByteBuffer buffer) {
+        final int cookie = buffer.getInt();
+        final int payloadLengthInBytes;
+        final int numberOfSignificantValueDigits;
+        final long lowestTrackableUnitValue;
+
+        if ((getCookieBase(cookie) == encodingCookieBase) ||
+                (getCookieBase(cookie) == V1EncodingCookieBase)) {
+            if (getCookieBase(cookie) == V2EncodingCookieBase) {
+                if (getWordSizeInBytesFromCookie(cookie) != V2maxWordSizeInBytes) {
+                    throw new IllegalArgumentException(
+                            "The buffer does not contain a Histogram (no valid cookie found)");
+                }
+            }
+            payloadLengthInBytes = buffer.getInt();
+            buffer.getInt(); // Skip normalizingIndexOffset. Encoded counts are in (un-normalized) index order.
+            numberOfSignificantValueDigits = buffer.getInt();
+            lowestTrackableUnitValue = buffer.getLong();
+            buffer.getLong(); // Skip highestTrackableValue, as values are added (or rejected) individually.
+            buffer.getDouble(); // Skip integerToDoubleValueConversionRatio, as add() does.
+        } else if (getCookieBase(cookie) == V0EncodingCookieBase) {
+            numberOfSignificantValueDigits = buffer.getInt();
+            lowestTrackableUnitValue = buffer.getLong();
+            buffer.getLong(); // Skip highestTrackableValue.
+            buffer.getLong(); // Discard totalCount field in V0 header.
+            payloadLengthInBytes = buffer.remaining();
+        } else {
+            throw new IllegalArgumentException("The buffer does not contain a Histogram (no valid cookie found)");
+        }
+        if ((payloadLengthInBytes < 0) || (payloadLengthInBytes > buffer.remaining())) {
+            throw new IllegalArgumentException("The buffer does not contain the full Histogram payload");
+        }
+
+        final int wordSizeInBytes = getWordSizeInBytesFromCookie(cookie);
+        if ((wordSizeInBytes != 2) && (wordSizeInBytes != 4) &&
+                (wordSizeInBytes != 8) && (wordSizeInBytes != V2maxWordSizeInBytes)) {
+            throw new IllegalArgumentException("word size must be 2, 4, 8, or V2maxWordSizeInBytes ("+
+                    V2maxWordSizeInBytes + ") bytes");
+        }
+
+        // Establish the encoded histogram's index layout:
+        final int sourceUnitMagnitude = (int) (Math.log(lowestTrackableUnitValue)/Math.log(2));
+        final int sourceSubBucketHalfCountMagnitude =
+                Integer.numberOfTrailingZeros(numberOfSubBuckets(numberOfSignificantValueDigits)) - 1;
+        // When the layouts match, encoded indexes are this histogram's indexes, and counts can be added directly:
+        final boolean indexesMatch = (sourceUnitMagnitude == unitMagnitude) &&
+                (sourceSubBucketHalfCountMagnitude == subBucketHalfCountMagnitude);
+
+        long directlyAddedTotalCount = 0;
+        int directlyAddedMinNonZeroIndex = -1;
+        int directlyAddedMaxIndex = -1;
+        int srcIndex = 0;
+        final int endPosition = buffer.position() + payloadLengthInBytes;
+        // V2 words are decoded a block at a time, and then consumed from the block:
+        final long[] words = (wordSizeInBytes == V2maxWordSizeInBytes) ? new long[DECODING_BLOCK_LENGTH] : null;
+        int wordCount = 0;
+        int wordIndex = 0;
+        while ((wordIndex < wordCount) || (buffer.position() < endPosition)) {
+            final long count;
+            if (wordSizeInBytes == V2maxWordSizeInBytes) {
+                // V2 encoding format uses a long encoded in a ZigZag LEB128 format (up to V2maxWordSizeInBytes):
+                if (wordIndex == wordCount) {
+                    wordCount = ZigZagEncoding.getLongs(buffer, endPosition, words);
+                    wordIndex = 0;
+                }
+                count = words[wordIndex++];
+                if (count < 0) {
+                    long zerosCount = -count;
+                    if (zerosCount > Integer.MAX_VALUE) {
+                        throw new IllegalArgumentException(
+                                "An encoded zero count of > Integer.MAX_VALUE was encountered in the source");
+                    }
+                    srcIndex += (int) zerosCount; // No need to add zeros. Just skip them.
+                    continue;
+                }
+            } else {
+                // decoding V1 and V0 encoding formats depends on indicated word size:
+                count =
+                        ((wordSizeInBytes == 2) ? buffer.getShort() :
+                                ((wordSizeInBytes == 4) ? buffer.getInt() :
+                                        buffer.getLong()
+                                )
+                        );
+            }
+            if (count > 0) {
+                if (indexesMatch && (srcIndex < countsArrayLength)) {
+                    addToCountAtIndex(srcIndex, count);
+                    directlyAddedTotalCount += count;
+                    directlyAddedMaxIndex = srcIndex;
+                    if ((directlyAddedMinNonZeroIndex == -1) && (srcIndex != 0)) {
+                        directlyAddedMinNonZeroIndex = srcIndex;
+                    }
+                } else {
+                    recordValueWithCount(
+                            valueFromIndex(srcIndex, sourceSubBucketHalfCountMagnitude, sourceUnitMagnitude), count);
+                }
+            }
+            srcIndex++;
+        }
+
+        if (directlyAddedTotalCount > 0) {
+            addToTotalCount(directlyAddedTotalCount);
+            cumulativeCountIndexIsValid = false;
+            updatedMaxValue(valueFromIndex(directlyAddedMaxIndex));
+            if (directlyAddedMinNonZeroIndex >= 0) {
+                updateMinNonZeroValue(valueFromIndex(directlyAddedMinNonZeroIndex));
+            }
+        }
+    }
+
+    /**
+     * Add the contents of a histogram encoded in compressed form in a ByteBuffer (e.g. via
+     * {@link #encodeIntoCompressedByteBuffer}) to this histogram, without constructing an intermediate
+     * histogram (see {@link #addFromEncodedByteBuffer(ByteBuffer)}).
+     *
+     * @param buffer The buffer to decode from (starting at its current position)
+     * @throws DataFormatException on errors in decoding the buffer compression
+     * @throws ArrayIndexOutOfBoundsException (may throw) if values in the encoded histogram are higher than
+     * highestTrackableValue (in which case some of the encoded counts may have already been added)
+     * @throws IllegalArgumentException if the buffer does not contain a compressed encoded (integer) histogram
+     */
+    public void addFromCompressedByteBuffer(final ByteBuffer buffer) throws DataFormatException {
+        final int cookie = buffer.getInt();
+        final ByteBuffer uncompressedBuffer;
+        if (getCookieBase(cookie) == V2CodecCompressedEncodingCookieBase) {
+            final HistogramCompressionCodec codec = HistogramCompressionCodecs.forCodecId(buffer.getInt());
+            final int uncompressedLength = buffer.getInt();
+            final int lengthOfCompressedContents = buffer.getInt();
+            if ((uncompressedLength < 0) || (lengthOfCompressedContents < 0) ||
+                    (lengthOfCompressedContents > buffer.remaining())) {
+                throw new IllegalArgumentException("The buffer does not contain the full compressed Histogram");
+            }
+            verifyCodecUncompressedLength(uncompressedLength, lengthOfCompressedContents);
+            final ByteBuffer compressedContents = buffer.slice();
+            compressedContents.limit(lengthOfCompressedContents);
+            uncompressedBuffer = getIntermediateUncompressedByteBuffer(uncompressedLength);
+            uncompressedBuffer.limit(uncompressedLength);
+            codec.decompress(compressedContents, uncompressedBuffer);
+            buffer.position(buffer.position() + lengthOfCompressedContents);
+            uncompressedBuffer.flip();
+        } else if ((getCookieBase(cookie) == compressedEncodingCookieBase) ||
+                (getCookieBase(cookie) == V1CompressedEncodingCookieBase) ||
+                (getCookieBase(cookie) == V0CompressedEncodingCookieBase)) {
+            final int lengthOfCompressedContents = buffer.getInt();
+            if ((lengthOfCompressedContents < 0) || (lengthOfCompressedContents > buffer.remaining())) {
+                throw new IllegalArgumentException("The buffer does not contain the full compressed Histogram");
+            }
+            uncompressedBuffer = inflateIntoIntermediateBuffer(buffer, lengthOfCompressedContents);
+        } else {
+            throw new IllegalArgumentException("The buffer does not contain a compressed Histogram");
+        }
+        addFromEncodedByteBuffer(uncompressedBuffer);
+    }
+
+    /**
+     * The uncompressed length of a codec compressed encoding is read from the (untrusted) buffer, so bound it by
+     * the compressed contents actually present ahead of allocating for it.
+     * @throws IllegalArgumentException if the uncompressed length is implausible for the compressed length
+     */
+    private static void verifyCodecUncompressedLength(final int uncompressedLength,
+                                                      final int lengthOfCompressedContents) {
+        if (uncompressedLength > Math.max(MIN_CODEC_UNCOMPRESSED_LENGTH_BOUND,
+                (long) lengthOfCompressedContents * MAX_CODEC_COMPRESSION_RATIO)) {
+            throw new IllegalArgumentException("The compressed Histogram's uncompressed length (" +
+                    uncompressedLength + ") is implausible for its compressed length (" +
+                    lengthOfCompressedContents + ")");
+        }
+    }
+
+    /**
+     * Inflate the deflated contents at the buffer's position (using the current thread's shared inflater) into the
+     * (reused) intermediate uncompressed buffer, and advance the buffer past them.
+     * @return the intermediate uncompressed buffer, limited to the inflated contents
+     */
+    private ByteBuffer inflateIntoIntermediateBuffer(final ByteBuffer buffer, final int lengthOfCompressedContents)
+            throws DataFormatException {
+        final Inflater decompressor = SharedInflater.get();
+        if (buffer.hasArray()) {
+            decompressor.setInput(buffer.array(), buffer.arrayOffset() + buffer.position(),
+                    lengthOfCompressedContents);
+            buffer.position(buffer.position() + lengthOfCompressedContents);
+        } else {
+            byte[] compressedContents = new byte[lengthOfCompressedContents];
+            buffer.get(compressedContents);
+            decompressor.setInput(compressedContents);
+        }
+        // The uncompressed length is not recorded ahead of the compressed contents, so grow as needed:
+        ByteBuffer inflatedBuffer = getIntermediateUncompressedByteBuffer(
+                Math.max(ENCODING_HEADER_SIZE, 4 * lengthOfCompressedContents));
+        int inflatedLength = 0;
+        while (!decompressor.finished()) {
+            if (inflatedLength == inflatedBuffer.capacity()) {
+                inflatedBuffer = getIntermediateUncompressedByteBuffer(2 * inflatedBuffer.capacity());
+            }
+            int length = decompressor.inflate(inflatedBuffer.array(), inflatedLength,
+                    inflatedBuffer.capacity() - inflatedLength);
+            if ((length == 0) && (decompressor.needsInput() || decompressor.needsDictionary())) {
+                throw new DataFormatException("The compressed contents are truncated");
+            }
+            inflatedLength += length;
+        }
+        inflatedBuffer.limit(inflatedLength);
+        return inflatedBuffer;
+    }
+
+    /**
+     * Get the (reused) intermediate uncompressed buffer, cleared, with (at least) the given capacity, while
+     * preserving its current contents.
+     */
+    private ByteBuffer getIntermediateUncompressedByteBuffer(final int neededCapacity) {
+        if (intermediateUncompressedByteBuffer == null) {
+            intermediateUncompressedByteBuffer = ByteBuffer.allocate(neededCapacity).order(BIG_ENDIAN);
+        } else if (intermediateUncompressedByteBuffer.capacity() < neededCapacity) {
+            ByteBuffer previousBuffer = intermediateUncompressedByteBuffer;
+            intermediateUncompressedByteBuffer = ByteBuffer.allocate(neededCapacity).order(BIG_ENDIAN);
+            System.arraycopy(previousBuffer.array(), 0, intermediateUncompressedByteBuffer.array(), 0,
+                    previousBuffer.capacity());
+        }
+        intermediateUncompressedByteBuffer.clear();
+        return intermediateUncompressedByteBuffer;
+    }
+
+    // Delta encoding support:
+    //
+    // A delta encoding holds the difference between a histogram's counts and those of an identically laid out
+    // base histogram (e.g. the previous interval histogram of the same source), such that histograms whose
+    // distribution is stable from one interval to the next encode into very small payloads. A delta encoding
+    // from no base holds all of the histogram's counts.
+    //
+    // The (uncompressed) delta encoding is a V2 encoding header (with the delta encoding cookie) followed by
+    // ZigZag LEB128-64b9B encoded words. Each non-zero word is the (possibly negative) count difference at the
+    // next index, and each zero word is followed by a word holding the number of indexes whose counts are
+    // unchanged. The compressed delta encoding deflates a delta encoding, following a header of:
+    //
+    //   int cookie, int compressed length, long sequence, long base sequence (-1 when there is no base),
+    //   long start time stamp, long end time stamp
+    //
+    // The sequence numbers identify the encoded interval and the interval it is a delta from, such that
+    // decoders can verify that a delta applies to the interval they have last decoded.
+
+    /**
+     * Encode the difference between this histogram's counts and those of a base histogram (which must have a
+     * matching counts array layout) in compressed form into a ByteBuffer.
+     *
+     * @param baseHistogram The base histogram, or null to encode the difference from an empty histogram
+     * @param sequence The sequence number of this histogram
+     * @param baseSequence The sequence number of the base histogram (ignored if there is no base histogram)
+     * @param targetBuffer The buffer to encode into
+     * @param compressionLevel Compression level (for java.util.zip.Deflater).
+     * @return The number of bytes written to the buffer
+     * @throws IllegalArgumentException if the base histogram's counts array layout does not match this one's
+     */
+    synchronized int encodeDeltaIntoCompressedByteBuffer(final AbstractHistogram baseHistogram,
+                                                         final long sequence,
+                                                         final long baseSequence,
+                                                         final ByteBuffer targetBuffer,
+                                                         final int compressionLevel) {
+        if ((baseHistogram != null) && !hasMatchingCountsArrayLayout(baseHistogram)) {
+            throw new IllegalArgumentException("The base histogram's counts array layout does not match");
+        }
+        int countsLimit = countsArrayIndex(getMaxValue()) + 1;
+        if (baseHistogram != null) {
+            countsLimit = Math.max(countsLimit, baseHistogram.countsArrayIndex(baseHistogram.getMaxValue()) + 1);
+        }
+        countsLimit = Math.min(countsLimit, countsArrayLength);
+
+        // An index whose count is unchanged takes (at most) two words, which is as much as any index can take:
+        final ByteBuffer deltaBuffer = getIntermediateUncompressedByteBuffer(
+                ENCODING_HEADER_SIZE + (2 * getNeededPayloadByteBufferCapacity(countsLimit)));
+        putEncodingHeader(deltaBuffer, getDeltaEncodingCookie(), 0); // Placeholder for payload length in bytes.
+        int index = 0;
+        while (index < countsLimit) {
+            final long baseCount = (baseHistogram != null) ? baseHistogram.getCountAtIndex(index) : 0;
+            final long delta = getCountAtIndex(index) - baseCount;
+            if (delta != 0) {
+                ZigZagEncoding.putLong(deltaBuffer, delta);
+                index++;
+                continue;
+            }
+            int unchangedCount = 1;
+            index++;
+            while ((index < countsLimit) && (getCountAtIndex(index) ==
+                    ((baseHistogram != null) ? baseHistogram.getCountAtIndex(index) : 0))) {
+                unchangedCount++;
+                index++;
+            }
+            ZigZagEncoding.putLong(deltaBuffer, 0);
+            ZigZagEncoding.putLong(deltaBuffer, unchangedCount);
+        }
+        final int deltaLength = deltaBuffer.position();
+        deltaBuffer.putInt(4, deltaLength - ENCODING_HEADER_SIZE); // Record the payload length
+
+        int initialTargetPosition = targetBuffer.position();
+        targetBuffer.putInt(getDeltaCompressedEncodingCookie());
+        targetBuffer.putInt(0); // Placeholder for compressed contents length
+        targetBuffer.putLong(sequence);
+        targetBuffer.putLong((baseHistogram != null) ? baseSequence : -1);
+        targetBuffer.putLong(startTimeStampMsec);
+        targetBuffer.putLong(endTimeStampMsec);
+
+        int compressedDataLength =
+                SharedDeflater.get().deflate(deltaBuffer.array(), 0, deltaLength, targetBuffer, compressionLevel);
+
+        targetBuffer.putInt(initialTargetPosition + 4, compressedDataLength); // Record the compressed length
+        int bytesWritten = compressedDataLength + DELTA_COMPRESSED_ENCODING_HEADER_SIZE;
+        targetBuffer.position(initialTargetPosition + bytesWritten);
+        return bytesWritten;
+    }
+
+    /**
+     * Get the capacity needed to delta encode this histogram in compressed form into a ByteBuffer
+     * @return the capacity needed to delta encode this histogram in compressed form into a ByteBuffer
+     */
+    int getNeededDeltaCompressedByteBufferCapacity() {
+        // Deflating may expand incompressible contents slightly:
+        final int deltaLength = ENCODING_HEADER_SIZE + (2 * getNeededPayloadByteBufferCapacity(countsArrayLength));
+        return DELTA_COMPRESSED_ENCODING_HEADER_SIZE + deltaLength + (deltaLength >> 8) + 64;
+    }
+
+    /**
+     * Determine whether or not the buffer holds a compressed delta encoding (at its current position)
+     */
+    static boolean isDeltaCompressedEncoding(final ByteBuffer buffer) {
+        return (buffer.remaining() >= DELTA_COMPRESSED_ENCODING_HEADER_SIZE) &&
+                (getCookieBase(buffer.getInt(buffer.position())) == V2DeltaCompressedEncodingCookieBase);
+    }
+
+    /**
+     * Get the sequence number of the compressed delta encoding (at the buffer's current position)
+     */
+    static long getDeltaEncodingSequence(final ByteBuffer buffer) {
+        return buffer.getLong(buffer.position() + 8);
+    }
+
+    /**
+     * Get the base sequence number of the compressed delta encoding (at the buffer's current position),
+     * or -1 if the encoding is not a delta from a base histogram
+     */
+    static long getDeltaEncodingBaseSequence(final ByteBuffer buffer) {
+        return buffer.getLong(buffer.position() + 16);
+    }
+
+    /**
+     * Construct an (empty) histogram with the counts array layout of the compressed delta encoding at the
+     * buffer's current position (which is not modified)
+     */
+    static Histogram constructForDeltaEncoding(final ByteBuffer buffer) throws DataFormatException {
+        final ByteBuffer headerBuffer = inflateDeltaEncodingHeader(buffer);
+        headerBuffer.getInt(); // Skip the payload length
+        final int normalizingIndexOffset = headerBuffer.getInt();
+        final int numberOfSignificantValueDigits = headerBuffer.getInt();
+        final long lowestDiscernibleValue = headerBuffer.getLong();
+        final long highestTrackableValue = headerBuffer.getLong();
+        final Histogram histogram =
+                new Histogram(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+        histogram.setNormalizingIndexOffset(normalizingIndexOffset);
+        return histogram;
+    }
+
+    private static ByteBuffer inflateDeltaEncodingHeader(final ByteBuffer buffer) throws DataFormatException {
+        final int lengthOfCompressedContents = buffer.getInt(buffer.position() + 4);
+        if ((lengthOfCompressedContents < 0) ||
+                (lengthOfCompressedContents > buffer.remaining() - DELTA_COMPRESSED_ENCODING_HEADER_SIZE)) {
+            throw new IllegalArgumentException("The buffer does not contain the full compressed delta encoding");
+        }
+        final ByteBuffer compressedContents = buffer.duplicate();
+        compressedContents.position(buffer.position() + DELTA_COMPRESSED_ENCODING_HEADER_SIZE);
+        final Inflater decompressor = new Inflater();
+        try {
+            if (compressedContents.hasArray()) {
+                decompressor.setInput(compressedContents.array(),
+                        compressedContents.arrayOffset() + compressedContents.position(), lengthOfCompressedContents);
+            } else {
+                byte[] compressedBytes = new byte[lengthOfCompressedContents];
+                compressedContents.get(compressedBytes);
+                decompressor.setInput(compressedBytes);
+            }
+            final ByteBuffer headerBuffer = ByteBuffer.allocate(ENCODING_HEADER_SIZE).order(BIG_ENDIAN);
+            if ((decompressor.inflate(headerBuffer.array()) < ENCODING_HEADER_SIZE) ||
+                    (getCookieBase(headerBuffer.getInt()) != V2DeltaEncodingCookieBase)) {
+                throw new IllegalArgumentException("The buffer does not contain a delta encoded Histogram");
+            }
+            return headerBuffer;
+        } finally {
+            decompressor.end();
+        }
+    }
+
+    /**
+     * Apply the compressed delta encoding at the buffer's current position to this histogram, which must hold
+     * the counts of the delta's base histogram (or be empty, if the delta is not from a base histogram), and
+     * have a matching counts array layout. The start/end timestamps of this histogram are set to those of the
+     * delta encoded histogram. The buffer is advanced past the delta encoding.
+     *
+     * @param buffer The buffer to decode from
+     * @throws DataFormatException on errors in decoding the buffer compression
+     * @throws IllegalArgumentException if the buffer does not contain a compressed delta encoding, if its
+     * counts array layout does not match this histogram's, or if it does not apply to this histogram's counts
+     */
+    synchronized void applyDeltaFromCompressedByteBuffer(final ByteBuffer buffer) throws DataFormatException {
+        final int cookie = buffer.getInt();
+        if (getCookieBase(cookie) != V2DeltaCompressedEncodingCookieBase) {
+            throw new IllegalArgumentException("The buffer does not contain a compressed delta encoded Histogram");
+        }
+        final int lengthOfCompressedContents = buffer.getInt();
+        buffer.getLong(); // Skip the sequence
+        buffer.getLong(); // Skip the base sequence
+        final long startTimeStamp = buffer.getLong();
+        final long endTimeStamp = buffer.getLong();
+        if ((lengthOfCompressedContents < 0) || (lengthOfCompressedContents > buffer.remaining())) {
+            throw new IllegalArgumentException("The buffer does not contain the full compressed delta encoding");
+        }
+        final ByteBuffer deltaBuffer = inflateIntoIntermediateBuffer(buffer, lengthOfCompressedContents);
+
+        if ((deltaBuffer.remaining() < ENCODING_HEADER_SIZE) ||
+                (getCookieBase(deltaBuffer.getInt()) != V2DeltaEncodingCookieBase)) {
+            throw new IllegalArgumentException("The buffer does not contain a delta encoded Histogram");
+        }
+        final int payloadLengthInBytes = deltaBuffer.getInt();
+        final int encodedNormalizingIndexOffset = deltaBuffer.getInt();
+        final int encodedNumberOfSignificantValueDigits = deltaBuffer.getInt();
+        final long encodedLowestDiscernibleValue = deltaBuffer.getLong();
+        final long encodedHighestTrackableValue = deltaBuffer.getLong();
+        deltaBuffer.getDouble(); // Skip integerToDoubleValueConversionRatio, as add() does.
+        if ((encodedNumberOfSignificantValueDigits != numberOfSignificantValueDigits) ||
+                (encodedLowestDiscernibleValue != lowestDiscernibleValue) ||
+                (encodedNormalizingIndexOffset != getNormalizingIndexOffset()) ||
+                (determineArrayLengthNeeded(encodedHighestTrackableValue) != countsArrayLength)) {
+            throw new IllegalArgumentException(
+                    "The delta encoded histogram's counts array layout does not match this histogram's");
+        }
+        if ((payloadLengthInBytes < 0) || (payloadLengthInBytes > deltaBuffer.remaining())) {
+            throw new IllegalArgumentException("The buffer does not contain the indicated payload amount");
+        }
+        final int endPosition = deltaBuffer.position() + payloadLengthInBytes;
+
+        int index = 0;
+        while (deltaBuffer.position() < endPosition) {
+            final long delta = ZigZagEncoding.getLong(deltaBuffer);
+            if (delta == 0) {
+                final long unchangedCount = ZigZagEncoding.getLong(deltaBuffer);
+                if ((unchangedCount <= 0) || (unchangedCount > countsArrayLength - index)) {
+                    throw new IllegalArgumentException("An invalid run of unchanged counts was encountered");
+                }
+                index += (int) unchangedCount;
+                continue;
+            }
+            if (index >= countsArrayLength) {
+                throw new IllegalArgumentException("The delta encoding extends beyond the counts array");
+            }
+            final long count = getCountAtIndex(index) + delta;
+            if (count < 0) {
+                throw new IllegalArgumentException("The delta encoding does not apply to this histogram's counts");
+            }
+            setCountAtIndex(index, count);
+            index++;
+        }
+        // Counts beyond those covered by the delta are zero in both the base and the delta encoded histogram:
+        establishInternalTackingValues(index);
+        cumulativeCountIndexIsValid = false;
+        setStartTimeStamp(startTimeStamp);
+        setEndTimeStamp(endTimeStamp);
+    }
+
     //   #### ##    ## ######## ######## ########  ##    ##    ###    ##
     //    ##  ###   ##    ##    ##       ##     ## ###   ##   ## ##   ##
     //    ##  ####  ##    ##    ##       ##     ## ####  ##  ##   ##  ##
@@ -2345,8 +3467,6 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
     }
 
     void establishInternalTackingValues(final int lengthToCover) {
-        resetMaxValue(0);
-        resetMinNonZeroValue(Long.MAX_VALUE);
         int maxIndex = -1;
         int minNonZeroIndex = -1;
         long observedTotalCount = 0;
@@ -2360,6 +3480,19 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
                 }
             }
         }
+        establishInternalTackingValues(observedTotalCount, minNonZeroIndex, maxIndex);
+    }
+
+    /**
+     * Establish the total count and the tracked min/max values from already observed ones.
+     * @param observedTotalCount The total count of all values in the counts array
+     * @param minNonZeroIndex The lowest (non-zero value) index with a positive count, or -1 if there is none
+     * @param maxIndex The highest index with a positive count, or -1 if there is none
+     */
+    void establishInternalTackingValues(final long observedTotalCount, final int minNonZeroIndex,
+                                        final int maxIndex) {
+        resetMaxValue(0);
+        resetMinNonZeroValue(Long.MAX_VALUE);
         if (maxIndex >= 0) {
             updatedMaxValue(highestEquivalentValue(valueFromIndex(maxIndex)));
         }
@@ -2369,6 +3502,37 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         setTotalCount(observedTotalCount);
     }
 
+    //
+    // The tracked min and max values bound the span of (logical) counts indexes that can hold non-zero
+    // counts. Operations that would otherwise walk the whole counts array (add, subtract, clear, encode)
+    // use these to only cover the populated span, which is commonly a small fraction of the array.
+    //
+    // This makes it an invariant that every non-zero count lies within [getLowestPopulatedIndex(),
+    // getHighestPopulatedIndex()]. Code that writes counts directly (through setCountAtIndex,
+    // addToCountAtIndex, or the counts arrays themselves) rather than through recordValue() and friends must
+    // re-establish minNonZeroValue and maxValue (see establishInternalTackingValues()) before the histogram is
+    // next added, subtracted, cleared or encoded, or counts outside the stale span will be silently skipped:
+    //
+
+    /**
+     * Get the lowest counts index that may hold a non-zero count. All counts below it are zero.
+     * @return the lowest counts index that may hold a non-zero count
+     */
+    int getLowestPopulatedIndex() {
+        if ((minNonZeroValue == Long.MAX_VALUE) || (getCountAtIndex(0) != 0)) {
+            return 0;
+        }
+        return countsArrayIndex(minNonZeroValue);
+    }
+
+    /**
+     * Get the highest counts index that may hold a non-zero count. All counts above it are zero.
+     * @return the highest counts index that may hold a non-zero count
+     */
+    int getHighestPopulatedIndex() {
+        return Math.min(countsArrayIndex(maxValue), countsArrayLength - 1);
+    }
+
     int getBucketsNeededToCoverValue(final long value) {
         // Shift won't overflow because subBucketMagnitude + unitMagnitude <= 62.
         // the k'th bucket can express from 0 * 2^k to subBucketCount * 2^k in units of 2^k
@@ -2471,6 +3635,18 @@ public abstract class AbstractHistogram extends AbstractHistogramBase implements
         return ((long) subBucketIndex) << (bucketIndex + unitMagnitude);
     }
 
+    private static long valueFromIndex(final int index, final int subBucketHalfCountMagnitude,
+                                       final int unitMagnitude) {
+        final int subBucketHalfCount = 1 << subBucketHalfCountMagnitude;
+        int bucketIndex = (index >> subBucketHalfCountMagnitude) - 1;
+        int subBucketIndex = (index & (subBucketHalfCount - 1)) + subBucketHalfCount;
+        if (bucketIndex < 0) {
+            subBucketIndex -= subBucketHalfCount;
+            bucketIndex = 0;
+        }
+        return ((long) subBucketIndex) << (bucketIndex + unitMagnitude);
+    }
+
     final long valueFromIndex(final int index) {
         int bucketIndex = (index >> subBucketHalfCountMagnitude) - 1;
         int subBucketIndex = (index & (subBucketHalfCount - 1)) + subBucketHalfCount;
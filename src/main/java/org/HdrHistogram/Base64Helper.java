@@ -8,6 +8,7 @@
 package org.HdrHistogram;
 
 import java.lang.reflect.Method;
+import java.nio.charset.StandardCharsets;
 
 /**
  * Base64Helper exists to bridge inconsistencies in Java SE support of Base64 encoding and decoding.
@@ -25,6 +26,10 @@ import java.lang.reflect.Method;
  * uses late binding (Reflection) internally to avoid javac-compile-time dependencies on a specific
  * Java SE version (e.g. beyond 7 or before 9).
  *
+ * Encoding does not depend on the platform at all: Base64Helper encodes with its own (table driven)
+ * encoder, which produces the same output as both of the platform encoders, and can encode directly
+ * into a caller provided byte array (e.g. a reusable log line buffer) with no intermediate String.
+ *
  */
 class Base64Helper {
 
@@ -35,11 +40,59 @@ class Base64Helper {
      * @return a String containing the Base64 encoded equivalent of the binary input
      */
     static String printBase64Binary(byte [] binaryArray) {
-        try {
-            return (String) encodeMethod.invoke(encoderObj, binaryArray);
-        } catch (Throwable e) {
-            throw new UnsupportedOperationException("Failed to use platform's base64 encode method");
+        final byte[] encoded = new byte[getEncodedLength(binaryArray.length)];
+        final int encodedLength = printBase64Binary(binaryArray, 0, binaryArray.length, encoded, 0);
+        return new String(encoded, 0, encodedLength, StandardCharsets.US_ASCII);
+    }
+
+    /**
+     * Get the length of the Base64 encoding of a given number of bytes
+     *
+     * @param binaryLength The number of bytes to be encoded
+     * @return the number of (ASCII) bytes in the Base64 encoding of binaryLength bytes
+     */
+    static int getEncodedLength(final int binaryLength) {
+        return 4 * ((binaryLength + 2) / 3);
+    }
+
+    /**
+     * Encodes a range of a byte array into its Base64 equivalent (as ASCII bytes) into a target byte array.
+     *
+     * @param binaryArray A binary encoded input array
+     * @param offset The offset of the range to encode in binaryArray
+     * @param length The length of the range to encode
+     * @param target The array to place the Base64 encoding in. Must have at least
+     *               {@link #getEncodedLength getEncodedLength(length)} bytes available from targetOffset.
+     * @param targetOffset The offset in target at which to place the encoding
+     * @return the number of bytes placed in target
+     */
+    static int printBase64Binary(final byte[] binaryArray, final int offset, final int length,
+                                 final byte[] target, final int targetOffset) {
+        int sourceIndex = offset;
+        int targetIndex = targetOffset;
+        final int wholeTripletsEnd = offset + length - (length % 3);
+        while (sourceIndex < wholeTripletsEnd) {
+            final int bits = ((binaryArray[sourceIndex++] & 0xff) << 16) |
+                    ((binaryArray[sourceIndex++] & 0xff) << 8) |
+                    (binaryArray[sourceIndex++] & 0xff);
+            target[targetIndex++] = ALPHABET[bits >>> 18];
+            target[targetIndex++] = ALPHABET[(bits >>> 12) & 0x3f];
+            target[targetIndex++] = ALPHABET[(bits >>> 6) & 0x3f];
+            target[targetIndex++] = ALPHABET[bits & 0x3f];
         }
+        final int remainingBytes = offset + length - sourceIndex;
+        if (remainingBytes > 0) {
+            // Encode the final 1 or 2 bytes, padded with '=' to a whole quad:
+            int bits = (binaryArray[sourceIndex] & 0xff) << 16;
+            if (remainingBytes == 2) {
+                bits |= (binaryArray[sourceIndex + 1] & 0xff) << 8;
+            }
+            target[targetIndex++] = ALPHABET[bits >>> 18];
+            target[targetIndex++] = ALPHABET[(bits >>> 12) & 0x3f];
+            target[targetIndex++] = (remainingBytes == 2) ? ALPHABET[(bits >>> 6) & 0x3f] : (byte) '=';
+            target[targetIndex++] = (byte) '=';
+        }
+        return targetIndex - targetOffset;
     }
 
     /**
@@ -57,13 +110,13 @@ class Base64Helper {
     }
 
 
+    private static final byte[] ALPHABET =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/".getBytes(StandardCharsets.US_ASCII);
+
     private static Method decodeMethod;
-    private static Method encodeMethod;
 
-    // encoderObj and decoderObj are used in non-static method forms, and
-    // irrelevant for static method forms:
+    // decoderObj is used in non-static method forms, and irrelevant for static method forms:
     private static Object decoderObj;
-    private static Object encoderObj;
 
     static {
         try {
@@ -72,25 +125,17 @@ class Base64Helper {
             Method getDecoderMethod =  javaUtilBase64Class.getMethod("getDecoder");
             decoderObj = getDecoderMethod.invoke(null);
             decodeMethod = decoderObj.getClass().getMethod("decode", String.class);
-
-            Method getEncoderMethod =  javaUtilBase64Class.getMethod("getEncoder");
-            encoderObj = getEncoderMethod.invoke(null);
-            encodeMethod = encoderObj.getClass().getMethod("encodeToString", byte[].class);
         } catch (Throwable e) {
             decodeMethod = null;
-            encodeMethod = null;
         }
 
-        if (encodeMethod == null) {
+        if (decodeMethod == null) {
             decoderObj = null;
-            encoderObj = null;
             try {
                 Class<?> javaxXmlBindDatatypeConverterClass = Class.forName("javax.xml.bind.DatatypeConverter");
                 decodeMethod = javaxXmlBindDatatypeConverterClass.getMethod("parseBase64Binary", String.class);
-                encodeMethod = javaxXmlBindDatatypeConverterClass.getMethod("printBase64Binary", byte[].class);
             } catch (Throwable e) {
                 decodeMethod = null;
-                encodeMethod = null;
             }
         }
     }
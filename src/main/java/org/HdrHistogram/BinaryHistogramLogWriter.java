@@ -0,0 +1,290 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.File;
+import java.io.FileNotFoundException;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.zip.Deflater;
+
+import static java.nio.ByteOrder.BIG_ENDIAN;
+
+/**
+ * A histogram log writer that writes histogram logs in a binary, length-prefixed record format, as an
+ * alternative to the text lines written by {@link HistogramLogWriter}.
+ * <p>
+ * Binary logs carry the same information as text logs (intervals with their optional tags, start and base
+ * times, and comments), and are read with the same {@link HistogramLogReader} and {@link HistogramLogScanner}
+ * used for text logs, which detect the format of the log they read. Interval histograms are logged in their
+ * compressed form as is, with no Base64 encoding and no text formatting of their timestamps, making binary logs
+ * both smaller and (much) cheaper to write and read than text logs, e.g. for shipping logs over the network at
+ * high rates.
+ * <h3>Binary histogram log format:</h3>
+ * All multi-byte fields are big endian. A binary log starts with an 8 byte header:
+ * <ul>
+ * <li>A 4 byte cookie ({@link #BINARY_LOG_COOKIE}), identifying the binary format. (The cookie can never start
+ * a text log, as its first byte is a control character.)</li>
+ * <li>A 4 byte format version ({@link #BINARY_LOG_FORMAT_VERSION})</li>
+ * </ul>
+ * The header is followed by records. Each record consists of a 4 byte record length (the number of bytes in
+ * the record that follow the length field), a 1 byte record type, and a record type specific body:
+ * <ul>
+ * <li>{@link #START_TIME_RECORD}: An 8 byte double holding the start time, in seconds since the epoch</li>
+ * <li>{@link #BASE_TIME_RECORD}: An 8 byte double holding the base time, in seconds since the epoch</li>
+ * <li>{@link #COMMENT_RECORD}: The comment, in UTF-8</li>
+ * <li>{@link #INTERVAL_RECORD}: An 8 byte double start timestamp (in seconds), an 8 byte double interval length
+ * (in seconds), an 8 byte double interval max value (scaled as it would be in a text log), a 4 byte tag length
+ * (-1 for intervals with no tag) followed by the tag in UTF-8, followed by the compressed histogram
+ * (as encoded by {@link EncodableHistogram#encodeIntoCompressedByteBuffer}) filling the rest of the record.</li>
+ * </ul>
+ * Readers skip records of types they do not know.
+ * <p>
+ * Timestamps are logged at full (double) precision, rather than rounded to the milliseconds logged by
+ * {@link HistogramLogWriter}. Binary logs do not support sidecar {@link HistogramLogIndex} indexes.
+ */
+public class BinaryHistogramLogWriter {
+    /**
+     * The cookie identifying a binary histogram log
+     */
+    public static final int BINARY_LOG_COOKIE = 0x1c849320;
+    /**
+     * The version of the binary histogram log format written by this writer
+     */
+    public static final int BINARY_LOG_FORMAT_VERSION = 1;
+
+    public static final byte START_TIME_RECORD = 1;
+    public static final byte BASE_TIME_RECORD = 2;
+    public static final byte COMMENT_RECORD = 3;
+    public static final byte INTERVAL_RECORD = 4;
+
+    // The length field, record type, and the timestamp, interval length, max value and tag length fields:
+    private static final int INTERVAL_RECORD_FIELDS_SIZE = 4 + 1 + (3 * 8) + 4;
+
+    private final OutputStream log;
+
+    private ByteBuffer recordBuffer = ByteBuffer.allocate(256).order(BIG_ENDIAN);
+
+    private HistogramCompressionCodec compressionCodec = HistogramCompressionCodecs.DEFLATE;
+    private int compressionLevel = Deflater.BEST_COMPRESSION;
+
+    private long baseTime = 0;
+
+    /**
+     * Constructs a new BinaryHistogramLogWriter around a newly created file with the specified file name.
+     * @param outputFileName The name of the file to create
+     * @throws FileNotFoundException when unable to open outputFileName
+     */
+    public BinaryHistogramLogWriter(final String outputFileName) throws FileNotFoundException {
+        this(new FileOutputStream(outputFileName));
+    }
+
+    /**
+     * Constructs a new BinaryHistogramLogWriter that will write into the specified file.
+     * @param outputFile The File to write to
+     * @throws FileNotFoundException when unable to open outputFile
+     */
+    public BinaryHistogramLogWriter(final File outputFile) throws FileNotFoundException {
+        this(new FileOutputStream(outputFile));
+    }
+
+    /**
+     * Constructs a new BinaryHistogramLogWriter that will write into the specified output stream. The log
+     * header is written to the stream as part of construction.
+     * @param outputStream The OutputStream to write to
+     */
+    public BinaryHistogramLogWriter(final OutputStream outputStream) {
+        log = outputStream;
+        recordBuffer.clear();
+        recordBuffer.putInt(BINARY_LOG_COOKIE);
+        recordBuffer.putInt(BINARY_LOG_FORMAT_VERSION);
+        write(recordBuffer);
+    }
+
+    /**
+     * Set the compression codec (and codec specific compression level) used for logged interval histograms.
+     * Defaults to {@link HistogramCompressionCodecs#DEFLATE} at {@link Deflater#BEST_COMPRESSION}.
+     * <p>
+     * Logs written with codecs other than {@link HistogramCompressionCodecs#DEFLATE} can only be read where
+     * the codec is available (see {@link HistogramCompressionCodecs}).
+     * @param compressionCodec The compression codec to use
+     * @param compressionLevel The codec specific compression level to use
+     */
+    public synchronized void setCompressionCodec(final HistogramCompressionCodec compressionCodec,
+                                                 final int compressionLevel) {
+        if (compressionCodec == null) {
+            throw new IllegalArgumentException("compressionCodec cannot be null");
+        }
+        this.compressionCodec = compressionCodec;
+        this.compressionLevel = compressionLevel;
+    }
+
+    /**
+     * Get the compression codec used for logged interval histograms.
+     * @return the compression codec used for logged interval histograms
+     */
+    public synchronized HistogramCompressionCodec getCompressionCodec() {
+        return compressionCodec;
+    }
+
+    /**
+     * Closes the file or output stream for this log writer.
+     */
+    public synchronized void close() {
+        try {
+            log.close();
+        } catch (IOException ex) {
+            throw new IllegalStateException("Failed to close the binary histogram log", ex);
+        }
+    }
+
+    /**
+     * Output an interval histogram, with the given timestamp information and the [optional] tag
+     * associated with the histogram, using a configurable maxValueUnitRatio. (note that the
+     * specified timestamp information will be used, and the timestamp information in the actual
+     * histogram will be ignored).
+     * The max value reported with the interval will be scaled by the given maxValueUnitRatio.
+     * @param startTimeStampSec The start timestamp to log with the interval histogram, in seconds.
+     * @param endTimeStampSec The end timestamp to log with the interval histogram, in seconds.
+     * @param histogram The interval histogram to log.
+     * @param maxValueUnitRatio The ratio by which to divide the histogram's max value when reporting on it.
+     */
+    public synchronized void outputIntervalHistogram(final double startTimeStampSec,
+                                                     final double endTimeStampSec,
+                                                     final EncodableHistogram histogram,
+                                                     final double maxValueUnitRatio) {
+        final String tag = histogram.getTag();
+        final byte[] tagBytes = (tag != null) ? tag.getBytes(StandardCharsets.UTF_8) : null;
+        final int neededCapacity = INTERVAL_RECORD_FIELDS_SIZE + ((tagBytes != null) ? tagBytes.length : 0) +
+                histogram.getNeededCompressedByteBufferCapacity(compressionCodec);
+        ensureRecordBufferCapacity(neededCapacity);
+
+        recordBuffer.clear();
+        recordBuffer.putInt(0); // Placeholder for the record length
+        recordBuffer.put(INTERVAL_RECORD);
+        recordBuffer.putDouble(startTimeStampSec);
+        recordBuffer.putDouble(endTimeStampSec - startTimeStampSec);
+        recordBuffer.putDouble(histogram.getMaxValueAsDouble() / maxValueUnitRatio);
+        if (tagBytes != null) {
+            recordBuffer.putInt(tagBytes.length);
+            recordBuffer.put(tagBytes);
+        } else {
+            recordBuffer.putInt(-1);
+        }
+        // The compressed histogram is encoded in place, at the end of the record:
+        histogram.encodeIntoCompressedByteBuffer(recordBuffer, compressionCodec, compressionLevel);
+        recordBuffer.putInt(0, recordBuffer.position() - 4);
+        write(recordBuffer);
+    }
+
+    /**
+     * Output an interval histogram, with the given timestamp information, and the [optional] tag
+     * associated with the histogram. (note that the specified timestamp information will be used,
+     * and the timestamp information in the actual histogram will be ignored).
+     * The max value in the histogram will be reported scaled down by a default maxValueUnitRatio of
+     * 1,000,000 (which is the msec : nsec ratio). Caller should use the direct form specifying
+     * maxValueUnitRatio some other ratio is needed for the max value output.
+     * @param startTimeStampSec The start timestamp to log with the interval histogram, in seconds.
+     * @param endTimeStampSec The end timestamp to log with the interval histogram, in seconds.
+     * @param histogram The interval histogram to log.
+     */
+    public void outputIntervalHistogram(final double startTimeStampSec,
+                                        final double endTimeStampSec,
+                                        final EncodableHistogram histogram) {
+        outputIntervalHistogram(startTimeStampSec, endTimeStampSec, histogram, 1000000.0);
+    }
+
+    /**
+     * Output an interval histogram, using the start/end timestamp indicated in the histogram,
+     * and the [optional] tag associated with the histogram.
+     * The histogram start and end timestamps are assumed to be in msec units. Logging will be
+     * in seconds, relative by a base time (if set via {@link #setBaseTime}). The default base time is 0.
+     * See {@link HistogramLogWriter#outputIntervalHistogram(EncodableHistogram)}.
+     * @param histogram The interval histogram to log.
+     */
+    public void outputIntervalHistogram(final EncodableHistogram histogram) {
+        outputIntervalHistogram((histogram.getStartTimeStamp() - baseTime)/1000.0,
+                (histogram.getEndTimeStamp() - baseTime)/1000.0,
+                histogram);
+    }
+
+    /**
+     * Log a start time in the log.
+     * @param startTimeMsec time (in milliseconds) since the absolute start time (the epoch)
+     */
+    public void outputStartTime(final long startTimeMsec) {
+        outputTime(START_TIME_RECORD, startTimeMsec);
+    }
+
+    /**
+     * Log a base time in the log.
+     * @param baseTimeMsec time (in milliseconds) since the absolute start time (the epoch)
+     */
+    public void outputBaseTime(final long baseTimeMsec) {
+        outputTime(BASE_TIME_RECORD, baseTimeMsec);
+    }
+
+    private synchronized void outputTime(final byte recordType, final long timeMsec) {
+        recordBuffer.clear();
+        recordBuffer.putInt(1 + 8);
+        recordBuffer.put(recordType);
+        recordBuffer.putDouble(timeMsec / 1000.0);
+        write(recordBuffer);
+    }
+
+    /**
+     * Log a comment to the log.
+     * @param comment the comment string.
+     */
+    public synchronized void outputComment(final String comment) {
+        final byte[] commentBytes = comment.getBytes(StandardCharsets.UTF_8);
+        ensureRecordBufferCapacity(4 + 1 + commentBytes.length);
+        recordBuffer.clear();
+        recordBuffer.putInt(1 + commentBytes.length);
+        recordBuffer.put(COMMENT_RECORD);
+        recordBuffer.put(commentBytes);
+        write(recordBuffer);
+    }
+
+    /**
+     * Set a base time to subtract from supplied histogram start/end timestamps when
+     * logging based on histogram timestamps.
+     * Base time is expected to be in msec since the epoch, as histogram start/end times
+     * are typically stamped with absolute times in msec since the epoch.
+     * @param baseTimeMsec base time to calculate timestamp deltas from
+     */
+    public void setBaseTime(long baseTimeMsec) {
+        this.baseTime = baseTimeMsec;
+    }
+
+    /**
+     * return the current base time offset (see {@link #setBaseTime}).
+     * @return the current base time
+     */
+    public long getBaseTime() {
+        return baseTime;
+    }
+
+    private void ensureRecordBufferCapacity(final int neededCapacity) {
+        if (recordBuffer.capacity() < neededCapacity) {
+            recordBuffer = ByteBuffer.allocate(neededCapacity).order(BIG_ENDIAN);
+        }
+    }
+
+    // Write the record (or header) composed in the buffer (from its start to its position) as a single write:
+    private void write(final ByteBuffer buffer) {
+        try {
+            log.write(buffer.array(), buffer.arrayOffset(), buffer.position());
+        } catch (IOException ex) {
+            throw new IllegalStateException("Failed to write to the binary histogram log", ex);
+        }
+    }
+}
@@ -0,0 +1,26 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+/**
+ * A callback for visiting the value buckets of a histogram with
+ * {@link AbstractHistogram#forEachLinearBucket(long, BucketConsumer)} and
+ * {@link AbstractHistogram#forEachLogarithmicBucket(long, double, BucketConsumer)}. Receives each bucket
+ * as primitives, with no per-bucket allocation.
+ */
+public interface BucketConsumer {
+
+    /**
+     * Visit a value bucket
+     *
+     * @param valueIteratedTo The highest value of the bucket
+     * @param countAddedInThisIterationStep The count of values recorded in the bucket
+     * @param totalCountToThisValue The total count of values recorded up to and including valueIteratedTo
+     */
+    void accept(long valueIteratedTo, long countAddedInThisIterationStep, long totalCountToThisValue);
+}
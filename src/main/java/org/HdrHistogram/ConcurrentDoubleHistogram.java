@@ -83,6 +83,29 @@ public class ConcurrentDoubleHistogram extends DoubleHistogram {
         this(highestToLowestValueRatio, numberOfSignificantValueDigits, ConcurrentHistogram.class);
     }
 
+    /**
+     * Construct a new DoubleHistogram with the specified dynamic range (provided in {@code highestToLowestValueRatio}),
+     * using a precision stated as a number of significant decimal digits, and with range headroom stated as a number
+     * of binary orders of magnitude. Values recorded within the headroom are recorded without auto-range adjustments,
+     * and without stalling concurrent recorders (see
+     * {@link DoubleHistogram#DoubleHistogram(long, int, int)} for details).
+     *
+     * @param highestToLowestValueRatio      specifies the dynamic range to use
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant decimal
+     *                                       digits to which the histogram will maintain value resolution and
+     *                                       separation. Must be a non-negative integer between 0 and 5.
+     * @param rangeHeadroomBinaryOrdersOfMagnitude The number of binary orders of magnitude of headroom to cover
+     *                                             below and above the specified dynamic range. Must be
+     *                                             non-negative.
+     */
+    public ConcurrentDoubleHistogram(final long highestToLowestValueRatio, final int numberOfSignificantValueDigits,
+                                     final int rangeHeadroomBinaryOrdersOfMagnitude) {
+        this(deriveHighestToLowestValueRatioWithHeadroom(highestToLowestValueRatio,
+                        rangeHeadroomBinaryOrdersOfMagnitude),
+                numberOfSignificantValueDigits, ConcurrentHistogram.class);
+        this.rangeHeadroomBinaryOrdersOfMagnitude = rangeHeadroomBinaryOrdersOfMagnitude;
+    }
+
     /**
      * Construct a {@link ConcurrentDoubleHistogram} with the same range settings as a given source,
      * duplicating the source's start/end timestamps (but NOT it's contents)
@@ -110,6 +133,28 @@ public class ConcurrentDoubleHistogram extends DoubleHistogram {
         );
     }
 
+    /**
+     * Record a batch of values in the histogram. Values are recorded individually (as with
+     * {@link #recordValue(double)}), such that values recorded concurrently with auto-range adjustments
+     * are retried on the recording path that tolerates such adjustments.
+     *
+     * @param values The array containing the values to be recorded
+     * @param offset The offset in the array of the first value to be recorded
+     * @param length The number of values to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value cannot be covered by the histogram's range
+     */
+    @Override
+    public void recordValues(final double[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        if ((offset < 0) || (length < 0) || (offset > values.length - length)) {
+            throw new IndexOutOfBoundsException("offset " + offset + " and length " + length +
+                    " out of bounds for values array of length " + values.length);
+        }
+        for (int i = offset; i < offset + length; i++) {
+            recordValue(values[i]);
+        }
+    }
+
     /**
      * Construct a new ConcurrentDoubleHistogram by decoding it from a ByteBuffer.
      * @param buffer The buffer to decode from
@@ -53,27 +53,13 @@ public class ConcurrentHistogram extends Histogram {
         try {
             wrp.readerLock();
 
+            // The conversion ratio travels with each counts array, and (unlike the normalizing index offset)
+            // is atomically replaced in place: A change that does not shift the counts does not change
+            // where any converted value is counted, so a writer in flight that converted its value with the
+            // previous ratio simply records it as it would have just before the change, and there is no need
+            // to flip phases (and wait for writers in flight).
+            activeCounts.setDoubleToIntegerValueConversionRatio(1.0 / integerToDoubleValueConversionRatio);
             inactiveCounts.setDoubleToIntegerValueConversionRatio(1.0 / integerToDoubleValueConversionRatio);
-
-            // switch active and inactive:
-            ConcurrentArrayWithNormalizingOffset tmp = activeCounts;
-            activeCounts = inactiveCounts;
-            inactiveCounts = tmp;
-
-            wrp.flipPhase();
-
-            inactiveCounts.setDoubleToIntegerValueConversionRatio(1.0 / integerToDoubleValueConversionRatio);
-
-            // switch active and inactive again:
-            tmp = activeCounts;
-            activeCounts = inactiveCounts;
-            inactiveCounts = tmp;
-
-            wrp.flipPhase();
-
-            // At this point, both active and inactive have normalizingIndexOffset safely set,
-            // and the switch in each was done without any writers using the wrong value in flight.
-
         } finally {
             wrp.readerUnlock();
         }
@@ -114,8 +100,33 @@ public class ConcurrentHistogram extends Histogram {
     void incrementCountAtIndex(final int index) {
         long criticalValue = wrp.writerCriticalSectionEnter();
         try {
-            activeCounts.atomicIncrement(
-                    normalizeIndex(index, activeCounts.getNormalizingIndexOffset(), activeCounts.length()));
+            final ConcurrentArrayWithNormalizingOffset counts = activeCounts;
+            counts.atomicIncrement(normalizeIndex(index, counts.getNormalizingIndexOffset(), counts.length()));
+        } finally {
+            wrp.writerCriticalSectionExit(criticalValue);
+        }
+    }
+
+    @Override
+    int incrementCountsAtValues(final long[] values, final int offset, final int length) {
+        // A single writer critical section for the whole batch:
+        long criticalValue = wrp.writerCriticalSectionEnter();
+        try {
+            final ConcurrentArrayWithNormalizingOffset counts = activeCounts;
+            final int normalizingIndexOffset = counts.getNormalizingIndexOffset();
+            final int countsLength = counts.length();
+            for (int i = 0; i < length; i++) {
+                final long value = values[offset + i];
+                if (value < 0) {
+                    return i;
+                }
+                final int index = countsArrayIndex(value);
+                if (index >= countsLength) {
+                    return i;
+                }
+                counts.atomicIncrement(normalizeIndex(index, normalizingIndexOffset, countsLength));
+            }
+            return length;
         } finally {
             wrp.writerCriticalSectionExit(criticalValue);
         }
@@ -125,8 +136,8 @@ public class ConcurrentHistogram extends Histogram {
     void addToCountAtIndex(final int index, final long value) {
         long criticalValue = wrp.writerCriticalSectionEnter();
         try {
-            activeCounts.atomicAdd(
-                    normalizeIndex(index, activeCounts.getNormalizingIndexOffset(), activeCounts.length()), value);
+            final ConcurrentArrayWithNormalizingOffset counts = activeCounts;
+            counts.atomicAdd(normalizeIndex(index, counts.getNormalizingIndexOffset(), counts.length()), value);
         } finally {
             wrp.writerCriticalSectionExit(criticalValue);
         }
@@ -165,10 +176,11 @@ public class ConcurrentHistogram extends Histogram {
     void recordConvertedDoubleValue(final double value) {
         long criticalValue = wrp.writerCriticalSectionEnter();
         try {
-            long integerValue = (long) (value * activeCounts.getDoubleToIntegerValueConversionRatio());
+            // Convert and count the value with the ratio and normalizing offset of the same counts array:
+            final ConcurrentArrayWithNormalizingOffset counts = activeCounts;
+            long integerValue = (long) (value * counts.getDoubleToIntegerValueConversionRatio());
             int index = countsArrayIndex(integerValue);
-            activeCounts.atomicIncrement(
-                    normalizeIndex(index, activeCounts.getNormalizingIndexOffset(), activeCounts.length()));
+            counts.atomicIncrement(normalizeIndex(index, counts.getNormalizingIndexOffset(), counts.length()));
             updateMinAndMax(integerValue);
             incrementTotalCount();
         } finally {
@@ -181,10 +193,11 @@ public class ConcurrentHistogram extends Histogram {
             throws ArrayIndexOutOfBoundsException {
         long criticalValue = wrp.writerCriticalSectionEnter();
         try {
-            long integerValue = (long) (value * activeCounts.getDoubleToIntegerValueConversionRatio());
+            // Convert and count the value with the ratio and normalizing offset of the same counts array:
+            final ConcurrentArrayWithNormalizingOffset counts = activeCounts;
+            long integerValue = (long) (value * counts.getDoubleToIntegerValueConversionRatio());
             int index = countsArrayIndex(integerValue);
-            activeCounts.atomicAdd(
-                    normalizeIndex(index, activeCounts.getNormalizingIndexOffset(), activeCounts.length()), count);
+            counts.atomicAdd(normalizeIndex(index, counts.getNormalizingIndexOffset(), counts.length()), count);
             updateMinAndMax(integerValue);
             addToTotalCount(count);
         } finally {
@@ -230,18 +243,14 @@ public class ConcurrentHistogram extends Histogram {
 
             wrp.flipPhase();
 
+            // No writers can be using the (now) inactive counts, and writers are only using the new active
+            // counts (which already have the new offset and conversion ratio), so the inactive counts can
+            // be set in place, with no need to switch back:
             setNormalizingIndexOffsetForInactive(newNormalizingIndexOffset, shiftedAmount,
                     lowestHalfBucketPopulated, newIntegerToDoubleValueConversionRatio);
 
-            // switch active and inactive again:
-            tmp = activeCounts;
-            activeCounts = inactiveCounts;
-            inactiveCounts = tmp;
-
-            wrp.flipPhase();
-
             // At this point, both active and inactive have normalizingIndexOffset safely set,
-            // and the switch in each was done without any writers using the wrong value in flight.
+            // and the switch was done without any writers using the wrong value in flight.
 
         } finally {
             wrp.readerUnlock();
@@ -354,6 +363,10 @@ public class ConcurrentHistogram extends Histogram {
                     allocateArray(newArrayLength, inactiveCounts.getNormalizingIndexOffset());
             ConcurrentArrayWithNormalizingOffset newInactiveCounts2 =
                     allocateArray(newArrayLength, activeCounts.getNormalizingIndexOffset());
+            newInactiveCounts1.setDoubleToIntegerValueConversionRatio(
+                    inactiveCounts.getDoubleToIntegerValueConversionRatio());
+            newInactiveCounts2.setDoubleToIntegerValueConversionRatio(
+                    activeCounts.getDoubleToIntegerValueConversionRatio());
 
 
             // Resize the current inactiveCounts:
@@ -370,22 +383,15 @@ public class ConcurrentHistogram extends Histogram {
 
             wrp.flipPhase();
 
-            // Resize the newly inactiveCounts:
+            // Resize the newly inactiveCounts (which no writers can be using, so there is no need to switch back):
             oldInactiveCounts = inactiveCounts;
             inactiveCounts = newInactiveCounts2;
 
             // Copy inactive contents to newly sized inactiveCounts:
             copyInactiveCountsContentsOnResize(oldInactiveCounts, countsDelta);
 
-            // switch active and inactive again:
-            tmp = activeCounts;
-            activeCounts = inactiveCounts;
-            inactiveCounts = tmp;
-
-            wrp.flipPhase();
-
             // At this point, both active and inactive have been safely resized,
-            // and the switch in each was done without any writers modifying it in flight.
+            // and the switch was done without any writers modifying either in flight.
 
             // We resized things. We can now make the histogram establish size accordingly for future recordings:
             establishSize(newHighestTrackableValue);
@@ -610,10 +616,11 @@ public class ConcurrentHistogram extends Histogram {
     }
 
     @Override
-    synchronized void fillBufferFromCountsArray(final ByteBuffer buffer) {
+    synchronized void fillBufferFromCountsArray(final ByteBuffer buffer, final int countsLimit,
+                                                final SharedDeflater sharedDeflater) {
         try {
             wrp.readerLock();
-            super.fillBufferFromCountsArray(buffer);
+            super.fillBufferFromCountsArray(buffer, countsLimit, sharedDeflater);
         } finally {
             wrp.readerUnlock();
         }
@@ -645,7 +652,7 @@ public class ConcurrentHistogram extends Histogram {
     static class AtomicLongArrayWithNormalizingOffset extends AtomicLongArray
             implements ConcurrentArrayWithNormalizingOffset {
         private int normalizingIndexOffset;
-        private double doubleToIntegerValueConversionRatio;
+        private volatile double doubleToIntegerValueConversionRatio;
 
         AtomicLongArrayWithNormalizingOffset(int length, int normalizingIndexOffset) {
             super(length);
@@ -0,0 +1,422 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.IOException;
+import java.io.InvalidObjectException;
+import java.io.ObjectInputStream;
+import java.io.ObjectOutputStream;
+import java.io.Serializable;
+import java.lang.invoke.MethodHandle;
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.MethodType;
+import java.lang.reflect.Field;
+import java.nio.Buffer;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.zip.DataFormatException;
+
+/**
+ * <h3>An integer values High Dynamic Range (HDR) Histogram that keeps its counts off-heap
+ * and supports safe concurrent recording operations.</h3>
+ * A {@link DirectConcurrentHistogram} guarantees lossless recording of values into the histogram even when the
+ * histogram is updated by multiple threads, and supports auto-resize and shift operations that may
+ * result from or occur concurrently with other recording operations.
+ * <p>
+ * {@link DirectConcurrentHistogram} tracks value counts as <b><code>long</code></b> counts in direct
+ * {@link ByteBuffer}s, outside of the Java heap, such that large histograms do not add to the work of garbage
+ * collectors (which would otherwise scan and copy their counts arrays). Since direct buffers do not provide
+ * atomic update operations, counts are updated with atomic compare-and-swap operations on the buffers' memory,
+ * such that recording is lock-free, as it is in {@link ConcurrentHistogram}. The JDK only provides such operations
+ * on native memory through its (unsupported) {@code sun.misc.Unsafe} class, which is probed for (and verified
+ * against a direct buffer) when the class is initialized. On JDKs or module configurations where it is not
+ * available, a {@link DirectConcurrentHistogram} keeps its counts in (on-heap) atomic arrays instead, exactly as
+ * {@link ConcurrentHistogram} does, and remains lock-free and fully functional.
+ * <p>
+ * It is important to note that concurrent recording, auto-sizing, and value shifting are the only thread-safe
+ * behaviors provided by {@link DirectConcurrentHistogram}, and that it is not otherwise synchronized. Specifically,
+ * {@link DirectConcurrentHistogram} provides no implicit synchronization that would prevent the contents of the
+ * histogram from changing during queries, iterations, copies, or addition operations on the histogram. Callers
+ * wishing to make potentially concurrent, multi-threaded updates that would safely work in the presence of
+ * queries, copies, or additions of histogram objects should either take care to externally synchronize and/or
+ * order their access, use {@link Recorder} or {@link SingleWriterRecorder} which are intended for
+ * this purpose.
+ * <p>
+ * Auto-resizing: When constructed with no specified value range range (or when auto-resize is turned on with {@link
+ * Histogram#setAutoResize}) a {@link DirectConcurrentHistogram} will auto-resize its dynamic range to include recorded
+ * values as they are encountered. Note that recording calls that cause auto-resizing may take longer to execute, as
+ * resizing incurs allocation and copying of internal data structures.
+ * <p>
+ * See package description for {@link org.HdrHistogram} for details.
+ */
+
+public class DirectConcurrentHistogram extends ConcurrentHistogram {
+
+    @Override
+    ConcurrentArrayWithNormalizingOffset allocateArray(int length, int normalizingIndexOffset) {
+        return newCountsArray(length, normalizingIndexOffset);
+    }
+
+    private static ConcurrentArrayWithNormalizingOffset newCountsArray(int length, int normalizingIndexOffset) {
+        if (DirectArrayWithNormalizingOffset.DIRECT_MEMORY_ACCESS_AVAILABLE) {
+            return new DirectArrayWithNormalizingOffset(length, normalizingIndexOffset);
+        }
+        return new AtomicLongArrayWithNormalizingOffset(length, normalizingIndexOffset);
+    }
+
+    @Override
+    public DirectConcurrentHistogram copy() {
+        DirectConcurrentHistogram copy = new DirectConcurrentHistogram(this);
+        copy.add(this);
+        return copy;
+    }
+
+    @Override
+    public DirectConcurrentHistogram copyCorrectedForCoordinatedOmission(
+            final long expectedIntervalBetweenValueSamples) {
+        DirectConcurrentHistogram toHistogram = new DirectConcurrentHistogram(this);
+        toHistogram.addWhileCorrectingForCoordinatedOmission(this, expectedIntervalBetweenValueSamples);
+        return toHistogram;
+    }
+
+    /**
+     * Construct an auto-resizing DirectConcurrentHistogram with a lowest discernible value of 1 and an
+     * auto-adjusting highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
+     *
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public DirectConcurrentHistogram(final int numberOfSignificantValueDigits) {
+        this(1, 2, numberOfSignificantValueDigits);
+        setAutoResize(true);
+    }
+
+    /**
+     * Construct a DirectConcurrentHistogram given the Highest value to be tracked and a number of significant
+     * decimal digits. The histogram will be constructed to implicitly track (distinguish from 0) values as low as 1.
+     *
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} 2.
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public DirectConcurrentHistogram(final long highestTrackableValue, final int numberOfSignificantValueDigits) {
+        this(1, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a DirectConcurrentHistogram given the Lowest and Highest values to be tracked and a number of
+     * significant decimal digits. Providing a lowestDiscernibleValue is useful is situations where the units used
+     * for the histogram's values are much smaller that the minimal accuracy required. E.g. when tracking
+     * time values stated in nanosecond units, where the minimal accuracy required is a microsecond, the
+     * proper value for lowestDiscernibleValue would be 1000.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public DirectConcurrentHistogram(final long lowestDiscernibleValue, final long highestTrackableValue,
+                                     final int numberOfSignificantValueDigits) {
+        this(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits,
+                true);
+    }
+
+    /**
+     * Construct a histogram with the same range settings as a given source histogram,
+     * duplicating the source's start/end timestamps (but NOT it's contents)
+     * @param source The source histogram to duplicate
+     */
+    public DirectConcurrentHistogram(final AbstractHistogram source) {
+        this(source, true);
+    }
+
+    DirectConcurrentHistogram(final AbstractHistogram source, boolean allocateCountsArray) {
+        super(source, false);
+        if (allocateCountsArray) {
+            activeCounts = newCountsArray(countsArrayLength, 0);
+            inactiveCounts = newCountsArray(countsArrayLength, 0);
+        }
+        wordSizeInBytes = 8;
+    }
+
+    DirectConcurrentHistogram(final long lowestDiscernibleValue, final long highestTrackableValue,
+                              final int numberOfSignificantValueDigits, boolean allocateCountsArray) {
+        super(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits,
+                false);
+        if (allocateCountsArray) {
+            activeCounts = newCountsArray(countsArrayLength, 0);
+            inactiveCounts = newCountsArray(countsArrayLength, 0);
+        }
+        wordSizeInBytes = 8;
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     */
+    public static DirectConcurrentHistogram decodeFromByteBuffer(final ByteBuffer buffer,
+                                                                 final long minBarForHighestTrackableValue) {
+        return decodeFromByteBuffer(buffer, DirectConcurrentHistogram.class, minBarForHighestTrackableValue);
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a compressed form in a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     * @throws DataFormatException on error parsing/decompressing the buffer
+     */
+    public static DirectConcurrentHistogram decodeFromCompressedByteBuffer(final ByteBuffer buffer,
+                                                                           final long minBarForHighestTrackableValue)
+            throws DataFormatException {
+        return decodeFromCompressedByteBuffer(buffer, DirectConcurrentHistogram.class,
+                minBarForHighestTrackableValue);
+    }
+
+    private void readObject(final ObjectInputStream o)
+            throws IOException, ClassNotFoundException {
+        o.defaultReadObject();
+        wrp = new WriterReaderPhaser();
+    }
+
+    /**
+     * Counts kept in a direct buffer, with atomic updates made to the buffer's memory through
+     * {@code sun.misc.Unsafe}. Unsafe is looked up reflectively, and accessed through (constant, and therefore
+     * inlined) method handles, such that no JDK internal API is referenced at compile time. The lookup is verified
+     * by cross-checking accesses made through it with accesses made through a direct buffer, and any failure to
+     * look it up or verify it leaves {@link #DIRECT_MEMORY_ACCESS_AVAILABLE} false, in which case no instances
+     * are created.
+     */
+    static class DirectArrayWithNormalizingOffset
+            implements ConcurrentArrayWithNormalizingOffset, Serializable {
+        static final boolean DIRECT_MEMORY_ACCESS_AVAILABLE;
+        // Bound handles of Unsafe's (Object, long) addressed accessors, always called with a null base:
+        private static final MethodHandle GET_LONG_VOLATILE;
+        private static final MethodHandle PUT_ORDERED_LONG;
+        private static final MethodHandle COMPARE_AND_SWAP_LONG;
+        // The (Buffer) -> long getter of a direct buffer's memory address:
+        private static final MethodHandle BUFFER_ADDRESS;
+
+        static {
+            MethodHandle getLongVolatile = null;
+            MethodHandle putOrderedLong = null;
+            MethodHandle compareAndSwapLong = null;
+            MethodHandle bufferAddress = null;
+            boolean available = false;
+            try {
+                final Class<?> unsafeClass = Class.forName("sun.misc.Unsafe");
+                final Field theUnsafe = unsafeClass.getDeclaredField("theUnsafe");
+                theUnsafe.setAccessible(true);
+                final Object unsafe = theUnsafe.get(null);
+                final MethodHandles.Lookup lookup = MethodHandles.publicLookup();
+                getLongVolatile = lookup.findVirtual(unsafeClass, "getLongVolatile",
+                        MethodType.methodType(long.class, Object.class, long.class)).bindTo(unsafe);
+                putOrderedLong = lookup.findVirtual(unsafeClass, "putOrderedLong",
+                        MethodType.methodType(void.class, Object.class, long.class, long.class)).bindTo(unsafe);
+                compareAndSwapLong = lookup.findVirtual(unsafeClass, "compareAndSwapLong",
+                        MethodType.methodType(boolean.class, Object.class, long.class, long.class, long.class))
+                        .bindTo(unsafe);
+                final long addressFieldOffset = (long) lookup.findVirtual(unsafeClass, "objectFieldOffset",
+                        MethodType.methodType(long.class, Field.class)).bindTo(unsafe)
+                        .invoke(Buffer.class.getDeclaredField("address"));
+                bufferAddress = MethodHandles.insertArguments(lookup.findVirtual(unsafeClass, "getLong",
+                        MethodType.methodType(long.class, Object.class, long.class)).bindTo(unsafe),
+                        1, addressFieldOffset).asType(MethodType.methodType(long.class, Buffer.class));
+                available = verifyDirectMemoryAccess(getLongVolatile, putOrderedLong, compareAndSwapLong,
+                        bufferAddress);
+            } catch (Throwable t) {
+                // Not available (e.g. no sun.misc.Unsafe, or java.nio not open to reflection):
+                available = false;
+            }
+            GET_LONG_VOLATILE = getLongVolatile;
+            PUT_ORDERED_LONG = putOrderedLong;
+            COMPARE_AND_SWAP_LONG = compareAndSwapLong;
+            BUFFER_ADDRESS = bufferAddress;
+            DIRECT_MEMORY_ACCESS_AVAILABLE = available;
+        }
+
+        // Cross-check accesses through the handles with accesses through a direct buffer, reading (a pattern
+        // written through the buffer) before anything is written through the handles, such that a wrongly
+        // resolved address is never written to:
+        private static boolean verifyDirectMemoryAccess(final MethodHandle getLongVolatile,
+                                                        final MethodHandle putOrderedLong,
+                                                        final MethodHandle compareAndSwapLong,
+                                                        final MethodHandle bufferAddress) throws Throwable {
+            final ByteBuffer probe = ByteBuffer.allocateDirect(16).order(ByteOrder.nativeOrder());
+            final long bufferStart = (long) bufferAddress.invokeExact((Buffer) probe);
+            final long address = (bufferStart + 7) & ~7L;
+            final int offset = (int) (address - bufferStart);
+            final long pattern = 0x0123456789abcdefL;
+            probe.putLong(offset, pattern);
+            if ((long) getLongVolatile.invokeExact((Object) null, address) != pattern) {
+                return false;
+            }
+            putOrderedLong.invokeExact((Object) null, address, ~pattern);
+            if (probe.getLong(offset) != ~pattern) {
+                return false;
+            }
+            if (!(boolean) compareAndSwapLong.invokeExact((Object) null, address, ~pattern, pattern)) {
+                return false;
+            }
+            return probe.getLong(offset) == pattern;
+        }
+
+        private static long getLongVolatile(final long address) {
+            try {
+                return (long) GET_LONG_VOLATILE.invokeExact((Object) null, address);
+            } catch (RuntimeException | Error ex) {
+                throw ex;
+            } catch (Throwable t) {
+                throw new IllegalStateException(t);
+            }
+        }
+
+        private static void putOrderedLong(final long address, final long value) {
+            try {
+                PUT_ORDERED_LONG.invokeExact((Object) null, address, value);
+            } catch (RuntimeException | Error ex) {
+                throw ex;
+            } catch (Throwable t) {
+                throw new IllegalStateException(t);
+            }
+        }
+
+        private static boolean compareAndSwapLong(final long address, final long expected, final long value) {
+            try {
+                return (boolean) COMPARE_AND_SWAP_LONG.invokeExact((Object) null, address, expected, value);
+            } catch (RuntimeException | Error ex) {
+                throw ex;
+            } catch (Throwable t) {
+                throw new IllegalStateException(t);
+            }
+        }
+
+        private static long addressOfBuffer(final ByteBuffer buffer) {
+            try {
+                return (long) BUFFER_ADDRESS.invokeExact((Buffer) buffer);
+            } catch (RuntimeException | Error ex) {
+                throw ex;
+            } catch (Throwable t) {
+                throw new IllegalStateException(t);
+            }
+        }
+
+        // Retained to keep the counts memory (which is freed when the buffer is collected) reachable:
+        private transient ByteBuffer counts;
+        // The 8 byte aligned address of the counts within the buffer's memory:
+        private transient long countsAddress;
+        private final int length;
+
+        private int normalizingIndexOffset;
+        private volatile double doubleToIntegerValueConversionRatio;
+
+        DirectArrayWithNormalizingOffset(int length, int normalizingIndexOffset) {
+            if (length > ((Integer.MAX_VALUE - 7) >> 3)) {
+                throw new IllegalArgumentException("counts array length " + length +
+                        " too large for a single direct buffer");
+            }
+            this.length = length;
+            this.normalizingIndexOffset = normalizingIndexOffset;
+            allocateCounts();
+        }
+
+        private void allocateCounts() {
+            // Atomic updates require aligned counts, so allow for aligning them within the buffer:
+            counts = ByteBuffer.allocateDirect((length << 3) + 7).order(ByteOrder.nativeOrder());
+            final long bufferAddress = addressOfBuffer(counts);
+            countsAddress = (bufferAddress + 7) & ~7L;
+        }
+
+        private long addressOf(final int index) {
+            // Report out of range indexes the way a counts array would:
+            if ((index < 0) || (index >= length)) {
+                throw new ArrayIndexOutOfBoundsException("index " + index + " out of counts range");
+            }
+            return countsAddress + (((long) index) << 3);
+        }
+
+        public int getNormalizingIndexOffset() {
+            return normalizingIndexOffset;
+        }
+
+        public void setNormalizingIndexOffset(int normalizingIndexOffset) {
+            this.normalizingIndexOffset = normalizingIndexOffset;
+        }
+
+        public double getDoubleToIntegerValueConversionRatio() {
+            return doubleToIntegerValueConversionRatio;
+        }
+
+        public void setDoubleToIntegerValueConversionRatio(double doubleToIntegerValueConversionRatio) {
+            this.doubleToIntegerValueConversionRatio = doubleToIntegerValueConversionRatio;
+        }
+
+        @Override
+        public long get(int index) {
+            return getLongVolatile(addressOf(index));
+        }
+
+        @Override
+        public void atomicIncrement(int index) {
+            atomicAdd(index, 1);
+        }
+
+        @Override
+        public void atomicAdd(int index, long valueToAdd) {
+            final long address = addressOf(index);
+            long count;
+            do {
+                count = getLongVolatile(address);
+            } while (!compareAndSwapLong(address, count, count + valueToAdd));
+        }
+
+        @Override
+        public void lazySet(int index, long newValue) {
+            putOrderedLong(addressOf(index), newValue);
+        }
+
+        @Override
+        public int length() {
+            return length;
+        }
+
+        @Override
+        public int getEstimatedFootprintInBytes() {
+            return 256 + (8 * length);
+        }
+
+        private void writeObject(final ObjectOutputStream o)
+                throws IOException {
+            o.defaultWriteObject();
+            for (int i = 0; i < length; i++) {
+                o.writeLong(get(i));
+            }
+        }
+
+        private void readObject(final ObjectInputStream o)
+                throws IOException, ClassNotFoundException {
+            o.defaultReadObject();
+            if (!DIRECT_MEMORY_ACCESS_AVAILABLE) {
+                throw new InvalidObjectException("direct counts memory access is not available on this JVM");
+            }
+            allocateCounts();
+            for (int i = 0; i < length; i++) {
+                lazySet(i, o.readLong());
+            }
+        }
+    }
+}
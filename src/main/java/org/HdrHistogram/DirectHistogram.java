@@ -0,0 +1,323 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.IOException;
+import java.io.ObjectInputStream;
+import java.io.ObjectOutputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.zip.DataFormatException;
+
+/**
+ * <h3>A High Dynamic Range (HDR) Histogram that keeps its counts off-heap</h3>
+ * <p>
+ * {@link DirectHistogram} supports the recording and analyzing sampled data value counts across a configurable
+ * integer value range with configurable value precision within the range. Value precision is expressed as the
+ * number of significant digits in the value recording, and provides control over value quantization behavior
+ * across the value range and the subsequent value resolution at any given level.
+ * <p>
+ * {@link DirectHistogram} tracks value counts as <b><code>long</code></b> counts in a direct {@link ByteBuffer},
+ * outside of the Java heap, such that large histograms do not add to the work of garbage collectors (which
+ * would otherwise scan and copy their counts arrays).
+ * <p>
+ * A {@link DirectHistogram} may also be constructed to keep its counts in a caller-provided buffer (e.g. a
+ * {@link java.nio.MappedByteBuffer} mapped from a file), such that other processes can read its live contents
+ * without serialization. The layout of the counts in the buffer is stable: The count at (normalized) counts
+ * index <code>i</code> is stored as a native byte order <code>long</code> at offset <code>8 * i</code> from the
+ * buffer's position at construction time, for {@link #getCountsBufferCapacity} bytes. Histograms whose contents
+ * are not shifted (e.g. histograms not used as internal storage of a {@link DoubleHistogram}) store the count
+ * at counts index <code>i</code> at normalized index <code>i</code>. Histograms that use a caller-provided buffer
+ * cannot be resized, and are not auto-resizing.
+ * <p>
+ * Auto-resizing: When constructed with no specified value range range (or when auto-resize is turned on with {@link
+ * Histogram#setAutoResize}) a {@link DirectHistogram} will auto-resize its dynamic range to include recorded values as
+ * they are encountered. Note that recording calls that cause auto-resizing may take longer to execute, as resizing
+ * incurs allocation and copying of internal data structures.
+ * <p>
+ * See package description for {@link org.HdrHistogram} for details.
+ */
+
+public class DirectHistogram extends Histogram {
+    transient ByteBuffer countsBuffer;
+    private boolean useCallerProvidedCountsBuffer;
+
+    @Override
+    long getCountAtIndex(final int index) {
+        return getCountAtNormalizedIndex(normalizeIndex(index, normalizingIndexOffset, countsArrayLength));
+    }
+
+    @Override
+    long getCountAtNormalizedIndex(final int index) {
+        return countsBuffer.getLong(byteOffsetOf(index));
+    }
+
+    @Override
+    void incrementCountAtIndex(final int index) {
+        final int byteOffset = byteOffsetOf(normalizeIndex(index, normalizingIndexOffset, countsArrayLength));
+        countsBuffer.putLong(byteOffset, countsBuffer.getLong(byteOffset) + 1);
+    }
+
+    @Override
+    void addToCountAtIndex(final int index, final long value) {
+        final int byteOffset = byteOffsetOf(normalizeIndex(index, normalizingIndexOffset, countsArrayLength));
+        countsBuffer.putLong(byteOffset, countsBuffer.getLong(byteOffset) + value);
+    }
+
+    @Override
+    void setCountAtIndex(int index, long value) {
+        setCountAtNormalizedIndex(normalizeIndex(index, normalizingIndexOffset, countsArrayLength), value);
+    }
+
+    @Override
+    void setCountAtNormalizedIndex(int index, long value) {
+        countsBuffer.putLong(byteOffsetOf(index), value);
+    }
+
+    private int byteOffsetOf(final int normalizedIndex) {
+        // Report out of range indexes the way a counts array would:
+        if ((normalizedIndex < 0) || (normalizedIndex >= countsArrayLength)) {
+            throw new ArrayIndexOutOfBoundsException("index " + normalizedIndex + " out of counts range");
+        }
+        return normalizedIndex << 3;
+    }
+
+    @Override
+    void clearCounts() {
+        for (int i = 0; i < countsArrayLength; i++) {
+            countsBuffer.putLong(i << 3, 0);
+        }
+        totalCount = 0;
+    }
+
+    /**
+     * Get the (read-only) counts buffer of this histogram. Count at normalized index <code>i</code> is held as a
+     * native byte order <code>long</code> at offset <code>8 * i</code> in the buffer. Note that the returned buffer
+     * will no longer reflect the histogram's counts if the histogram is subsequently resized.
+     *
+     * @return a read-only view of the histogram's counts buffer
+     */
+    public ByteBuffer getCountsBuffer() {
+        return countsBuffer.asReadOnlyBuffer().order(ByteOrder.nativeOrder());
+    }
+
+    /**
+     * Get the number of bytes of counts buffer needed by a {@link DirectHistogram} of the given configuration,
+     * e.g. for sizing a caller-provided buffer to construct it with.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     * @param highestTrackableValue The highest value to be tracked by the histogram.
+     * @param numberOfSignificantValueDigits The number of significant decimal digits of precision.
+     * @return the number of bytes of counts buffer needed
+     */
+    public static int getCountsBufferCapacity(final long lowestDiscernibleValue, final long highestTrackableValue,
+                                              final int numberOfSignificantValueDigits) {
+        // Establish the configuration's counts array length without allocating any counts:
+        return new Histogram(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits,
+                false).countsArrayLength << 3;
+    }
+
+    private static ByteBuffer allocateCountsBuffer(final int countsArrayLength) {
+        if (countsArrayLength > (Integer.MAX_VALUE >> 3)) {
+            throw new IllegalArgumentException("counts array length " + countsArrayLength +
+                    " too large for a single direct buffer");
+        }
+        return ByteBuffer.allocateDirect(countsArrayLength << 3).order(ByteOrder.nativeOrder());
+    }
+
+    @Override
+    public void setAutoResize(boolean autoResize) {
+        if (autoResize && useCallerProvidedCountsBuffer) {
+            throw new IllegalStateException(
+                    "DirectHistogram with a caller-provided counts buffer does not support AutoResize operation.");
+        }
+        super.setAutoResize(autoResize);
+    }
+
+    @Override
+    public DirectHistogram copy() {
+        DirectHistogram copy = new DirectHistogram(this);
+        copy.add(this);
+        return copy;
+    }
+
+    @Override
+    public DirectHistogram copyCorrectedForCoordinatedOmission(final long expectedIntervalBetweenValueSamples) {
+        DirectHistogram toHistogram = new DirectHistogram(this);
+        toHistogram.addWhileCorrectingForCoordinatedOmission(this, expectedIntervalBetweenValueSamples);
+        return toHistogram;
+    }
+
+    @Override
+    void resize(long newHighestTrackableValue) {
+        if (useCallerProvidedCountsBuffer) {
+            throw new IllegalStateException(
+                    "DirectHistogram with a caller-provided counts buffer does not support resizing operations.");
+        }
+        final int oldNormalizedZeroIndex = normalizeIndex(0, normalizingIndexOffset, countsArrayLength);
+        final int oldCountsArrayLength = countsArrayLength;
+        final ByteBuffer oldCountsBuffer = countsBuffer;
+
+        establishSize(newHighestTrackableValue);
+
+        final int countsDelta = countsArrayLength - oldCountsArrayLength;
+
+        // A newly allocated direct buffer is zeroed, so only the old counts need to be copied over. We need
+        // to shift the stuff from the zero index and up to the end of the old range by the change in length:
+        countsBuffer = allocateCountsBuffer(countsArrayLength);
+        for (int fromIndex = 0; fromIndex < oldCountsArrayLength; fromIndex++) {
+            final int toIndex = ((oldNormalizedZeroIndex == 0) || (fromIndex < oldNormalizedZeroIndex)) ?
+                    fromIndex : fromIndex + countsDelta;
+            countsBuffer.putLong(toIndex << 3, oldCountsBuffer.getLong(fromIndex << 3));
+        }
+    }
+
+    @Override
+    int _getEstimatedFootprintInBytes() {
+        return (512 + (8 * countsArrayLength));
+    }
+
+    /**
+     * Construct an auto-resizing DirectHistogram with a lowest discernible value of 1 and an auto-adjusting
+     * highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
+     *
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public DirectHistogram(final int numberOfSignificantValueDigits) {
+        this(1, 2, numberOfSignificantValueDigits);
+        setAutoResize(true);
+    }
+
+    /**
+     * Construct a DirectHistogram given the Highest value to be tracked and a number of significant decimal digits.
+     * The histogram will be constructed to implicitly track (distinguish from 0) values as low as 1.
+     *
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} 2.
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public DirectHistogram(final long highestTrackableValue, final int numberOfSignificantValueDigits) {
+        this(1, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a DirectHistogram given the Lowest and Highest values to be tracked and a number of significant
+     * decimal digits. Providing a lowestDiscernibleValue is useful is situations where the units used
+     * for the histogram's values are much smaller that the minimal accuracy required. E.g. when tracking
+     * time values stated in nanosecond units, where the minimal accuracy required is a microsecond, the
+     * proper value for lowestDiscernibleValue would be 1000.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public DirectHistogram(final long lowestDiscernibleValue, final long highestTrackableValue,
+                           final int numberOfSignificantValueDigits) {
+        super(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits, false);
+        countsBuffer = allocateCountsBuffer(countsArrayLength);
+        wordSizeInBytes = 8;
+    }
+
+    /**
+     * Construct a DirectHistogram given the Lowest and Highest values to be tracked and a number of significant
+     * decimal digits, which keeps its counts in the given caller-provided buffer. The buffer's contents (from its
+     * current position, for {@link #getCountsBufferCapacity} bytes) are used as the histogram's initial counts,
+     * allowing a histogram to be re-attached to a previously populated buffer (e.g. one mapped from a file).
+     * The histogram's total count, min and max values are established from the buffer's contents.
+     * The resulting histogram is not auto-resizing and cannot be resized.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     * @param countsBuffer The buffer to keep the histogram's counts in
+     * @throws IllegalArgumentException if the buffer has fewer than {@link #getCountsBufferCapacity} bytes remaining
+     */
+    public DirectHistogram(final long lowestDiscernibleValue, final long highestTrackableValue,
+                           final int numberOfSignificantValueDigits, final ByteBuffer countsBuffer) {
+        super(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits, false);
+        final int countsBufferCapacity = countsArrayLength << 3;
+        if (countsBuffer.remaining() < countsBufferCapacity) {
+            throw new IllegalArgumentException("counts buffer has " + countsBuffer.remaining() +
+                    " bytes remaining, and needs at least " + countsBufferCapacity);
+        }
+        final ByteBuffer countsView = countsBuffer.duplicate();
+        countsView.limit(countsView.position() + countsBufferCapacity);
+        this.countsBuffer = countsView.slice().order(ByteOrder.nativeOrder());
+        useCallerProvidedCountsBuffer = true;
+        wordSizeInBytes = 8;
+        establishInternalTackingValues();
+    }
+
+    /**
+     * Construct a DirectHistogram with the same range settings as a given source histogram,
+     * duplicating the source's start/end timestamps (but NOT it's contents)
+     * @param source The source histogram to duplicate
+     */
+    public DirectHistogram(final AbstractHistogram source) {
+        super(source, false);
+        countsBuffer = allocateCountsBuffer(countsArrayLength);
+        wordSizeInBytes = 8;
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     */
+    public static DirectHistogram decodeFromByteBuffer(final ByteBuffer buffer,
+                                                       final long minBarForHighestTrackableValue) {
+        return decodeFromByteBuffer(buffer, DirectHistogram.class, minBarForHighestTrackableValue);
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a compressed form in a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     * @throws DataFormatException on error parsing/decompressing the buffer
+     */
+    public static DirectHistogram decodeFromCompressedByteBuffer(final ByteBuffer buffer,
+                                                                 final long minBarForHighestTrackableValue)
+            throws DataFormatException {
+        return decodeFromCompressedByteBuffer(buffer, DirectHistogram.class, minBarForHighestTrackableValue);
+    }
+
+    private void writeObject(final ObjectOutputStream o)
+            throws IOException {
+        o.defaultWriteObject();
+        for (int i = 0; i < countsArrayLength; i++) {
+            o.writeLong(countsBuffer.getLong(i << 3));
+        }
+    }
+
+    private void readObject(final ObjectInputStream o)
+            throws IOException, ClassNotFoundException {
+        o.defaultReadObject();
+        // A deserialized histogram always keeps its counts in a newly allocated buffer:
+        useCallerProvidedCountsBuffer = false;
+        countsBuffer = allocateCountsBuffer(countsArrayLength);
+        for (int i = 0; i < countsArrayLength; i++) {
+            countsBuffer.putLong(i << 3, o.readLong());
+        }
+    }
+}
@@ -11,6 +11,7 @@ import java.io.*;
 import java.lang.reflect.Constructor;
 import java.lang.reflect.InvocationTargetException;
 import java.nio.ByteBuffer;
+import java.nio.DoubleBuffer;
 import java.util.Iterator;
 import java.util.zip.DataFormatException;
 import java.util.zip.Deflater;
@@ -65,6 +66,14 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
 
     private boolean autoResize = false;
 
+    int rangeHeadroomBinaryOrdersOfMagnitude = 0;
+
+    private static final int RECORD_VALUES_BATCH_LENGTH = 1024;
+
+    // Reused across recordValues(double[]...) calls, which are not thread-safe (or are synchronized) in all
+    // variants that use it:
+    private long[] convertedValuesBuffer = null;
+
     /**
      * Construct a new auto-resizing DoubleHistogram using a precision stated as a number
      * of significant decimal digits.
@@ -112,6 +121,42 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
         this(highestToLowestValueRatio, numberOfSignificantValueDigits, Histogram.class);
     }
 
+    /**
+     * Construct a new DoubleHistogram with the specified dynamic range (provided in
+     * {@code highestToLowestValueRatio}), using a precision stated as a number of significant
+     * decimal digits, and with range headroom stated as a number of binary orders of magnitude.
+     * <p>
+     * A histogram with range headroom covers an additional rangeHeadroomBinaryOrdersOfMagnitude binary orders of
+     * magnitude both below and above its specified dynamic range (its actual dynamic range, as reported by
+     * {@link #getHighestToLowestValueRatio()}, is highestToLowestValueRatio * 2^(2 * headroom)). The first value
+     * recorded into an empty histogram (whether below or above the currently covered range) places the
+     * covered range such that the value lands in its middle, at least rangeHeadroomBinaryOrdersOfMagnitude binary
+     * orders of magnitude away from either end. Values later recorded within the headroom (in either direction)
+     * are recorded without any auto-range adjustment, avoiding the shifting of already recorded counts (and the
+     * stalling of concurrent recorders) that extending the covered range would otherwise incur. Each binary order
+     * of magnitude of headroom adds roughly 2 * 10^numberOfSignificantValueDigits counts to the histogram's
+     * footprint.
+     * <p>
+     * The headroom is carried by copies, but is not part of the encoded (or serialized) form: a histogram
+     * decoded from an encoding keeps the widened dynamic range, but places its covered range (e.g. after a
+     * reset) without headroom.
+     *
+     * @param highestToLowestValueRatio specifies the dynamic range to use
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     * @param rangeHeadroomBinaryOrdersOfMagnitude The number of binary orders of magnitude of headroom to cover
+     *                                             below and above the specified dynamic range. Must be
+     *                                             non-negative.
+     */
+    public DoubleHistogram(final long highestToLowestValueRatio, final int numberOfSignificantValueDigits,
+                           final int rangeHeadroomBinaryOrdersOfMagnitude) {
+        this(deriveHighestToLowestValueRatioWithHeadroom(highestToLowestValueRatio,
+                        rangeHeadroomBinaryOrdersOfMagnitude),
+                numberOfSignificantValueDigits, Histogram.class);
+        this.rangeHeadroomBinaryOrdersOfMagnitude = rangeHeadroomBinaryOrdersOfMagnitude;
+    }
+
     /**
      * Construct a new DoubleHistogram with the specified dynamic range (provided in
      * {@code highestToLowestValueRatio}) and using a precision stated as a number of significant
@@ -233,9 +278,22 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
                 source.integerValuesHistogram,
                 true);
         this.autoResize = source.autoResize;
+        this.rangeHeadroomBinaryOrdersOfMagnitude = source.rangeHeadroomBinaryOrdersOfMagnitude;
         setTrackableValueRange(source.currentLowestValueInAutoRange, source.currentHighestValueLimitInAutoRange);
     }
 
+    static long deriveHighestToLowestValueRatioWithHeadroom(final long highestToLowestValueRatio,
+                                                            final int rangeHeadroomBinaryOrdersOfMagnitude) {
+        if ((rangeHeadroomBinaryOrdersOfMagnitude < 0) ||
+                ((highestToLowestValueRatio > 0) &&
+                        ((2 * rangeHeadroomBinaryOrdersOfMagnitude) >=
+                                Long.numberOfLeadingZeros(highestToLowestValueRatio)))) {
+            throw new IllegalArgumentException("rangeHeadroomBinaryOrdersOfMagnitude must be non-negative, and " +
+                    "highestToLowestValueRatio * 2^(2 * rangeHeadroomBinaryOrdersOfMagnitude) must be < 2^63");
+        }
+        return highestToLowestValueRatio << (2 * rangeHeadroomBinaryOrdersOfMagnitude);
+    }
+
     private void init(final long configuredHighestToLowestValueRatio, final double lowestTrackableUnitValue,
                       final AbstractHistogram integerValuesHistogram) {
         this.configuredHighestToLowestValueRatio = configuredHighestToLowestValueRatio;
@@ -270,6 +328,24 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
         this.autoResize = autoResize;
     }
 
+    /**
+     * Indicate whether or not the cumulative count index is enabled for this histogram.
+     * (see {@link AbstractHistogram#setCumulativeCountIndexEnabled}).
+     * @return true if the cumulative count index is enabled
+     */
+    public boolean isCumulativeCountIndexEnabled() {
+        return integerValuesHistogram.isCumulativeCountIndexEnabled();
+    }
+
+    /**
+     * Control whether or not the histogram will maintain a cumulative count index in support of value and
+     * percentile queries (see {@link AbstractHistogram#setCumulativeCountIndexEnabled}).
+     * @param enabled cumulative count index setting
+     */
+    public void setCumulativeCountIndexEnabled(final boolean enabled) {
+        integerValuesHistogram.setCumulativeCountIndexEnabled(enabled);
+    }
+
     //
     //
     //
@@ -328,6 +404,80 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
         recordValueWithCountAndExpectedInterval(value, 1, expectedIntervalBetweenValueSamples);
     }
 
+    /**
+     * Record a batch of values in the histogram. Equivalent to recording each of the values with
+     * {@link #recordValue(double)}, but values that fall within the current auto range are converted and
+     * recorded in batches (see {@link AbstractHistogram#recordValues(long[], int, int)}).
+     *
+     * @param values The array containing the values to be recorded
+     * @param offset The offset in the array of the first value to be recorded
+     * @param length The number of values to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value cannot be covered by the histogram's range
+     */
+    @Override
+    public void recordValues(final double[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        if ((offset < 0) || (length < 0) || (offset > values.length - length)) {
+            throw new IndexOutOfBoundsException("offset " + offset + " and length " + length +
+                    " out of bounds for values array of length " + values.length);
+        }
+        if (convertedValuesBuffer == null) {
+            convertedValuesBuffer = new long[RECORD_VALUES_BATCH_LENGTH];
+        }
+        final long[] convertedValues = convertedValuesBuffer;
+        for (int batchOffset = offset; batchOffset < offset + length; batchOffset += convertedValues.length) {
+            final int batchLength = Math.min(offset + length - batchOffset, convertedValues.length);
+            if (!recordValuesInCurrentAutoRange(values, batchOffset, batchLength, convertedValues)) {
+                // Some values in the batch fall outside of the current auto range. Record them individually,
+                // auto-adjusting the range as needed:
+                for (int i = batchOffset; i < batchOffset + batchLength; i++) {
+                    recordSingleValue(values[i]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Record a batch of values in the histogram, consisting of the values remaining in a buffer. Equivalent to
+     * {@link #recordValues(double[], int, int)}. The buffer's position is advanced to its limit.
+     *
+     * @param values The buffer containing the values to be recorded (from its position to its limit)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value cannot be covered by the histogram's range
+     */
+    @Override
+    public void recordValues(final DoubleBuffer values) throws ArrayIndexOutOfBoundsException {
+        if (values.hasArray()) {
+            recordValues(values.array(), values.arrayOffset() + values.position(), values.remaining());
+            values.position(values.limit());
+            return;
+        }
+        final double[] batch = new double[Math.min(values.remaining(), RECORD_VALUES_BATCH_LENGTH)];
+        while (values.hasRemaining()) {
+            final int batchLength = Math.min(values.remaining(), batch.length);
+            values.get(batch, 0, batchLength);
+            recordValues(batch, 0, batchLength);
+        }
+    }
+
+    private boolean recordValuesInCurrentAutoRange(final double[] values, final int offset, final int length,
+                                                   final long[] convertedValues) {
+        final double lowestValueInAutoRange = currentLowestValueInAutoRange;
+        final double highestValueLimitInAutoRange = currentHighestValueLimitInAutoRange;
+        for (int i = offset; i < offset + length; i++) {
+            final double value = values[i];
+            if (((value < lowestValueInAutoRange) && (value != 0.0)) || (value >= highestValueLimitInAutoRange)) {
+                return false;
+            }
+        }
+        final double doubleToIntegerValueConversionRatio =
+                integerValuesHistogram.getDoubleToIntegerValueConversionRatio();
+        for (int i = 0; i < length; i++) {
+            convertedValues[i] = (long) (values[offset + i] * doubleToIntegerValueConversionRatio);
+        }
+        integerValuesHistogram.recordValues(convertedValues, 0, length);
+        return true;
+    }
+
     private void recordCountAtValue(final long count, final double value) throws ArrayIndexOutOfBoundsException {
         int throwCount = 0;
         while (true) {
@@ -413,6 +563,10 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
 
     private synchronized void autoAdjustRangeForValueSlowPath(final double value) {
         try {
+            // The first non-zero value recorded into the histogram places the covered range (recorded zero
+            // values are unaffected by shifts of the covered range):
+            final boolean placingCoveredRange = (rangeHeadroomBinaryOrdersOfMagnitude > 0) &&
+                    (integerValuesHistogram.getMaxValue() == 0);
             if (value < currentLowestValueInAutoRange) {
                 if (value < 0.0) {
                     throw new ArrayIndexOutOfBoundsException("Negative values cannot be recorded");
@@ -424,6 +578,9 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
                     shiftCoveredRangeToTheRight(shiftAmount);
                 }
                 while (value < currentLowestValueInAutoRange);
+                if (placingCoveredRange) {
+                    centerCoveredRangeOnValue(value);
+                }
             } else if (value >= currentHighestValueLimitInAutoRange) {
                 if (value > highestAllowedValueEver) {
                     throw new ArrayIndexOutOfBoundsException(
@@ -440,6 +597,9 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
                     shiftCoveredRangeToTheLeft(shiftAmount);
                 }
                 while (value >= currentHighestValueLimitInAutoRange);
+                if (placingCoveredRange) {
+                    centerCoveredRangeOnValue(value);
+                }
             }
         } catch (ArrayIndexOutOfBoundsException ex) {
             throw new ArrayIndexOutOfBoundsException("The value " + value +
@@ -450,6 +610,27 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
         }
     }
 
+    // Shift the covered range such that the value lands in its middle, leaving (at least) the range headroom
+    // both below and above the value. Only used while no non-zero values are recorded, so no counts are shifted:
+    private void centerCoveredRangeOnValue(final double value) {
+        final int binaryOrdersOfMagnitudeAboveLowest = Math.getExponent(value / currentLowestValueInAutoRange);
+        final int binaryOrdersOfMagnitudeToMiddle =
+                Math.getExponent(currentHighestValueLimitInAutoRange / currentLowestValueInAutoRange) / 2;
+        int shiftAmount = binaryOrdersOfMagnitudeToMiddle - binaryOrdersOfMagnitudeAboveLowest;
+        if (shiftAmount > 0) {
+            shiftCoveredRangeToTheRight(shiftAmount);
+        } else if (shiftAmount < 0) {
+            // Do not shift the covered range beyond the highest allowed value:
+            while ((shiftAmount < 0) &&
+                    (currentHighestValueLimitInAutoRange * Math.pow(2.0, -shiftAmount) > highestAllowedValueEver)) {
+                shiftAmount++;
+            }
+            if (shiftAmount < 0) {
+                shiftCoveredRangeToTheLeft(-shiftAmount);
+            }
+        }
+    }
+
     private void shiftCoveredRangeToTheRight(final int numberOfBinaryOrdersOfMagnitude) {
         // We are going to adjust the tracked range by effectively shifting it to the right
         // (in the integer shift sense).
@@ -628,6 +809,7 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
     public DoubleHistogram copy() {
         final DoubleHistogram targetHistogram =
                 new DoubleHistogram(configuredHighestToLowestValueRatio, getNumberOfSignificantValueDigits());
+        targetHistogram.rangeHeadroomBinaryOrdersOfMagnitude = rangeHeadroomBinaryOrdersOfMagnitude;
         targetHistogram.setTrackableValueRange(currentLowestValueInAutoRange, currentHighestValueLimitInAutoRange);
         integerValuesHistogram.copyInto(targetHistogram.integerValuesHistogram);
         return targetHistogram;
@@ -658,6 +840,7 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
     public DoubleHistogram copyCorrectedForCoordinatedOmission(final double expectedIntervalBetweenValueSamples) {
         final DoubleHistogram targetHistogram =
                 new DoubleHistogram(configuredHighestToLowestValueRatio, getNumberOfSignificantValueDigits());
+        targetHistogram.rangeHeadroomBinaryOrdersOfMagnitude = rangeHeadroomBinaryOrdersOfMagnitude;
         targetHistogram.setTrackableValueRange(currentLowestValueInAutoRange, currentHighestValueLimitInAutoRange);
         targetHistogram.addWhileCorrectingForCoordinatedOmission(this, expectedIntervalBetweenValueSamples);
         return targetHistogram;
@@ -1109,6 +1292,24 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
         return integerValuesHistogram.getValueAtPercentile(percentile) * getIntegerToDoubleValueConversionRatio();
     }
 
+    /**
+     * Get the values at a given set of percentiles, in a single pass over the histogram's counts.
+     * <p>
+     * valuesAtPercentiles[i] will be set to the value that {@link #getValueAtPercentile}
+     * would return for sortedPercentiles[i]. The percentiles must be provided in ascending order.
+     * No allocation is performed.
+     *
+     * @param sortedPercentiles The percentiles for which to return the associated values, in ascending order
+     * @param valuesAtPercentiles The array to fill with the values at the requested percentiles. Must be at
+     *                            least as long as sortedPercentiles.
+     * @throws IllegalArgumentException if sortedPercentiles is not sorted in ascending order, or if
+     * valuesAtPercentiles is shorter than sortedPercentiles
+     */
+    public void getValuesAtPercentiles(final double[] sortedPercentiles, final double[] valuesAtPercentiles) {
+        integerValuesHistogram.getValuesAtPercentiles(sortedPercentiles, null, valuesAtPercentiles,
+                getIntegerToDoubleValueConversionRatio());
+    }
+
     /**
      * Get the percentile at a given value.
      * The percentile returned is the percentile of values recorded in the histogram that are smaller
@@ -1513,6 +1714,36 @@ public class DoubleHistogram extends EncodableHistogram implements DoubleValueRe
         return encodeIntoCompressedByteBuffer(targetBuffer, Deflater.DEFAULT_COMPRESSION);
     }
 
+    /**
+     * Encode this histogram in compressed form into a byte array, using the given compression codec.
+     * See {@link AbstractHistogram#encodeIntoCompressedByteBuffer(ByteBuffer, HistogramCompressionCodec, int)}.
+     * @param targetBuffer The buffer to encode into
+     * @param codec The compression codec to use
+     * @param compressionLevel Compression level (codec specific, e.g. for java.util.zip.Deflater).
+     * @return The number of bytes written to the buffer
+     */
+    @Override
+    synchronized public int encodeIntoCompressedByteBuffer(
+            final ByteBuffer targetBuffer,
+            final HistogramCompressionCodec codec,
+            final int compressionLevel) {
+        targetBuffer.putInt(DHIST_compressedEncodingCookie);
+        targetBuffer.putInt(getNumberOfSignificantValueDigits());
+        targetBuffer.putLong(configuredHighestToLowestValueRatio);
+        return integerValuesHistogram.encodeIntoCompressedByteBuffer(targetBuffer, codec, compressionLevel) + 16;
+    }
+
+    /**
+     * Get the capacity needed to encode this histogram in compressed form, using the given compression codec,
+     * into a ByteBuffer
+     * @param codec The compression codec to be used
+     * @return the capacity needed to encode this histogram in compressed form into a ByteBuffer
+     */
+    @Override
+    public int getNeededCompressedByteBufferCapacity(final HistogramCompressionCodec codec) {
+        return integerValuesHistogram.getNeededCompressedByteBufferCapacity(codec) + 16;
+    }
+
     private static final Class[] constructorArgTypes = {long.class, int.class, Class.class, AbstractHistogram.class};
 
     static <T extends DoubleHistogram> T constructHistogramFromBuffer(
@@ -22,6 +22,34 @@ public abstract class EncodableHistogram {
 
     public abstract int encodeIntoCompressedByteBuffer(final ByteBuffer targetBuffer, int compressionLevel);
 
+    /**
+     * Encode this histogram in compressed form into a byte array, using the given compression codec.
+     * <p>
+     * Histogram classes that do not support compression codecs (e.g. those written ahead of their
+     * introduction) encode in {@link HistogramCompressionCodecs#DEFLATE} compressed form regardless of
+     * the given codec, which decodes wherever the codec's encodings would.
+     *
+     * @param targetBuffer The buffer to encode into
+     * @param codec The compression codec to use
+     * @param compressionLevel Compression level (codec specific, e.g. for java.util.zip.Deflater).
+     * @return The number of bytes written to the buffer
+     */
+    public int encodeIntoCompressedByteBuffer(final ByteBuffer targetBuffer,
+                                              final HistogramCompressionCodec codec,
+                                              final int compressionLevel) {
+        return encodeIntoCompressedByteBuffer(targetBuffer, compressionLevel);
+    }
+
+    /**
+     * Get the capacity needed to encode this histogram in compressed form, using the given compression codec,
+     * into a ByteBuffer (see {@link #encodeIntoCompressedByteBuffer(ByteBuffer, HistogramCompressionCodec, int)}).
+     * @param codec The compression codec to be used
+     * @return the capacity needed to encode this histogram in compressed form into a ByteBuffer
+     */
+    public int getNeededCompressedByteBufferCapacity(final HistogramCompressionCodec codec) {
+        return getNeededByteBufferCapacity();
+    }
+
     public abstract long getStartTimeStamp();
 
     public abstract void setStartTimeStamp(long startTimeStamp);
@@ -0,0 +1,67 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.math.BigDecimal;
+import java.math.RoundingMode;
+
+/**
+ * Appends fixed point representations of values to a {@link StringBuilder}, producing the exact same text as
+ * the "%{width}.{decimalPlaces}f" {@link java.util.Formatter} conversion (in {@link java.util.Locale#US}) does,
+ * without the cost of parsing a format string and boxing the value.
+ */
+class FixedPointFormat {
+
+    /**
+     * Append a value the way the "%{width}.{decimalPlaces}f" {@link java.util.Formatter} conversion does: rounded
+     * (half up) from the value's shortest decimal representation, and right justified within width.
+     *
+     * @param output The builder to append to
+     * @param value The value to append
+     * @param decimalPlaces The number of digits to append after the decimal point
+     * @param width The minimal width (padded with leading spaces) of the appended text
+     */
+    static void append(final StringBuilder output, double value, final int decimalPlaces, final int width) {
+        final int start = output.length();
+        if (Double.isNaN(value) || Double.isInfinite(value)) {
+            output.append(value);
+        } else {
+            if (Double.doubleToRawLongBits(value) < 0) {
+                // Includes -0.0, which the Formatter also outputs with a sign:
+                output.append('-');
+                value = -value;
+            }
+            if ((value < (1L << 53)) && (value == Math.rint(value))) {
+                // Integral values (the common case for unscaled values) need no rounding:
+                output.append((long) value);
+                if (decimalPlaces > 0) {
+                    output.append('.');
+                    for (int i = 0; i < decimalPlaces; i++) {
+                        output.append('0');
+                    }
+                }
+            } else {
+                output.append(BigDecimal.valueOf(value).setScale(decimalPlaces, RoundingMode.HALF_UP).toPlainString());
+            }
+        }
+        padTo(output, start, width);
+    }
+
+    /**
+     * Right justify the text appended to output since start within width, by inserting leading spaces
+     *
+     * @param output The builder holding the text
+     * @param start The position in output at which the text to justify starts
+     * @param width The width to justify the text within
+     */
+    static void padTo(final StringBuilder output, final int start, final int width) {
+        for (int length = output.length() - start; length < width; length++) {
+            output.insert(start, ' ');
+        }
+    }
+}
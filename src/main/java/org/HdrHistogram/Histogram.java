@@ -100,10 +100,132 @@ public class Histogram extends AbstractHistogram {
 
     @Override
     void clearCounts() {
-        java.util.Arrays.fill(counts, 0);
+        // Only the populated span of the counts array can hold non-zero counts:
+        final int fromIndex = normalizeIndex(getLowestPopulatedIndex(), normalizingIndexOffset, countsArrayLength);
+        final int toIndex = normalizeIndex(getHighestPopulatedIndex(), normalizingIndexOffset, countsArrayLength);
+        if (fromIndex <= toIndex) {
+            java.util.Arrays.fill(counts, fromIndex, toIndex + 1, 0);
+        } else {
+            // The span wraps around the end of the (normalized) counts array:
+            java.util.Arrays.fill(counts, fromIndex, countsArrayLength, 0);
+            java.util.Arrays.fill(counts, 0, toIndex + 1, 0);
+        }
         totalCount = 0;
     }
 
+    @Override
+    int setCountsFromDecodedWords(final long[] words, final int wordCount, int dstIndex) {
+        if ((counts == null) || (normalizingIndexOffset != 0)) {
+            return super.setCountsFromDecodedWords(words, wordCount, dstIndex);
+        }
+        // Without normalization, counts indexes are counts array indexes. The (validated) counts fit the array:
+        final long[] counts = this.counts;
+        for (int i = 0; i < wordCount; i++) {
+            final long count = words[i];
+            if (count < 0) {
+                dstIndex += (int) -count;
+            } else {
+                counts[dstIndex++] = count;
+            }
+        }
+        return dstIndex;
+    }
+
+    @Override
+    int incrementCountsAtValues(final long[] values, final int offset, final int length) {
+        if (counts == null) {
+            return super.incrementCountsAtValues(values, offset, length);
+        }
+        final long[] counts = this.counts;
+        final int normalizingIndexOffset = this.normalizingIndexOffset;
+        final int countsArrayLength = this.countsArrayLength;
+        for (int i = 0; i < length; i++) {
+            final long value = values[offset + i];
+            if (value < 0) {
+                return i;
+            }
+            final int index = countsArrayIndex(value);
+            if (index >= countsArrayLength) {
+                return i;
+            }
+            counts[normalizeIndex(index, normalizingIndexOffset, countsArrayLength)]++;
+        }
+        return length;
+    }
+
+    @Override
+    long addCountsArrayDirectly(final AbstractHistogram otherHistogram) {
+        if ((counts != null) && (otherHistogram instanceof PackedHistogram)) {
+            // Matching layouts share the normalizing index offset, so the packed (normalized) indexes
+            // are our counts array indexes:
+            return ((PackedHistogram) otherHistogram).addNonZeroCountsInto(counts);
+        }
+        if ((counts == null) || !(otherHistogram instanceof Histogram) ||
+                (((Histogram) otherHistogram).counts == null)) {
+            return -1;
+        }
+        final long[] otherCounts = ((Histogram) otherHistogram).counts;
+        // Only the other histogram's populated span can hold non-zero counts. With matching layouts, both
+        // histograms keep each (logical) index at the same (normalized) counts array location:
+        final int highestPopulatedIndex = otherHistogram.getHighestPopulatedIndex();
+        long observedOtherTotalCount = 0;
+        int normalizedIndex = normalizeIndex(otherHistogram.getLowestPopulatedIndex(),
+                normalizingIndexOffset, countsArrayLength);
+        for (int index = otherHistogram.getLowestPopulatedIndex(); index <= highestPopulatedIndex; index++) {
+            final long otherCount = otherCounts[normalizedIndex];
+            counts[normalizedIndex] += otherCount;
+            observedOtherTotalCount += otherCount;
+            if (++normalizedIndex == countsArrayLength) {
+                normalizedIndex = 0;
+            }
+        }
+        return observedOtherTotalCount;
+    }
+
+    @Override
+    boolean subtractCountsArrayDirectly(final AbstractHistogram otherHistogram) {
+        if ((counts == null) || !(otherHistogram instanceof Histogram) ||
+                (((Histogram) otherHistogram).counts == null)) {
+            return false;
+        }
+        final long[] otherCounts = ((Histogram) otherHistogram).counts;
+        final int otherHighestPopulatedIndex = otherHistogram.getHighestPopulatedIndex();
+        int normalizedIndex = normalizeIndex(otherHistogram.getLowestPopulatedIndex(),
+                normalizingIndexOffset, countsArrayLength);
+        for (int index = otherHistogram.getLowestPopulatedIndex(); index <= otherHighestPopulatedIndex; index++) {
+            if (counts[normalizedIndex] < otherCounts[normalizedIndex]) {
+                // Leave it to the caller's per-value path to report the offending value:
+                return false;
+            }
+            if (++normalizedIndex == countsArrayLength) {
+                normalizedIndex = 0;
+            }
+        }
+        // Walk this histogram's populated span (which covers all of the other's non-zero counts once the check
+        // above has passed) in logical index order, such that the total count and min/max indexes are derived
+        // in the same pass:
+        final int highestPopulatedIndex = getHighestPopulatedIndex();
+        long observedTotalCount = 0;
+        int minNonZeroIndex = -1;
+        int maxIndex = -1;
+        normalizedIndex = normalizeIndex(getLowestPopulatedIndex(), normalizingIndexOffset, countsArrayLength);
+        for (int index = getLowestPopulatedIndex(); index <= highestPopulatedIndex; index++) {
+            final long countAtIndex = (counts[normalizedIndex] -= otherCounts[normalizedIndex]);
+            if (countAtIndex > 0) {
+                observedTotalCount += countAtIndex;
+                maxIndex = index;
+                if ((minNonZeroIndex == -1) && (index != 0)) {
+                    minNonZeroIndex = index;
+                }
+            }
+            if (++normalizedIndex == countsArrayLength) {
+                normalizedIndex = 0;
+            }
+        }
+        establishInternalTackingValues(observedTotalCount, minNonZeroIndex, maxIndex);
+        return true;
+    }
+
     @Override
     public Histogram copy() {
         Histogram copy = new Histogram(this);
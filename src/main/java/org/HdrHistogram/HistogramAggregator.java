@@ -0,0 +1,144 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.ByteBuffer;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.zip.DataFormatException;
+
+/**
+ * Aggregates the interval histograms of many sources, as encoded by each source's {@link HistogramDeltaEncoder},
+ * into a single interval histogram. Aggregators can be arranged in a tree: an intermediate aggregator encodes
+ * each of its aggregated intervals with its own {@link HistogramDeltaEncoder}, for aggregation by its parent,
+ * such that no single aggregator decodes (or receives) the encodings of all sources.
+ * <p>
+ * Each source's encodings are decoded by a {@link HistogramDeltaDecoder} of its own (identified by the source's
+ * id), such that the encodings of different sources can be decoded in parallel (e.g. from multiple network
+ * threads). Only the addition of each decoded interval into the aggregated interval is serialized.
+ * <p>
+ * A common pattern for using an intermediate {@link HistogramAggregator} looks like this:
+ * <br><pre><code>
+ * HistogramAggregator aggregator = new HistogramAggregator(3);
+ * HistogramDeltaEncoder encoder = new HistogramDeltaEncoder();
+ * Histogram aggregatedInterval = null;
+ * ...
+ * [on receiving an encoded interval from a source:]
+ *   aggregator.addEncodedInterval(sourceId, receivedBuffer);
+ * ...
+ * [every interval:]
+ *   aggregatedInterval = aggregator.getAggregatedIntervalHistogram(aggregatedInterval);
+ *   buffer.clear();
+ *   encoder.encodeIntoCompressedByteBuffer(aggregatedInterval, buffer);
+ *   [send the buffer's contents to the parent aggregator]
+ * </code></pre>
+ */
+public class HistogramAggregator {
+    private final ConcurrentHashMap<String, HistogramDeltaDecoder> decoders = new ConcurrentHashMap<>();
+    private Histogram aggregatedHistogram;
+
+    /**
+     * Construct an auto-resizing {@link HistogramAggregator} with a lowest discernible value of 1 and an
+     * auto-adjusting highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
+     *
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public HistogramAggregator(final int numberOfSignificantValueDigits) {
+        aggregatedHistogram = new Histogram(numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a {@link HistogramAggregator} given the Lowest and highest values to be tracked and a number
+     * of significant decimal digits.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public HistogramAggregator(final long lowestDiscernibleValue,
+                               final long highestTrackableValue,
+                               final int numberOfSignificantValueDigits) {
+        aggregatedHistogram = new Histogram(lowestDiscernibleValue, highestTrackableValue,
+                numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Decode an encoded interval of a source (see {@link HistogramDeltaDecoder#decodeFromCompressedByteBuffer}),
+     * and add it to the aggregated interval. Encoded intervals of different sources may be added concurrently.
+     *
+     * @param sourceId The id of the source that encoded the interval
+     * @param buffer The buffer to decode from (starting at its current position)
+     * @throws DataFormatException on errors in decoding the buffer compression
+     * @throws IllegalArgumentException if the buffer does not contain a compressed delta encoding
+     * @throws IllegalStateException if the encoding is a delta from an interval of the source other than the
+     * last one decoded (in which case the source's next encoding must be a full one)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if values in the interval are higher than the
+     * aggregated interval's highestTrackableValue (for aggregators that do not auto-resize)
+     */
+    public void addEncodedInterval(final String sourceId, final ByteBuffer buffer) throws DataFormatException {
+        HistogramDeltaDecoder decoder = decoders.get(sourceId);
+        if (decoder == null) {
+            final HistogramDeltaDecoder newDecoder = new HistogramDeltaDecoder();
+            decoder = decoders.putIfAbsent(sourceId, newDecoder);
+            if (decoder == null) {
+                decoder = newDecoder;
+            }
+        }
+        // The decoded interval is retained by (and only modified under the lock of) its decoder:
+        synchronized (decoder) {
+            final Histogram intervalHistogram = decoder.decodeFromCompressedByteBuffer(buffer);
+            synchronized (this) {
+                aggregatedHistogram.add(intervalHistogram);
+            }
+        }
+    }
+
+    /**
+     * Forget a source, e.g. once it is known to have stopped. The next encoded interval of a source with the
+     * same id must be a full one.
+     *
+     * @param sourceId The id of the source to forget
+     */
+    public void removeSource(final String sourceId) {
+        decoders.remove(sourceId);
+    }
+
+    /**
+     * Get the number of sources whose encoded intervals have been added (and that have not been removed)
+     * @return the number of sources
+     */
+    public int getSourceCount() {
+        return decoders.size();
+    }
+
+    /**
+     * Get the interval histogram aggregated from the encoded intervals added since the previous call (or since
+     * the construction of this aggregator), and start a new aggregated interval. The aggregated interval is
+     * copied into the histogram to recycle if one is provided.
+     *
+     * @param histogramToRecycle a previously returned histogram to copy the aggregated interval into (may be null)
+     * @return the aggregated interval histogram
+     */
+    public synchronized Histogram getAggregatedIntervalHistogram(final Histogram histogramToRecycle) {
+        if (histogramToRecycle == null) {
+            final Histogram intervalHistogram = aggregatedHistogram;
+            aggregatedHistogram = new Histogram(intervalHistogram);
+            aggregatedHistogram.reset(); // Do not carry over the aggregated interval's timestamps
+            return intervalHistogram;
+        }
+        aggregatedHistogram.copyInto(histogramToRecycle);
+        aggregatedHistogram.reset();
+        return histogramToRecycle;
+    }
+}
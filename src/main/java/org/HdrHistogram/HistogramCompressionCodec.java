@@ -0,0 +1,59 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.ByteBuffer;
+import java.util.zip.DataFormatException;
+
+/**
+ * A compression codec for compressed histogram encodings.
+ * <p>
+ * Codecs are identified in compressed histogram encodings by their codec id, and are looked up by that id
+ * when decoding (see {@link HistogramCompressionCodecs}). Codecs other than the built-in ones (e.g. LZ4 or
+ * Zstd based codecs) can be made available either by registering them with
+ * {@link HistogramCompressionCodecs#register(HistogramCompressionCodec)}, or by providing them as a
+ * {@link java.util.ServiceLoader} service for this interface.
+ * <p>
+ * Codec implementations must be thread-safe.
+ */
+public interface HistogramCompressionCodec {
+
+    /**
+     * Get the id identifying this codec in compressed histogram encodings. Ids below
+     * {@link HistogramCompressionCodecs#FIRST_USER_CODEC_ID} are reserved for built-in codecs.
+     * @return the id of this codec
+     */
+    int getCodecId();
+
+    /**
+     * Get the highest number of bytes that compressing the given number of bytes may require.
+     * @param uncompressedLength The number of bytes to be compressed
+     * @return the highest number of bytes that their compressed form may require
+     */
+    int getMaxCompressedLength(int uncompressedLength);
+
+    /**
+     * Compress the remaining contents of a source buffer into a target buffer, at its current position.
+     * Both buffers' positions are advanced past the consumed and produced bytes.
+     * @param source The buffer containing the bytes to compress
+     * @param target The buffer to write the compressed bytes into
+     * @param compressionLevel A codec specific compression level (e.g. for java.util.zip.Deflater). Codecs
+     *                         may ignore compression levels they do not support.
+     * @return The number of compressed bytes written into the target buffer
+     */
+    int compress(ByteBuffer source, ByteBuffer target, int compressionLevel);
+
+    /**
+     * Decompress the remaining contents of a source buffer into a target buffer, filling the target's
+     * remaining capacity. Both buffers' positions are advanced past the consumed and produced bytes.
+     * @param source The buffer containing the compressed bytes
+     * @param target The buffer to write the decompressed bytes into
+     * @throws DataFormatException if the source does not decompress into exactly the target's remaining bytes
+     */
+    void decompress(ByteBuffer source, ByteBuffer target) throws DataFormatException;
+}
@@ -0,0 +1,201 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+import java.util.Iterator;
+import java.util.ServiceConfigurationError;
+import java.util.ServiceLoader;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.zip.DataFormatException;
+import java.util.zip.Deflater;
+import java.util.zip.Inflater;
+
+/**
+ * The built-in {@link HistogramCompressionCodec}s, and the registry used to look up codecs by id when
+ * decoding compressed histograms.
+ * <p>
+ * {@link #DEFLATE} compressed encodings use the original compressed histogram encoding format, and remain
+ * readable by all decoders. Encodings using any other codec use a codec-identifying compressed encoding
+ * format, and can only be decoded where that codec is available.
+ * <p>
+ * In addition to the built-in codecs, any {@link HistogramCompressionCodec} providers found via
+ * {@link java.util.ServiceLoader} are registered when this class is initialized.
+ */
+public final class HistogramCompressionCodecs {
+    /**
+     * The codec id of the {@link #DEFLATE} codec
+     */
+    public static final int DEFLATE_CODEC_ID = 0;
+
+    /**
+     * The codec id of the {@link #NONE} codec
+     */
+    public static final int NONE_CODEC_ID = 1;
+
+    /**
+     * The lowest codec id available to non-built-in codecs
+     */
+    public static final int FIRST_USER_CODEC_ID = 16;
+
+    /**
+     * A codec using java.util.zip's deflate compression.
+     */
+    public static final HistogramCompressionCodec DEFLATE = new DeflateCodec();
+
+    /**
+     * A codec that stores its input uncompressed, trading encoding size for encoding speed.
+     */
+    public static final HistogramCompressionCodec NONE = new NoneCodec();
+
+    private static final ConcurrentHashMap<Integer, HistogramCompressionCodec> codecs =
+            new ConcurrentHashMap<Integer, HistogramCompressionCodec>();
+
+    static {
+        codecs.put(DEFLATE_CODEC_ID, DEFLATE);
+        codecs.put(NONE_CODEC_ID, NONE);
+        Iterator<HistogramCompressionCodec> providers =
+                ServiceLoader.load(HistogramCompressionCodec.class).iterator();
+        while (true) {
+            try {
+                if (!providers.hasNext()) {
+                    break;
+                }
+                register(providers.next());
+            } catch (ServiceConfigurationError | IllegalArgumentException ex) {
+                // Skip providers that cannot be loaded or registered
+            }
+        }
+    }
+
+    private HistogramCompressionCodecs() {
+    }
+
+    /**
+     * Register a codec, making it available for decoding compressed histograms that use its codec id.
+     * @param codec The codec to register
+     * @throws IllegalArgumentException if the codec's id is reserved for built-in codecs, or if a different
+     * codec is already registered with the same id
+     */
+    public static void register(final HistogramCompressionCodec codec) {
+        final int codecId = codec.getCodecId();
+        if (codecId < FIRST_USER_CODEC_ID) {
+            throw new IllegalArgumentException("codec id " + codecId + " is reserved for built-in codecs");
+        }
+        HistogramCompressionCodec existingCodec = codecs.putIfAbsent(codecId, codec);
+        if ((existingCodec != null) && (existingCodec != codec)) {
+            throw new IllegalArgumentException("a different codec is already registered with codec id " + codecId);
+        }
+    }
+
+    /**
+     * Get the codec registered with the given codec id.
+     * @param codecId The codec id
+     * @return the codec registered with the given codec id
+     * @throws IllegalArgumentException if no codec is registered with the given codec id
+     */
+    public static HistogramCompressionCodec forCodecId(final int codecId) {
+        HistogramCompressionCodec codec = codecs.get(codecId);
+        if (codec == null) {
+            throw new IllegalArgumentException("No HistogramCompressionCodec registered with codec id " + codecId);
+        }
+        return codec;
+    }
+
+    private static class DeflateCodec implements HistogramCompressionCodec {
+        @Override
+        public int getCodecId() {
+            return DEFLATE_CODEC_ID;
+        }
+
+        @Override
+        public int getMaxCompressedLength(final int uncompressedLength) {
+            // zlib's stored-block worst case: 5 bytes per 16KB block, plus header and trailer:
+            return uncompressedLength + ((uncompressedLength >> 14) + 1) * 5 + 6;
+        }
+
+        @Override
+        public int compress(final ByteBuffer source, final ByteBuffer target, final int compressionLevel) {
+            final Deflater compressor = new Deflater(compressionLevel);
+            try {
+                final byte[] sourceArray = toArray(source);
+                compressor.setInput(sourceArray, 0, sourceArray.length);
+                compressor.finish();
+                final byte[] outputArray = new byte[Math.min(8 * 1024, Math.max(target.remaining(), 1))];
+                while (!compressor.finished()) {
+                    if (!target.hasRemaining()) {
+                        throw new BufferOverflowException();
+                    }
+                    int compressedLength =
+                            compressor.deflate(outputArray, 0, Math.min(outputArray.length, target.remaining()));
+                    target.put(outputArray, 0, compressedLength);
+                }
+                return (int) compressor.getBytesWritten();
+            } finally {
+                compressor.end();
+            }
+        }
+
+        @Override
+        public void decompress(final ByteBuffer source, final ByteBuffer target) throws DataFormatException {
+            final Inflater decompressor = new Inflater();
+            try {
+                final byte[] sourceArray = toArray(source);
+                decompressor.setInput(sourceArray, 0, sourceArray.length);
+                final byte[] outputArray = new byte[target.remaining()];
+                int decompressedLength = 0;
+                while (decompressedLength < outputArray.length) {
+                    int length = decompressor.inflate(outputArray, decompressedLength,
+                            outputArray.length - decompressedLength);
+                    if (length == 0) {
+                        throw new DataFormatException("compressed contents are shorter than indicated");
+                    }
+                    decompressedLength += length;
+                }
+                target.put(outputArray);
+            } finally {
+                decompressor.end();
+            }
+        }
+
+        private static byte[] toArray(final ByteBuffer source) {
+            final byte[] array = new byte[source.remaining()];
+            source.get(array);
+            return array;
+        }
+    }
+
+    private static class NoneCodec implements HistogramCompressionCodec {
+        @Override
+        public int getCodecId() {
+            return NONE_CODEC_ID;
+        }
+
+        @Override
+        public int getMaxCompressedLength(final int uncompressedLength) {
+            return uncompressedLength;
+        }
+
+        @Override
+        public int compress(final ByteBuffer source, final ByteBuffer target, final int compressionLevel) {
+            final int length = source.remaining();
+            target.put(source);
+            return length;
+        }
+
+        @Override
+        public void decompress(final ByteBuffer source, final ByteBuffer target) throws DataFormatException {
+            if (source.remaining() != target.remaining()) {
+                throw new DataFormatException("stored contents length (" + source.remaining() +
+                        ") does not match the indicated length (" + target.remaining() + ")");
+            }
+            target.put(source);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.ByteBuffer;
+import java.util.zip.DataFormatException;
+
+/**
+ * Decodes a source's successive interval histograms, as encoded by a {@link HistogramDeltaEncoder}. Each
+ * encoded interval is decoded by applying its delta to the source's previously decoded interval histogram.
+ * <p>
+ * A delta that is not from the previously decoded interval (e.g. because an encoding was lost or failed to
+ * decode) is rejected with an {@link IllegalStateException}, and the source is then expected to make its
+ * next encoding a full one (see {@link HistogramDeltaEncoder#reset()}). Full encodings are always decoded.
+ * <p>
+ * A {@link HistogramDeltaDecoder} decodes the intervals of a single source, and is thread-safe.
+ */
+public class HistogramDeltaDecoder {
+    private Histogram intervalHistogram;
+    private long decodedSequence;
+
+    /**
+     * Construct a {@link HistogramDeltaDecoder}
+     */
+    public HistogramDeltaDecoder() {
+    }
+
+    /**
+     * Decode the next interval histogram from a compressed delta encoding in a ByteBuffer (starting at its
+     * current position), and advance the buffer past the encoding.
+     * <p>
+     * The returned histogram is retained by the decoder, as the base for decoding the next interval, and is
+     * modified by the next call. It must not be modified by the caller (copy it to keep or modify it).
+     *
+     * @param buffer The buffer to decode from
+     * @return The decoded interval histogram
+     * @throws DataFormatException on errors in decoding the buffer compression
+     * @throws IllegalArgumentException if the buffer does not contain a compressed delta encoding
+     * @throws IllegalStateException if the encoding is a delta from an interval other than the last one decoded
+     */
+    public synchronized Histogram decodeFromCompressedByteBuffer(final ByteBuffer buffer)
+            throws DataFormatException {
+        if (!AbstractHistogram.isDeltaCompressedEncoding(buffer)) {
+            throw new IllegalArgumentException("The buffer does not contain a compressed delta encoded Histogram");
+        }
+        final long sequence = AbstractHistogram.getDeltaEncodingSequence(buffer);
+        final long baseSequence = AbstractHistogram.getDeltaEncodingBaseSequence(buffer);
+        if (baseSequence < 0) {
+            // A full encoding, which does not depend on any previously decoded interval:
+            intervalHistogram = AbstractHistogram.constructForDeltaEncoding(buffer);
+        } else if ((intervalHistogram == null) || (baseSequence != decodedSequence)) {
+            throw new IllegalStateException("The encoded interval (sequence " + sequence +
+                    ") is a delta from an interval (sequence " + baseSequence +
+                    ") other than the last decoded one. A full encoding is needed.");
+        }
+        try {
+            intervalHistogram.applyDeltaFromCompressedByteBuffer(buffer);
+        } catch (DataFormatException | RuntimeException ex) {
+            // The retained interval histogram may have been partially modified, and can no longer serve as a base:
+            intervalHistogram = null;
+            throw ex;
+        }
+        decodedSequence = sequence;
+        return intervalHistogram;
+    }
+
+    /**
+     * Forget the previously decoded interval, such that only a full encoding can be decoded next
+     */
+    public synchronized void reset() {
+        intervalHistogram = null;
+    }
+}
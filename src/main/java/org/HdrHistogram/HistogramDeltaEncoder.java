@@ -0,0 +1,160 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.ByteBuffer;
+import java.util.Random;
+import java.util.zip.Deflater;
+
+/**
+ * Encodes a source's successive interval histograms in compressed form, each as a delta from the source's
+ * previous interval histogram, for decoding by a {@link HistogramDeltaDecoder} (e.g. within a
+ * {@link HistogramAggregator}). Sources whose distribution is stable from one interval to the next encode
+ * into very small payloads.
+ * <p>
+ * Each encoding identifies the interval it encodes and the interval it is a delta from (a sequence number
+ * of each), such that a decoder can verify that a delta applies to the interval it has last decoded. An
+ * interval is encoded in full (as a delta from no interval) when it is the first interval encoded, when
+ * its counts array layout does not match the previous interval's (e.g. after an auto-resize), and when
+ * the next encoding is requested to be a full one via {@link #reset()} (e.g. after the decoding of a
+ * previous encoding has failed, or an encoding has been lost).
+ * <p>
+ * A common pattern for encoding a {@link Recorder}'s interval histograms looks like this:
+ * <br><pre><code>
+ * HistogramDeltaEncoder encoder = new HistogramDeltaEncoder();
+ * ByteBuffer buffer = ByteBuffer.allocate(...);
+ * ...
+ * [every interval:]
+ *   buffer.clear();
+ *   encoder.encodeNextIntervalIntoCompressedByteBuffer(recorder, buffer);
+ *   [send the buffer's contents to the aggregator]
+ * </code></pre>
+ * The previous interval histogram (which the deltas are from) is retained by the encoder. When encoding
+ * a {@link Recorder}'s interval histograms (via {@link #encodeNextIntervalIntoCompressedByteBuffer}), the
+ * retained interval histogram is the recorder's previous interval histogram, which is recycled into the
+ * recorder once it is no longer needed, such that no copying of interval histograms is involved.
+ * <p>
+ * A {@link HistogramDeltaEncoder} encodes the intervals of a single source, and is thread-safe.
+ */
+public class HistogramDeltaEncoder {
+    private final int compressionLevel;
+
+    private AbstractHistogram previousIntervalHistogram;
+    // Set when the previous interval histogram was obtained from a Recorder, and can be recycled into it:
+    private boolean previousIntervalHistogramIsRecorded;
+    private long previousSequence;
+    private long nextSequence;
+
+    /**
+     * Construct a {@link HistogramDeltaEncoder} using the default compression level
+     */
+    public HistogramDeltaEncoder() {
+        this(Deflater.DEFAULT_COMPRESSION);
+    }
+
+    /**
+     * Construct a {@link HistogramDeltaEncoder} using the given compression level
+     * @param compressionLevel Compression level (for java.util.zip.Deflater).
+     */
+    public HistogramDeltaEncoder(final int compressionLevel) {
+        this.compressionLevel = compressionLevel;
+        // Start the sequence at an arbitrary point, such that the sequence numbers of the encoder that replaces
+        // this one (e.g. after a restart of the source) are unlikely to be mistaken for those of this one:
+        this.nextSequence = new Random().nextLong() & (Long.MAX_VALUE >> 1);
+    }
+
+    /**
+     * Encode an interval histogram, as a delta from the previously encoded interval histogram, in compressed
+     * form into a ByteBuffer. The interval histogram is copied (to serve as the base of the next delta), and
+     * may be modified or recycled once this call returns.
+     *
+     * @param intervalHistogram The interval histogram to encode
+     * @param targetBuffer The buffer to encode into
+     * @return The number of bytes written to the buffer
+     */
+    public synchronized int encodeIntoCompressedByteBuffer(final AbstractHistogram intervalHistogram,
+                                                           final ByteBuffer targetBuffer) {
+        final int bytesWritten;
+        try {
+            bytesWritten = encode(intervalHistogram, targetBuffer);
+        } catch (RuntimeException ex) {
+            // An interval that failed to encode is never decoded, so the next encoding must be a full one:
+            reset();
+            throw ex;
+        }
+        if ((previousIntervalHistogram != null) && !previousIntervalHistogramIsRecorded &&
+                previousIntervalHistogram.hasMatchingCountsArrayLayout(intervalHistogram)) {
+            intervalHistogram.copyInto(previousIntervalHistogram);
+        } else {
+            previousIntervalHistogram = new Histogram(intervalHistogram);
+            previousIntervalHistogram.add(intervalHistogram);
+        }
+        previousIntervalHistogramIsRecorded = false;
+        return bytesWritten;
+    }
+
+    /**
+     * Take the next interval histogram from a recorder (see {@link Recorder#getIntervalHistogram(Histogram)}),
+     * and encode it, as a delta from the previously encoded interval histogram, in compressed form into a
+     * ByteBuffer. The interval histogram is retained (to serve as the base of the next delta), and recycled
+     * into the recorder once it is no longer needed. An encoder must only be used with a single recorder.
+     *
+     * @param recorder The recorder to take the next interval histogram from
+     * @param targetBuffer The buffer to encode into
+     * @return The number of bytes written to the buffer
+     */
+    public synchronized int encodeNextIntervalIntoCompressedByteBuffer(final Recorder recorder,
+                                                                       final ByteBuffer targetBuffer) {
+        final Histogram intervalHistogram = recorder.getIntervalHistogram();
+        final AbstractHistogram histogramToRecycle =
+                previousIntervalHistogramIsRecorded ? previousIntervalHistogram : null;
+        boolean encoded = false;
+        try {
+            final int bytesWritten = encode(intervalHistogram, targetBuffer);
+            encoded = true;
+            return bytesWritten;
+        } finally {
+            if (histogramToRecycle != null) {
+                recorder.releaseIntervalHistogram((Histogram) histogramToRecycle);
+            }
+            // An interval that failed to encode is never decoded, so the next encoding must be a full one:
+            previousIntervalHistogram = encoded ? intervalHistogram : null;
+            previousIntervalHistogramIsRecorded = encoded;
+        }
+    }
+
+    /**
+     * Get the capacity needed to encode an interval histogram in compressed form into a ByteBuffer
+     * @param intervalHistogram The interval histogram to be encoded
+     * @return the capacity needed to encode the interval histogram in compressed form into a ByteBuffer
+     */
+    public int getNeededCompressedByteBufferCapacity(final AbstractHistogram intervalHistogram) {
+        return intervalHistogram.getNeededDeltaCompressedByteBufferCapacity();
+    }
+
+    /**
+     * Make the next encoding a full (non-delta) one
+     */
+    public synchronized void reset() {
+        previousIntervalHistogram = null;
+        previousIntervalHistogramIsRecorded = false;
+    }
+
+    private int encode(final AbstractHistogram intervalHistogram, final ByteBuffer targetBuffer) {
+        AbstractHistogram baseHistogram = previousIntervalHistogram;
+        if ((baseHistogram != null) && !intervalHistogram.hasMatchingCountsArrayLayout(baseHistogram)) {
+            baseHistogram = null;
+        }
+        final long sequence = nextSequence;
+        final int bytesWritten = intervalHistogram.encodeDeltaIntoCompressedByteBuffer(
+                baseHistogram, sequence, previousSequence, targetBuffer, compressionLevel);
+        previousSequence = sequence;
+        nextSequence = sequence + 1;
+        return bytesWritten;
+    }
+}
@@ -0,0 +1,226 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.*;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Locale;
+import java.util.Scanner;
+
+/**
+ * A sidecar index for a histogram log, mapping the logged timestamp (and tag) of each interval in the log to
+ * the line number and byte offset of its interval line. Indexes are produced by a {@link HistogramLogWriter}
+ * (see {@link HistogramLogWriter#outputIndexTo(File)}), and allow a {@link HistogramLogReader} to seek
+ * directly to the intervals in a requested time range (see
+ * {@link HistogramLogReader#HistogramLogReader(File, HistogramLogIndex)}) rather than scan the log from its
+ * beginning.
+ * <h3>Histogram log index format:</h3>
+ * A histogram log index consists of text lines. Lines beginning with the "#" character are comments. The
+ * "#[StartTime: " and "#[BaseTime: " comment lines record the start time and base time indications logged
+ * ahead of the log's intervals (see {@link HistogramLogReader}). All other lines are index entries,
+ * containing an optional Tag=tagString text field, followed by exactly three comma delimited fields:
+ * <ul>
+ * <li>StartTimestamp: The logged start timestamp of the interval, in seconds.</li>
+ * <li>LineNumber: The (zero based) line number of the interval line in the log.</li>
+ * <li>ByteOffset: The byte offset of the interval line in the log.</li>
+ * </ul>
+ * Entries appear in log order.
+ */
+public class HistogramLogIndex {
+    /**
+     * The file name suffix conventionally used for the index of a histogram log (appended to the log's name).
+     */
+    public static final String INDEX_FILE_NAME_SUFFIX = ".hidx";
+
+    static final String INDEX_FORMAT_VERSION = "1.0";
+
+    private final List<String> tags = new ArrayList<>();
+    private double[] timestampsSec = new double[64];
+    private long[] lineNumbers = new long[64];
+    private long[] byteOffsets = new long[64];
+    private int entryCount = 0;
+
+    private double startTimeSec = Double.NaN;
+    private double baseTimeSec = Double.NaN;
+
+    private HistogramLogIndex() {
+    }
+
+    /**
+     * Get the index file conventionally associated with the given log file (in the same directory, with
+     * {@link #INDEX_FILE_NAME_SUFFIX} appended to the log's file name).
+     * @param logFile The histogram log file
+     * @return the index file associated with the log file
+     */
+    public static File indexFileFor(final File logFile) {
+        return new File(logFile.getPath() + INDEX_FILE_NAME_SUFFIX);
+    }
+
+    /**
+     * Read a histogram log index from the given index file.
+     * @param indexFile The index file to read
+     * @return the histogram log index
+     * @throws FileNotFoundException when unable to find indexFile
+     * @throws IllegalArgumentException if the index file contains malformed entries
+     */
+    public static HistogramLogIndex read(final File indexFile) throws FileNotFoundException {
+        final HistogramLogIndex index = new HistogramLogIndex();
+        try (Scanner scanner = new Scanner(indexFile)) {
+            scanner.useLocale(Locale.US);
+            while (scanner.hasNextLine()) {
+                index.parseLine(scanner.nextLine());
+            }
+        }
+        return index;
+    }
+
+    private void parseLine(final String line) {
+        if (line.startsWith("#[StartTime: ")) {
+            startTimeSec = Double.parseDouble(line.substring("#[StartTime: ".length(), line.indexOf(']')));
+            return;
+        }
+        if (line.startsWith("#[BaseTime: ")) {
+            baseTimeSec = Double.parseDouble(line.substring("#[BaseTime: ".length(), line.indexOf(']')));
+            return;
+        }
+        if (line.isEmpty() || line.startsWith("#")) {
+            return;
+        }
+        final String[] fields = line.split(",");
+        final int firstField = fields[0].startsWith("Tag=") ? 1 : 0;
+        if (fields.length != firstField + 3) {
+            throw new IllegalArgumentException("Malformed histogram log index entry: " + line);
+        }
+        try {
+            addEntry((firstField == 1) ? fields[0].substring(4) : null,
+                    Double.parseDouble(fields[firstField]),
+                    Long.parseLong(fields[firstField + 1]),
+                    Long.parseLong(fields[firstField + 2]));
+        } catch (NumberFormatException ex) {
+            throw new IllegalArgumentException("Malformed histogram log index entry: " + line, ex);
+        }
+    }
+
+    private void addEntry(final String tag, final double timestampSec, final long lineNumber,
+                          final long byteOffset) {
+        if (entryCount == timestampsSec.length) {
+            final int newLength = 2 * entryCount;
+            timestampsSec = Arrays.copyOf(timestampsSec, newLength);
+            lineNumbers = Arrays.copyOf(lineNumbers, newLength);
+            byteOffsets = Arrays.copyOf(byteOffsets, newLength);
+        }
+        tags.add(tag);
+        timestampsSec[entryCount] = timestampSec;
+        lineNumbers[entryCount] = lineNumber;
+        byteOffsets[entryCount] = byteOffset;
+        entryCount++;
+    }
+
+    /**
+     * Write an index entry line (in the index format described above)
+     */
+    static void outputEntry(final PrintStream indexLog, final String tag, final double timestampSec,
+                            final long lineNumber, final long byteOffset) {
+        if (tag == null) {
+            indexLog.format(Locale.US, "%.3f,%d,%d\n", timestampSec, lineNumber, byteOffset);
+        } else {
+            indexLog.format(Locale.US, "Tag=%s,%.3f,%d,%d\n", tag, timestampSec, lineNumber, byteOffset);
+        }
+    }
+
+    /**
+     * Get the number of entries (indexed intervals) in the index
+     * @return the number of entries in the index
+     */
+    public int getEntryCount() {
+        return entryCount;
+    }
+
+    /**
+     * Get the tag of the interval at the given entry
+     * @param entryIndex The index of the entry
+     * @return the tag of the interval, or null if it has none
+     */
+    public String getTag(final int entryIndex) {
+        return tags.get(entryIndex);
+    }
+
+    /**
+     * Get the logged start timestamp of the interval at the given entry
+     * @param entryIndex The index of the entry
+     * @return the logged start timestamp of the interval, in seconds
+     */
+    public double getTimestampSec(final int entryIndex) {
+        checkEntryIndex(entryIndex);
+        return timestampsSec[entryIndex];
+    }
+
+    /**
+     * Get the (zero based) line number in the log of the interval line at the given entry
+     * @param entryIndex The index of the entry
+     * @return the line number of the interval line
+     */
+    public long getLineNumber(final int entryIndex) {
+        checkEntryIndex(entryIndex);
+        return lineNumbers[entryIndex];
+    }
+
+    /**
+     * Get the byte offset in the log of the interval line at the given entry
+     * @param entryIndex The index of the entry
+     * @return the byte offset of the interval line
+     */
+    public long getByteOffset(final int entryIndex) {
+        checkEntryIndex(entryIndex);
+        return byteOffsets[entryIndex];
+    }
+
+    /**
+     * Get the index of the first entry with a logged start timestamp at or after the given timestamp.
+     * Logged timestamps are assumed to appear in order in the log.
+     * @param timestampSec The logged timestamp to look for, in seconds
+     * @return the index of the first entry at or after timestampSec, or {@link #getEntryCount()} if none exists
+     */
+    public int findFirstEntryAtOrAfter(final double timestampSec) {
+        int low = 0;
+        int high = entryCount;
+        while (low < high) {
+            final int mid = (low + high) >>> 1;
+            if (timestampsSec[mid] < timestampSec) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    /**
+     * Get the log start time recorded in the index, if any
+     * @return the log start time (in seconds since the epoch), or NaN if the index recorded none
+     */
+    public double getStartTimeSec() {
+        return startTimeSec;
+    }
+
+    /**
+     * Get the log base time recorded in the index, if any
+     * @return the log base time (in seconds since the epoch), or NaN if the index recorded none
+     */
+    public double getBaseTimeSec() {
+        return baseTimeSec;
+    }
+
+    private void checkEntryIndex(final int entryIndex) {
+        if ((entryIndex < 0) || (entryIndex >= entryCount)) {
+            throw new IndexOutOfBoundsException("entryIndex " + entryIndex + " out of range");
+        }
+    }
+}
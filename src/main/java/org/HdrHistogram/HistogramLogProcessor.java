@@ -7,10 +7,18 @@
 
 package org.HdrHistogram;
 
+import java.io.File;
 import java.io.FileNotFoundException;
 import java.io.FileOutputStream;
 import java.io.PrintStream;
 import java.util.*;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Semaphore;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicReference;
+import java.util.zip.DataFormatException;
 
 /**
  * {@link org.HdrHistogram.HistogramLogProcessor} will process an input log and
@@ -48,6 +56,16 @@ import java.util.*;
  * HistogramLogProcessor also accepts and optional -csv parameter, which
  * will cause the output formatting (of both output file forms) to use
  * a CSV file format.
+ * <p>
+ * The -pertag option causes HistogramLogProcessor to produce separate outputs
+ * for every tag found in the input log, in a single pass over it. The outputs
+ * of each tag are named as they would be for a processing of that tag alone,
+ * with a ".tag" suffix added to the output file name for tagged lines (e.g.
+ * mylog.tag and mylog.tag.hgrm). When not provided with an output file name,
+ * the histogram percentile distributions of all tags are written to standard
+ * output, one after the other. Interval histograms are decoded and processed
+ * on a pool of worker threads, with the intervals of each tag processed (in
+ * log order) by one of the workers.
  */
 public class HistogramLogProcessor extends Thread {
 
@@ -55,6 +73,9 @@ public class HistogramLogProcessor extends Thread {
 
     private final HistogramLogProcessorConfiguration config;
 
+    private final String logFormat;
+    private final String movingWindowLogFormat;
+
     private HistogramLogReader logReader;
 
     private static class HistogramLogProcessorConfiguration {
@@ -69,6 +90,7 @@ public class HistogramLogProcessor extends Thread {
         boolean logFormatCsv = false;
         boolean listTags = false;
         boolean allTags = false;
+        boolean perTag = false;
 
         boolean movingWindow = false;
         double movingWindowPercentileToReport = 99.0;
@@ -93,6 +115,8 @@ public class HistogramLogProcessor extends Thread {
                         listTags = true;
                     } else if (args[i].equals("-alltags")) {
                         allTags = true;
+                    } else if (args[i].equals("-pertag")) {
+                        perTag = true;
                     } else if (args[i].equals("-i")) {
                         inputFileName = args[++i];              // lgtm [java/index-out-of-bounds]
                     } else if (args[i].equals("-tag")) {
@@ -137,7 +161,8 @@ public class HistogramLogProcessor extends Thread {
                 final String validArgs =
                         "\"[-csv] [-v] [-i inputFileName] [-o outputFileName] [-tag tag] " +
                                 "[-start rangeStartTimeSec] [-end rangeEndTimeSec] " +
-                                "[-outputValueUnitRatio r] [-correctLogWithKnownCoordinatedOmission i] [-listtags]";
+                                "[-outputValueUnitRatio r] [-correctLogWithKnownCoordinatedOmission i] [-listtags] " +
+                                "[-pertag]";
 
                 System.err.println("valid arguments = " + validArgs);
 
@@ -158,7 +183,10 @@ public class HistogramLogProcessor extends Thread {
                             "                                              value i (in whatever units the log histograms were recorded with). This\n" +
                             "                                              feature should only be used when the input log is known to have been\n" +
                             "                                              recorded with coordinated omissions, and when an expected interval is known.\n" +
-                            " [-listtags]                                  list all tags found on histogram lines the input file."
+                            " [-listtags]                                  list all tags found on histogram lines the input file.\n" +
+                            " [-pertag]                                    Produce separate outputs for each tag found in the input file, in a\n" +
+                            "                                              single pass over the file (output files are named per tag, as\n" +
+                            "                                              outputFileName.tag, outputFileName.tag.hgrm, etc.)"
                 );
                 System.exit(1);
             }
@@ -196,6 +224,146 @@ public class HistogramLogProcessor extends Thread {
         return histogram;
     }
 
+    private static void accumulate(final EncodableHistogram intervalHistogram,
+                                   final boolean logUsesDoubleHistograms,
+                                   final Histogram accumulatedRegularHistogram,
+                                   final DoubleHistogram accumulatedDoubleHistogram) {
+        if (intervalHistogram instanceof DoubleHistogram) {
+            if (!logUsesDoubleHistograms) {
+                throw new IllegalStateException("Encountered a DoubleHistogram line in a log of Histograms.");
+            }
+            accumulatedDoubleHistogram.add((DoubleHistogram) intervalHistogram);
+        } else {
+            if (logUsesDoubleHistograms) {
+                throw new IllegalStateException("Encountered a Histogram line in a log of DoubleHistograms.");
+            }
+            accumulatedRegularHistogram.add((Histogram) intervalHistogram);
+        }
+    }
+
+    /**
+     * Add an interval histogram to the moving window sum, and subtract (and forget) the intervals that have
+     * fallen out of the window.
+     * @param expiredHistograms If non-null, regular histograms that fall out of the window are added to it
+     *                          (such that they can be reused)
+     */
+    private void updateMovingWindow(final EncodableHistogram intervalHistogram,
+                                    final EncodableHistogram movingWindowSumHistogram,
+                                    final Queue<EncodableHistogram> movingWindowQueue,
+                                    final Queue<Histogram> expiredHistograms) {
+        long windowCutOffTimeStamp = intervalHistogram.getEndTimeStamp() - config.movingWindowLengthInMsec;
+        // Add the current interval histogram to the moving window sums:
+        if ((movingWindowSumHistogram instanceof DoubleHistogram) &&
+                (intervalHistogram instanceof DoubleHistogram)){
+            ((DoubleHistogram) movingWindowSumHistogram).add((DoubleHistogram) intervalHistogram);
+        } else if ((movingWindowSumHistogram instanceof Histogram) &&
+                (intervalHistogram instanceof Histogram)){
+            ((Histogram) movingWindowSumHistogram).add((Histogram) intervalHistogram);
+        }
+        // Remove previous, now-out-of-window interval histograms from moving window:
+        EncodableHistogram head;
+        while (((head = movingWindowQueue.peek()) != null) &&
+                (head.getEndTimeStamp() <= windowCutOffTimeStamp)) {
+            EncodableHistogram prevHist = movingWindowQueue.remove();
+            if (movingWindowSumHistogram instanceof DoubleHistogram) {
+                if (prevHist != null) {
+                    ((DoubleHistogram) movingWindowSumHistogram).subtract((DoubleHistogram) prevHist);
+                }
+            } else if (movingWindowSumHistogram instanceof Histogram) {
+                if (prevHist != null) {
+                    ((Histogram) movingWindowSumHistogram).subtract((Histogram) prevHist);
+                    if (expiredHistograms != null) {
+                        expiredHistograms.add((Histogram) prevHist);
+                    }
+                }
+            }
+        }
+        // Add interval histogram to moving window previous intervals memory:
+        movingWindowQueue.add(intervalHistogram);
+    }
+
+    private void outputTimeIntervalLogLegend(final PrintStream log) {
+        if (config.logFormatCsv) {
+            log.println("\"Timestamp\",\"Int_Count\",\"Int_50%\",\"Int_90%\",\"Int_Max\",\"Total_Count\"," +
+                    "\"Total_50%\",\"Total_90%\",\"Total_99%\",\"Total_99.9%\",\"Total_99.99%\",\"Total_Max\"");
+        } else {
+            log.println("Time: IntervalPercentiles:count ( 50% 90% Max ) TotalPercentiles:count ( 50% 90% 99% 99.9% 99.99% Max )");
+        }
+    }
+
+    private void outputTimeIntervalLogLine(final PrintStream log, final double logStartTimeSec,
+                                           final EncodableHistogram intervalHistogram,
+                                           final EncodableHistogram accumulatedHistogram) {
+        if (intervalHistogram instanceof DoubleHistogram) {
+            final DoubleHistogram accumulatedDoubleHistogram = (DoubleHistogram) accumulatedHistogram;
+            log.format(Locale.US, logFormat,
+                    ((intervalHistogram.getEndTimeStamp() / 1000.0) - logStartTimeSec),
+                    // values recorded during the last reporting interval
+                    ((DoubleHistogram) intervalHistogram).getTotalCount(),
+                    ((DoubleHistogram) intervalHistogram).getValueAtPercentile(50.0) / config.outputValueUnitRatio,
+                    ((DoubleHistogram) intervalHistogram).getValueAtPercentile(90.0) / config.outputValueUnitRatio,
+                    ((DoubleHistogram) intervalHistogram).getMaxValue() / config.outputValueUnitRatio,
+                    // values recorded from the beginning until now
+                    accumulatedDoubleHistogram.getTotalCount(),
+                    accumulatedDoubleHistogram.getValueAtPercentile(50.0) / config.outputValueUnitRatio,
+                    accumulatedDoubleHistogram.getValueAtPercentile(90.0) / config.outputValueUnitRatio,
+                    accumulatedDoubleHistogram.getValueAtPercentile(99.0) / config.outputValueUnitRatio,
+                    accumulatedDoubleHistogram.getValueAtPercentile(99.9) / config.outputValueUnitRatio,
+                    accumulatedDoubleHistogram.getValueAtPercentile(99.99) / config.outputValueUnitRatio,
+                    accumulatedDoubleHistogram.getMaxValue() / config.outputValueUnitRatio
+            );
+        } else {
+            final Histogram accumulatedRegularHistogram = (Histogram) accumulatedHistogram;
+            log.format(Locale.US, logFormat,
+                    ((intervalHistogram.getEndTimeStamp() / 1000.0) - logStartTimeSec),
+                    // values recorded during the last reporting interval
+                    ((Histogram) intervalHistogram).getTotalCount(),
+                    ((Histogram) intervalHistogram).getValueAtPercentile(50.0) / config.outputValueUnitRatio,
+                    ((Histogram) intervalHistogram).getValueAtPercentile(90.0) / config.outputValueUnitRatio,
+                    ((Histogram) intervalHistogram).getMaxValue() / config.outputValueUnitRatio,
+                    // values recorded from the beginning until now
+                    accumulatedRegularHistogram.getTotalCount(),
+                    accumulatedRegularHistogram.getValueAtPercentile(50.0) / config.outputValueUnitRatio,
+                    accumulatedRegularHistogram.getValueAtPercentile(90.0) / config.outputValueUnitRatio,
+                    accumulatedRegularHistogram.getValueAtPercentile(99.0) / config.outputValueUnitRatio,
+                    accumulatedRegularHistogram.getValueAtPercentile(99.9) / config.outputValueUnitRatio,
+                    accumulatedRegularHistogram.getValueAtPercentile(99.99) / config.outputValueUnitRatio,
+                    accumulatedRegularHistogram.getMaxValue() / config.outputValueUnitRatio
+            );
+        }
+    }
+
+    private void outputMovingWindowLogLegend(final PrintStream log) {
+        if (config.logFormatCsv) {
+            log.println("\"Timestamp\",\"Window_Count\",\"" +
+                    config.movingWindowPercentileToReport +"%'ile\",\"Max\"");
+        } else {
+            log.println("Time: WindowCount " + config.movingWindowPercentileToReport + "%'ile Max");
+        }
+    }
+
+    private void outputMovingWindowLogLine(final PrintStream log, final double logStartTimeSec,
+                                           final EncodableHistogram intervalHistogram,
+                                           final EncodableHistogram movingWindowSumHistogram) {
+        if (intervalHistogram instanceof DoubleHistogram) {
+            log.format(Locale.US, movingWindowLogFormat,
+                    ((intervalHistogram.getEndTimeStamp() / 1000.0) - logStartTimeSec),
+                    // values recorded during the last reporting interval
+                    ((DoubleHistogram) movingWindowSumHistogram).getTotalCount(),
+                    ((DoubleHistogram) movingWindowSumHistogram).getValueAtPercentile(config.movingWindowPercentileToReport) / config.outputValueUnitRatio,
+                    ((DoubleHistogram) movingWindowSumHistogram).getMaxValue() / config.outputValueUnitRatio
+            );
+        } else {
+            log.format(Locale.US, movingWindowLogFormat,
+                    ((intervalHistogram.getEndTimeStamp() / 1000.0) - logStartTimeSec),
+                    // values recorded during the last reporting interval
+                    ((Histogram) movingWindowSumHistogram).getTotalCount(),
+                    ((Histogram) movingWindowSumHistogram).getValueAtPercentile(config.movingWindowPercentileToReport) / config.outputValueUnitRatio,
+                    ((Histogram) movingWindowSumHistogram).getMaxValue() / config.outputValueUnitRatio
+            );
+        }
+    }
+
     private int lineNumber = 0;
 
     private EncodableHistogram getIntervalHistogram() {
@@ -220,6 +388,43 @@ public class HistogramLogProcessor extends Thread {
         return histogram;
     }
 
+    private void addRemainingIntervalHistograms(final Histogram accumulatedHistogram) {
+        boolean added;
+        do {
+            added = false;
+            try {
+                added = logReader.addNextIntervalHistogramTo(accumulatedHistogram,
+                        config.rangeStartTimeSec, config.rangeEndTimeSec, config.tag);
+            } catch (RuntimeException ex) {
+                System.err.println("Log file parsing error at line number " + lineNumber +
+                        ": line appears to be malformed.");
+                if (config.verbose) {
+                    throw ex;
+                } else {
+                    System.exit(1);
+                }
+            }
+            lineNumber++;
+        } while (added);
+    }
+
+    private HistogramLogReader.EncodedInterval getEncodedIntervalHistogram() {
+        HistogramLogReader.EncodedInterval interval = null;
+        try {
+            interval = logReader.nextEncodedIntervalHistogram(config.rangeStartTimeSec, config.rangeEndTimeSec);
+        } catch (RuntimeException ex) {
+            System.err.println("Log file parsing error at line number " + lineNumber +
+                    ": line appears to be malformed.");
+            if (config.verbose) {
+                throw ex;
+            } else {
+                System.exit(1);
+            }
+        }
+        lineNumber++;
+        return interval;
+    }
+
     private EncodableHistogram getIntervalHistogram(String tag) {
         EncodableHistogram histogram;
         if (tag == null) {
@@ -271,14 +476,9 @@ public class HistogramLogProcessor extends Thread {
             return;
         }
 
-        final String logFormat;
-        final String movingWindowLogFormat;
-        if (config.logFormatCsv) {
-            logFormat = "%.3f,%d,%.3f,%.3f,%.3f,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n";
-            movingWindowLogFormat = "%.3f,%d,%.3f,%.3f\n";
-        } else {
-            logFormat = "%4.3f: I:%d ( %7.3f %7.3f %7.3f ) T:%d ( %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f )\n";
-            movingWindowLogFormat = "%4.3f: I:%d P:%7.3f M:%7.3f\n";
+        if (config.perTag) {
+            runPerTag();
+            return;
         }
 
         try {
@@ -328,50 +528,21 @@ public class HistogramLogProcessor extends Thread {
                     new DoubleHistogram(3) :
                     new Histogram(3);
 
+            // When only the accumulated distribution is needed (no per-interval output, moving window, or
+            // coordinated omission correction), intervals following the first one can be added to the
+            // accumulated histogram directly from their encoded form:
+            final boolean accumulateEncodedIntervals = !logUsesDoubleHistograms &&
+                    (timeIntervalLog == null) && !config.movingWindow &&
+                    !(config.expectedIntervalForCoordinatedOmissionCorrection > 0.0);
 
             while (intervalHistogram != null) {
 
-                // handle accumulated histogram:
-                if (intervalHistogram instanceof DoubleHistogram) {
-                    if (!logUsesDoubleHistograms) {
-                        throw new IllegalStateException("Encountered a DoubleHistogram line in a log of Histograms.");
-                    }
-                    accumulatedDoubleHistogram.add((DoubleHistogram) intervalHistogram);
-                } else {
-                    if (logUsesDoubleHistograms) {
-                        throw new IllegalStateException("Encountered a Histogram line in a log of DoubleHistograms.");
-                    }
-                    accumulatedRegularHistogram.add((Histogram) intervalHistogram);
-                }
+                accumulate(intervalHistogram, logUsesDoubleHistograms,
+                        accumulatedRegularHistogram, accumulatedDoubleHistogram);
 
-                long windowCutOffTimeStamp = intervalHistogram.getEndTimeStamp() - config.movingWindowLengthInMsec;
                 // handle moving window:
                 if (config.movingWindow) {
-                    // Add the current interval histogram to the moving window sums:
-                    if ((movingWindowSumHistogram instanceof DoubleHistogram) &&
-                            (intervalHistogram instanceof DoubleHistogram)){
-                        ((DoubleHistogram) movingWindowSumHistogram).add((DoubleHistogram) intervalHistogram);
-                    } else if ((movingWindowSumHistogram instanceof Histogram) &&
-                            (intervalHistogram instanceof Histogram)){
-                        ((Histogram) movingWindowSumHistogram).add((Histogram) intervalHistogram);
-                    }
-                    // Remove previous, now-out-of-window interval histograms from moving window:
-                    EncodableHistogram head;
-                    while (((head = movingWindowQueue.peek()) != null) &&
-                            (head.getEndTimeStamp() <= windowCutOffTimeStamp)) {
-                        EncodableHistogram prevHist = movingWindowQueue.remove();
-                        if (movingWindowSumHistogram instanceof DoubleHistogram) {
-                            if (prevHist != null) {
-                                ((DoubleHistogram) movingWindowSumHistogram).subtract((DoubleHistogram) prevHist);
-                            }
-                        } else if (movingWindowSumHistogram instanceof Histogram) {
-                            if (prevHist != null) {
-                                ((Histogram) movingWindowSumHistogram).subtract((Histogram) prevHist);
-                            }
-                        }
-                    }
-                    // Add interval histogram to moving window previous intervals memory:
-                    movingWindowQueue.add(intervalHistogram);
+                    updateMovingWindow(intervalHistogram, movingWindowSumHistogram, movingWindowQueue, null);
                 }
 
                 if ((firstStartTime == 0.0) && (logReader.getStartTimeSec() != 0.0)) {
@@ -387,79 +558,24 @@ public class HistogramLogProcessor extends Thread {
                 if (timeIntervalLog != null) {
                     if (!timeIntervalLogLegendWritten) {
                         timeIntervalLogLegendWritten = true;
-                        if (config.logFormatCsv) {
-                            timeIntervalLog.println("\"Timestamp\",\"Int_Count\",\"Int_50%\",\"Int_90%\",\"Int_Max\",\"Total_Count\"," +
-                                    "\"Total_50%\",\"Total_90%\",\"Total_99%\",\"Total_99.9%\",\"Total_99.99%\",\"Total_Max\"");
-                        } else {
-                            timeIntervalLog.println("Time: IntervalPercentiles:count ( 50% 90% Max ) TotalPercentiles:count ( 50% 90% 99% 99.9% 99.99% Max )");
-                        }
-                    }
-
-                    if (logUsesDoubleHistograms) {
-                        timeIntervalLog.format(Locale.US, logFormat,
-                                ((intervalHistogram.getEndTimeStamp() / 1000.0) - logReader.getStartTimeSec()),
-                                // values recorded during the last reporting interval
-                                ((DoubleHistogram) intervalHistogram).getTotalCount(),
-                                ((DoubleHistogram) intervalHistogram).getValueAtPercentile(50.0) / config.outputValueUnitRatio,
-                                ((DoubleHistogram) intervalHistogram).getValueAtPercentile(90.0) / config.outputValueUnitRatio,
-                                ((DoubleHistogram) intervalHistogram).getMaxValue() / config.outputValueUnitRatio,
-                                // values recorded from the beginning until now
-                                accumulatedDoubleHistogram.getTotalCount(),
-                                accumulatedDoubleHistogram.getValueAtPercentile(50.0) / config.outputValueUnitRatio,
-                                accumulatedDoubleHistogram.getValueAtPercentile(90.0) / config.outputValueUnitRatio,
-                                accumulatedDoubleHistogram.getValueAtPercentile(99.0) / config.outputValueUnitRatio,
-                                accumulatedDoubleHistogram.getValueAtPercentile(99.9) / config.outputValueUnitRatio,
-                                accumulatedDoubleHistogram.getValueAtPercentile(99.99) / config.outputValueUnitRatio,
-                                accumulatedDoubleHistogram.getMaxValue() / config.outputValueUnitRatio
-                        );
-                    } else {
-                        timeIntervalLog.format(Locale.US, logFormat,
-                                ((intervalHistogram.getEndTimeStamp() / 1000.0) - logReader.getStartTimeSec()),
-                                // values recorded during the last reporting interval
-                                ((Histogram) intervalHistogram).getTotalCount(),
-                                ((Histogram) intervalHistogram).getValueAtPercentile(50.0) / config.outputValueUnitRatio,
-                                ((Histogram) intervalHistogram).getValueAtPercentile(90.0) / config.outputValueUnitRatio,
-                                ((Histogram) intervalHistogram).getMaxValue() / config.outputValueUnitRatio,
-                                // values recorded from the beginning until now
-                                accumulatedRegularHistogram.getTotalCount(),
-                                accumulatedRegularHistogram.getValueAtPercentile(50.0) / config.outputValueUnitRatio,
-                                accumulatedRegularHistogram.getValueAtPercentile(90.0) / config.outputValueUnitRatio,
-                                accumulatedRegularHistogram.getValueAtPercentile(99.0) / config.outputValueUnitRatio,
-                                accumulatedRegularHistogram.getValueAtPercentile(99.9) / config.outputValueUnitRatio,
-                                accumulatedRegularHistogram.getValueAtPercentile(99.99) / config.outputValueUnitRatio,
-                                accumulatedRegularHistogram.getMaxValue() / config.outputValueUnitRatio
-                        );
+                        outputTimeIntervalLogLegend(timeIntervalLog);
                     }
+                    outputTimeIntervalLogLine(timeIntervalLog, logReader.getStartTimeSec(), intervalHistogram,
+                            logUsesDoubleHistograms ? accumulatedDoubleHistogram : accumulatedRegularHistogram);
                 }
 
                 if (movingWindowLog != null) {
                     if (!movingWindowLogLegendWritten) {
                         movingWindowLogLegendWritten = true;
-                        if (config.logFormatCsv) {
-                            movingWindowLog.println("\"Timestamp\",\"Window_Count\",\"" +
-                                    config.movingWindowPercentileToReport +"%'ile\",\"Max\"");
-                        } else {
-                            movingWindowLog.println("Time: WindowCount " + config.movingWindowPercentileToReport + "%'ile Max");
-                        }
-                    }
-                    if (intervalHistogram instanceof DoubleHistogram) {
-                        movingWindowLog.format(Locale.US, movingWindowLogFormat,
-                                ((intervalHistogram.getEndTimeStamp() / 1000.0) - logReader.getStartTimeSec()),
-                                // values recorded during the last reporting interval
-                                ((DoubleHistogram) movingWindowSumHistogram).getTotalCount(),
-                                ((DoubleHistogram) movingWindowSumHistogram).getValueAtPercentile(config.movingWindowPercentileToReport) / config.outputValueUnitRatio,
-                                ((DoubleHistogram) movingWindowSumHistogram).getMaxValue() / config.outputValueUnitRatio
-                        );
-                    } else {
-                        movingWindowLog.format(Locale.US, movingWindowLogFormat,
-                                ((intervalHistogram.getEndTimeStamp() / 1000.0) - logReader.getStartTimeSec()),
-                                // values recorded during the last reporting interval
-                                ((Histogram) movingWindowSumHistogram).getTotalCount(),
-                                ((Histogram) movingWindowSumHistogram).getValueAtPercentile(config.movingWindowPercentileToReport) / config.outputValueUnitRatio,
-                                ((Histogram) movingWindowSumHistogram).getMaxValue() / config.outputValueUnitRatio
-                        );
+                        outputMovingWindowLogLegend(movingWindowLog);
                     }
+                    outputMovingWindowLogLine(movingWindowLog, logReader.getStartTimeSec(), intervalHistogram,
+                            movingWindowSumHistogram);
+                }
 
+                if (accumulateEncodedIntervals) {
+                    addRemainingIntervalHistograms(accumulatedRegularHistogram);
+                    break;
                 }
 
                 intervalHistogram = getIntervalHistogram(config.tag);
@@ -485,6 +601,284 @@ public class HistogramLogProcessor extends Thread {
         }
     }
 
+    // The number of read (but not yet processed) intervals allowed per worker, bounding the memory held by
+    // intervals waiting on busy workers:
+    private static final int MAX_PENDING_INTERVALS_PER_WORKER = 256;
+
+    /**
+     * The state and outputs of a single tag in a {@link #runPerTag()} pass. All intervals of a tag are
+     * processed, in log order, by the same (single threaded) worker.
+     */
+    private class TagProcessor {
+        final String tag;
+        final ExecutorService worker;
+        final String outputFileName;
+        PrintStream timeIntervalLog = null;
+        PrintStream movingWindowLog = null;
+        boolean timeIntervalLogLegendWritten = false;
+        boolean movingWindowLogLegendWritten = false;
+        double firstStartTime = 0.0;
+
+        boolean logUsesDoubleHistograms;
+        Histogram accumulatedRegularHistogram = null;
+        DoubleHistogram accumulatedDoubleHistogram = null;
+        EncodableHistogram movingWindowSumHistogram = null;
+        final Queue<EncodableHistogram> movingWindowQueue = new LinkedList<>();
+        // Interval histograms that are done with, and can be decoded into:
+        final Queue<Histogram> recycledIntervalHistograms = new ArrayDeque<>();
+
+        TagProcessor(final String tag, final ExecutorService worker) {
+            this.tag = tag;
+            this.worker = worker;
+            if (config.outputFileName == null) {
+                outputFileName = null;
+                return;
+            }
+            outputFileName = (tag == null) ? config.outputFileName : config.outputFileName + "." + tag;
+            try {
+                timeIntervalLog = new PrintStream(new FileOutputStream(outputFileName), false);
+                outputTimeRange(timeIntervalLog, "Interval percentile log");
+            } catch (FileNotFoundException ex) {
+                System.err.println("Failed to open output file " + outputFileName);
+            }
+            if (config.movingWindow) {
+                String movingWindowOutputFileName = outputFileName + ".mwp";
+                try {
+                    movingWindowLog = new PrintStream(new FileOutputStream(movingWindowOutputFileName), false);
+                    outputTimeRange(movingWindowLog, "Moving window log for " +
+                            config.movingWindowPercentileToReport + " percentile");
+                } catch (FileNotFoundException ex) {
+                    System.err.println("Failed to open moving window output file " + movingWindowOutputFileName);
+                }
+            }
+        }
+
+        void processInterval(final HistogramLogReader.EncodedInterval interval, final double logStartTimeSec)
+                throws DataFormatException {
+            final EncodableHistogram intervalHistogram = decodeIntervalHistogram(interval);
+            if ((accumulatedRegularHistogram == null) && (accumulatedDoubleHistogram == null)) {
+                logUsesDoubleHistograms = (intervalHistogram instanceof DoubleHistogram);
+                if (logUsesDoubleHistograms) {
+                    accumulatedDoubleHistogram = ((DoubleHistogram) intervalHistogram).copy();
+                    accumulatedDoubleHistogram.reset();
+                    accumulatedDoubleHistogram.setAutoResize(true);
+                    movingWindowSumHistogram = new DoubleHistogram(3);
+                } else {
+                    accumulatedRegularHistogram = ((Histogram) intervalHistogram).copy();
+                    accumulatedRegularHistogram.reset();
+                    accumulatedRegularHistogram.setAutoResize(true);
+                    movingWindowSumHistogram = new Histogram(3);
+                }
+            }
+
+            accumulate(intervalHistogram, logUsesDoubleHistograms,
+                    accumulatedRegularHistogram, accumulatedDoubleHistogram);
+
+            if (config.movingWindow) {
+                updateMovingWindow(intervalHistogram, movingWindowSumHistogram, movingWindowQueue,
+                        recyclingIntervalHistograms() ? recycledIntervalHistograms : null);
+            }
+
+            if ((firstStartTime == 0.0) && (logStartTimeSec != 0.0)) {
+                firstStartTime = logStartTimeSec;
+                if (timeIntervalLog != null) {
+                    outputStartTime(timeIntervalLog, firstStartTime);
+                }
+            }
+
+            if (timeIntervalLog != null) {
+                if (!timeIntervalLogLegendWritten) {
+                    timeIntervalLogLegendWritten = true;
+                    outputTimeIntervalLogLegend(timeIntervalLog);
+                }
+                outputTimeIntervalLogLine(timeIntervalLog, logStartTimeSec, intervalHistogram,
+                        logUsesDoubleHistograms ? accumulatedDoubleHistogram : accumulatedRegularHistogram);
+            }
+
+            if (movingWindowLog != null) {
+                if (!movingWindowLogLegendWritten) {
+                    movingWindowLogLegendWritten = true;
+                    outputMovingWindowLogLegend(movingWindowLog);
+                }
+                outputMovingWindowLogLine(movingWindowLog, logStartTimeSec, intervalHistogram,
+                        movingWindowSumHistogram);
+            }
+
+            if (!config.movingWindow && recyclingIntervalHistograms()) {
+                // Nothing refers to the interval histogram any longer:
+                recycledIntervalHistograms.add((Histogram) intervalHistogram);
+            }
+        }
+
+        // Once a tag is known to use (integer value) histograms, intervals are decoded into recycled
+        // histograms (unless coordinated omission correction replaces them with corrected copies anyway):
+        private boolean recyclingIntervalHistograms() {
+            return (accumulatedRegularHistogram != null) &&
+                    !(config.expectedIntervalForCoordinatedOmissionCorrection > 0.0);
+        }
+
+        private EncodableHistogram decodeIntervalHistogram(final HistogramLogReader.EncodedInterval interval)
+                throws DataFormatException {
+            if (!recyclingIntervalHistograms()) {
+                final EncodableHistogram histogram = interval.decode();
+                if (config.expectedIntervalForCoordinatedOmissionCorrection > 0.0) {
+                    return copyCorrectedForCoordinatedOmission(histogram);
+                }
+                return histogram;
+            }
+            Histogram histogram = recycledIntervalHistograms.poll();
+            if (histogram == null) {
+                histogram = new Histogram(accumulatedRegularHistogram);
+            } else {
+                histogram.reset();
+            }
+            // Intervals are decoded into a fixed layout, which must be able to grow to cover their values:
+            histogram.setAutoResize(true);
+            histogram.addFromCompressedByteBuffer(interval.getCompressedBuffer());
+            histogram.setStartTimeStamp(interval.startTimeStampMsec);
+            histogram.setEndTimeStamp(interval.endTimeStampMsec);
+            histogram.setTag(interval.tag);
+            return histogram;
+        }
+
+        void outputPercentileDistribution(final PrintStream log) {
+            if (firstStartTime != 0.0) {
+                outputStartTime(log, firstStartTime);
+            }
+            if (logUsesDoubleHistograms) {
+                accumulatedDoubleHistogram.outputPercentileDistribution(log,
+                        config.percentilesOutputTicksPerHalf, config.outputValueUnitRatio, config.logFormatCsv);
+            } else {
+                accumulatedRegularHistogram.outputPercentileDistribution(log,
+                        config.percentilesOutputTicksPerHalf, config.outputValueUnitRatio, config.logFormatCsv);
+            }
+        }
+
+        void close() {
+            if (timeIntervalLog != null) {
+                timeIntervalLog.close();
+            }
+            if (movingWindowLog != null) {
+                movingWindowLog.close();
+            }
+        }
+    }
+
+    /**
+     * Process the intervals of all tags in a single pass over the log, producing per-tag outputs. The log is
+     * read (but not decoded) on the calling thread, and each interval is handed to the worker its tag is
+     * assigned to, which decodes and processes it.
+     */
+    private void runPerTag() {
+        final ExecutorService[] workers = new ExecutorService[Runtime.getRuntime().availableProcessors()];
+        for (int i = 0; i < workers.length; i++) {
+            workers[i] = Executors.newSingleThreadExecutor(new ThreadFactory() {
+                @Override
+                public Thread newThread(Runnable runnable) {
+                    Thread thread = new Thread(runnable, "HistogramLogProcessor-worker");
+                    thread.setDaemon(true);
+                    return thread;
+                }
+            });
+        }
+        final Semaphore pendingIntervalPermits = new Semaphore(workers.length * MAX_PENDING_INTERVALS_PER_WORKER);
+        final AtomicReference<Throwable> workerFailure = new AtomicReference<>();
+        // Tags are reported in order, with the default (no tag) lines first:
+        final Map<String, TagProcessor> tagProcessors = new TreeMap<>();
+        TagProcessor defaultTagProcessor = null;
+
+        try {
+            HistogramLogReader.EncodedInterval interval;
+            while (((interval = getEncodedIntervalHistogram()) != null) && (workerFailure.get() == null)) {
+                TagProcessor tagProcessor = (interval.tag == null) ? defaultTagProcessor :
+                        tagProcessors.get(interval.tag);
+                if (tagProcessor == null) {
+                    final int tagCount = tagProcessors.size() + ((defaultTagProcessor != null) ? 1 : 0);
+                    tagProcessor = new TagProcessor(interval.tag, workers[tagCount % workers.length]);
+                    if (interval.tag == null) {
+                        defaultTagProcessor = tagProcessor;
+                    } else {
+                        tagProcessors.put(interval.tag, tagProcessor);
+                    }
+                }
+                pendingIntervalPermits.acquireUninterruptibly();
+                final TagProcessor intervalTagProcessor = tagProcessor;
+                final HistogramLogReader.EncodedInterval intervalToProcess = interval;
+                final double logStartTimeSec = logReader.getStartTimeSec();
+                tagProcessor.worker.execute(new Runnable() {
+                    @Override
+                    public void run() {
+                        try {
+                            if (workerFailure.get() == null) {
+                                intervalTagProcessor.processInterval(intervalToProcess, logStartTimeSec);
+                            }
+                        } catch (Throwable t) {
+                            workerFailure.compareAndSet(null, t);
+                        } finally {
+                            pendingIntervalPermits.release();
+                        }
+                    }
+                });
+            }
+        } finally {
+            for (ExecutorService worker : workers) {
+                worker.shutdown();
+            }
+        }
+        boolean interrupted = false;
+        for (ExecutorService worker : workers) {
+            while (true) {
+                try {
+                    if (worker.awaitTermination(1, TimeUnit.SECONDS)) {
+                        break;
+                    }
+                } catch (InterruptedException ex) {
+                    interrupted = true;
+                }
+            }
+        }
+        if (interrupted) {
+            Thread.currentThread().interrupt();
+        }
+
+        final List<TagProcessor> orderedTagProcessors = new ArrayList<>();
+        if (defaultTagProcessor != null) {
+            orderedTagProcessors.add(defaultTagProcessor);
+        }
+        orderedTagProcessors.addAll(tagProcessors.values());
+        try {
+            final Throwable failure = workerFailure.get();
+            if (failure != null) {
+                System.err.println("Log file decoding error: an interval histogram could not be decoded or processed.");
+                if (config.verbose) {
+                    throw new RuntimeException(failure);
+                } else {
+                    System.exit(1);
+                }
+            }
+            for (TagProcessor tagProcessor : orderedTagProcessors) {
+                if (tagProcessor.outputFileName != null) {
+                    String hgrmOutputFileName = tagProcessor.outputFileName + ".hgrm";
+                    try (PrintStream histogramPercentileLog =
+                                 new PrintStream(new FileOutputStream(hgrmOutputFileName), false)) {
+                        outputTimeRange(histogramPercentileLog, "Overall percentile distribution");
+                        tagProcessor.outputPercentileDistribution(histogramPercentileLog);
+                    } catch (FileNotFoundException ex) {
+                        System.err.println("Failed to open percentiles histogram output file " + hgrmOutputFileName);
+                    }
+                } else {
+                    System.out.println("#[Tag: " +
+                            ((tagProcessor.tag == null) ? "[NO TAG (default)]" : tagProcessor.tag) + "]");
+                    tagProcessor.outputPercentileDistribution(System.out);
+                }
+            }
+        } finally {
+            for (TagProcessor tagProcessor : orderedTagProcessors) {
+                tagProcessor.close();
+            }
+        }
+    }
+
     /**
      * Construct a {@link org.HdrHistogram.HistogramLogProcessor} with the given arguments
      * (provided in command line style).
@@ -505,6 +899,8 @@ public class HistogramLogProcessor extends Thread {
      *                                                             recorded with coordinated omissions, and when an expected interval is known.
      * [-outputValueUnitRatio r]                                   The scaling factor by which to divide histogram recorded values units
      *                                                             in output. [default = 1000000.0 (1 msec in nsec)]"
+     * [-pertag]                                                   Produce separate outputs for each tag found in the input file,
+     *                                                             in a single pass over the file
      * </pre>
      * @param args command line arguments
      * @throws FileNotFoundException if specified input file is not found
@@ -512,8 +908,22 @@ public class HistogramLogProcessor extends Thread {
     public HistogramLogProcessor(final String[] args) throws FileNotFoundException {
         this.setName("HistogramLogProcessor");
         config = new HistogramLogProcessorConfiguration(args);
+        if (config.logFormatCsv) {
+            logFormat = "%.3f,%d,%.3f,%.3f,%.3f,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n";
+            movingWindowLogFormat = "%.3f,%d,%.3f,%.3f\n";
+        } else {
+            logFormat = "%4.3f: I:%d ( %7.3f %7.3f %7.3f ) T:%d ( %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f )\n";
+            movingWindowLogFormat = "%4.3f: I:%d P:%7.3f M:%7.3f\n";
+        }
         if (config.inputFileName != null) {
-            logReader = new HistogramLogReader(config.inputFileName);
+            final File inputFile = new File(config.inputFileName);
+            final File indexFile = HistogramLogIndex.indexFileFor(inputFile);
+            if (indexFile.exists()) {
+                // Use the log's sidecar index to seek directly to the requested time range:
+                logReader = new HistogramLogReader(inputFile, HistogramLogIndex.read(indexFile));
+            } else {
+                logReader = new HistogramLogReader(inputFile);
+            }
         } else {
             logReader = new HistogramLogReader(System.in);
         }
@@ -8,6 +8,9 @@
 package org.HdrHistogram;
 
 import java.io.*;
+import java.nio.ByteBuffer;
+import java.nio.channels.Channels;
+import java.nio.channels.FileChannel;
 import java.util.zip.DataFormatException;
 
 /**
@@ -50,10 +53,21 @@ import java.util.zip.DataFormatException;
  * by a number parse-able as a double, representing the start time (in seconds)
  * that may be added to timestamps in the file to determine an absolute
  * timestamp (e.g. since the epoch) for each interval.
+ * <p>
+ * A reader constructed with a {@link HistogramLogIndex} for its log file (see
+ * {@link #HistogramLogReader(File, HistogramLogIndex)}) seeks directly to the first
+ * interval of a requested time range, rather than scanning through the log up to it.
+ * <p>
+ * Binary histogram logs, as written by {@link BinaryHistogramLogWriter}, are read in the same way as
+ * text logs. The format of the log is detected when the reader is constructed. (Binary logs are not
+ * indexed, and are always scanned.)
  */
 public class HistogramLogReader implements Closeable {
 
-    private final HistogramLogScanner scanner;
+    private HistogramLogScanner scanner;
+    private final File indexedFile;
+    private final HistogramLogIndex index;
+    private long scannerStartLineNumber = 0;
     private final HistogramLogScanner.EventHandler handler = new HistogramLogScanner.EventHandler() {
         @Override
         public boolean onComment(String comment)
@@ -117,6 +131,46 @@ public class HistogramLogReader implements Closeable {
                 // after limit we stop on each line
                 return true;
             }
+
+            if (readingEncodedIntervals) {
+                // Leave the parsing and decoding of the payload to the caller:
+                final HistogramLogScanner.LazyHistogramReader lazyPayloadReader =
+                        (HistogramLogScanner.LazyHistogramReader) lazyReader;
+                final long startTimeStampMsec = (long) (absoluteStartTimeStampSec * 1000.0);
+                final long endTimeStampMsec = (long) (absoluteEndTimeStampSec * 1000.0);
+                if (lazyPayloadReader.isBinary()) {
+                    // Binary payloads are only valid until the next record is read, so keep a copy:
+                    final ByteBuffer payload = lazyPayloadReader.readCompressedBuffer();
+                    final ByteBuffer payloadCopy = ByteBuffer.allocate(payload.remaining());
+                    payloadCopy.put(payload).flip();
+                    nextEncodedInterval = new EncodedInterval(tag, startTimeStampMsec, endTimeStampMsec, payloadCopy);
+                } else {
+                    nextEncodedInterval = new EncodedInterval(tag, startTimeStampMsec, endTimeStampMsec,
+                            lazyPayloadReader.readCompressedPayload());
+                }
+                return true;
+            }
+
+            if (accumulator != null) {
+                // Filter on tag before decoding anything, and add the encoded form directly into the accumulator:
+                if ((accumulatorTag == null) ? (tag != null) : !accumulatorTag.equals(tag)) {
+                    return false;
+                }
+                try {
+                    accumulator.addFromCompressedByteBuffer(
+                            ((HistogramLogScanner.LazyHistogramReader) lazyReader).readCompressedBuffer());
+                } catch (DataFormatException e) {
+                    // stop after exception
+                    return true;
+                }
+                accumulator.setStartTimeStamp(
+                        Math.min(accumulator.getStartTimeStamp(), (long) (absoluteStartTimeStampSec * 1000.0)));
+                accumulator.setEndTimeStamp(
+                        Math.max(accumulator.getEndTimeStamp(), (long) (absoluteEndTimeStampSec * 1000.0)));
+                addedToAccumulator = true;
+                return true;
+            }
+
             EncodableHistogram histogram;
             try {
                 histogram = lazyReader.read();
@@ -159,6 +213,70 @@ public class HistogramLogReader implements Closeable {
     private double rangeStartTimeSec;
     private double rangeEndTimeSec;
     private EncodableHistogram nextHistogram;
+    private AbstractHistogram accumulator;
+    private String accumulatorTag;
+    private boolean addedToAccumulator;
+    private boolean readingEncodedIntervals;
+    private EncodedInterval nextEncodedInterval;
+
+    /**
+     * An interval read from the log in its encoded form, with its tag and (absolute) timestamps established,
+     * but with its histogram not yet parsed or decoded. Allows the (comparatively expensive) decoding of
+     * intervals to be performed elsewhere, e.g. on other threads than the one reading the log.
+     */
+    static class EncodedInterval {
+        final String tag;
+        final long startTimeStampMsec;
+        final long endTimeStampMsec;
+        // The Base64 encoded payload of a text log line, or the compressed payload of a binary log record:
+        private final String compressedPayload;
+        private final ByteBuffer compressedBuffer;
+
+        EncodedInterval(final String tag, final long startTimeStampMsec, final long endTimeStampMsec,
+                        final String compressedPayload) {
+            this.tag = tag;
+            this.startTimeStampMsec = startTimeStampMsec;
+            this.endTimeStampMsec = endTimeStampMsec;
+            this.compressedPayload = compressedPayload;
+            this.compressedBuffer = null;
+        }
+
+        EncodedInterval(final String tag, final long startTimeStampMsec, final long endTimeStampMsec,
+                        final ByteBuffer compressedBuffer) {
+            this.tag = tag;
+            this.startTimeStampMsec = startTimeStampMsec;
+            this.endTimeStampMsec = endTimeStampMsec;
+            this.compressedPayload = null;
+            this.compressedBuffer = compressedBuffer;
+        }
+
+        /**
+         * Get the compressed encoded histogram of the interval (e.g. to add into an accumulator with
+         * {@link AbstractHistogram#addFromCompressedByteBuffer(ByteBuffer)})
+         * @return a buffer containing the compressed encoded histogram
+         */
+        ByteBuffer getCompressedBuffer() {
+            if (compressedBuffer != null) {
+                return compressedBuffer.duplicate();
+            }
+            return ByteBuffer.wrap(Base64Helper.parseBase64Binary(compressedPayload));
+        }
+
+        /**
+         * Decode the interval's histogram, as {@link HistogramLogReader#nextIntervalHistogram(double, double)}
+         * would have
+         * @return the decoded histogram, with its timestamps and tag set
+         * @throws DataFormatException on errors in decoding the histogram
+         */
+        EncodableHistogram decode() throws DataFormatException {
+            final EncodableHistogram histogram =
+                    EncodableHistogram.decodeFromCompressedByteBuffer(getCompressedBuffer(), 0);
+            histogram.setStartTimeStamp(startTimeStampMsec);
+            histogram.setEndTimeStamp(endTimeStampMsec);
+            histogram.setTag(tag);
+            return histogram;
+        }
+    }
 
     /**
      * Constructs a new HistogramLogReader that produces intervals read from the specified file name.
@@ -167,6 +285,8 @@ public class HistogramLogReader implements Closeable {
      */
     public HistogramLogReader(final String inputFileName) throws FileNotFoundException {
         scanner = new HistogramLogScanner(new File(inputFileName));
+        indexedFile = null;
+        index = null;
     }
 
     /**
@@ -175,6 +295,8 @@ public class HistogramLogReader implements Closeable {
      */
     public HistogramLogReader(final InputStream inputStream) {
         scanner = new HistogramLogScanner(inputStream);
+        indexedFile = null;
+        index = null;
     }
 
     /**
@@ -184,6 +306,34 @@ public class HistogramLogReader implements Closeable {
      */
     public HistogramLogReader(final File inputFile) throws FileNotFoundException {
         scanner = new HistogramLogScanner(inputFile);
+        indexedFile = null;
+        index = null;
+    }
+
+    /**
+     * Constructs a new HistogramLogReader that produces intervals read from the specified file, using
+     * the given index of the file (see {@link HistogramLogIndex}) to seek directly to the first interval
+     * of requested time ranges.
+     * <p>
+     * The reader only ever seeks forward, past lines that it has not yet read, such that intervals
+     * read through it are the same as those that would be read without an index. The log's start time
+     * and base time are established from the index (see {@link HistogramLogIndex#getStartTimeSec()}).
+     * @param inputFile The File to read from
+     * @param index The index of inputFile
+     * @throws java.io.FileNotFoundException when unable to find inputFile
+     */
+    public HistogramLogReader(final File inputFile, final HistogramLogIndex index) throws FileNotFoundException {
+        scanner = new HistogramLogScanner(inputFile);
+        indexedFile = inputFile;
+        this.index = index;
+        if (!Double.isNaN(index.getStartTimeSec())) {
+            startTimeSec = index.getStartTimeSec();
+            observedStartTime = true;
+        }
+        if (!Double.isNaN(index.getBaseTimeSec())) {
+            baseTimeSec = index.getBaseTimeSec();
+            observedBaseTime = true;
+        }
     }
 
     /**
@@ -285,12 +435,134 @@ public class HistogramLogReader implements Closeable {
         this.rangeStartTimeSec = rangeStartTimeSec;
         this.rangeEndTimeSec = rangeEndTimeSec;
         this.absolute = absolute;
+        seekToRangeStart();
         scanner.process(handler);
         EncodableHistogram histogram = this.nextHistogram;
         nextHistogram = null;
         return histogram;
     }
 
+    /**
+     * Add the next interval histogram in the log with a matching tag to the given accumulator, if the interval
+     * falls within a time range.
+     * <p>
+     * This is equivalent to (but cheaper than) reading matching intervals with
+     * {@link #nextIntervalHistogram(double, double)} and adding them to the accumulator: interval lines
+     * whose tag does not match are skipped without being decoded, and the encoded form of a matching
+     * interval is added directly into the accumulator (see
+     * {@link AbstractHistogram#addFromCompressedByteBuffer(java.nio.ByteBuffer)}), without constructing a
+     * histogram for it. The accumulator's start and end timestamps are extended to cover the (absolute)
+     * time range of the added interval.
+     * <p>
+     * The range is assumed to be in seconds relative to the actual timestamp value found in each interval
+     * line in the log, and not in absolute time. Timestamps are assumed to appear in order in the log file,
+     * and as such this method will return false upon encountering a timestamp larger than endTimeSec.
+     * <p>
+     * Upon encountering any unexpected format errors in reading the next interval from the file, this
+     * method will return false. Use {@link #hasNext} to determine whether or not additional intervals may
+     * be available for reading in the log input.
+     *
+     * @param accumulator The histogram to add the interval to. Interval histograms in the log
+     *                    must be (integer value) histograms.
+     * @param startTimeSec The (non-absolute time) start of the expected
+     *                     time range, in seconds.
+     * @param endTimeSec The (non-absolute time) end of the expected time
+     *                   range, in seconds.
+     * @param tag The tag of the intervals to add, or null to add only intervals that have no tag
+     * @return true if an interval was added to the accumulator, or false if no appropriate interval found
+     */
+    public boolean addNextIntervalHistogramTo(final AbstractHistogram accumulator,
+                                              final double startTimeSec,
+                                              final double endTimeSec,
+                                              final String tag) {
+        this.rangeStartTimeSec = startTimeSec;
+        this.rangeEndTimeSec = endTimeSec;
+        this.absolute = false;
+        seekToRangeStart();
+        this.accumulator = accumulator;
+        this.accumulatorTag = tag;
+        this.addedToAccumulator = false;
+        try {
+            scanner.process(handler);
+        } finally {
+            this.accumulator = null;
+            this.accumulatorTag = null;
+        }
+        return addedToAccumulator;
+    }
+
+    /**
+     * Read the next interval in the log (of any tag), if the interval falls within a time range, without
+     * parsing or decoding its histogram. The range is interpreted as it is by
+     * {@link #nextIntervalHistogram(double, double)}.
+     *
+     * @param startTimeSec The (non-absolute time) start of the expected time range, in seconds.
+     * @param endTimeSec The (non-absolute time) end of the expected time range, in seconds.
+     * @return an encoded interval, or a null if no appropriate interval found
+     */
+    EncodedInterval nextEncodedIntervalHistogram(final double startTimeSec, final double endTimeSec) {
+        this.rangeStartTimeSec = startTimeSec;
+        this.rangeEndTimeSec = endTimeSec;
+        this.absolute = false;
+        seekToRangeStart();
+        this.readingEncodedIntervals = true;
+        try {
+            scanner.process(handler);
+        } finally {
+            this.readingEncodedIntervals = false;
+        }
+        final EncodedInterval interval = nextEncodedInterval;
+        nextEncodedInterval = null;
+        return interval;
+    }
+
+    /**
+     * If the log is indexed, seek forward to the first interval line at or after the range start time
+     * (when that line has not yet been read).
+     */
+    private void seekToRangeStart() {
+        if ((index == null) || (index.getEntryCount() == 0)) {
+            return;
+        }
+        if (!observedStartTime) {
+            // No explicit start time noted. Use 1st logged time, as the handler would:
+            startTimeSec = index.getTimestampSec(0);
+            observedStartTime = true;
+        }
+        if (!observedBaseTime) {
+            // No explicit base time noted. Deduce from 1st logged time, using the handler's criteria:
+            baseTimeSec = (index.getTimestampSec(0) < startTimeSec - (365 * 24 * 3600.0)) ? startTimeSec : 0.0;
+            observedBaseTime = true;
+        }
+        final double rangeStartLoggedTimeStampSec = absolute ?
+                (rangeStartTimeSec - baseTimeSec) :
+                (rangeStartTimeSec + startTimeSec - baseTimeSec);
+        // Logged timestamps have msec resolution. Seek to a msec earlier to be immune to rounding:
+        final int entry = index.findFirstEntryAtOrAfter(rangeStartLoggedTimeStampSec - 0.001);
+        if (entry == index.getEntryCount()) {
+            return;
+        }
+        final long entryLineNumber = index.getLineNumber(entry);
+        if (entryLineNumber <= scannerStartLineNumber + scanner.getProcessedLineCount()) {
+            return; // Never seek backwards, or to where we already are.
+        }
+        try {
+            final FileInputStream inputStream = new FileInputStream(indexedFile);
+            final FileChannel channel = inputStream.getChannel();
+            try {
+                channel.position(index.getByteOffset(entry));
+            } catch (IOException ex) {
+                inputStream.close();
+                throw ex;
+            }
+            scanner.close();
+            scanner = new HistogramLogScanner(Channels.newInputStream(channel));
+            scannerStartLineNumber = entryLineNumber;
+        } catch (IOException ex) {
+            throw new IllegalStateException("Failed to seek in indexed log file " + indexedFile, ex);
+        }
+    }
+
     /**
      * Indicates whether or not additional intervals may exist in the log
      * @return true if additional intervals may exist in the log
@@ -9,10 +9,20 @@ package org.HdrHistogram;
 
 import java.io.*;
 import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
 import java.util.Locale;
+import java.util.NoSuchElementException;
 import java.util.Scanner;
 import java.util.zip.DataFormatException;
 
+import static org.HdrHistogram.BinaryHistogramLogWriter.*;
+
+/**
+ * Scans histogram logs, reporting the events in them to an {@link EventHandler}.
+ * <p>
+ * Both text logs (as written by {@link HistogramLogWriter}) and binary logs (as written by
+ * {@link BinaryHistogramLogWriter}) are supported. The format of a log is detected from its first bytes.
+ */
 public class HistogramLogScanner implements Closeable {
 
     // can't use lambdas, and anyway we need to let the handler take the exception
@@ -42,9 +52,10 @@ public class HistogramLogScanner implements Closeable {
         boolean onException(Throwable t);
     }
     
-    private static class LazyHistogramReader implements EncodableHistogramSupplier {
+    static class LazyHistogramReader implements EncodableHistogramSupplier {
 
         private final Scanner scanner;
+        private ByteBuffer binaryPayload;
         private boolean gotIt = true;
 
         private LazyHistogramReader(Scanner scanner)
@@ -56,27 +67,86 @@ public class HistogramLogScanner implements Closeable {
         {
             gotIt = false;
         }
+
+        private void allowGet(final ByteBuffer binaryPayload)
+        {
+            this.binaryPayload = binaryPayload;
+            gotIt = false;
+        }
+
+        /**
+         * Indicates whether the payloads read are from a binary log, in which case the buffers returned by
+         * {@link #readCompressedBuffer()} are only valid until the next record is scanned.
+         * @return true if the payloads read are from a binary log
+         */
+        boolean isBinary()
+        {
+            return scanner == null;
+        }
         
         @Override
         public EncodableHistogram read() throws DataFormatException
         {
-            // prevent double calls to this method
-            if (gotIt) {
-                throw new IllegalStateException();
-            }
-            gotIt = true;
-            
-            final String compressedPayloadString = scanner.next();
-            final ByteBuffer buffer = ByteBuffer.wrap(Base64Helper.parseBase64Binary(compressedPayloadString));
+            final ByteBuffer buffer = readCompressedBuffer();
 
             EncodableHistogram histogram = EncodableHistogram.decodeFromCompressedByteBuffer(buffer, 0);
 
             return histogram;       
         }
+
+        /**
+         * Read the (still compressed) encoded histogram payload of the current line, without decoding it.
+         * Like {@link #read()}, this may be called only once per line.
+         * @return a buffer containing the compressed encoded histogram
+         */
+        ByteBuffer readCompressedBuffer()
+        {
+            if (isBinary()) {
+                checkAndClearGet();
+                return binaryPayload;
+            }
+            return ByteBuffer.wrap(Base64Helper.parseBase64Binary(readCompressedPayload()));
+        }
+
+        /**
+         * Read the (still Base64 encoded) compressed histogram payload of the current line, without parsing it.
+         * Like {@link #read()}, this may be called only once per line.
+         * @return the Base64 encoded compressed histogram
+         */
+        String readCompressedPayload()
+        {
+            if (isBinary()) {
+                final ByteBuffer payload = readCompressedBuffer();
+                final byte[] payloadBytes = new byte[payload.remaining()];
+                payload.get(payloadBytes);
+                return Base64Helper.printBase64Binary(payloadBytes);
+            }
+            checkAndClearGet();
+            return scanner.next();
+        }
+
+        private void checkAndClearGet()
+        {
+            // prevent double calls to the read methods
+            if (gotIt) {
+                throw new IllegalStateException();
+            }
+            gotIt = true;
+        }
     }
 
+    // A bound on the length of a binary record, generously (4x) above the largest possible encoding of a histogram
+    // (~6.2M counts, for a 5 digit histogram covering the full long range, at up to 9 bytes each), such that a
+    // corrupt record length is reported rather than allocated for:
+    static final int MAX_BINARY_RECORD_LENGTH = 1 << 28;
+
     private final LazyHistogramReader lazyReader;
+    // Exactly one of scanner (for text logs) and binaryInput (for binary logs) is non-null:
     protected final Scanner scanner;
+    private final DataInputStream binaryInput;
+    private byte[] binaryRecordBytes = new byte[256];
+    private ByteBuffer binaryRecord = ByteBuffer.wrap(binaryRecordBytes);
+    private long processedLineCount = 0;
     
     /**
      * Constructs a new HistogramLogReader that produces intervals read from the specified file name.
@@ -84,7 +154,7 @@ public class HistogramLogScanner implements Closeable {
      * @throws java.io.FileNotFoundException when unable to find inputFileName
      */
     public HistogramLogScanner(final String inputFileName) throws FileNotFoundException {
-        this(new Scanner(new File(inputFileName)));
+        this(new FileInputStream(inputFileName));
     }
 
     /**
@@ -95,7 +165,17 @@ public class HistogramLogScanner implements Closeable {
      * @param inputStream The InputStream to read from
      */
     public HistogramLogScanner(final InputStream inputStream) {
-        this(new Scanner(inputStream));
+        final BufferedInputStream bufferedInput = new BufferedInputStream(inputStream);
+        if (startsWithBinaryLogCookie(bufferedInput)) {
+            this.scanner = null;
+            this.binaryInput = new DataInputStream(bufferedInput);
+            readBinaryLogHeader();
+        } else {
+            this.scanner = new Scanner(bufferedInput);
+            this.binaryInput = null;
+            initScanner();
+        }
+        this.lazyReader = new LazyHistogramReader(scanner);
     }
 
     /**
@@ -104,14 +184,39 @@ public class HistogramLogScanner implements Closeable {
      * @throws java.io.FileNotFoundException when unable to find inputFile
      */
     public HistogramLogScanner(final File inputFile) throws FileNotFoundException {
-        this(new Scanner(inputFile));
+        this(new FileInputStream(inputFile));
     }
 
-    private HistogramLogScanner(Scanner scanner)
-    {
-        this.scanner = scanner;
-        this.lazyReader = new LazyHistogramReader(scanner);
-        initScanner();
+    private static boolean startsWithBinaryLogCookie(final BufferedInputStream input) {
+        final byte[] cookieBytes = new byte[4];
+        int bytesRead = 0;
+        input.mark(cookieBytes.length);
+        try {
+            int n;
+            while ((bytesRead < cookieBytes.length) &&
+                    ((n = input.read(cookieBytes, bytesRead, cookieBytes.length - bytesRead)) >= 0)) {
+                bytesRead += n;
+            }
+            input.reset();
+        } catch (IOException ex) {
+            // Leave it to the (text) scanner to report on the log ending, as it would for any text log:
+            return false;
+        }
+        return (bytesRead == cookieBytes.length) &&
+                (ByteBuffer.wrap(cookieBytes).getInt() == BINARY_LOG_COOKIE);
+    }
+
+    private void readBinaryLogHeader() {
+        final int formatVersion;
+        try {
+            binaryInput.readInt(); // The cookie
+            formatVersion = binaryInput.readInt();
+        } catch (IOException ex) {
+            throw new IllegalArgumentException("Failed to read the binary histogram log header", ex);
+        }
+        if (formatVersion > BINARY_LOG_FORMAT_VERSION) {
+            throw new IllegalArgumentException("Unsupported binary histogram log format version " + formatVersion);
+        }
     }
 
     private void initScanner() {
@@ -125,10 +230,22 @@ public class HistogramLogScanner implements Closeable {
     @Override
     public void close()
     {
-        scanner.close();
+        if (scanner != null) {
+            scanner.close();
+        } else {
+            try {
+                binaryInput.close();
+            } catch (IOException ex) {
+                throw new IllegalStateException("Failed to close the binary histogram log", ex);
+            }
+        }
     }
 
     public void process(EventHandler handler) {
+        if (binaryInput != null) {
+            processBinaryLog(handler);
+            return;
+        }
         while (scanner.hasNextLine()) {
             try {
                 if (scanner.hasNext("\\#.*")) {
@@ -183,16 +300,119 @@ public class HistogramLogScanner implements Closeable {
                 }
             } finally {
                 scanner.nextLine(); // Move to next line.
+                processedLineCount++;
             }
         }
     }
 
+    private void processBinaryLog(EventHandler handler) {
+        while (hasNextLine()) {
+            try {
+                final byte recordType = readBinaryRecord();
+                final ByteBuffer record = binaryRecord;
+                switch (recordType) {
+                    case START_TIME_RECORD:
+                        if (handler.onStartTime(record.getDouble())) {
+                            return;
+                        }
+                        break;
+                    case BASE_TIME_RECORD:
+                        if (handler.onBaseTime(record.getDouble())) {
+                            return;
+                        }
+                        break;
+                    case COMMENT_RECORD:
+                        if (handler.onComment("#" + new String(binaryRecordBytes, record.position(),
+                                record.remaining(), StandardCharsets.UTF_8))) {
+                            return;
+                        }
+                        break;
+                    case INTERVAL_RECORD:
+                        final double logTimeStampInSec = record.getDouble();
+                        final double intervalLengthSec = record.getDouble();
+                        record.getDouble(); // Skip max value, as max value can be deduced from the histogram.
+                        final int tagLength = record.getInt();
+                        String tagString = null;
+                        if (tagLength >= 0) {
+                            tagString = new String(binaryRecordBytes, record.position(), tagLength,
+                                    StandardCharsets.UTF_8);
+                            record.position(record.position() + tagLength);
+                        }
+                        // The compressed histogram fills the rest of the record:
+                        lazyReader.allowGet(record.slice());
+                        if (handler.onHistogram(tagString, logTimeStampInSec, intervalLengthSec, lazyReader)) {
+                            return;
+                        }
+                        break;
+                    default:
+                        // Skip records of unknown types
+                        break;
+                }
+            } catch (Throwable ex) {
+                if (handler.onException(ex)) {
+                    return;
+                }
+            } finally {
+                processedLineCount++;
+            }
+        }
+    }
+
+    // Read the next binary record into binaryRecord, positioned after its record type, and return the record type:
+    private byte readBinaryRecord() throws IOException {
+        try {
+            final int recordLength = binaryInput.readInt();
+            if (recordLength < 1) {
+                throw new IOException("Invalid binary histogram log record length " + recordLength);
+            }
+            if (recordLength > MAX_BINARY_RECORD_LENGTH) {
+                // Skip past the record (if it is really there), such that following records can still be read:
+                long remainingLength = recordLength;
+                long skippedLength;
+                while ((remainingLength > 0) && ((skippedLength = binaryInput.skip(remainingLength)) > 0)) {
+                    remainingLength -= skippedLength;
+                }
+                throw new IOException("Binary histogram log record length " + recordLength +
+                        " exceeds the maximum record length " + MAX_BINARY_RECORD_LENGTH);
+            }
+            if (binaryRecordBytes.length < recordLength) {
+                binaryRecordBytes = new byte[recordLength];
+                binaryRecord = ByteBuffer.wrap(binaryRecordBytes);
+            }
+            binaryInput.readFully(binaryRecordBytes, 0, recordLength);
+            binaryRecord.clear();
+            binaryRecord.limit(recordLength);
+            return binaryRecord.get();
+        } catch (EOFException ex) {
+            // Treat a truncated last record like a truncated last text line (the log may still be being written):
+            throw new NoSuchElementException("Truncated binary histogram log record");
+        }
+    }
+
     /**
      * Indicates whether or not additional intervals may exist in the log
      * 
      * @return true if additional intervals may exist in the log
      */
     public boolean hasNextLine() {
-        return scanner.hasNextLine();
+        if (scanner != null) {
+            return scanner.hasNextLine();
+        }
+        try {
+            binaryInput.mark(1);
+            final boolean hasNext = (binaryInput.read() >= 0);
+            binaryInput.reset();
+            return hasNext;
+        } catch (IOException ex) {
+            return false;
+        }
+    }
+
+    /**
+     * Get the number of lines (or, for binary logs, records) processed so far
+     * @return the number of lines processed so far
+     */
+    long getProcessedLineCount() {
+        return processedLineCount;
     }
 }
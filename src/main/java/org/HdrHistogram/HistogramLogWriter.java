@@ -2,10 +2,12 @@ package org.HdrHistogram;
 
 import java.io.File;
 import java.io.FileNotFoundException;
+import java.io.FileOutputStream;
+import java.io.FilterOutputStream;
+import java.io.IOException;
 import java.io.OutputStream;
 import java.io.PrintStream;
 import java.nio.ByteBuffer;
-import java.util.Arrays;
 import java.util.Date;
 import java.util.Locale;
 import java.util.regex.Matcher;
@@ -39,6 +41,9 @@ import static java.nio.ByteOrder.BIG_ENDIAN;
  * to use a comment to indicate the logging application at the head
  * of the log, followed by the log format version, a start time,
  * and a legend (in that order).
+ * <p>
+ * A log writer can optionally produce a sidecar {@link HistogramLogIndex} for the log it writes (see
+ * {@link #outputIndexTo(File)}), allowing readers to seek directly to the intervals in a time range.
  *
  */
 public class HistogramLogWriter {
@@ -48,8 +53,16 @@ public class HistogramLogWriter {
     private Matcher containsDelimiterMatcher = containsDelimiterPattern.matcher("");
 
     private final PrintStream log;
+    private final LineCountingOutputStream logCounter;
+    private PrintStream indexLog = null;
+    private boolean observedIntervals = false;
 
     private ByteBuffer targetBuffer;
+    private final StringBuilder lineFields = new StringBuilder(128);
+    private byte[] lineBuffer;
+
+    private HistogramCompressionCodec compressionCodec = HistogramCompressionCodecs.DEFLATE;
+    private int compressionLevel = Deflater.BEST_COMPRESSION;
 
     private long baseTime = 0;
 
@@ -59,7 +72,7 @@ public class HistogramLogWriter {
      * @throws FileNotFoundException when unable to open outputFileName
      */
     public HistogramLogWriter(final String outputFileName) throws FileNotFoundException {
-        log = new PrintStream(outputFileName);
+        this(new FileOutputStream(outputFileName));
     }
 
     /**
@@ -68,7 +81,7 @@ public class HistogramLogWriter {
      * @throws FileNotFoundException when unable to open outputFile
      */
     public HistogramLogWriter(final File outputFile) throws FileNotFoundException {
-        log = new PrintStream(outputFile);
+        this(new FileOutputStream(outputFile));
     }
 
     /**
@@ -76,7 +89,8 @@ public class HistogramLogWriter {
      * @param outputStream The OutputStream to write to
      */
     public HistogramLogWriter(final OutputStream outputStream) {
-        log = new PrintStream(outputStream);
+        logCounter = new LineCountingOutputStream(outputStream);
+        log = new PrintStream(logCounter);
     }
 
     /**
@@ -84,14 +98,78 @@ public class HistogramLogWriter {
      * @param printStream The PrintStream to write to
      */
     public HistogramLogWriter(final PrintStream printStream) {
+        logCounter = null;
         log = printStream;
     }
 
+    /**
+     * Output a sidecar index of the log (see {@link HistogramLogIndex}) into the specified file. The index
+     * file would conventionally be named with {@link HistogramLogIndex#indexFileFor(File)}.
+     * <p>
+     * Indexing must be started before any output is written to the log, and is only supported for log
+     * writers constructed around a file or an output stream (and not a {@link PrintStream}). Byte offsets
+     * recorded in the index are relative to the start of this writer's output.
+     * @param indexFile The File to write the index to
+     * @throws FileNotFoundException when unable to open indexFile
+     */
+    public void outputIndexTo(final File indexFile) throws FileNotFoundException {
+        outputIndexTo(new FileOutputStream(indexFile));
+    }
+
+    /**
+     * Output a sidecar index of the log (see {@link HistogramLogIndex}) into the specified output stream,
+     * which will be closed when this writer is closed. See {@link #outputIndexTo(File)}.
+     * @param indexStream The OutputStream to write the index to
+     */
+    public synchronized void outputIndexTo(final OutputStream indexStream) {
+        if (logCounter == null) {
+            throw new IllegalStateException(
+                    "Log indexing is not supported for log writers constructed around a PrintStream");
+        }
+        if (indexLog != null) {
+            throw new IllegalStateException("Log indexing has already been started");
+        }
+        if (logCounter.getByteCount() != 0) {
+            throw new IllegalStateException("Log indexing must be started before any output is written");
+        }
+        indexLog = new PrintStream(indexStream);
+        indexLog.format("#[Histogram log index format version %s]\n", HistogramLogIndex.INDEX_FORMAT_VERSION);
+    }
+
+    /**
+     * Set the compression codec (and codec specific compression level) used for logged interval histograms.
+     * Defaults to {@link HistogramCompressionCodecs#DEFLATE} at {@link Deflater#BEST_COMPRESSION}.
+     * <p>
+     * Logs written with codecs other than {@link HistogramCompressionCodecs#DEFLATE} can only be read where
+     * the codec is available (see {@link HistogramCompressionCodecs}).
+     * @param compressionCodec The compression codec to use
+     * @param compressionLevel The codec specific compression level to use
+     */
+    public synchronized void setCompressionCodec(final HistogramCompressionCodec compressionCodec,
+                                                 final int compressionLevel) {
+        if (compressionCodec == null) {
+            throw new IllegalArgumentException("compressionCodec cannot be null");
+        }
+        this.compressionCodec = compressionCodec;
+        this.compressionLevel = compressionLevel;
+    }
+
+    /**
+     * Get the compression codec used for logged interval histograms.
+     * @return the compression codec used for logged interval histograms
+     */
+    public synchronized HistogramCompressionCodec getCompressionCodec() {
+        return compressionCodec;
+    }
+
     /**
      * Closes the file or output stream for this log writer.
      */
     public void close() {
         log.close();
+        if (indexLog != null) {
+            indexLog.close();
+        }
     }
 
     /**
@@ -109,35 +187,80 @@ public class HistogramLogWriter {
                                         final double endTimeStampSec,
                                         final EncodableHistogram histogram,
                                         final double maxValueUnitRatio) {
-        if ((targetBuffer == null) || targetBuffer.capacity() < histogram.getNeededByteBufferCapacity()) {
-            targetBuffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity()).order(BIG_ENDIAN);
+        int neededCapacity = histogram.getNeededCompressedByteBufferCapacity(compressionCodec);
+        if ((targetBuffer == null) || targetBuffer.capacity() < neededCapacity) {
+            targetBuffer = ByteBuffer.allocate(neededCapacity).order(BIG_ENDIAN);
         }
         targetBuffer.clear();
 
-        int compressedLength = histogram.encodeIntoCompressedByteBuffer(targetBuffer, Deflater.BEST_COMPRESSION);
-        byte[] compressedArray = Arrays.copyOf(targetBuffer.array(), compressedLength);
+        int compressedLength =
+                histogram.encodeIntoCompressedByteBuffer(targetBuffer, compressionCodec, compressionLevel);
 
         String tag = histogram.getTag();
-        if (tag == null) {
-            log.format(Locale.US, "%.3f,%.3f,%.3f,%s\n",
-                    startTimeStampSec,
-                    endTimeStampSec - startTimeStampSec,
-                    histogram.getMaxValueAsDouble() / maxValueUnitRatio,
-                    Base64Helper.printBase64Binary(compressedArray)
-            );
-        } else {
+        if (tag != null) {
             containsDelimiterMatcher.reset(tag);
             if (containsDelimiterMatcher.matches()) {
                 throw new IllegalArgumentException("Tag string cannot contain commas, spaces, or line breaks");
             }
-            log.format(Locale.US, "Tag=%s,%.3f,%.3f,%.3f,%s\n",
-                    tag,
-                    startTimeStampSec,
-                    endTimeStampSec - startTimeStampSec,
-                    histogram.getMaxValueAsDouble() / maxValueUnitRatio,
-                    Base64Helper.printBase64Binary(compressedArray)
-            );
         }
+
+        // Compose the line's text fields with no Formatter involved (producing the same text as the
+        // "[Tag=%s,]%.3f,%.3f,%.3f," format would), and Base64 encode the compressed histogram straight
+        // after them into the (reused) line buffer:
+        lineFields.setLength(0);
+        if (tag != null) {
+            lineFields.append("Tag=").append(tag).append(',');
+        }
+        FixedPointFormat.append(lineFields, startTimeStampSec, 3, 0);
+        lineFields.append(',');
+        FixedPointFormat.append(lineFields, endTimeStampSec - startTimeStampSec, 3, 0);
+        lineFields.append(',');
+        FixedPointFormat.append(lineFields, histogram.getMaxValueAsDouble() / maxValueUnitRatio, 3, 0);
+        lineFields.append(',');
+
+        // Line fields are (almost always) all ASCII, in which case their chars are copied over as bytes:
+        final byte[] fieldBytes = nonAsciiTextBytes(lineFields);
+        final int fieldsLength = (fieldBytes != null) ? fieldBytes.length : lineFields.length();
+        final int lineLength = fieldsLength + Base64Helper.getEncodedLength(compressedLength) + 1;
+        if ((lineBuffer == null) || (lineBuffer.length < lineLength)) {
+            lineBuffer = new byte[lineLength];
+        }
+        if (fieldBytes != null) {
+            System.arraycopy(fieldBytes, 0, lineBuffer, 0, fieldsLength);
+        } else {
+            for (int i = 0; i < fieldsLength; i++) {
+                lineBuffer[i] = (byte) lineFields.charAt(i);
+            }
+        }
+        int position = fieldsLength;
+        position += Base64Helper.printBase64Binary(targetBuffer.array(), targetBuffer.arrayOffset(), compressedLength,
+                lineBuffer, position);
+        lineBuffer[position++] = '\n';
+
+        indexIntervalLine(tag, startTimeStampSec);
+        log.write(lineBuffer, 0, position);
+    }
+
+    /**
+     * Get the bytes of text (in the default charset, as the log's PrintStream would) if it contains non-ASCII
+     * characters, or null if it is all ASCII (in which case its characters are its bytes).
+     */
+    private static byte[] nonAsciiTextBytes(final CharSequence text) {
+        for (int i = 0; i < text.length(); i++) {
+            if (text.charAt(i) >= 0x80) {
+                return text.toString().getBytes();
+            }
+        }
+        return null;
+    }
+
+    private void indexIntervalLine(final String tag, final double startTimeStampSec) {
+        if (indexLog != null) {
+            // Index the (zero based) line number and byte offset of the interval line about to be logged:
+            HistogramLogIndex.outputEntry(indexLog, tag, startTimeStampSec,
+                    logCounter.getLineCount(), logCounter.getByteCount());
+        }
+        observedIntervals = true;
     }
 
     /**
@@ -188,6 +311,7 @@ public class HistogramLogWriter {
         log.format(Locale.US, "#[StartTime: %.3f (seconds since epoch), %s]\n",
                 startTimeMsec / 1000.0,
                 (new Date(startTimeMsec)).toString());
+        outputIndexedTime("StartTime", startTimeMsec);
     }
 
 
@@ -198,6 +322,14 @@ public class HistogramLogWriter {
     public void outputBaseTime(final long baseTimeMsec) {
         log.format(Locale.US, "#[BaseTime: %.3f (seconds since epoch)]\n",
                 baseTimeMsec/1000.0);
+        outputIndexedTime("BaseTime", baseTimeMsec);
+    }
+
+    private synchronized void outputIndexedTime(final String timeName, final long timeMsec) {
+        // Only start and base times noted ahead of the log's intervals apply to reading the log:
+        if ((indexLog != null) && !observedIntervals) {
+            indexLog.format(Locale.US, "#[%s: %.3f]\n", timeName, timeMsec / 1000.0);
+        }
     }
 
     /**
@@ -241,4 +373,44 @@ public class HistogramLogWriter {
     public long getBaseTime() {
         return baseTime;
     }
+
+    /**
+     * Counts the bytes and line terminators written through it, to track the position of logged lines.
+     */
+    private static class LineCountingOutputStream extends FilterOutputStream {
+        private long byteCount = 0;
+        private long lineCount = 0;
+
+        LineCountingOutputStream(final OutputStream out) {
+            super(out);
+        }
+
+        @Override
+        public void write(final int b) throws IOException {
+            out.write(b);
+            byteCount++;
+            if (b == '\n') {
+                lineCount++;
+            }
+        }
+
+        @Override
+        public void write(final byte[] b, final int off, final int len) throws IOException {
+            out.write(b, off, len);
+            byteCount += len;
+            for (int i = off; i < off + len; i++) {
+                if (b[i] == '\n') {
+                    lineCount++;
+                }
+            }
+        }
+
+        long getByteCount() {
+            return byteCount;
+        }
+
+        long getLineCount() {
+            return lineCount;
+        }
+    }
 }
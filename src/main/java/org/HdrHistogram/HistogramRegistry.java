@@ -0,0 +1,428 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.LongBuffer;
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicLongArray;
+
+/**
+ * A registry of keyed, same-shaped recorders, whose value counts are all held in a few large slab segments
+ * (per recording phase), and which provides stable interval {@link Histogram} samples of all keys at once
+ * without interrupting or stalling active recording of values.
+ * <p>
+ * Tracking many (e.g. per-endpoint, per-status and per-tenant) histograms as individual {@link Recorder}
+ * instances carries the per-instance overhead of separate histogram objects and counts arrays for each key,
+ * scattered across the heap. A {@link HistogramRegistry} instead allocates the counts of its keys in slab
+ * segments, each holding the counts of several keys (each key owning a fixed range of a segment), and records
+ * through lightweight per-key {@link Handle}s. Segments are allocated as keys are registered, such that the
+ * registry's footprint is proportional to the number of registered keys rather than to its capacity. All keys share a single {@link WriterReaderPhaser}, and are flipped together.
+ * <p>
+ * {@link Handle}s support concurrent recording calls. Recording calls are wait-free on architectures that support
+ * atomic increment operations, and are lock-free on architectures that do not. Since keys do not track their
+ * min, max and total counts while recording, these are established when interval histograms are taken.
+ * <p>
+ * A common pattern for using a {@link HistogramRegistry} looks like this:
+ * <br><pre><code>
+ * HistogramRegistry&lt;String&gt; registry = new HistogramRegistry&lt;&gt;(10000, 1, 3600000000000L, 2);
+ * ...
+ * // On the recording path:
+ * registry.handleFor(endpointName).recordValue(latencyNsec);
+ * ...
+ * [start of some loop construct that periodically wants to log interval histograms]
+ *   ...
+ *   // Log the interval histograms of all keys (tagged with their keys) in one pass:
+ *   registry.outputIntervalHistograms(histogramLogWriter);
+ *   ...
+ * [end of loop construct]
+ * </code></pre>
+ *
+ * @param <K> The type of the registry's keys
+ */
+public class HistogramRegistry<K> {
+    // The (targeted) number of counts in a slab segment:
+    private static final int SEGMENT_TARGET_LENGTH = 64 * 1024;
+
+    private final WriterReaderPhaser recordingPhaser = new WriterReaderPhaser();
+
+    // A template histogram establishing the shape (value to index mapping) shared by all keys:
+    private final Histogram shape;
+    private final int countsArrayLength;
+    private final int capacity;
+    private final int keysPerSegment;
+
+    // The slab segments of each phase (indexed by segment), allocated as keys are registered:
+    private volatile AtomicLongArray[] activeCounts;
+    private AtomicLongArray[] inactiveCounts;
+
+    private final ConcurrentHashMap<K, Handle> handles = new ConcurrentHashMap<>();
+    private final List<Handle> handlesBySlot = new ArrayList<>();
+
+    private long intervalStartTimeStampMsec;
+    private Histogram outputHistogram;
+
+    /**
+     * Construct a {@link HistogramRegistry} for up to a given number of keys, given the Lowest and highest values
+     * to be tracked and a number of significant decimal digits (shared by all keys).
+     *
+     * @param capacity The maximum number of keys that may be registered
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public HistogramRegistry(final int capacity,
+                             final long lowestDiscernibleValue,
+                             final long highestTrackableValue,
+                             final int numberOfSignificantValueDigits) {
+        if (capacity < 1) {
+            throw new IllegalArgumentException("capacity must be >= 1");
+        }
+        shape = new Histogram(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+        countsArrayLength = shape.countsArrayLength;
+        this.capacity = capacity;
+        keysPerSegment = Math.min(capacity, Math.max(1, SEGMENT_TARGET_LENGTH / countsArrayLength));
+        final int segmentCount = (capacity + keysPerSegment - 1) / keysPerSegment;
+        activeCounts = new AtomicLongArray[segmentCount];
+        inactiveCounts = new AtomicLongArray[segmentCount];
+        intervalStartTimeStampMsec = System.currentTimeMillis();
+    }
+
+    /**
+     * Get the recording handle for the given key, registering the key if it is not yet registered.
+     *
+     * @param key The key
+     * @return The recording handle for the key
+     * @throws IllegalStateException if the key is not registered and the registry is at capacity
+     */
+    public Handle handleFor(final K key) {
+        Handle handle = handles.get(key);
+        return (handle != null) ? handle : register(key);
+    }
+
+    private synchronized Handle register(final K key) {
+        Handle handle = handles.get(key);
+        if (handle == null) {
+            if (handlesBySlot.size() == capacity) {
+                throw new IllegalStateException("HistogramRegistry capacity (" + capacity + " keys) exceeded");
+            }
+            final int slot = handlesBySlot.size();
+            final int segmentIndex = slot / keysPerSegment;
+            if (activeCounts[segmentIndex] == null) {
+                // The first key of a segment allocates the segment (in both phases). Segment allocation is
+                // published to recorders along with the handle (through the handles map):
+                final int segmentLength =
+                        Math.min(keysPerSegment, capacity - (segmentIndex * keysPerSegment)) * countsArrayLength;
+                activeCounts[segmentIndex] = new AtomicLongArray(segmentLength);
+                inactiveCounts[segmentIndex] = new AtomicLongArray(segmentLength);
+            }
+            handle = new Handle(key, segmentIndex, (slot % keysPerSegment) * countsArrayLength);
+            handlesBySlot.add(handle);
+            handles.put(key, handle);
+        }
+        return handle;
+    }
+
+    /**
+     * Get the number of keys registered in the registry
+     * @return the number of registered keys
+     */
+    public synchronized int getKeyCount() {
+        return handlesBySlot.size();
+    }
+
+    /**
+     * Get the maximum number of keys that may be registered in the registry
+     * @return the registry's capacity
+     */
+    public int getCapacity() {
+        return capacity;
+    }
+
+    /**
+     * Get the interval histograms of all registered keys, in the order of their registration. Each interval
+     * histogram contains all value counts recorded for its key since the previous interval histograms were taken.
+     * All keys are sampled in the same phase flip, and share the same start and end timestamps.
+     *
+     * @return a map of the registered keys to their interval histograms
+     */
+    public synchronized Map<K, Histogram> getIntervalHistograms() {
+        performIntervalSample();
+        final Map<K, Histogram> intervalHistograms = new LinkedHashMap<>();
+        for (Handle handle : handlesBySlot) {
+            final Histogram histogram = new Histogram(shape);
+            drainInactiveCountsInto(handle, histogram);
+            intervalHistograms.put(handle.key, histogram);
+        }
+        return intervalHistograms;
+    }
+
+    /**
+     * Output the interval histograms of all registered keys to the given log writer, in the order of their
+     * registration, tagging each with its key (as a String). The interval histograms are sampled as with
+     * {@link #getIntervalHistograms()}, and are logged in a single pass through a single reused histogram.
+     * Keys whose interval histogram is empty are not logged.
+     *
+     * @param writer The log writer to output the interval histograms to
+     */
+    public synchronized void outputIntervalHistograms(final HistogramLogWriter writer) {
+        performIntervalSample();
+        if (outputHistogram == null) {
+            outputHistogram = new Histogram(shape);
+        }
+        for (Handle handle : handlesBySlot) {
+            outputHistogram.reset();
+            drainInactiveCountsInto(handle, outputHistogram);
+            if (outputHistogram.getTotalCount() > 0) {
+                outputHistogram.setTag(String.valueOf(handle.key));
+                writer.outputIntervalHistogram(outputHistogram);
+            }
+        }
+    }
+
+    /**
+     * Reset any value counts accumulated thus far, for all keys.
+     */
+    public synchronized void reset() {
+        performIntervalSample();
+        for (AtomicLongArray segment : inactiveCounts) {
+            if (segment != null) {
+                clearCounts(segment, 0, segment.length());
+            }
+        }
+    }
+
+    private void performIntervalSample() {
+        try {
+            recordingPhaser.readerLock();
+
+            // Swap active and inactive slab segments (the inactive segments are always left cleared):
+            final AtomicLongArray[] tempCounts = inactiveCounts;
+            inactiveCounts = activeCounts;
+            activeCounts = tempCounts;
+
+            // Mark end time of previous interval and start time of new one:
+            final long now = System.currentTimeMillis();
+            shape.setStartTimeStamp(intervalStartTimeStampMsec);
+            shape.setEndTimeStamp(now);
+            intervalStartTimeStampMsec = now;
+
+            // Make sure we are not in the middle of recording a value on the previously active segments:
+
+            // Flip phase to make sure no recordings that were in flight pre-flip are still active:
+            recordingPhaser.flipPhase(500000L /* yield in 0.5 msec units if needed */);
+        } finally {
+            recordingPhaser.readerUnlock();
+        }
+    }
+
+    // Move the counts of the given key from the inactive segments into the (empty) target histogram:
+    private void drainInactiveCountsInto(final Handle handle, final Histogram targetHistogram) {
+        final AtomicLongArray counts = inactiveCounts[handle.segmentIndex];
+        final int base = handle.countsBase;
+        long observedTotalCount = 0;
+        int minNonZeroIndex = -1;
+        int maxIndex = -1;
+        for (int i = 0; i < countsArrayLength; i++) {
+            final long count = counts.get(base + i);
+            if (count != 0) {
+                counts.set(base + i, 0);
+                targetHistogram.addToCountAtIndex(i, count);
+                observedTotalCount += count;
+                maxIndex = i;
+                if ((minNonZeroIndex < 0) && (i != 0)) {
+                    minNonZeroIndex = i;
+                }
+            }
+        }
+        // Establish the target's min/max (which bound its populated index span) along with its total count:
+        targetHistogram.establishInternalTackingValues(observedTotalCount, minNonZeroIndex, maxIndex);
+        targetHistogram.setStartTimeStamp(shape.getStartTimeStamp());
+        targetHistogram.setEndTimeStamp(shape.getEndTimeStamp());
+    }
+
+    private static void clearCounts(final AtomicLongArray counts, final int base, final int length) {
+        for (int i = base; i < base + length; i++) {
+            counts.lazySet(i, 0);
+        }
+    }
+
+    /**
+     * A recording handle for a single key of a {@link HistogramRegistry}. Values recorded through the handle
+     * are reported in the key's interval histograms.
+     */
+    public class Handle implements ValueRecorder {
+        private final K key;
+        private final int segmentIndex;
+        private final int countsBase;
+
+        private Handle(final K key, final int segmentIndex, final int countsBase) {
+            this.key = key;
+            this.segmentIndex = segmentIndex;
+            this.countsBase = countsBase;
+        }
+
+        /**
+         * Get the key this handle records for
+         * @return the key
+         */
+        public K getKey() {
+            return key;
+        }
+
+        private int slabIndex(final long value) {
+            final int index = shape.countsArrayIndex(value);
+            if (index >= countsArrayLength) {
+                throw new ArrayIndexOutOfBoundsException("value " + value + " exceeds highestTrackableValue");
+            }
+            return countsBase + index;
+        }
+
+        /**
+         * Record a value
+         * @param value the value to record
+         * @throws ArrayIndexOutOfBoundsException (may throw) if value is exceeds highestTrackableValue
+         */
+        @Override
+        public void recordValue(final long value) throws ArrayIndexOutOfBoundsException {
+            final int slabIndex = slabIndex(value);
+            long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+            try {
+                activeCounts[segmentIndex].incrementAndGet(slabIndex);
+            } finally {
+                recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+            }
+        }
+
+        /**
+         * Record a value (adding to the value's current count)
+         *
+         * @param value The value to be recorded
+         * @param count The number of occurrences of this value to record
+         * @throws ArrayIndexOutOfBoundsException (may throw) if value is exceeds highestTrackableValue
+         */
+        @Override
+        public void recordValueWithCount(final long value, final long count) throws ArrayIndexOutOfBoundsException {
+            final int slabIndex = slabIndex(value);
+            long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+            try {
+                activeCounts[segmentIndex].addAndGet(slabIndex, count);
+            } finally {
+                recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+            }
+        }
+
+        /**
+         * Record a value
+         * <p>
+         * To compensate for the loss of sampled values when a recorded value is larger than the expected
+         * interval between value samples, the handle will auto-generate an additional series of
+         * decreasingly-smaller (down to the expectedIntervalBetweenValueSamples) value records.
+         * <p>
+         * See related notes {@link AbstractHistogram#recordValueWithExpectedInterval(long, long)}
+         * for more explanations about coordinated omission and expected interval correction.
+         *
+         * @param value The value to record
+         * @param expectedIntervalBetweenValueSamples If expectedIntervalBetweenValueSamples is larger than 0, add
+         *                                           auto-generated value records as appropriate if value is larger
+         *                                           than expectedIntervalBetweenValueSamples
+         * @throws ArrayIndexOutOfBoundsException (may throw) if value is exceeds highestTrackableValue
+         */
+        @Override
+        public void recordValueWithExpectedInterval(final long value, final long expectedIntervalBetweenValueSamples)
+                throws ArrayIndexOutOfBoundsException {
+            final int slabIndex = slabIndex(value);
+            long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+            try {
+                final AtomicLongArray counts = activeCounts[segmentIndex];
+                counts.incrementAndGet(slabIndex);
+                if (expectedIntervalBetweenValueSamples <= 0) {
+                    return;
+                }
+                for (long missingValue = value - expectedIntervalBetweenValueSamples;
+                     missingValue >= expectedIntervalBetweenValueSamples;
+                     missingValue -= expectedIntervalBetweenValueSamples) {
+                    counts.incrementAndGet(slabIndex(missingValue));
+                }
+            } finally {
+                recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+            }
+        }
+
+        /**
+         * Record a batch of values. Equivalent to recording each of the values with
+         * {@link #recordValue(long)}, but with a single recording critical section for the whole batch.
+         *
+         * @param values The array containing the values to be recorded
+         * @param offset The offset in the array of the first value to be recorded
+         * @param length The number of values to be recorded
+         * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+         */
+        @Override
+        public void recordValues(final long[] values, final int offset, final int length)
+                throws ArrayIndexOutOfBoundsException {
+            if ((offset < 0) || (length < 0) || (offset > values.length - length)) {
+                throw new IndexOutOfBoundsException("offset " + offset + " and length " + length +
+                        " out of bounds for values array of length " + values.length);
+            }
+            long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+            try {
+                final AtomicLongArray counts = activeCounts[segmentIndex];
+                for (int i = offset; i < offset + length; i++) {
+                    counts.incrementAndGet(slabIndex(values[i]));
+                }
+            } finally {
+                recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+            }
+        }
+
+        /**
+         * Record a batch of values, consisting of the values remaining in a buffer. Equivalent to
+         * {@link #recordValues(long[], int, int)}. The buffer's position is advanced to its limit.
+         *
+         * @param values The buffer containing the values to be recorded (from its position to its limit)
+         * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+         */
+        @Override
+        public void recordValues(final LongBuffer values) throws ArrayIndexOutOfBoundsException {
+            long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+            try {
+                final AtomicLongArray counts = activeCounts[segmentIndex];
+                while (values.hasRemaining()) {
+                    counts.incrementAndGet(slabIndex(values.get()));
+                }
+            } finally {
+                recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+            }
+        }
+
+        /**
+         * Reset any value counts accumulated thus far for this handle's key. Counts recorded concurrently with
+         * the reset may or may not be discarded.
+         */
+        @Override
+        public void reset() {
+            synchronized (HistogramRegistry.this) {
+                try {
+                    recordingPhaser.readerLock();
+                    clearCounts(activeCounts[segmentIndex], countsBase, countsArrayLength);
+                } finally {
+                    recordingPhaser.readerUnlock();
+                }
+            }
+        }
+    }
+}
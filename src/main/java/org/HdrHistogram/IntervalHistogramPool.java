@@ -0,0 +1,76 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.util.Arrays;
+
+/**
+ * A bounded pool of released interval histograms, shared by the recorders (see e.g.
+ * {@link Recorder#releaseIntervalHistogram}). Pooled interval histograms are handed out (most recently released
+ * first) to interval sampling calls that are not provided with a histogram to recycle.
+ * <p>
+ * An {@link IntervalHistogramPool} is not thread-safe, and is accessed under its recorder's lock. Verifying that a
+ * released histogram belongs to the recorder is left to the recorder.
+ *
+ * @param <T> The type of the pooled interval histograms
+ */
+class IntervalHistogramPool<T extends EncodableHistogram> {
+    static final int DEFAULT_CAPACITY = 2;
+
+    private Object[] pooledHistograms = new Object[DEFAULT_CAPACITY];
+    private int pooledHistogramCount = 0;
+
+    /**
+     * Add a released interval histogram to the pool.
+     * @param intervalHistogram the released interval histogram
+     * @return true if the interval histogram was pooled, false if it was dropped because the pool is full
+     * @throws IllegalArgumentException if the interval histogram is already in the pool
+     */
+    boolean release(final T intervalHistogram) {
+        for (int i = 0; i < pooledHistogramCount; i++) {
+            if (pooledHistograms[i] == intervalHistogram) {
+                throw new IllegalArgumentException("interval histogram has already been released");
+            }
+        }
+        if (pooledHistogramCount == pooledHistograms.length) {
+            return false;
+        }
+        pooledHistograms[pooledHistogramCount++] = intervalHistogram;
+        return true;
+    }
+
+    /**
+     * Take a histogram out of the pool.
+     * @return a pooled interval histogram, or null if the pool is empty
+     */
+    @SuppressWarnings("unchecked")
+    T take() {
+        if (pooledHistogramCount == 0) {
+            return null;
+        }
+        final T pooledHistogram = (T) pooledHistograms[--pooledHistogramCount];
+        pooledHistograms[pooledHistogramCount] = null;
+        return pooledHistogram;
+    }
+
+    int getCapacity() {
+        return pooledHistograms.length;
+    }
+
+    /**
+     * Set the capacity of the pool. Pooled interval histograms beyond the new capacity are dropped.
+     * @param capacity the pool capacity. Must be non-negative.
+     */
+    void setCapacity(final int capacity) {
+        if (capacity < 0) {
+            throw new IllegalArgumentException("capacity must be >= 0");
+        }
+        pooledHistogramCount = Math.min(pooledHistogramCount, capacity);
+        pooledHistograms = Arrays.copyOf(pooledHistograms, capacity);
+    }
+}
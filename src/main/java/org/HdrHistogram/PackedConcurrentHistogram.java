@@ -253,7 +253,7 @@ public class PackedConcurrentHistogram extends ConcurrentHistogram {
         private ConcurrentPackedLongArray packedCounts;
 
         private int normalizingIndexOffset;
-        private double doubleToIntegerValueConversionRatio;
+        private volatile double doubleToIntegerValueConversionRatio;
 
         ConcurrentPackedArrayWithNormalizingOffset(int length, int normalizingIndexOffset) {
             packedCounts = new ConcurrentPackedLongArray(length);
@@ -7,11 +7,13 @@
 
 package org.HdrHistogram;
 
+import org.HdrHistogram.packedarray.IterationValue;
 import org.HdrHistogram.packedarray.PackedLongArray;
 
 import java.io.IOException;
 import java.io.ObjectInputStream;
 import java.nio.ByteBuffer;
+import java.util.Iterator;
 import java.util.zip.DataFormatException;
 
 /**
@@ -139,6 +141,164 @@ public class PackedHistogram extends Histogram {
         }
     }
 
+    // Query support:
+    //
+    // Each get() from the packed counts array walks its packed index, so scanning the counts array index by
+    // index probes the packed index at every (mostly zero) index. The queries below iterate over the non-zero
+    // entries of the packed array instead, in time proportional to the number of populated entries.
+    // The non-zero entries are iterated in (normalized) counts array order, which is the (logical) index order
+    // only when there is no normalizing index offset (which is the case unless the histogram is the internal
+    // histogram of a DoubleHistogram that was shifted). When there is, or when the cumulative count index is
+    // enabled (which answers these queries from the index), the queries are left to AbstractHistogram.
+
+    private boolean queriesIterateNonZeroValues() {
+        return (normalizingIndexOffset == 0) && !isCumulativeCountIndexEnabled();
+    }
+
+    private long valueAtPercentileIndex(final double percentile, final int index) {
+        long valueAtIndex = valueFromIndex(index);
+        return (percentile == 0.0) ?
+                lowestEquivalentValue(valueAtIndex) :
+                highestEquivalentValue(valueAtIndex);
+    }
+
+    @Override
+    public long getValueAtPercentile(final double percentile) {
+        if (!queriesIterateNonZeroValues()) {
+            return super.getValueAtPercentile(percentile);
+        }
+        final long countAtPercentile = countAtPercentile(percentile, getTotalCount());
+        long totalToCurrentIndex = 0;
+        for (IterationValue v : packedCounts.nonZeroValues()) {
+            totalToCurrentIndex += v.getValue();
+            if (totalToCurrentIndex >= countAtPercentile) {
+                return valueAtPercentileIndex(percentile, v.getIndex());
+            }
+        }
+        return 0;
+    }
+
+    @Override
+    void getValuesAtPercentiles(final double[] sortedPercentiles,
+                                final long[] longValues,
+                                final double[] doubleValues,
+                                final double valueConversionRatio) {
+        if (!queriesIterateNonZeroValues()) {
+            super.getValuesAtPercentiles(sortedPercentiles, longValues, doubleValues, valueConversionRatio);
+            return;
+        }
+        final int outputLength = (longValues != null) ? longValues.length : doubleValues.length;
+        if (outputLength < sortedPercentiles.length) {
+            throw new IllegalArgumentException("The values array (length " + outputLength +
+                    ") is shorter than the percentiles array (length " + sortedPercentiles.length + ")");
+        }
+        final long totalCount = getTotalCount();
+        final Iterator<IterationValue> nonZeroValues = packedCounts.nonZeroValues().iterator();
+        long totalToCurrentIndex = 0;
+        int currentIndex = 0;
+        double previousPercentile = Double.NEGATIVE_INFINITY;
+        for (int j = 0; j < sortedPercentiles.length; j++) {
+            final double percentile = sortedPercentiles[j];
+            if (percentile < previousPercentile) {
+                throw new IllegalArgumentException("Percentiles must be sorted in ascending order");
+            }
+            previousPercentile = percentile;
+            final long countAtPercentile = countAtPercentile(percentile, totalCount);
+            // Resume from the entry that satisfied the previous percentile:
+            while ((totalToCurrentIndex < countAtPercentile) && nonZeroValues.hasNext()) {
+                IterationValue v = nonZeroValues.next();
+                totalToCurrentIndex += v.getValue();
+                currentIndex = v.getIndex();
+            }
+            long valueAtPercentile = 0;
+            if (totalToCurrentIndex >= countAtPercentile) {
+                valueAtPercentile = valueAtPercentileIndex(percentile, currentIndex);
+            }
+            if (longValues != null) {
+                longValues[j] = valueAtPercentile;
+            } else {
+                doubleValues[j] = valueAtPercentile * valueConversionRatio;
+            }
+        }
+    }
+
+    @Override
+    public double getPercentileAtOrBelowValue(final long value) {
+        if ((getTotalCount() == 0) || !queriesIterateNonZeroValues()) {
+            return super.getPercentileAtOrBelowValue(value);
+        }
+        final int targetIndex = Math.min(countsArrayIndex(value), (countsArrayLength - 1));
+        long totalToCurrentIndex = 0;
+        for (IterationValue v : packedCounts.nonZeroValues()) {
+            if (v.getIndex() > targetIndex) {
+                break;
+            }
+            totalToCurrentIndex += v.getValue();
+        }
+        return (100.0 * totalToCurrentIndex) / getTotalCount();
+    }
+
+    @Override
+    public long getCountBetweenValues(final long lowValue, final long highValue)
+            throws ArrayIndexOutOfBoundsException {
+        if (!queriesIterateNonZeroValues()) {
+            return super.getCountBetweenValues(lowValue, highValue);
+        }
+        final int lowIndex = Math.max(0, countsArrayIndex(lowValue));
+        final int highIndex = Math.min(countsArrayIndex(highValue), (countsArrayLength - 1));
+        long count = 0;
+        for (IterationValue v : packedCounts.nonZeroValues()) {
+            if (v.getIndex() > highIndex) {
+                break;
+            }
+            if (v.getIndex() >= lowIndex) {
+                count += v.getValue();
+            }
+        }
+        return count;
+    }
+
+    @Override
+    public double getMean() {
+        if ((getTotalCount() == 0) || !queriesIterateNonZeroValues()) {
+            return super.getMean();
+        }
+        double totalValue = 0;
+        for (IterationValue v : packedCounts.nonZeroValues()) {
+            totalValue += medianEquivalentValue(valueFromIndex(v.getIndex())) * (double) v.getValue();
+        }
+        return totalValue / getTotalCount();
+    }
+
+    @Override
+    public double getStdDeviation() {
+        if ((getTotalCount() == 0) || !queriesIterateNonZeroValues()) {
+            return super.getStdDeviation();
+        }
+        final double mean = getMean();
+        double geometric_deviation_total = 0.0;
+        for (IterationValue v : packedCounts.nonZeroValues()) {
+            double deviation = medianEquivalentValue(valueFromIndex(v.getIndex())) - mean;
+            geometric_deviation_total += (deviation * deviation) * v.getValue();
+        }
+        return Math.sqrt(geometric_deviation_total / getTotalCount());
+    }
+
+    /**
+     * Add the non-zero counts of this histogram into an identically laid out (and normalized) counts array.
+     * Used by {@link Histogram} to add a packed histogram to a dense one without scanning the packed counts.
+     * @param targetCounts The counts array to add into
+     * @return the total count added
+     */
+    long addNonZeroCountsInto(final long[] targetCounts) {
+        long addedTotalCount = 0;
+        for (IterationValue v : packedCounts.nonZeroValues()) {
+            targetCounts[v.getIndex()] += v.getValue();
+            addedTotalCount += v.getValue();
+        }
+        return addedTotalCount;
+    }
+
     @Override
     int _getEstimatedFootprintInBytes() {
         return 192 + (8 * packedCounts.getPhysicalLength());
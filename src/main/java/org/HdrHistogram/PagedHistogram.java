@@ -0,0 +1,279 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.IOException;
+import java.io.ObjectInputStream;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+import java.util.zip.DataFormatException;
+
+/**
+ * <h3>A High Dynamic Range (HDR) Histogram that uses a paged internal representation</h3>
+ * <p>
+ * {@link PagedHistogram} supports the recording and analyzing sampled data value counts across a configurable
+ * integer value range with configurable value precision within the range. Value precision is expressed as the
+ * number of significant digits in the value recording, and provides control over value quantization behavior
+ * across the value range and the subsequent value resolution at any given level.
+ * <p>
+ * {@link PagedHistogram} tracks value counts in fixed size pages of <b><code>long</code></b> counts
+ * ({@link #PAGE_LENGTH} counts per page), which are only allocated when a count within their range is first
+ * recorded. Count accesses involve a single additional (page) indirection when compared to {@link Histogram},
+ * while the footprint of a histogram that only records values in a few regions of a wide value range (e.g. the
+ * latencies of a single endpoint, tracked in nanoseconds with a range of hours) remains proportional to the
+ * number of regions touched rather than to the size of the range. Unlike {@link PackedHistogram}, recording a
+ * previously unrecorded value never requires repacking of the internal representation.
+ * <p>
+ * Pages remain allocated when the histogram is reset, such that histograms that are repeatedly reset and
+ * re-recorded into (e.g. interval histograms) do not reallocate them.
+ * <p>
+ * Auto-resizing: When constructed with no specified value range range (or when auto-resize is turned on with {@link
+ * Histogram#setAutoResize}) a {@link PagedHistogram} will auto-resize its dynamic range to include recorded values as
+ * they are encountered. Note that recording calls that cause auto-resizing may take longer to execute, as resizing
+ * incurs allocation and copying of internal data structures.
+ * <p>
+ * See package description for {@link org.HdrHistogram} for details.
+ */
+
+public class PagedHistogram extends Histogram {
+    static final int PAGE_LENGTH_MAGNITUDE = 7;
+    /**
+     * The number of counts in each page
+     */
+    public static final int PAGE_LENGTH = 1 << PAGE_LENGTH_MAGNITUDE;
+    static final int PAGE_INDEX_MASK = PAGE_LENGTH - 1;
+
+    private long[][] pages;
+    private int allocatedPageCount;
+
+    @Override
+    long getCountAtIndex(final int index) {
+        return getCountAtNormalizedIndex(normalizeIndex(index, normalizingIndexOffset, countsArrayLength));
+    }
+
+    @Override
+    long getCountAtNormalizedIndex(final int index) {
+        final long[] page = pages[index >>> PAGE_LENGTH_MAGNITUDE];
+        return (page != null) ? page[index & PAGE_INDEX_MASK] : 0;
+    }
+
+    @Override
+    void incrementCountAtIndex(final int index) {
+        final int normalizedIndex = normalizeIndex(index, normalizingIndexOffset, countsArrayLength);
+        pageForIndex(normalizedIndex)[normalizedIndex & PAGE_INDEX_MASK]++;
+    }
+
+    @Override
+    void addToCountAtIndex(final int index, final long value) {
+        final int normalizedIndex = normalizeIndex(index, normalizingIndexOffset, countsArrayLength);
+        pageForIndex(normalizedIndex)[normalizedIndex & PAGE_INDEX_MASK] += value;
+    }
+
+    @Override
+    void setCountAtIndex(int index, long value) {
+        setCountAtNormalizedIndex(normalizeIndex(index, normalizingIndexOffset, countsArrayLength), value);
+    }
+
+    @Override
+    void setCountAtNormalizedIndex(int index, long value) {
+        if ((value == 0) && (pages[index >>> PAGE_LENGTH_MAGNITUDE] == null)) {
+            // Unallocated pages are implicitly zero:
+            return;
+        }
+        pageForIndex(index)[index & PAGE_INDEX_MASK] = value;
+    }
+
+    private long[] pageForIndex(final int normalizedIndex) {
+        final int pageIndex = normalizedIndex >>> PAGE_LENGTH_MAGNITUDE;
+        final long[] page = pages[pageIndex];
+        return (page != null) ? page : allocatePage(pageIndex);
+    }
+
+    private long[] allocatePage(final int pageIndex) {
+        // The last page only covers the remainder of the counts range, such that accesses beyond
+        // the range throw (as they would for a Histogram's counts array):
+        final long[] page =
+                new long[Math.min(PAGE_LENGTH, countsArrayLength - (pageIndex << PAGE_LENGTH_MAGNITUDE))];
+        pages[pageIndex] = page;
+        allocatedPageCount++;
+        return page;
+    }
+
+    @Override
+    void clearCounts() {
+        for (long[] page : pages) {
+            if (page != null) {
+                Arrays.fill(page, 0);
+            }
+        }
+        totalCount = 0;
+    }
+
+    /**
+     * Get the number of pages currently allocated by this histogram
+     * @return the number of allocated pages
+     */
+    public int getAllocatedPageCount() {
+        return allocatedPageCount;
+    }
+
+    @Override
+    public PagedHistogram copy() {
+        PagedHistogram copy = new PagedHistogram(this);
+        copy.add(this);
+        return copy;
+    }
+
+    @Override
+    public PagedHistogram copyCorrectedForCoordinatedOmission(final long expectedIntervalBetweenValueSamples) {
+        PagedHistogram toHistogram = new PagedHistogram(this);
+        toHistogram.addWhileCorrectingForCoordinatedOmission(this, expectedIntervalBetweenValueSamples);
+        return toHistogram;
+    }
+
+    @Override
+    void resize(long newHighestTrackableValue) {
+        final int oldNormalizedZeroIndex = normalizeIndex(0, normalizingIndexOffset, countsArrayLength);
+        final int oldCountsArrayLength = countsArrayLength;
+        final long[][] oldPages = pages;
+
+        establishSize(newHighestTrackableValue);
+
+        if (oldNormalizedZeroIndex == 0) {
+            // Counts stay at their indexes. Grow the page table, and the last page if it was a partial one:
+            pages = Arrays.copyOf(oldPages, pageCountFor(countsArrayLength));
+            final int lastOldPageIndex = pageCountFor(oldCountsArrayLength) - 1;
+            final long[] lastOldPage = pages[lastOldPageIndex];
+            if ((lastOldPage != null) && (lastOldPage.length < PAGE_LENGTH)) {
+                pages[lastOldPageIndex] = Arrays.copyOf(lastOldPage,
+                        Math.min(PAGE_LENGTH, countsArrayLength - (lastOldPageIndex << PAGE_LENGTH_MAGNITUDE)));
+            }
+            return;
+        }
+
+        // We need to shift the counts from the zero index and up to the end of the range by the change in
+        // length. Re-record all allocated counts into newly allocated pages, at their shifted indexes:
+        pages = new long[pageCountFor(countsArrayLength)][];
+        allocatedPageCount = 0;
+        final int countsDelta = countsArrayLength - oldCountsArrayLength;
+        for (int oldPageIndex = 0; oldPageIndex < oldPages.length; oldPageIndex++) {
+            final long[] oldPage = oldPages[oldPageIndex];
+            if (oldPage == null) {
+                continue;
+            }
+            final int oldPageBase = oldPageIndex << PAGE_LENGTH_MAGNITUDE;
+            for (int i = 0; i < oldPage.length; i++) {
+                final long count = oldPage[i];
+                if (count != 0) {
+                    final int fromIndex = oldPageBase + i;
+                    final int toIndex = (fromIndex >= oldNormalizedZeroIndex) ? fromIndex + countsDelta : fromIndex;
+                    pageForIndex(toIndex)[toIndex & PAGE_INDEX_MASK] = count;
+                }
+            }
+        }
+    }
+
+    private static int pageCountFor(final int countsArrayLength) {
+        return (countsArrayLength + PAGE_INDEX_MASK) >>> PAGE_LENGTH_MAGNITUDE;
+    }
+
+    @Override
+    int _getEstimatedFootprintInBytes() {
+        return 192 + (8 * pages.length) + (allocatedPageCount * (16 + (8 * PAGE_LENGTH)));
+    }
+
+    /**
+     * Construct an auto-resizing PagedHistogram with a lowest discernible value of 1 and an auto-adjusting
+     * highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
+     *
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public PagedHistogram(final int numberOfSignificantValueDigits) {
+        this(1, 2, numberOfSignificantValueDigits);
+        setAutoResize(true);
+    }
+
+    /**
+     * Construct a PagedHistogram given the Highest value to be tracked and a number of significant decimal digits. The
+     * histogram will be constructed to implicitly track (distinguish from 0) values as low as 1.
+     *
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} 2.
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public PagedHistogram(final long highestTrackableValue, final int numberOfSignificantValueDigits) {
+        this(1, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a PagedHistogram given the Lowest and Highest values to be tracked and a number of significant
+     * decimal digits. Providing a lowestDiscernibleValue is useful is situations where the units used
+     * for the histogram's values are much smaller that the minimal accuracy required. E.g. when tracking
+     * time values stated in nanosecond units, where the minimal accuracy required is a microsecond, the
+     * proper value for lowestDiscernibleValue would be 1000.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public PagedHistogram(final long lowestDiscernibleValue, final long highestTrackableValue,
+                          final int numberOfSignificantValueDigits) {
+        super(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits, false);
+        pages = new long[pageCountFor(countsArrayLength)][];
+        wordSizeInBytes = 8;
+    }
+
+    /**
+     * Construct a PagedHistogram with the same range settings as a given source histogram,
+     * duplicating the source's start/end timestamps (but NOT it's contents)
+     * @param source The source histogram to duplicate
+     */
+    public PagedHistogram(final AbstractHistogram source) {
+        super(source, false);
+        pages = new long[pageCountFor(countsArrayLength)][];
+        wordSizeInBytes = 8;
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     */
+    public static PagedHistogram decodeFromByteBuffer(final ByteBuffer buffer,
+                                                      final long minBarForHighestTrackableValue) {
+        return decodeFromByteBuffer(buffer, PagedHistogram.class, minBarForHighestTrackableValue);
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a compressed form in a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     * @throws DataFormatException on error parsing/decompressing the buffer
+     */
+    public static PagedHistogram decodeFromCompressedByteBuffer(final ByteBuffer buffer,
+                                                                final long minBarForHighestTrackableValue)
+            throws DataFormatException {
+        return decodeFromCompressedByteBuffer(buffer, PagedHistogram.class, minBarForHighestTrackableValue);
+    }
+
+    private void readObject(final ObjectInputStream o)
+            throws IOException, ClassNotFoundException {
+        o.defaultReadObject();
+    }
+}
@@ -0,0 +1,507 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.*;
+import java.nio.ByteBuffer;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.charset.Charset;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.zip.DataFormatException;
+
+/**
+ * A histogram log reader that reads a histogram log file (see {@link HistogramLogReader} for the log format)
+ * by memory-mapping it, splitting it into chunks on line boundaries, and parsing, filtering (by tag and time
+ * range) and decoding the interval histograms in each chunk in parallel, across a pool of worker threads.
+ * <p>
+ * Where {@link HistogramLogReader} reads a log line by line on a single thread, a
+ * {@link ParallelHistogramLogReader} is intended for summarizing large (e.g. multi-GB) log files. Matching
+ * intervals can either be collected in log order (via {@link #readIntervalHistograms}), or reduced in
+ * parallel into an accumulator histogram (via {@link #addIntervalHistogramsTo}), in which case the interval
+ * histograms are added directly from their encoded form, without being constructed (see
+ * {@link AbstractHistogram#addFromCompressedByteBuffer(java.nio.ByteBuffer)}).
+ * <p>
+ * Log start time and base time indications (the "#[StartTime: " and "#[BaseTime: " comments) are established
+ * from the log header, i.e. from the comment lines preceding the first interval line in the log. Unlike
+ * {@link HistogramLogReader}, time range filtering does not assume that timestamps appear in order in the log,
+ * and all intervals in the log are examined.
+ * <p>
+ * Time ranges and timestamps are interpreted as they are by {@link HistogramLogReader}: ranges are in seconds,
+ * relative to the log's start time, and returned histograms have their start and end timestamps set to the
+ * absolute time of the interval. A null tag selects only the intervals that have no tag.
+ * <p>
+ * Only text logs are supported. Binary logs (see {@link BinaryHistogramLogWriter}) are read with a
+ * {@link HistogramLogReader}.
+ */
+public class ParallelHistogramLogReader implements Closeable {
+    static final int DEFAULT_CHUNK_SIZE_IN_BYTES = 16 * 1024 * 1024;
+    private static final int INITIAL_LINE_REGION_LENGTH = 64 * 1024;
+    private static final Charset LOG_CHARSET = Charset.forName("US-ASCII");
+
+    private final RandomAccessFile file;
+    private final FileChannel channel;
+    private final long fileLength;
+    private final ExecutorService executor;
+    private final boolean ownsExecutor;
+    private final int chunkSizeInBytes;
+
+    private double startTimeSec = 0.0;
+    private double baseTimeSec = 0.0;
+
+    /**
+     * Constructs a new ParallelHistogramLogReader that reads intervals from the specified file name, using a
+     * worker pool of {@link Runtime#availableProcessors()} threads.
+     * @param inputFileName The name of the file to read from
+     * @throws java.io.FileNotFoundException when unable to find inputFileName
+     * @throws IOException on errors reading the file's header
+     */
+    public ParallelHistogramLogReader(final String inputFileName) throws IOException {
+        this(new File(inputFileName));
+    }
+
+    /**
+     * Constructs a new ParallelHistogramLogReader that reads intervals from the specified file, using a
+     * worker pool of {@link Runtime#availableProcessors()} threads.
+     * @param inputFile The File to read from
+     * @throws java.io.FileNotFoundException when unable to find inputFile
+     * @throws IOException on errors reading the file's header
+     */
+    public ParallelHistogramLogReader(final File inputFile) throws IOException {
+        this(inputFile, null, DEFAULT_CHUNK_SIZE_IN_BYTES);
+    }
+
+    /**
+     * Constructs a new ParallelHistogramLogReader that reads intervals from the specified file, using the
+     * given executor to parse and decode chunks of the file. Readers constructed through this constructor
+     * do not assume ownership of the executor, and will not shut it down on {@link #close()}.
+     * @param inputFile The File to read from
+     * @param executor The executor to parse and decode chunks of the file on
+     * @throws java.io.FileNotFoundException when unable to find inputFile
+     * @throws IOException on errors reading the file's header
+     */
+    public ParallelHistogramLogReader(final File inputFile, final ExecutorService executor) throws IOException {
+        this(inputFile, executor, DEFAULT_CHUNK_SIZE_IN_BYTES);
+    }
+
+    ParallelHistogramLogReader(final File inputFile, final ExecutorService executor,
+                               final int chunkSizeInBytes) throws IOException {
+        if (chunkSizeInBytes < 1) {
+            throw new IllegalArgumentException("chunkSizeInBytes must be >= 1");
+        }
+        this.file = new RandomAccessFile(inputFile, "r");
+        this.channel = file.getChannel();
+        this.fileLength = channel.size();
+        this.chunkSizeInBytes = chunkSizeInBytes;
+        if (executor != null) {
+            this.executor = executor;
+            this.ownsExecutor = false;
+        } else {
+            this.executor = Executors.newFixedThreadPool(Runtime.getRuntime().availableProcessors(),
+                    new ThreadFactory() {
+                        @Override
+                        public Thread newThread(Runnable runnable) {
+                            Thread thread = new Thread(runnable, "ParallelHistogramLogReader");
+                            thread.setDaemon(true);
+                            return thread;
+                        }
+                    });
+            this.ownsExecutor = true;
+        }
+        try {
+            readHeader();
+        } catch (IOException ex) {
+            close();
+            throw ex;
+        }
+    }
+
+    /**
+     * Get the start time of the log (or 0.0), per the log file format explained in {@link HistogramLogReader}.
+     * This is the time indicated by a "#[StartTime:" line in the log header, if one exists, and the timestamp
+     * of the first interval in the log otherwise.
+     * @return the start time of the log, in seconds
+     */
+    public double getStartTimeSec() {
+        return startTimeSec;
+    }
+
+    /**
+     * Read all interval histograms with a matching tag and with a start timestamp that falls between
+     * startTimeSec and endTimeSec (in seconds, relative to the log's start time) from the log. Chunks of the
+     * log are parsed and decoded in parallel, and the histograms are returned in the order in which they
+     * appear in the log.
+     *
+     * @param startTimeSec The (non-absolute time) start of the expected time range, in seconds.
+     * @param endTimeSec The (non-absolute time) end of the expected time range, in seconds.
+     * @param tag The tag of the intervals to read, or null to read only intervals that have no tag
+     * @return the matching interval histograms, in log order
+     * @throws IOException on errors reading the log file
+     * @throws IllegalArgumentException if a malformed interval line is encountered
+     */
+    public List<EncodableHistogram> readIntervalHistograms(final double startTimeSec,
+                                                           final double endTimeSec,
+                                                           final String tag) throws IOException {
+        final List<Future<List<EncodableHistogram>>> chunkResults = new ArrayList<>();
+        for (long chunkStart = 0; chunkStart < fileLength; chunkStart += chunkSizeInBytes) {
+            final LogChunk chunk = new LogChunk(chunkStart, Math.min(fileLength, chunkStart + chunkSizeInBytes));
+            chunkResults.add(executor.submit(new Callable<List<EncodableHistogram>>() {
+                @Override
+                public List<EncodableHistogram> call() throws Exception {
+                    return chunk.readIntervalHistograms(startTimeSec, endTimeSec, tag);
+                }
+            }));
+        }
+        final List<EncodableHistogram> histograms = new ArrayList<>();
+        for (Future<List<EncodableHistogram>> chunkResult : chunkResults) {
+            histograms.addAll(getChunkResult(chunkResult));
+        }
+        return histograms;
+    }
+
+    /**
+     * Add all interval histograms with a matching tag and with a start timestamp that falls between
+     * startTimeSec and endTimeSec (in seconds, relative to the log's start time) in the log to the given
+     * accumulator. Chunks of the log are reduced in parallel, with each worker reducing the chunks it handles into
+     * a single (initially empty) histogram of the accumulator's configuration, which is then added to the
+     * accumulator. The accumulator's start and end timestamps are extended to cover the (absolute) time ranges of
+     * the added intervals.
+     *
+     * @param accumulator The histogram to add the intervals to. Interval histograms in the log
+     *                    must be (integer value) histograms.
+     * @param startTimeSec The (non-absolute time) start of the expected time range, in seconds.
+     * @param endTimeSec The (non-absolute time) end of the expected time range, in seconds.
+     * @param tag The tag of the intervals to add, or null to add only intervals that have no tag
+     * @return the number of interval histograms added to the accumulator
+     * @throws IOException on errors reading the log file
+     * @throws IllegalArgumentException if a malformed interval line is encountered
+     */
+    public int addIntervalHistogramsTo(final AbstractHistogram accumulator,
+                                       final double startTimeSec,
+                                       final double endTimeSec,
+                                       final String tag) throws IOException {
+        // Each worker reduces the chunks it claims into its own (initially empty) accumulator, such that the
+        // number of live accumulators is bounded by the number of workers rather than by the size of the log:
+        final long chunkCount = (fileLength + chunkSizeInBytes - 1) / chunkSizeInBytes;
+        final int workerCount = (int) Math.min(chunkCount, Runtime.getRuntime().availableProcessors());
+        final AtomicLong nextChunkIndex = new AtomicLong();
+        final List<AbstractHistogram> workerAccumulators = new ArrayList<>();
+        final List<Future<Integer>> workerResults = new ArrayList<>();
+        for (int i = 0; i < workerCount; i++) {
+            final AbstractHistogram workerAccumulator = new Histogram(accumulator);
+            workerAccumulators.add(workerAccumulator);
+            workerResults.add(executor.submit(new Callable<Integer>() {
+                @Override
+                public Integer call() throws Exception {
+                    int workerAddedCount = 0;
+                    long chunkIndex;
+                    while ((chunkIndex = nextChunkIndex.getAndIncrement()) < chunkCount) {
+                        final long chunkStart = chunkIndex * chunkSizeInBytes;
+                        final LogChunk chunk =
+                                new LogChunk(chunkStart, Math.min(fileLength, chunkStart + chunkSizeInBytes));
+                        workerAddedCount +=
+                                chunk.addIntervalHistogramsTo(workerAccumulator, startTimeSec, endTimeSec, tag);
+                    }
+                    return workerAddedCount;
+                }
+            }));
+        }
+        int addedCount = 0;
+        for (int i = 0; i < workerResults.size(); i++) {
+            final int workerAddedCount = getChunkResult(workerResults.get(i));
+            if (workerAddedCount > 0) {
+                final AbstractHistogram workerAccumulator = workerAccumulators.get(i);
+                accumulator.add(workerAccumulator);
+                accumulator.setStartTimeStamp(
+                        Math.min(accumulator.getStartTimeStamp(), workerAccumulator.getStartTimeStamp()));
+                accumulator.setEndTimeStamp(
+                        Math.max(accumulator.getEndTimeStamp(), workerAccumulator.getEndTimeStamp()));
+                addedCount += workerAddedCount;
+            }
+        }
+        return addedCount;
+    }
+
+    private static <T> T getChunkResult(final Future<T> chunkResult) throws IOException {
+        try {
+            return chunkResult.get();
+        } catch (InterruptedException ex) {
+            Thread.currentThread().interrupt();
+            throw new InterruptedIOException("Interrupted while reading histogram log");
+        } catch (ExecutionException ex) {
+            final Throwable cause = ex.getCause();
+            if (cause instanceof IOException) {
+                throw (IOException) cause;
+            } else if (cause instanceof RuntimeException) {
+                throw (RuntimeException) cause;
+            } else if (cause instanceof Error) {
+                throw (Error) cause;
+            }
+            throw new IllegalArgumentException("Failed to decode histogram log", cause);
+        }
+    }
+
+    @Override
+    public void close() throws IOException {
+        if (ownsExecutor) {
+            executor.shutdown();
+        }
+        file.close();
+    }
+
+    private void readHeader() throws IOException {
+        boolean observedStartTime = false;
+        boolean observedBaseTime = false;
+        final LogChunk header = new LogChunk(0, fileLength);
+        String line;
+        while ((line = header.nextLine()) != null) {
+            if (line.startsWith("#[StartTime: ")) {
+                final Double time = parseLeadingDouble(line, "#[StartTime: ".length());
+                if (time != null) {
+                    startTimeSec = time;
+                    observedStartTime = true;
+                }
+            } else if (line.startsWith("#[BaseTime: ")) {
+                final Double time = parseLeadingDouble(line, "#[BaseTime: ".length());
+                if (time != null) {
+                    baseTimeSec = time;
+                    observedBaseTime = true;
+                }
+            } else if ((line.length() > 0) && !line.startsWith("#") && !line.startsWith("\"StartTimestamp\"")) {
+                // First interval line:
+                final IntervalLine interval = new IntervalLine(line, header.lineStartPosition);
+                if (!observedStartTime) {
+                    // No explicit start time noted. Use 1st observed time:
+                    startTimeSec = interval.timestampSec;
+                }
+                if (!observedBaseTime) {
+                    // No explicit base time noted. Deduce from 1st observed time (compared to start time),
+                    // as HistogramLogReader does:
+                    baseTimeSec = (interval.timestampSec < startTimeSec - (365 * 24 * 3600.0)) ? startTimeSec : 0.0;
+                }
+                return;
+            }
+        }
+    }
+
+    private static Double parseLeadingDouble(final String line, final int offset) {
+        int end = offset;
+        while ((end < line.length()) && (line.charAt(end) != ' ')) {
+            end++;
+        }
+        try {
+            return Double.parseDouble(line.substring(offset, end));
+        } catch (NumberFormatException ex) {
+            return null;
+        }
+    }
+
+    /**
+     * A parsed interval line: [Tag=tagString,]startTimestamp,intervalLength,intervalMax,compressedHistogram
+     */
+    private static class IntervalLine {
+        final String tag;
+        final double timestampSec;
+        final double lengthSec;
+        final String payload;
+
+        IntervalLine(final String line, final long lineStartPosition) {
+            final String[] fields = new String[5];
+            int fieldCount = 0;
+            int tokenStart = -1;
+            for (int i = 0; i <= line.length(); i++) {
+                final boolean isDelimiter = (i == line.length()) || (line.charAt(i) == ',') || (line.charAt(i) == ' ');
+                if (isDelimiter) {
+                    if (tokenStart >= 0) {
+                        if (fieldCount == fields.length) {
+                            break;
+                        }
+                        fields[fieldCount++] = line.substring(tokenStart, i);
+                        tokenStart = -1;
+                    }
+                } else if (tokenStart < 0) {
+                    tokenStart = i;
+                }
+            }
+            final int firstField = ((fieldCount > 0) && fields[0].startsWith("Tag=")) ? 1 : 0;
+            if (fieldCount < firstField + 4) {
+                throw new IllegalArgumentException("Malformed histogram log line at byte offset " +
+                        lineStartPosition);
+            }
+            tag = (firstField == 1) ? fields[0].substring(4) : null;
+            try {
+                timestampSec = Double.parseDouble(fields[firstField]);
+                lengthSec = Double.parseDouble(fields[firstField + 1]);
+            } catch (NumberFormatException ex) {
+                throw new IllegalArgumentException("Malformed histogram log line at byte offset " +
+                        lineStartPosition, ex);
+            }
+            payload = fields[firstField + 3];
+        }
+    }
+
+    /**
+     * A chunk of the log file, owning the lines that start within [startPosition, endPosition). Lines are
+     * read through mapped regions of the file, which are extended (re-mapped) as needed for lines that cross
+     * a region's end.
+     */
+    private class LogChunk {
+        private final long endPosition;
+        private long position;
+        private boolean positionIsAtLineStart;
+        private long lineStartPosition;
+        private MappedByteBuffer region;
+        private long regionStart;
+        private byte[] lineBytes = new byte[1024];
+
+        LogChunk(final long startPosition, final long endPosition) {
+            this.position = startPosition;
+            this.positionIsAtLineStart = (startPosition == 0);
+            this.endPosition = endPosition;
+        }
+
+        List<EncodableHistogram> readIntervalHistograms(final double rangeStartTimeSec,
+                                                        final double rangeEndTimeSec,
+                                                        final String tag) throws IOException, DataFormatException {
+            final List<EncodableHistogram> histograms = new ArrayList<>();
+            IntervalLine interval;
+            while ((interval = nextMatchingInterval(rangeStartTimeSec, rangeEndTimeSec, tag)) != null) {
+                final EncodableHistogram histogram = EncodableHistogram.decodeFromCompressedByteBuffer(
+                        ByteBuffer.wrap(Base64Helper.parseBase64Binary(interval.payload)), 0);
+                final double absoluteStartTimeStampSec = interval.timestampSec + baseTimeSec;
+                histogram.setStartTimeStamp((long) (absoluteStartTimeStampSec * 1000.0));
+                histogram.setEndTimeStamp((long) ((absoluteStartTimeStampSec + interval.lengthSec) * 1000.0));
+                histogram.setTag(interval.tag);
+                histograms.add(histogram);
+            }
+            return histograms;
+        }
+
+        int addIntervalHistogramsTo(final AbstractHistogram accumulator,
+                                    final double rangeStartTimeSec,
+                                    final double rangeEndTimeSec,
+                                    final String tag) throws IOException, DataFormatException {
+            int addedCount = 0;
+            IntervalLine interval;
+            while ((interval = nextMatchingInterval(rangeStartTimeSec, rangeEndTimeSec, tag)) != null) {
+                accumulator.addFromCompressedByteBuffer(
+                        ByteBuffer.wrap(Base64Helper.parseBase64Binary(interval.payload)));
+                final double absoluteStartTimeStampSec = interval.timestampSec + baseTimeSec;
+                accumulator.setStartTimeStamp(
+                        Math.min(accumulator.getStartTimeStamp(), (long) (absoluteStartTimeStampSec * 1000.0)));
+                accumulator.setEndTimeStamp(Math.max(accumulator.getEndTimeStamp(),
+                        (long) ((absoluteStartTimeStampSec + interval.lengthSec) * 1000.0)));
+                addedCount++;
+            }
+            return addedCount;
+        }
+
+        private IntervalLine nextMatchingInterval(final double rangeStartTimeSec,
+                                                  final double rangeEndTimeSec,
+                                                  final String tag) throws IOException {
+            final String tagPrefix = (tag == null) ? null : "Tag=" + tag + ",";
+            String line;
+            while ((line = nextLine()) != null) {
+                if ((line.length() == 0) || line.startsWith("#") || line.startsWith("\"StartTimestamp\"")) {
+                    // comment, legend, or empty line
+                    continue;
+                }
+                // Filter on tag and time range before decoding anything:
+                if ((tagPrefix == null) ? line.startsWith("Tag=") : !line.startsWith(tagPrefix)) {
+                    continue;
+                }
+                final IntervalLine interval = new IntervalLine(line, lineStartPosition);
+                final double offsetStartTimeStampSec = interval.timestampSec + baseTimeSec - startTimeSec;
+                if ((offsetStartTimeStampSec < rangeStartTimeSec) || (offsetStartTimeStampSec > rangeEndTimeSec)) {
+                    continue;
+                }
+                return interval;
+            }
+            return null;
+        }
+
+        /**
+         * Read the next line owned by this chunk.
+         * @return the next line (without line terminators), or null if no more lines start in this chunk
+         */
+        String nextLine() throws IOException {
+            if (!positionIsAtLineStart) {
+                // The line containing the chunk's start position belongs to the previous chunk, unless
+                // the chunk starts right after a line terminator:
+                if (byteAt(position - 1) != '\n') {
+                    position = findLineEnd(position) + 1;
+                }
+                positionIsAtLineStart = true;
+            }
+            if ((position >= endPosition) || (position >= fileLength)) {
+                return null;
+            }
+            lineStartPosition = position;
+            final long lineEnd = findLineEnd(position);
+            int lineLength = (int) (lineEnd - position);
+            if (lineBytes.length < lineLength) {
+                lineBytes = new byte[Math.max(lineLength, 2 * lineBytes.length)];
+            }
+            mapRegion(position, lineLength);
+            region.position((int) (position - regionStart));
+            region.get(lineBytes, 0, lineLength);
+            position = lineEnd + 1;
+            if ((lineLength > 0) && (lineBytes[lineLength - 1] == '\r')) {
+                lineLength--;
+            }
+            return new String(lineBytes, 0, lineLength, LOG_CHARSET);
+        }
+
+        private byte byteAt(final long filePosition) throws IOException {
+            mapRegion(filePosition, 1);
+            return region.get((int) (filePosition - regionStart));
+        }
+
+        /**
+         * Find the position of the line terminator for the line at the given position (or the end of the file).
+         */
+        private long findLineEnd(final long fromPosition) throws IOException {
+            long searchPosition = fromPosition;
+            int neededLength = INITIAL_LINE_REGION_LENGTH;
+            while (searchPosition < fileLength) {
+                mapRegion(fromPosition, (int) Math.min(neededLength, fileLength - fromPosition));
+                final long regionEnd = regionStart + region.capacity();
+                for (; searchPosition < regionEnd; searchPosition++) {
+                    if (region.get((int) (searchPosition - regionStart)) == '\n') {
+                        return searchPosition;
+                    }
+                }
+                if (neededLength > Integer.MAX_VALUE / 2) {
+                    throw new IllegalArgumentException("Histogram log line at byte offset " + fromPosition +
+                            " is too long");
+                }
+                neededLength *= 2;
+            }
+            return fileLength;
+        }
+
+        /**
+         * Make sure the mapped region covers [fromPosition, fromPosition + length).
+         */
+        private void mapRegion(final long fromPosition, final int length) throws IOException {
+            if ((region != null) && (fromPosition >= regionStart) &&
+                    (fromPosition + length <= regionStart + region.capacity())) {
+                return;
+            }
+            final long mappedLength = Math.min(fileLength - fromPosition,
+                    Math.max((long) length, (long) INITIAL_LINE_REGION_LENGTH +
+                            Math.min(endPosition - fromPosition, (long) chunkSizeInBytes)));
+            regionStart = fromPosition;
+            region = channel.map(FileChannel.MapMode.READ_ONLY, fromPosition,
+                    Math.min(mappedLength, Integer.MAX_VALUE));
+        }
+    }
+}
@@ -0,0 +1,25 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+/**
+ * A callback for visiting the percentile distribution of a histogram with
+ * {@link AbstractHistogram#forEachPercentile(int, PercentileConsumer)}. Receives each percentile iteration step
+ * as primitives, with no per-step allocation.
+ */
+public interface PercentileConsumer {
+
+    /**
+     * Visit a percentile iteration step
+     *
+     * @param valueIteratedTo The (highest equivalent) value at the percentile level
+     * @param percentileLevelIteratedTo The percentile level of the step (100.0 for the last step)
+     * @param totalCountToThisValue The total count of values recorded up to and including valueIteratedTo
+     */
+    void accept(long valueIteratedTo, double percentileLevelIteratedTo, long totalCountToThisValue);
+}
@@ -0,0 +1,67 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+/**
+ * Formats the percentile distribution lines of
+ * {@link AbstractHistogram#outputPercentileDistribution(java.io.PrintStream, int, Double, boolean)} into a
+ * {@link StringBuilder}, producing the exact same text as the equivalent {@link java.util.Formatter} patterns
+ * ("%12.{digits}f %2.12f %10d %14.2f", or "%.{digits}f,%.12f,%d,%.2f" for csv), without the per-line cost of
+ * parsing format strings and boxing arguments.
+ */
+class PercentileDistributionFormatter implements PercentileConsumer {
+    private final StringBuilder output = new StringBuilder(4096);
+    private final int numberOfSignificantValueDigits;
+    private final double outputValueUnitScalingRatio;
+    private final boolean useCsvFormat;
+
+    PercentileDistributionFormatter(final int numberOfSignificantValueDigits,
+                                    final double outputValueUnitScalingRatio,
+                                    final boolean useCsvFormat) {
+        this.numberOfSignificantValueDigits = numberOfSignificantValueDigits;
+        this.outputValueUnitScalingRatio = outputValueUnitScalingRatio;
+        this.useCsvFormat = useCsvFormat;
+    }
+
+    @Override
+    public void accept(final long valueIteratedTo, final double percentileLevelIteratedTo,
+                       final long totalCountToThisValue) {
+        final double percentile = percentileLevelIteratedTo / 100.0D;
+        final boolean lastLine = (percentileLevelIteratedTo == 100.0D);
+        if (useCsvFormat) {
+            FixedPointFormat.append(output, valueIteratedTo / outputValueUnitScalingRatio,
+                    numberOfSignificantValueDigits, 0);
+            output.append(',');
+            FixedPointFormat.append(output, percentile, 12, 0);
+            output.append(',').append(totalCountToThisValue).append(',');
+            if (lastLine) {
+                output.append("Infinity");
+            } else {
+                FixedPointFormat.append(output, 1 / (1.0D - percentile), 2, 0);
+            }
+        } else {
+            FixedPointFormat.append(output, valueIteratedTo / outputValueUnitScalingRatio,
+                    numberOfSignificantValueDigits, 12);
+            output.append(' ');
+            FixedPointFormat.append(output, percentile, 12, 2);
+            output.append(' ');
+            final int start = output.length();
+            output.append(totalCountToThisValue);
+            FixedPointFormat.padTo(output, start, 10);
+            if (!lastLine) {
+                output.append(' ');
+                FixedPointFormat.append(output, 1 / (1.0D - percentile), 2, 14);
+            }
+        }
+        output.append('\n');
+    }
+
+    StringBuilder getOutput() {
+        return output;
+    }
+}
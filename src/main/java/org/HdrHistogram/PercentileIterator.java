@@ -75,11 +75,19 @@ public class PercentileIterator extends AbstractHistogramIterator implements Ite
         // [from either 0% or from the previous half-distance]. When that half-distance is
         // crossed, the scale changes and the tick size is effectively cut in half.
 
+        percentileLevelToIterateTo = nextPercentileLevel(percentileLevelToIterateTo, percentileTicksPerHalfDistance);
+    }
+
+    /**
+     * Compute the percentile level of the iteration step that follows a given percentile level. Shared with
+     * {@link AbstractHistogram#forEachPercentile}, which iterates through the same steps.
+     */
+    static double nextPercentileLevel(final double percentileLevel, final int percentileTicksPerHalfDistance) {
         long percentileReportingTicks =
                 percentileTicksPerHalfDistance *
                         (long) Math.pow(2,
-                                (long) (Math.log(100.0 / (100.0 - (percentileLevelToIterateTo))) / Math.log(2)) + 1);
-        percentileLevelToIterateTo += 100.0 / percentileReportingTicks;
+                                (long) (Math.log(100.0 / (100.0 - (percentileLevel))) / Math.log(2)) + 1);
+        return percentileLevel + (100.0 / percentileReportingTicks);
     }
 
     @Override
@@ -0,0 +1,24 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+/**
+ * A callback for visiting the recorded values of a histogram with
+ * {@link AbstractHistogram#forEachRecordedValue(RecordedValueConsumer)}. Receives each recorded value level
+ * as primitives, with no per-value allocation.
+ */
+public interface RecordedValueConsumer {
+
+    /**
+     * Visit a recorded value level
+     *
+     * @param valueIteratedTo The (highest equivalent) value of the level
+     * @param countAtValue The count of values recorded at the level (never 0)
+     */
+    void accept(long valueIteratedTo, long countAtValue);
+}
@@ -7,6 +7,8 @@
 
 package org.HdrHistogram;
 
+import java.nio.LongBuffer;
+import java.util.concurrent.CopyOnWriteArrayList;
 import java.util.concurrent.atomic.AtomicLong;
 
 /**
@@ -36,6 +38,19 @@ import java.util.concurrent.atomic.AtomicLong;
  *   ...
  * [end of loop construct]
  * </code></pre>
+ * <p>
+ * When constructed with a stripe count (see {@link Recorder#Recorder(long, long, int, int)}), a {@link Recorder}
+ * records into a {@link StripedConcurrentHistogram}, which spreads recording threads across independent count
+ * stripes to avoid contended cache lines under write-heavy many-core recording. The stripes are merged into a
+ * (non-striped) {@link Histogram} only when an interval histogram is taken.
+ * <p>
+ * When constructed with a write combining buffer length (see {@link Recorder#Recorder(int, boolean, int)}),
+ * {@link Recorder#recordValue} calls from each recording thread are accumulated in a small buffer private to
+ * that thread, which is recorded into the shared active histogram as a single batch whenever it fills up. This
+ * mode is intended for very hot recording call sites, where even a single contended atomic increment per recorded
+ * value is too expensive. Values held in the recording threads' buffers are drained into the active histogram
+ * whenever an interval histogram is taken (or the recorder is reset), such that no recorded values are lost
+ * across interval flips.
  *
  */
 
@@ -48,6 +63,13 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
     private volatile Histogram activeHistogram;
     private Histogram inactiveHistogram;
 
+    private final IntervalHistogramPool<Histogram> intervalHistogramPool = new IntervalHistogramPool<>();
+
+    private final int writeCombiningBufferLength;
+    private final ThreadLocal<WriteCombiningBuffer> writeCombiningBuffers;
+    private final CopyOnWriteArrayList<WriteCombiningBuffer> registeredWriteCombiningBuffers =
+            new CopyOnWriteArrayList<>();
+
     /**
      * Construct an auto-resizing {@link Recorder} with a lowest discernible value of
      * 1 and an auto-adjusting highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
@@ -65,10 +87,50 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
      * @param packed Specifies whether the recorder will uses a packed internal representation or not.
      */
     public Recorder(final int numberOfSignificantValueDigits, boolean packed) {
+        this(numberOfSignificantValueDigits, packed, 0);
+    }
+
+    /**
+     * Construct an auto-resizing, optionally write combining {@link Recorder} with a lowest discernible value of
+     * 1 and an auto-adjusting highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
+     * <p>
+     * When writeCombiningBufferLength is positive, {@link Recorder#recordValue} calls made by each recording
+     * thread are accumulated in a buffer private to that thread, and are recorded into the shared active histogram
+     * in batches of writeCombiningBufferLength values. Buffered values are drained into the active histogram
+     * whenever an interval histogram is taken. Since buffered values are only recorded when their batch is
+     * recorded, an exception resulting from recording a buffered value (e.g. due to exceeding the auto-resizing
+     * limit) may be thrown by a later {@link Recorder#recordValue} call, or when taking an interval histogram.
+     * Each recording thread's buffers occupy 2 * writeCombiningBufferLength longs (plus overhead) for as long as
+     * the thread is alive.
+     *
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     * @param packed Specifies whether the recorder will uses a packed internal representation or not.
+     * @param writeCombiningBufferLength The number of values each recording thread accumulates before recording
+     *                                   them into the active histogram. Must be non-negative. A value of 0
+     *                                   disables write combining.
+     */
+    public Recorder(final int numberOfSignificantValueDigits, final boolean packed,
+                    final int writeCombiningBufferLength) {
+        if (writeCombiningBufferLength < 0) {
+            throw new IllegalArgumentException("writeCombiningBufferLength must be >= 0");
+        }
         activeHistogram = packed ?
                 new InternalPackedConcurrentHistogram(instanceId, numberOfSignificantValueDigits) :
                 new InternalConcurrentHistogram(instanceId, numberOfSignificantValueDigits);
         inactiveHistogram = null;
+        this.writeCombiningBufferLength = writeCombiningBufferLength;
+        writeCombiningBuffers = (writeCombiningBufferLength > 0) ?
+                new ThreadLocal<WriteCombiningBuffer>() {
+                    @Override
+                    protected WriteCombiningBuffer initialValue() {
+                        WriteCombiningBuffer buffer = new WriteCombiningBuffer();
+                        registeredWriteCombiningBuffers.add(buffer);
+                        return buffer;
+                    }
+                } :
+                null;
         activeHistogram.setStartTimeStamp(System.currentTimeMillis());
     }
 
@@ -121,6 +183,40 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
         activeHistogram = new InternalAtomicHistogram(
                 instanceId, lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
         inactiveHistogram = null;
+        writeCombiningBufferLength = 0;
+        writeCombiningBuffers = null;
+        activeHistogram.setStartTimeStamp(System.currentTimeMillis());
+    }
+
+    /**
+     * Construct a striped {@link Recorder} given the Lowest and highest values to be tracked, a number
+     * of significant decimal digits, and a number of count stripes. Recording threads will be spread across
+     * stripeCount independent count stripes (see {@link StripedConcurrentHistogram}), which are merged into
+     * a single (non-striped) {@link Histogram} when an interval histogram is taken. This mode is intended
+     * for write-heavy recording from many concurrent threads, and carries a memory footprint of
+     * 2 * stripeCount fixed-range histograms.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     * @param stripeCount The number of count stripes to record into. Must be a positive integer. Will be
+     *                    rounded up to the nearest power of 2.
+     */
+    public Recorder(final long lowestDiscernibleValue,
+                    final long highestTrackableValue,
+                    final int numberOfSignificantValueDigits,
+                    final int stripeCount) {
+        activeHistogram = new InternalStripedConcurrentHistogram(
+                instanceId, lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits,
+                stripeCount);
+        inactiveHistogram = null;
+        writeCombiningBufferLength = 0;
+        writeCombiningBuffers = null;
         activeHistogram.setStartTimeStamp(System.currentTimeMillis());
     }
 
@@ -131,6 +227,13 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
      */
     @Override
     public void recordValue(final long value) throws ArrayIndexOutOfBoundsException {
+        if (writeCombiningBuffers != null) {
+            if (value < 0) {
+                throw new ArrayIndexOutOfBoundsException("Histogram recorded value cannot be negative.");
+            }
+            writeCombiningBuffers.get().recordValue(value);
+            return;
+        }
         long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
         try {
             activeHistogram.recordValue(value);
@@ -183,6 +286,43 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
         }
     }
 
+    /**
+     * Record a batch of values in the histogram. Equivalent to recording each of the values with
+     * {@link #recordValue(long)}, but with a single recording critical section for the whole batch.
+     *
+     * @param values The array containing the values to be recorded
+     * @param offset The offset in the array of the first value to be recorded
+     * @param length The number of values to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValues(final long[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+        try {
+            activeHistogram.recordValues(values, offset, length);
+        } finally {
+            recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+        }
+    }
+
+    /**
+     * Record a batch of values in the histogram, consisting of the values remaining in a buffer. Equivalent to
+     * {@link #recordValues(long[], int, int)}. The buffer's position is advanced to its limit.
+     *
+     * @param values The buffer containing the values to be recorded (from its position to its limit)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValues(final LongBuffer values) throws ArrayIndexOutOfBoundsException {
+        long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+        try {
+            activeHistogram.recordValues(values);
+        } finally {
+            recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+        }
+    }
+
     @Override
     public synchronized Histogram getIntervalHistogram() {
         return getIntervalHistogram(null);
@@ -198,6 +338,12 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
                                                        boolean enforceContainingInstance) {
         // Verify that replacement histogram can validly be used as an inactive histogram replacement:
         validateFitAsReplacementHistogram(histogramToRecycle, enforceContainingInstance);
+        if (histogramToRecycle == null) {
+            histogramToRecycle = intervalHistogramPool.take();
+        }
+        if (activeHistogram instanceof InternalStripedConcurrentHistogram) {
+            return getMergedIntervalHistogram(histogramToRecycle);
+        }
         inactiveHistogram = histogramToRecycle;
         performIntervalSample();
         Histogram sampledHistogram = inactiveHistogram;
@@ -211,6 +357,64 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
         inactiveHistogram.copyInto(targetHistogram);
     }
 
+    synchronized void publishIntervalHistogram(final SharedHistogramPublisher publisher) {
+        // Publish straight from the sampled inactive histogram, which remains ours until the next sample:
+        performIntervalSample();
+        publisher.publish(inactiveHistogram);
+    }
+
+    private Histogram getMergedIntervalHistogram(Histogram histogramToRecycle) {
+        // The striped inactive histogram is never exposed. Instead, its stripes are merged into
+        // the (recycled or newly allocated) interval histogram we hand out:
+        performIntervalSample();
+        Histogram mergedHistogram = histogramToRecycle;
+        if (mergedHistogram == null) {
+            mergedHistogram = new InternalHistogram(instanceId, inactiveHistogram);
+        }
+        inactiveHistogram.copyInto(mergedHistogram);
+        return mergedHistogram;
+    }
+
+    /**
+     * Release an interval histogram previously obtained from this Recorder (via {@link #getIntervalHistogram()} or one
+     * of its recycling variants) back into this Recorder's bounded pool of interval histograms. Pooled interval
+     * histograms are used by subsequent getIntervalHistogram() calls that are not provided with a histogram to recycle, such
+     * that steady-state interval sampling with explicit releases does not allocate.
+     * <p>
+     * NOTE: The caller must not access a released interval histogram after releasing it. Releasing the same
+     * interval histogram instance more than once (without obtaining it again) is disallowed.
+     *
+     * @param intervalHistogram a previously returned interval histogram (from this instance of {@link Recorder}).
+     * @return true if the interval histogram was pooled, false if it was dropped because the pool is full
+     * (or the provided interval histogram is null)
+     * @throws IllegalArgumentException if the interval histogram was not obtained from this instance, or if it
+     * has already been released
+     */
+    public synchronized boolean releaseIntervalHistogram(final Histogram intervalHistogram) {
+        if (intervalHistogram == null) {
+            return false;
+        }
+        validateFitAsReplacementHistogram(intervalHistogram, true);
+        return intervalHistogramPool.release(intervalHistogram);
+    }
+
+    /**
+     * Get the capacity of this Recorder's pool of released interval histograms.
+     * @return the interval histogram pool capacity
+     */
+    public synchronized int getIntervalHistogramPoolCapacity() {
+        return intervalHistogramPool.getCapacity();
+    }
+
+    /**
+     * Set the capacity of this Recorder's pool of released interval histograms (see
+     * {@link #releaseIntervalHistogram}). Pooled interval histograms beyond the new capacity are dropped.
+     * @param capacity the interval histogram pool capacity. Must be non-negative.
+     */
+    public synchronized void setIntervalHistogramPoolCapacity(final int capacity) {
+        intervalHistogramPool.setCapacity(capacity);
+    }
+
     /**
      * Reset any value counts accumulated thus far.
      */
@@ -222,6 +426,9 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
     }
 
     private void performIntervalSample() {
+        if (writeCombiningBuffers != null) {
+            drainWriteCombiningBuffers();
+        }
         try {
             recordingPhaser.readerLock();
 
@@ -241,6 +448,13 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
                     inactiveHistogram = new InternalPackedConcurrentHistogram(
                             instanceId,
                             activeHistogram.getNumberOfSignificantValueDigits());
+                } else if (activeHistogram instanceof InternalStripedConcurrentHistogram) {
+                    inactiveHistogram = new InternalStripedConcurrentHistogram(
+                            instanceId,
+                            activeHistogram.getLowestDiscernibleValue(),
+                            activeHistogram.getHighestTrackableValue(),
+                            activeHistogram.getNumberOfSignificantValueDigits(),
+                            ((InternalStripedConcurrentHistogram) activeHistogram).getStripeCount());
                 } else {
                     throw new IllegalStateException("Unexpected internal histogram type for activeHistogram");
                 }
@@ -267,6 +481,77 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
         }
     }
 
+    //
+    // Write combining support:
+    //
+
+    private void drainWriteCombiningBuffers() {
+        for (WriteCombiningBuffer buffer : registeredWriteCombiningBuffers) {
+            buffer.drain();
+            if (!buffer.owner.isAlive()) {
+                // A dead thread will not record into its buffer again, and has now been fully drained:
+                registeredWriteCombiningBuffers.remove(buffer);
+            }
+        }
+    }
+
+    private void recordBatch(final ValueBatch batch) {
+        long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+        try {
+            activeHistogram.recordValues(batch.values, 0, batch.count);
+        } finally {
+            batch.count = 0;
+            recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+        }
+    }
+
+    private static class ValueBatch {
+        private final long[] values;
+        private int count = 0;
+
+        private ValueBatch(int length) {
+            values = new long[length];
+        }
+    }
+
+    // A per-recording-thread, double buffered batch of values. The owning thread appends to the active batch
+    // within (uncontended) critical sections of the buffer's own phaser, which allows a reader to flip the
+    // batches and drain the inactive one without stalling or missing concurrent appends:
+    private class WriteCombiningBuffer {
+        private final Thread owner = Thread.currentThread();
+        private final WriterReaderPhaser bufferPhaser = new WriterReaderPhaser();
+        private volatile ValueBatch activeBatch = new ValueBatch(writeCombiningBufferLength);
+        private ValueBatch inactiveBatch = new ValueBatch(writeCombiningBufferLength);
+
+        private void recordValue(final long value) {
+            long criticalValueAtEnter = bufferPhaser.writerCriticalSectionEnter();
+            try {
+                final ValueBatch batch = activeBatch;
+                batch.values[batch.count++] = value;
+                if (batch.count == batch.values.length) {
+                    recordBatch(batch);
+                }
+            } finally {
+                bufferPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+            }
+        }
+
+        private void drain() {
+            try {
+                bufferPhaser.readerLock();
+                final ValueBatch batch = inactiveBatch;
+                inactiveBatch = activeBatch;
+                activeBatch = batch;
+                bufferPhaser.flipPhase(500000L /* yield in 0.5 msec units if needed */);
+                if (inactiveBatch.count > 0) {
+                    recordBatch(inactiveBatch);
+                }
+            } finally {
+                bufferPhaser.readerUnlock();
+            }
+        }
+    }
+
     private static class InternalAtomicHistogram extends AtomicHistogram {
         private final long containingInstanceId;
 
@@ -297,6 +582,29 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
         }
     }
 
+    private static class InternalStripedConcurrentHistogram extends StripedConcurrentHistogram {
+        private final long containingInstanceId;
+
+        private InternalStripedConcurrentHistogram(long id,
+                                                   long lowestDiscernibleValue,
+                                                   long highestTrackableValue,
+                                                   int numberOfSignificantValueDigits,
+                                                   int stripeCount) {
+            super(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits, stripeCount);
+            this.containingInstanceId = id;
+        }
+    }
+
+    // Interval histograms handed out by striped recorders hold merged (non-striped) counts:
+    private static class InternalHistogram extends Histogram {
+        private final long containingInstanceId;
+
+        private InternalHistogram(long id, AbstractHistogram source) {
+            super(source);
+            this.containingInstanceId = id;
+        }
+    }
+
     private void validateFitAsReplacementHistogram(Histogram replacementHistogram,
                                                    boolean enforceContainingInstance) {
         boolean bad = true;
@@ -329,6 +637,15 @@ public class Recorder implements ValueRecorder, IntervalHistogramProvider<Histog
                     )) {
                 bad = false;
             }
+        } else if (replacementHistogram instanceof InternalHistogram) {
+            if ((activeHistogram instanceof InternalStripedConcurrentHistogram)
+                    &&
+                    ((!enforceContainingInstance) ||
+                            (((InternalHistogram)replacementHistogram).containingInstanceId ==
+                                    ((InternalStripedConcurrentHistogram)activeHistogram).containingInstanceId)
+                    )) {
+                bad = false;
+            }
         }
         if (bad) {
             throw new IllegalArgumentException("replacement histogram must have been obtained via a previous" +
@@ -0,0 +1,143 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+import java.util.zip.Deflater;
+
+import static java.nio.ByteOrder.BIG_ENDIAN;
+
+/**
+ * A reusable deflating encoder, shared by all histograms encoded on the same thread (see {@link #get()}), such
+ * that encoding into compressed form neither allocates a per-encoding {@link Deflater}, nor keeps a
+ * {@link Deflater} (and its native state) alive per histogram.
+ * <p>
+ * Uncompressed encodings are produced (in a single pass over the counts) into a growable uncompressed buffer,
+ * which grows to the size of the largest encoding produced on the thread, rather than being fully sized for
+ * the (worst case) encoding of the full counts array ahead of encoding. (The uncompressed encoding is deflated once
+ * complete, as Java 7's {@link Deflater} only accepts array input.)
+ * <p>
+ * Compressed output is written directly into the target buffer's backing array when it has one. Targets
+ * without an accessible backing array (e.g. direct buffers) are written through a reused output array.
+ * <p>
+ * A {@link SharedDeflater} is not thread-safe, and supports a single encoding in progress at a time.
+ */
+class SharedDeflater {
+    static final int INITIAL_UNCOMPRESSED_BUFFER_CAPACITY = 8 * 1024;
+    private static final int OUTPUT_ARRAY_LENGTH = 8 * 1024;
+
+    private static final ThreadLocal<SharedDeflater> threadLocalDeflater =
+            new ThreadLocal<SharedDeflater>() {
+                @Override
+                protected SharedDeflater initialValue() {
+                    return new SharedDeflater();
+                }
+            };
+
+    private final Deflater deflater = new Deflater();
+    private ByteBuffer uncompressedBuffer =
+            ByteBuffer.allocate(INITIAL_UNCOMPRESSED_BUFFER_CAPACITY).order(BIG_ENDIAN);
+    private byte[] outputArray = null;
+
+    private ByteBuffer targetBuffer;
+
+    /**
+     * Get the current thread's {@link SharedDeflater}
+     * @return the current thread's {@link SharedDeflater}
+     */
+    static SharedDeflater get() {
+        return threadLocalDeflater.get();
+    }
+
+    /**
+     * Start a new uncompressed encoding.
+     * @return the (cleared) uncompressed buffer to write the uncompressed encoding into
+     */
+    ByteBuffer startUncompressedEncoding() {
+        uncompressedBuffer.clear();
+        return uncompressedBuffer;
+    }
+
+    /**
+     * Make sure the uncompressed buffer has room for at least the given number of bytes, growing it (while
+     * preserving its contents and position) if it does not.
+     * @param neededBytes The number of bytes about to be written into the uncompressed buffer
+     * @return the uncompressed buffer to continue writing the uncompressed encoding into
+     */
+    ByteBuffer ensureUncompressedRoom(final int neededBytes) {
+        if (uncompressedBuffer.remaining() < neededBytes) {
+            final ByteBuffer previousBuffer = uncompressedBuffer;
+            final int neededCapacity = previousBuffer.position() + neededBytes;
+            uncompressedBuffer = ByteBuffer.allocate(Math.max(2 * previousBuffer.capacity(), neededCapacity))
+                    .order(BIG_ENDIAN);
+            System.arraycopy(previousBuffer.array(), 0, uncompressedBuffer.array(), 0, previousBuffer.position());
+            uncompressedBuffer.position(previousBuffer.position());
+        }
+        return uncompressedBuffer;
+    }
+
+    /**
+     * Compress the uncompressed encoding (the uncompressed buffer's contents up to its position) into the
+     * target buffer (at its current position).
+     * @param targetBuffer The buffer to write compressed output into
+     * @param compressionLevel Compression level (for java.util.zip.Deflater)
+     * @return the total number of compressed bytes written into the target buffer
+     * @throws BufferOverflowException if the target buffer does not have room for the compressed output
+     */
+    int deflateUncompressedEncoding(final ByteBuffer targetBuffer, final int compressionLevel) {
+        return deflate(uncompressedBuffer.array(), 0, uncompressedBuffer.position(), targetBuffer,
+                compressionLevel);
+    }
+
+    /**
+     * Compress the given uncompressed bytes into the target buffer (at its current position).
+     * @param source The array containing the uncompressed bytes
+     * @param offset The offset of the first uncompressed byte in source
+     * @param length The number of uncompressed bytes
+     * @param targetBuffer The buffer to write compressed output into
+     * @param compressionLevel Compression level (for java.util.zip.Deflater)
+     * @return the total number of compressed bytes written into the target buffer
+     * @throws BufferOverflowException if the target buffer does not have room for the compressed output
+     */
+    int deflate(final byte[] source, final int offset, final int length,
+                final ByteBuffer targetBuffer, final int compressionLevel) {
+        deflater.reset();
+        deflater.setLevel(compressionLevel);
+        this.targetBuffer = targetBuffer;
+        try {
+            deflater.setInput(source, offset, length);
+            deflater.finish();
+            while (!deflater.finished()) {
+                deflateIntoTarget();
+            }
+            return (int) deflater.getBytesWritten();
+        } finally {
+            this.targetBuffer = null;
+        }
+    }
+
+    private void deflateIntoTarget() {
+        if (!targetBuffer.hasRemaining()) {
+            throw new BufferOverflowException();
+        }
+        if (targetBuffer.hasArray()) {
+            final int position = targetBuffer.position();
+            final int compressedLength = deflater.deflate(targetBuffer.array(),
+                    targetBuffer.arrayOffset() + position, targetBuffer.remaining());
+            targetBuffer.position(position + compressedLength);
+        } else {
+            if (outputArray == null) {
+                outputArray = new byte[OUTPUT_ARRAY_LENGTH];
+            }
+            final int compressedLength = deflater.deflate(outputArray, 0,
+                    Math.min(outputArray.length, targetBuffer.remaining()));
+            targetBuffer.put(outputArray, 0, compressedLength);
+        }
+    }
+}
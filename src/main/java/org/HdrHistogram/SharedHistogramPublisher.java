@@ -0,0 +1,255 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.channels.FileChannel;
+
+/**
+ * Publishes histograms (e.g. the interval histograms of a {@link Recorder}) into a shared memory region, such
+ * as a memory-mapped file, from which other threads or processes can read them with a {@link SharedHistogramReader}
+ * (or any reader that follows the layout below) with no encoding, compression or decoding involved.
+ * <p>
+ * Each publication copies the counts of the published histogram into the region, framed by a seqlock-style
+ * sequence number: the sequence is odd while a publication is in progress and even once it is complete, such
+ * that readers can detect (and retry) reads that overlap a publication. Publishing an interval histogram of a
+ * {@link Recorder} with {@link #publishIntervalHistogram(Recorder)} reads the counts directly from the recorder's
+ * inactive histogram right after its phase flip, without taking an intermediate copy. Only the populated span of
+ * the published histogram's counts (the span covering its minimum and maximum values) is copied, along with
+ * zeroing of the counts left in the region by the previous publication outside of that span, such that the cost
+ * of a publication tracks the range of values published rather than the (configured) length of the counts.
+ * <p>
+ * A publisher is configured with the lowest discernible value, highest trackable value and number of significant
+ * value digits of the histograms it publishes, and can publish any histogram with the same lowest discernible value
+ * and number of significant value digits whose values fall within its highest trackable value.
+ * <h3>Region layout</h3>
+ * All fields are <b><code>long</code></b>s, in native byte order, at the following offsets from the start of
+ * the region:
+ * <ul>
+ * <li>{@link #COOKIE_OFFSET}: {@link #COOKIE}, identifying the layout (and byte order) of the region</li>
+ * <li>{@link #SEQUENCE_OFFSET}: The publication sequence number. Odd while a publication is in progress.</li>
+ * <li>{@link #LOWEST_DISCERNIBLE_VALUE_OFFSET}, {@link #HIGHEST_TRACKABLE_VALUE_OFFSET},
+ * {@link #NUMBER_OF_SIGNIFICANT_VALUE_DIGITS_OFFSET}: The histogram configuration</li>
+ * <li>{@link #COUNTS_LENGTH_OFFSET}: The number of counts in the region</li>
+ * <li>{@link #START_TIMESTAMP_OFFSET}, {@link #END_TIMESTAMP_OFFSET}: The published histogram's timestamps</li>
+ * <li>{@link #TOTAL_COUNT_OFFSET}: The published histogram's total count</li>
+ * <li>{@link #COUNTS_OFFSET}: The first of the counts, holding the count at counts index 0. The count at
+ * counts index <code>i</code> is at <code>COUNTS_OFFSET + (8 * i)</code>, where counts indexes are as used by
+ * {@link AbstractHistogram} (and {@link DirectHistogram}'s buffer layout) for the configuration.</li>
+ * </ul>
+ * Note that the region only provides ordering of its contents with respect to the sequence number to the
+ * extent that the JVM orders accesses to direct buffers around volatile field accesses (which it does on all
+ * current JVMs, and which the underlying hardware provides across processes sharing the mapping).
+ */
+public class SharedHistogramPublisher {
+    /**
+     * The cookie identifying a region laid out by a {@link SharedHistogramPublisher}
+     */
+    public static final long COOKIE = 0x1c849312_00000001L;
+
+    public static final int COOKIE_OFFSET = 0;
+    public static final int SEQUENCE_OFFSET = 8;
+    public static final int LOWEST_DISCERNIBLE_VALUE_OFFSET = 16;
+    public static final int HIGHEST_TRACKABLE_VALUE_OFFSET = 24;
+    public static final int NUMBER_OF_SIGNIFICANT_VALUE_DIGITS_OFFSET = 32;
+    public static final int COUNTS_LENGTH_OFFSET = 40;
+    public static final int START_TIMESTAMP_OFFSET = 48;
+    public static final int END_TIMESTAMP_OFFSET = 56;
+    public static final int TOTAL_COUNT_OFFSET = 64;
+    /**
+     * The offset of the counts in the region. The header is padded to keep the counts cache line aligned.
+     */
+    public static final int COUNTS_OFFSET = 128;
+
+    private final ByteBuffer region;
+    private final long lowestDiscernibleValue;
+    private final long highestTrackableValue;
+    private final int numberOfSignificantValueDigits;
+    private final int countsLength;
+    private long sequence;
+    // The span of counts indexes that may hold non-zero counts in the region (empty when lowest > highest):
+    private int publishedLowestIndex = 0;
+    private int publishedHighestIndex = -1;
+
+    private volatile long fence;
+
+    /**
+     * Get the size (in bytes) of the region needed to publish histograms of the given configuration
+     *
+     * @param lowestDiscernibleValue The lowest value that can be discerned (distinguished from 0) by the histogram
+     * @param highestTrackableValue The highest value to be tracked by the histogram
+     * @param numberOfSignificantValueDigits The number of significant decimal digits of precision
+     * @return the size of the region needed
+     */
+    public static int getNeededRegionCapacity(final long lowestDiscernibleValue, final long highestTrackableValue,
+                                              final int numberOfSignificantValueDigits) {
+        return COUNTS_OFFSET + DirectHistogram.getCountsBufferCapacity(
+                lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a publisher that publishes into a memory-mapped file (created, or resized, as needed)
+     *
+     * @param file The file to map and publish into
+     * @param lowestDiscernibleValue The lowest value that can be discerned (distinguished from 0) by the histogram
+     * @param highestTrackableValue The highest value to be tracked by the histogram
+     * @param numberOfSignificantValueDigits The number of significant decimal digits of precision
+     * @throws IOException on errors creating or mapping the file
+     */
+    public SharedHistogramPublisher(final File file,
+                                    final long lowestDiscernibleValue,
+                                    final long highestTrackableValue,
+                                    final int numberOfSignificantValueDigits) throws IOException {
+        this(mapFile(file,
+                getNeededRegionCapacity(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits)),
+                lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a publisher that publishes into the given region (from its current position)
+     *
+     * @param region The region to publish into, e.g. a {@link java.nio.MappedByteBuffer}
+     * @param lowestDiscernibleValue The lowest value that can be discerned (distinguished from 0) by the histogram
+     * @param highestTrackableValue The highest value to be tracked by the histogram
+     * @param numberOfSignificantValueDigits The number of significant decimal digits of precision
+     * @throws IllegalArgumentException if the region is smaller than {@link #getNeededRegionCapacity}
+     */
+    public SharedHistogramPublisher(final ByteBuffer region,
+                                    final long lowestDiscernibleValue,
+                                    final long highestTrackableValue,
+                                    final int numberOfSignificantValueDigits) {
+        // Establish the configuration's counts length (validating the configuration in the process):
+        final Histogram shape =
+                new Histogram(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits, false);
+        final int neededCapacity = COUNTS_OFFSET + (shape.countsArrayLength << 3);
+        if (region.remaining() < neededCapacity) {
+            throw new IllegalArgumentException("region has " + region.remaining() +
+                    " bytes remaining, and needs at least " + neededCapacity);
+        }
+        final ByteBuffer regionView = region.duplicate();
+        regionView.limit(regionView.position() + neededCapacity);
+        this.region = regionView.slice().order(ByteOrder.nativeOrder());
+        this.lowestDiscernibleValue = shape.getLowestDiscernibleValue();
+        this.highestTrackableValue = shape.getHighestTrackableValue();
+        this.numberOfSignificantValueDigits = numberOfSignificantValueDigits;
+        this.countsLength = shape.countsArrayLength;
+
+        // Pick up from the region's existing sequence (so that readers of a re-used region keep making progress),
+        // and mark the region as not yet published into:
+        sequence = (this.region.getLong(COOKIE_OFFSET) == COOKIE) ? this.region.getLong(SEQUENCE_OFFSET) : 0;
+        beginPublication();
+        this.region.putLong(COOKIE_OFFSET, COOKIE);
+        this.region.putLong(LOWEST_DISCERNIBLE_VALUE_OFFSET, this.lowestDiscernibleValue);
+        this.region.putLong(HIGHEST_TRACKABLE_VALUE_OFFSET, this.highestTrackableValue);
+        this.region.putLong(NUMBER_OF_SIGNIFICANT_VALUE_DIGITS_OFFSET, numberOfSignificantValueDigits);
+        this.region.putLong(COUNTS_LENGTH_OFFSET, countsLength);
+        this.region.putLong(START_TIMESTAMP_OFFSET, 0);
+        this.region.putLong(END_TIMESTAMP_OFFSET, 0);
+        this.region.putLong(TOTAL_COUNT_OFFSET, 0);
+        for (int i = 0; i < countsLength; i++) {
+            this.region.putLong(COUNTS_OFFSET + (i << 3), 0);
+        }
+        endPublication();
+    }
+
+    private static ByteBuffer mapFile(final File file, final int size) throws IOException {
+        try (RandomAccessFile randomAccessFile = new RandomAccessFile(file, "rw")) {
+            randomAccessFile.setLength(size);
+            // The mapping remains valid after the file is closed:
+            return randomAccessFile.getChannel().map(FileChannel.MapMode.READ_WRITE, 0, size);
+        }
+    }
+
+    /**
+     * Take an interval histogram sample from the given recorder, and publish it. The counts are published
+     * directly from the recorder's sampled (inactive) histogram, with no intermediate copy.
+     *
+     * @param recorder The recorder to sample and publish the interval histogram of
+     * @throws IllegalArgumentException if the recorder's histograms are not compatible with this publisher
+     */
+    public void publishIntervalHistogram(final Recorder recorder) {
+        recorder.publishIntervalHistogram(this);
+    }
+
+    /**
+     * Publish the current contents of the given histogram. The histogram is expected to not be concurrently
+     * modified during the call, apart from concurrent recording into histograms that support it (e.g.
+     * {@link ConcurrentHistogram}), in which case the published contents may or may not include values recorded
+     * during the call.
+     *
+     * @param histogram The histogram to publish
+     * @throws IllegalArgumentException if the histogram is not compatible with this publisher
+     */
+    public synchronized void publish(final AbstractHistogram histogram) {
+        if ((histogram.getLowestDiscernibleValue() != lowestDiscernibleValue) ||
+                (histogram.getNumberOfSignificantValueDigits() != numberOfSignificantValueDigits)) {
+            throw new IllegalArgumentException("The histogram's lowestDiscernibleValue and " +
+                    "numberOfSignificantValueDigits must match those of the publisher");
+        }
+        if (histogram.countsArrayIndex(histogram.getMaxValue()) >= countsLength) {
+            throw new IllegalArgumentException("The histogram contains values beyond the publisher's " +
+                    "highestTrackableValue (" + highestTrackableValue + ")");
+        }
+        // Only the counts within the histogram's populated span can be non-zero:
+        final int lowestIndex = histogram.getLowestPopulatedIndex();
+        final int highestIndex = Math.min(histogram.getHighestPopulatedIndex(), countsLength - 1);
+        beginPublication();
+        region.putLong(START_TIMESTAMP_OFFSET, histogram.getStartTimeStamp());
+        region.putLong(END_TIMESTAMP_OFFSET, histogram.getEndTimeStamp());
+        // Clear the counts of the previous publication that fall outside of this one's span:
+        for (int i = publishedLowestIndex; i <= Math.min(publishedHighestIndex, lowestIndex - 1); i++) {
+            region.putLong(COUNTS_OFFSET + (i << 3), 0);
+        }
+        for (int i = Math.max(publishedLowestIndex, highestIndex + 1); i <= publishedHighestIndex; i++) {
+            region.putLong(COUNTS_OFFSET + (i << 3), 0);
+        }
+        long totalCount = 0;
+        for (int i = lowestIndex; i <= highestIndex; i++) {
+            final long count = histogram.getCountAtIndex(i);
+            region.putLong(COUNTS_OFFSET + (i << 3), count);
+            totalCount += count;
+        }
+        publishedLowestIndex = lowestIndex;
+        publishedHighestIndex = highestIndex;
+        region.putLong(TOTAL_COUNT_OFFSET, totalCount);
+        endPublication();
+    }
+
+    /**
+     * Get the number of publications made into the region thus far (including the initial, empty, publication
+     * made when the publisher was constructed, and those made by previous publishers of the same region)
+     *
+     * @return the number of publications
+     */
+    public synchronized long getPublicationCount() {
+        return sequence >> 1;
+    }
+
+    private void beginPublication() {
+        sequence = (sequence + 2) & ~1L;
+        region.putLong(SEQUENCE_OFFSET, sequence - 1);
+        orderBufferAccesses();
+    }
+
+    private void endPublication() {
+        orderBufferAccesses();
+        region.putLong(SEQUENCE_OFFSET, sequence);
+    }
+
+    // A volatile store followed by a volatile load, keeping buffer accesses from being reordered across it:
+    private void orderBufferAccesses() {
+        fence = sequence;
+        if (fence != sequence) {
+            throw new IllegalStateException("Publications must be made under the publisher's lock");
+        }
+    }
+}
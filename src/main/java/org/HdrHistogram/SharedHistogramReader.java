@@ -0,0 +1,162 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.channels.FileChannel;
+
+import static org.HdrHistogram.SharedHistogramPublisher.*;
+
+/**
+ * Reads histograms published by a {@link SharedHistogramPublisher} from a shared memory region (e.g. a
+ * memory-mapped file that a publisher in another process publishes into). Reads copy the published counts
+ * straight into a {@link Histogram}, with no decoding, and are retried if they overlap a publication, such that
+ * the histograms read are always complete and consistent publications.
+ * <p>
+ * See {@link SharedHistogramPublisher} for the layout of the region.
+ */
+public class SharedHistogramReader {
+    private final ByteBuffer region;
+    private final long lowestDiscernibleValue;
+    private final long highestTrackableValue;
+    private final int numberOfSignificantValueDigits;
+    private final int countsLength;
+
+    private volatile long fence;
+
+    /**
+     * Construct a reader of histograms published into the given memory-mapped file
+     *
+     * @param file The file to map and read from
+     * @throws IOException on errors opening or mapping the file
+     * @throws IllegalArgumentException if the file does not contain a region laid out by a publisher
+     */
+    public SharedHistogramReader(final File file) throws IOException {
+        this(mapFile(file));
+    }
+
+    /**
+     * Construct a reader of histograms published into the given region (from its current position)
+     *
+     * @param region The region to read from
+     * @throws IllegalArgumentException if the region is not laid out by a publisher
+     */
+    public SharedHistogramReader(final ByteBuffer region) {
+        final ByteBuffer regionView = region.slice().order(ByteOrder.nativeOrder());
+        if ((regionView.remaining() < COUNTS_OFFSET) || (regionView.getLong(COOKIE_OFFSET) != COOKIE)) {
+            throw new IllegalArgumentException("The region does not contain a published histogram");
+        }
+        this.region = regionView;
+        // The configuration of a region does not change once it has been laid out:
+        lowestDiscernibleValue = regionView.getLong(LOWEST_DISCERNIBLE_VALUE_OFFSET);
+        highestTrackableValue = regionView.getLong(HIGHEST_TRACKABLE_VALUE_OFFSET);
+        numberOfSignificantValueDigits = (int) regionView.getLong(NUMBER_OF_SIGNIFICANT_VALUE_DIGITS_OFFSET);
+        countsLength = (int) regionView.getLong(COUNTS_LENGTH_OFFSET);
+        if (regionView.remaining() < COUNTS_OFFSET + ((long) countsLength << 3)) {
+            throw new IllegalArgumentException("The region is too small for its indicated counts length");
+        }
+    }
+
+    private static ByteBuffer mapFile(final File file) throws IOException {
+        try (RandomAccessFile randomAccessFile = new RandomAccessFile(file, "r")) {
+            // The mapping remains valid after the file is closed:
+            return randomAccessFile.getChannel().map(FileChannel.MapMode.READ_ONLY, 0, randomAccessFile.length());
+        }
+    }
+
+    /**
+     * Get the sequence number of the latest complete publication. Can be used to poll for new publications.
+     *
+     * @return the sequence number of the latest complete publication (always even)
+     */
+    public long getPublishedSequence() {
+        return region.getLong(SEQUENCE_OFFSET) & ~1L;
+    }
+
+    /**
+     * Read the latest published histogram into a newly allocated histogram
+     *
+     * @return a histogram containing the latest published histogram
+     */
+    public Histogram getHistogram() {
+        return getHistogram(null);
+    }
+
+    /**
+     * Read the latest published histogram, into a histogram to recycle if one is provided
+     *
+     * @param histogramToRecycle a previously returned histogram to reuse (may be null)
+     * @return a histogram containing the latest published histogram
+     * @throws IllegalArgumentException if the histogram to recycle is of a different configuration
+     */
+    public synchronized Histogram getHistogram(final Histogram histogramToRecycle) {
+        Histogram histogram = histogramToRecycle;
+        if (histogram == null) {
+            histogram = new Histogram(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+        } else if ((histogram.getLowestDiscernibleValue() != lowestDiscernibleValue) ||
+                (histogram.getNumberOfSignificantValueDigits() != numberOfSignificantValueDigits) ||
+                (histogram.countsArrayLength < countsLength)) {
+            throw new IllegalArgumentException("The histogram to recycle does not match the published configuration");
+        }
+        while (!tryRead(histogram)) {
+            Thread.yield();
+        }
+        return histogram;
+    }
+
+    // Read a publication into the histogram, and report if the read was consistent (did not overlap a publication):
+    private boolean tryRead(final Histogram histogram) {
+        final long sequenceAtStart = region.getLong(SEQUENCE_OFFSET);
+        if ((sequenceAtStart & 1) != 0) {
+            // A publication is in progress:
+            return false;
+        }
+        orderBufferAccesses(sequenceAtStart);
+
+        histogram.reset();
+        long observedTotalCount = 0;
+        int minNonZeroIndex = -1;
+        int maxIndex = -1;
+        for (int i = 0; i < countsLength; i++) {
+            final long count = region.getLong(COUNTS_OFFSET + (i << 3));
+            if (count != 0) {
+                histogram.setCountAtIndex(i, count);
+                observedTotalCount += count;
+                maxIndex = i;
+                if ((minNonZeroIndex < 0) && (i != 0)) {
+                    minNonZeroIndex = i;
+                }
+            }
+        }
+        final long startTimeStamp = region.getLong(START_TIMESTAMP_OFFSET);
+        final long endTimeStamp = region.getLong(END_TIMESTAMP_OFFSET);
+        // Establish the tracking values even for reads that will be retried, such that the retry's reset
+        // covers all of the counts set by this read:
+        histogram.establishInternalTackingValues(observedTotalCount, minNonZeroIndex, maxIndex);
+
+        orderBufferAccesses(sequenceAtStart);
+        if (region.getLong(SEQUENCE_OFFSET) != sequenceAtStart) {
+            return false;
+        }
+        histogram.setStartTimeStamp(startTimeStamp);
+        histogram.setEndTimeStamp(endTimeStamp);
+        return true;
+    }
+
+    // A volatile store followed by a volatile load, keeping buffer accesses from being reordered across it:
+    private void orderBufferAccesses(final long sequence) {
+        fence = sequence;
+        if (fence != sequence) {
+            throw new IllegalStateException("Reads must be made under the reader's lock");
+        }
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.util.zip.Inflater;
+
+/**
+ * A reusable {@link Inflater}, shared by all histograms decoded on the same thread (see {@link #get()}), such that
+ * decoding from compressed form (e.g. in {@link AbstractHistogram#addFromCompressedByteBuffer}) neither allocates
+ * a per-decoding {@link Inflater}, nor keeps an {@link Inflater} (and its native state) alive per histogram.
+ * The counterpart of {@link SharedDeflater}.
+ * <p>
+ * The shared inflater supports a single decoding in progress at a time, and must not be ended.
+ */
+class SharedInflater {
+    private static final ThreadLocal<Inflater> threadLocalInflater =
+            new ThreadLocal<Inflater>() {
+                @Override
+                protected Inflater initialValue() {
+                    return new Inflater();
+                }
+            };
+
+    private SharedInflater() {
+    }
+
+    /**
+     * Get the current thread's shared {@link Inflater}, reset and ready for new input
+     * @return the current thread's shared {@link Inflater}
+     */
+    static Inflater get() {
+        final Inflater inflater = threadLocalInflater.get();
+        inflater.reset();
+        return inflater;
+    }
+}
@@ -7,6 +7,7 @@
 
 package org.HdrHistogram;
 
+import java.nio.DoubleBuffer;
 import java.util.concurrent.atomic.AtomicLong;
 
 /**
@@ -47,6 +48,8 @@ public class SingleWriterDoubleRecorder implements DoubleValueRecorder, Interval
     private volatile DoubleHistogram activeHistogram;
     private DoubleHistogram inactiveHistogram;
 
+    private final IntervalHistogramPool<DoubleHistogram> intervalHistogramPool = new IntervalHistogramPool<>();
+
     /**
      * Construct an auto-resizing {@link SingleWriterDoubleRecorder} using a precision stated as a
      * number of significant decimal digits.
@@ -156,6 +159,43 @@ public class SingleWriterDoubleRecorder implements DoubleValueRecorder, Interval
         }
     }
 
+    /**
+     * Record a batch of values in the histogram. Equivalent to recording each of the values with
+     * {@link #recordValue(double)}, but with a single recording critical section for the whole batch.
+     *
+     * @param values The array containing the values to be recorded
+     * @param offset The offset in the array of the first value to be recorded
+     * @param length The number of values to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValues(final double[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+        try {
+            activeHistogram.recordValues(values, offset, length);
+        } finally {
+            recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+        }
+    }
+
+    /**
+     * Record a batch of values in the histogram, consisting of the values remaining in a buffer. Equivalent to
+     * {@link #recordValues(double[], int, int)}. The buffer's position is advanced to its limit.
+     *
+     * @param values The buffer containing the values to be recorded (from its position to its limit)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValues(final DoubleBuffer values) throws ArrayIndexOutOfBoundsException {
+        long criticalValueAtEnter = recordingPhaser.writerCriticalSectionEnter();
+        try {
+            activeHistogram.recordValues(values);
+        } finally {
+            recordingPhaser.writerCriticalSectionExit(criticalValueAtEnter);
+        }
+    }
+
     @Override
     public synchronized DoubleHistogram getIntervalHistogram() {
         return getIntervalHistogram(null);
@@ -171,6 +211,9 @@ public class SingleWriterDoubleRecorder implements DoubleValueRecorder, Interval
                                                              boolean enforceContainingInstance) {
         // Verify that replacement histogram can validly be used as an inactive histogram replacement:
         validateFitAsReplacementHistogram(histogramToRecycle, enforceContainingInstance);
+        if (histogramToRecycle == null) {
+            histogramToRecycle = intervalHistogramPool.take();
+        }
         inactiveHistogram = histogramToRecycle;
         performIntervalSample();
         DoubleHistogram sampledHistogram = inactiveHistogram;
@@ -184,6 +227,46 @@ public class SingleWriterDoubleRecorder implements DoubleValueRecorder, Interval
         inactiveHistogram.copyInto(targetHistogram);
     }
 
+    /**
+     * Release an interval histogram previously obtained from this SingleWriterDoubleRecorder (via {@link #getIntervalHistogram()} or one
+     * of its recycling variants) back into this SingleWriterDoubleRecorder's bounded pool of interval histograms. Pooled interval
+     * histograms are used by subsequent getIntervalHistogram() calls that are not provided with a histogram to recycle, such
+     * that steady-state interval sampling with explicit releases does not allocate.
+     * <p>
+     * NOTE: The caller must not access a released interval histogram after releasing it. Releasing the same
+     * interval histogram instance more than once (without obtaining it again) is disallowed.
+     *
+     * @param intervalHistogram a previously returned interval histogram (from this instance of {@link SingleWriterDoubleRecorder}).
+     * @return true if the interval histogram was pooled, false if it was dropped because the pool is full
+     * (or the provided interval histogram is null)
+     * @throws IllegalArgumentException if the interval histogram was not obtained from this instance, or if it
+     * has already been released
+     */
+    public synchronized boolean releaseIntervalHistogram(final DoubleHistogram intervalHistogram) {
+        if (intervalHistogram == null) {
+            return false;
+        }
+        validateFitAsReplacementHistogram(intervalHistogram, true);
+        return intervalHistogramPool.release(intervalHistogram);
+    }
+
+    /**
+     * Get the capacity of this SingleWriterDoubleRecorder's pool of released interval histograms.
+     * @return the interval histogram pool capacity
+     */
+    public synchronized int getIntervalHistogramPoolCapacity() {
+        return intervalHistogramPool.getCapacity();
+    }
+
+    /**
+     * Set the capacity of this SingleWriterDoubleRecorder's pool of released interval histograms (see
+     * {@link #releaseIntervalHistogram}). Pooled interval histograms beyond the new capacity are dropped.
+     * @param capacity the interval histogram pool capacity. Must be non-negative.
+     */
+    public synchronized void setIntervalHistogramPoolCapacity(final int capacity) {
+        intervalHistogramPool.setCapacity(capacity);
+    }
+
     /**
      * Reset any value counts accumulated thus far.
      */
@@ -0,0 +1,324 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.LongBuffer;
+
+/**
+ * Records integer values into a sliding window made of a ring of slot histograms, and maintains a histogram
+ * of the values recorded in the window (e.g. "the values recorded over the last 60 seconds, in 1 second slots").
+ * <p>
+ * The window consists of the current slot, into which values are recorded, and the previous
+ * (slot count - 1) slots. Each call to {@link #advance()} starts a new current slot, expiring the oldest one.
+ * <p>
+ * The window histogram is maintained incrementally: values are recorded into both the current slot and the window
+ * histogram, and expiring a slot only touches the counts within the slot's (lowest to highest recorded value)
+ * range, rather than adding up or subtracting whole histograms. The window histogram keeps a cumulative count
+ * index (see {@link AbstractHistogram#setCumulativeCountIndexEnabled}), such that repeated percentile queries made
+ * between modifications of the window are cheap.
+ * <p>
+ * {@link SlidingWindowHistogram} is not thread safe. Use {@link SlidingWindowRecorder} for recording values from
+ * multiple threads.
+ * <p>
+ * A common pattern for using a {@link SlidingWindowHistogram} looks like this:
+ * <br><pre><code>
+ * SlidingWindowHistogram slidingWindow = new SlidingWindowHistogram(60, 3600000000L, 3); // 60 slots
+ * ...
+ * [every second:]
+ *   double p99OverTheLastMinute = slidingWindow.getWindowHistogram().getValueAtPercentile(99.0);
+ *   slidingWindow.advance();
+ * </code></pre>
+ */
+
+public class SlidingWindowHistogram implements ValueRecorder {
+    private final Histogram[] slots;
+    private final Histogram windowHistogram;
+    private int currentSlotIndex = 0;
+
+    /**
+     * Construct an auto-resizing {@link SlidingWindowHistogram} with a lowest discernible value of 1 and an
+     * auto-adjusting highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
+     *
+     * @param slotCount The number of slots in the window (including the current slot)
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public SlidingWindowHistogram(final int slotCount, final int numberOfSignificantValueDigits) {
+        this(slotCount, 1, 2, numberOfSignificantValueDigits);
+        windowHistogram.setAutoResize(true);
+        for (Histogram slot : slots) {
+            slot.setAutoResize(true);
+        }
+    }
+
+    /**
+     * Construct a {@link SlidingWindowHistogram} given the highest value to be tracked and a number of significant
+     * decimal digits. The histograms will be constructed to implicitly track (distinguish from 0) values as low as 1.
+     *
+     * @param slotCount The number of slots in the window (including the current slot)
+     * @param highestTrackableValue The highest value to be tracked by the histograms. Must be a positive
+     *                              integer that is {@literal >=} 2.
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public SlidingWindowHistogram(final int slotCount, final long highestTrackableValue,
+                                  final int numberOfSignificantValueDigits) {
+        this(slotCount, 1, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a {@link SlidingWindowHistogram} given the Lowest and highest values to be tracked and a number
+     * of significant decimal digits.
+     *
+     * @param slotCount The number of slots in the window (including the current slot)
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histograms.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histograms. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public SlidingWindowHistogram(final int slotCount,
+                                  final long lowestDiscernibleValue,
+                                  final long highestTrackableValue,
+                                  final int numberOfSignificantValueDigits) {
+        if (slotCount < 1) {
+            throw new IllegalArgumentException("slotCount must be >= 1");
+        }
+        windowHistogram = new Histogram(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+        windowHistogram.setCumulativeCountIndexEnabled(true);
+        slots = new Histogram[slotCount];
+        for (int i = 0; i < slotCount; i++) {
+            slots[i] = new Histogram(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+        }
+        final long now = System.currentTimeMillis();
+        windowHistogram.setStartTimeStamp(now);
+        slots[currentSlotIndex].setStartTimeStamp(now);
+    }
+
+    /**
+     * Get the number of slots in the window (including the current slot)
+     * @return the number of slots in the window
+     */
+    public int getSlotCount() {
+        return slots.length;
+    }
+
+    /**
+     * Get the histogram of all values recorded in the window. The returned histogram is live (it reflects
+     * subsequent recordings and advances of the window) and must not be modified. Use
+     * {@link AbstractHistogram#copy()} to retain a stable copy of it.
+     *
+     * @return the histogram of all values recorded in the window
+     */
+    public Histogram getWindowHistogram() {
+        return windowHistogram;
+    }
+
+    /**
+     * Get the histogram of the values recorded in the current slot. The returned histogram is live, and must
+     * not be modified.
+     *
+     * @return the histogram of the values recorded in the current slot
+     */
+    public Histogram getCurrentSlotHistogram() {
+        return slots[currentSlotIndex];
+    }
+
+    /**
+     * Start a new current slot, expiring the oldest slot in the window (and removing its values from
+     * the window histogram).
+     */
+    public void advance() {
+        final long now = System.currentTimeMillis();
+        slots[currentSlotIndex].setEndTimeStamp(now);
+        currentSlotIndex = (currentSlotIndex + 1) % slots.length;
+        expireSlot(slots[currentSlotIndex]);
+        slots[currentSlotIndex].setStartTimeStamp(now);
+        // The window now starts where its oldest remaining slot does:
+        long windowStartTimeStamp = now;
+        for (Histogram slot : slots) {
+            windowStartTimeStamp = Math.min(windowStartTimeStamp, slot.getStartTimeStamp());
+        }
+        windowHistogram.setStartTimeStamp(windowStartTimeStamp);
+    }
+
+    /**
+     * Add the contents of the given histogram (e.g. an interval histogram obtained from a {@link Recorder}) to
+     * the current slot (and to the window). Only the counts within the other histogram's (lowest to highest
+     * recorded value) range are visited.
+     *
+     * @param otherHistogram The histogram to add. Must have the same lowest discernible value and number of
+     *                       significant value digits as this sliding window's histograms.
+     * @throws ArrayIndexOutOfBoundsException (may throw) if values in otherHistogram cannot be covered by the
+     * window's range
+     */
+    public void add(final AbstractHistogram otherHistogram) throws ArrayIndexOutOfBoundsException {
+        if ((otherHistogram.getLowestDiscernibleValue() != windowHistogram.getLowestDiscernibleValue()) ||
+                (otherHistogram.getNumberOfSignificantValueDigits() !=
+                        windowHistogram.getNumberOfSignificantValueDigits())) {
+            throw new IllegalArgumentException("The other histogram's lowestDiscernibleValue and " +
+                    "numberOfSignificantValueDigits must match those of the sliding window");
+        }
+        if (otherHistogram.getTotalCount() == 0) {
+            return;
+        }
+        final Histogram currentSlot = slots[currentSlotIndex];
+        final int fromIndex = otherHistogram.countsArrayIndex(otherHistogram.getMinValue());
+        final int toIndex = otherHistogram.countsArrayIndex(otherHistogram.getMaxValue());
+        for (int i = fromIndex; i <= toIndex; i++) {
+            final long count = otherHistogram.getCountAtIndex(i);
+            if (count > 0) {
+                final long value = otherHistogram.valueFromIndex(i);
+                currentSlot.recordValueWithCount(value, count);
+                windowHistogram.recordValueWithCount(value, count);
+            }
+        }
+    }
+
+    private void expireSlot(final Histogram slot) {
+        final long slotTotalCount = slot.getTotalCount();
+        if (slotTotalCount != 0) {
+            // Remove the slot's counts from the window, visiting only the slot's non-zero range:
+            final int fromIndex = slot.countsArrayIndex(slot.getMinValue());
+            final int toIndex = slot.countsArrayIndex(slot.getMaxValue());
+            for (int i = fromIndex; i <= toIndex; i++) {
+                final long count = slot.getCountAtIndex(i);
+                if (count != 0) {
+                    windowHistogram.addToCountAtIndex(i, -count);
+                    slot.setCountAtIndex(i, 0);
+                }
+            }
+            establishWindowTrackingValues(windowHistogram.getTotalCount() - slotTotalCount);
+        }
+        slot.establishInternalTackingValues(0, -1, -1);
+        slot.setStartTimeStamp(Long.MAX_VALUE);
+        slot.setEndTimeStamp(0);
+    }
+
+    private void establishWindowTrackingValues(final long windowTotalCount) {
+        windowHistogram.cumulativeCountIndexIsValid = false;
+        if (windowTotalCount == 0) {
+            windowHistogram.establishInternalTackingValues(0, -1, -1);
+            return;
+        }
+        // The window's min and max can only have moved inwards. Scan inwards from the previous ones until
+        // counts are found, rather than scanning the whole counts array:
+        int maxIndex = windowHistogram.countsArrayIndex(windowHistogram.getMaxValue());
+        while ((maxIndex > 0) && (windowHistogram.getCountAtIndex(maxIndex) == 0)) {
+            maxIndex--;
+        }
+        int minNonZeroIndex = -1;
+        if (windowHistogram.getMinNonZeroValue() != Long.MAX_VALUE) {
+            minNonZeroIndex = Math.max(windowHistogram.countsArrayIndex(windowHistogram.getMinNonZeroValue()), 1);
+            while ((minNonZeroIndex <= maxIndex) && (windowHistogram.getCountAtIndex(minNonZeroIndex) == 0)) {
+                minNonZeroIndex++;
+            }
+            if (minNonZeroIndex > maxIndex) {
+                // Only zero values remain in the window:
+                minNonZeroIndex = -1;
+            }
+        }
+        windowHistogram.establishInternalTackingValues(windowTotalCount, minNonZeroIndex, maxIndex);
+    }
+
+    /**
+     * Record a value in the current slot
+     *
+     * @param value The value to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if value is exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValue(final long value) throws ArrayIndexOutOfBoundsException {
+        slots[currentSlotIndex].recordValue(value);
+        windowHistogram.recordValue(value);
+    }
+
+    /**
+     * Record a value in the current slot (adding to the value's current count)
+     *
+     * @param value The value to be recorded
+     * @param count The number of occurrences of this value to record
+     * @throws ArrayIndexOutOfBoundsException (may throw) if value is exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValueWithCount(final long value, final long count) throws ArrayIndexOutOfBoundsException {
+        slots[currentSlotIndex].recordValueWithCount(value, count);
+        windowHistogram.recordValueWithCount(value, count);
+    }
+
+    /**
+     * Record a value in the current slot
+     * <p>
+     * To compensate for the loss of sampled values when a recorded value is larger than the expected
+     * interval between value samples, will auto-generate an additional series of decreasingly-smaller
+     * (down to the expectedIntervalBetweenValueSamples) value records.
+     * <p>
+     * See related notes {@link AbstractHistogram#recordValueWithExpectedInterval(long, long)}
+     * for more explanations about coordinated omission and expected interval correction.
+     *
+     * @param value The value to record
+     * @param expectedIntervalBetweenValueSamples If expectedIntervalBetweenValueSamples is larger than 0, add
+     *                                           auto-generated value records as appropriate if value is larger
+     *                                           than expectedIntervalBetweenValueSamples
+     * @throws ArrayIndexOutOfBoundsException (may throw) if value is exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValueWithExpectedInterval(final long value, final long expectedIntervalBetweenValueSamples)
+            throws ArrayIndexOutOfBoundsException {
+        slots[currentSlotIndex].recordValueWithExpectedInterval(value, expectedIntervalBetweenValueSamples);
+        windowHistogram.recordValueWithExpectedInterval(value, expectedIntervalBetweenValueSamples);
+    }
+
+    /**
+     * Record a batch of values in the current slot. Equivalent to recording each of the values with
+     * {@link #recordValue(long)}.
+     *
+     * @param values The array containing the values to be recorded
+     * @param offset The offset in the array of the first value to be recorded
+     * @param length The number of values to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValues(final long[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        slots[currentSlotIndex].recordValues(values, offset, length);
+        windowHistogram.recordValues(values, offset, length);
+    }
+
+    /**
+     * Record a batch of values in the current slot, consisting of the values remaining in a buffer. Equivalent
+     * to {@link #recordValues(long[], int, int)}. The buffer's position is advanced to its limit.
+     *
+     * @param values The buffer containing the values to be recorded (from its position to its limit)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value exceeds highestTrackableValue
+     */
+    @Override
+    public void recordValues(final LongBuffer values) throws ArrayIndexOutOfBoundsException {
+        slots[currentSlotIndex].recordValues(values.duplicate());
+        windowHistogram.recordValues(values);
+    }
+
+    /**
+     * Reset the contents of all slots, and of the window
+     */
+    @Override
+    public void reset() {
+        for (Histogram slot : slots) {
+            slot.reset();
+        }
+        windowHistogram.reset();
+        final long now = System.currentTimeMillis();
+        windowHistogram.setStartTimeStamp(now);
+        slots[currentSlotIndex].setStartTimeStamp(now);
+    }
+}
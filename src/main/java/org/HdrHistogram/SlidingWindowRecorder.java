@@ -0,0 +1,203 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.nio.LongBuffer;
+
+/**
+ * Records integer values from multiple concurrent threads, and maintains a sliding window histogram of the values
+ * recorded over the last (slot count) intervals, e.g. "the values recorded over the last 60 seconds, updated every
+ * second".
+ * <p>
+ * Values are recorded into a {@link Recorder}. Each call to {@link #advance()} takes the recorder's interval
+ * histogram and adds it as the newest slot of a {@link SlidingWindowHistogram}, expiring the oldest slot. The
+ * sliding window histogram holds one additional (always empty) current slot, such that the window covers (slot
+ * count) completed intervals, with each slot stamped with its own interval's start and end times. Window
+ * queries reflect all values recorded in the last (slot count) completed intervals, and do not include values
+ * recorded since the last call to {@link #advance()}.
+ * <p>
+ * Recording calls are wait-free on architectures that support atomic increment operations, and
+ * are lock-free on architectures that do not.
+ * <p>
+ * A common pattern for using a {@link SlidingWindowRecorder} looks like this:
+ * <br><pre><code>
+ * SlidingWindowRecorder recorder = new SlidingWindowRecorder(60, 3600000000L, 3); // 60 slots
+ * Histogram windowHistogram = null;
+ * ...
+ * [every second:]
+ *   recorder.advance();
+ *   double p99OverTheLastMinute = recorder.getValueAtPercentile(99.0);
+ *   // Or, to examine the window in more detail, recycling the previously obtained copy:
+ *   windowHistogram = recorder.getWindowHistogram(windowHistogram);
+ * </code></pre>
+ */
+
+public class SlidingWindowRecorder implements ValueRecorder {
+    private final Recorder recorder;
+    private final SlidingWindowHistogram slidingWindowHistogram;
+    private Histogram intervalHistogram;
+
+    /**
+     * Construct an auto-resizing {@link SlidingWindowRecorder} with a lowest discernible value of 1 and an
+     * auto-adjusting highestTrackableValue. Can auto-resize up to track values up to (Long.MAX_VALUE / 2).
+     *
+     * @param slotCount The number of intervals (slots) in the window
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public SlidingWindowRecorder(final int slotCount, final int numberOfSignificantValueDigits) {
+        recorder = new Recorder(numberOfSignificantValueDigits);
+        slidingWindowHistogram = new SlidingWindowHistogram(windowSlotCount(slotCount),
+                numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a {@link SlidingWindowRecorder} given the highest value to be tracked and a number of significant
+     * decimal digits. The histograms will be constructed to implicitly track (distinguish from 0) values as low as 1.
+     *
+     * @param slotCount The number of intervals (slots) in the window
+     * @param highestTrackableValue The highest value to be tracked by the histograms. Must be a positive
+     *                              integer that is {@literal >=} 2.
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public SlidingWindowRecorder(final int slotCount, final long highestTrackableValue,
+                                 final int numberOfSignificantValueDigits) {
+        this(slotCount, 1, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a {@link SlidingWindowRecorder} given the Lowest and highest values to be tracked and a number
+     * of significant decimal digits.
+     *
+     * @param slotCount The number of intervals (slots) in the window
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histograms.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histograms. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public SlidingWindowRecorder(final int slotCount,
+                                 final long lowestDiscernibleValue,
+                                 final long highestTrackableValue,
+                                 final int numberOfSignificantValueDigits) {
+        recorder = new Recorder(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+        slidingWindowHistogram = new SlidingWindowHistogram(windowSlotCount(slotCount),
+                lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Get the number of intervals (slots) in the window
+     * @return the number of slots in the window
+     */
+    public int getSlotCount() {
+        return slidingWindowHistogram.getSlotCount() - 1;
+    }
+
+    private static int windowSlotCount(final int slotCount) {
+        if (slotCount < 1) {
+            throw new IllegalArgumentException("slotCount must be >= 1");
+        }
+        // Completed intervals are added to the sliding window's current slot, which is then closed by advancing:
+        return slotCount + 1;
+    }
+
+    /**
+     * Complete the current interval: add the values recorded since the previous call as the newest slot of
+     * the window, expiring the oldest slot.
+     */
+    public synchronized void advance() {
+        intervalHistogram = recorder.getIntervalHistogram(intervalHistogram);
+        // Add the interval to the slot being closed, so that it carries the interval's own start time:
+        slidingWindowHistogram.add(intervalHistogram);
+        slidingWindowHistogram.getCurrentSlotHistogram().setStartTimeStamp(intervalHistogram.getStartTimeStamp());
+        slidingWindowHistogram.advance();
+    }
+
+    /**
+     * Get the value at a given percentile of the values in the window.
+     * See {@link AbstractHistogram#getValueAtPercentile(double)}.
+     *
+     * @param percentile  The percentile for which to return the associated value
+     * @return The value that the given percentage of the window's values fall at or below
+     */
+    public synchronized long getValueAtPercentile(final double percentile) {
+        return slidingWindowHistogram.getWindowHistogram().getValueAtPercentile(percentile);
+    }
+
+    /**
+     * Get the total count of values in the window
+     * @return the total count of values in the window
+     */
+    public synchronized long getTotalCount() {
+        return slidingWindowHistogram.getWindowHistogram().getTotalCount();
+    }
+
+    /**
+     * Get a copy of the window histogram, into a newly allocated histogram
+     * @return a copy of the window histogram
+     */
+    public synchronized Histogram getWindowHistogram() {
+        return slidingWindowHistogram.getWindowHistogram().copy();
+    }
+
+    /**
+     * Get a copy of the window histogram, copied into a histogram to recycle if one is provided
+     *
+     * @param histogramToRecycle a previously returned histogram to copy the window into (may be null)
+     * @return a copy of the window histogram
+     */
+    public synchronized Histogram getWindowHistogram(final Histogram histogramToRecycle) {
+        if (histogramToRecycle == null) {
+            return getWindowHistogram();
+        }
+        slidingWindowHistogram.getWindowHistogram().copyInto(histogramToRecycle);
+        return histogramToRecycle;
+    }
+
+    @Override
+    public void recordValue(final long value) throws ArrayIndexOutOfBoundsException {
+        recorder.recordValue(value);
+    }
+
+    @Override
+    public void recordValueWithCount(final long value, final long count) throws ArrayIndexOutOfBoundsException {
+        recorder.recordValueWithCount(value, count);
+    }
+
+    @Override
+    public void recordValueWithExpectedInterval(final long value, final long expectedIntervalBetweenValueSamples)
+            throws ArrayIndexOutOfBoundsException {
+        recorder.recordValueWithExpectedInterval(value, expectedIntervalBetweenValueSamples);
+    }
+
+    @Override
+    public void recordValues(final long[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        recorder.recordValues(values, offset, length);
+    }
+
+    @Override
+    public void recordValues(final LongBuffer values) throws ArrayIndexOutOfBoundsException {
+        recorder.recordValues(values);
+    }
+
+    /**
+     * Reset the contents of the window, and any values recorded since the last call to {@link #advance()}
+     */
+    @Override
+    public synchronized void reset() {
+        recorder.reset();
+        slidingWindowHistogram.reset();
+    }
+}
@@ -0,0 +1,383 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+import java.io.IOException;
+import java.io.ObjectInputStream;
+import java.nio.ByteBuffer;
+import java.util.concurrent.atomic.AtomicLongArray;
+import java.util.zip.DataFormatException;
+
+/**
+ * <h3>A High Dynamic Range (HDR) Histogram that stripes its counts across recording threads</h3>
+ * A StripedConcurrentHistogram guarantees lossless recording of values into the histogram even when the
+ * histogram is updated by multiple threads, and is intended for write-heavy recording on many-core systems.
+ * <p>
+ * Where an {@link AtomicHistogram} has all recording threads atomically updating a single shared counts
+ * array and a single shared total count, a StripedConcurrentHistogram maintains a number of independent
+ * count stripes (each a full counts array, along with its own total count), and each recording thread
+ * records into the stripe selected by its thread id. This avoids having the counts of commonly recorded
+ * values, and the total count, be contended cache lines shared by all recording threads. Recording remains
+ * wait-free (on architectures that support atomic increment operations).
+ * <p>
+ * Queries, iterations, copies and additions see the sum of all stripes, and are correspondingly more
+ * expensive than those of an {@link AtomicHistogram}. The stripes are therefore best merged once into a
+ * non-striped histogram, e.g. by using {@link #copyInto} or {@link Histogram#add} into a {@link Histogram},
+ * before being queried repeatedly. A {@link Recorder} constructed with a stripe count does exactly this,
+ * merging the stripes of its internal StripedConcurrentHistogram only when an interval histogram is taken.
+ * <p>
+ * Note that the memory footprint of a StripedConcurrentHistogram is that of {@link #getStripeCount()}
+ * {@link AtomicHistogram}s covering the same range.
+ * <p>
+ * Like {@link AtomicHistogram}, lossless recording is the only thread-safe behavior provided by
+ * StripedConcurrentHistogram: it does not support auto-resizing, does not support value shift operations,
+ * and provides no implicit synchronization that would prevent the contents of the histogram from changing
+ * during iterations, copies, or addition operations on the histogram. Callers wishing to make potentially
+ * concurrent, multi-threaded updates that would safely work in the presence of queries, copies, or
+ * additions of histogram objects should use the {@link Recorder} class, which is intended for this purpose.
+ * <p>
+ * See package description for {@link org.HdrHistogram} for details.
+ */
+
+public class StripedConcurrentHistogram extends Histogram {
+
+    static final int MAX_DEFAULT_STRIPE_COUNT = 16;
+
+    // Spacing (in longs) between stripe total counts, to keep them on separate cache lines:
+    private static final int TOTAL_COUNT_STRIDE = 16;
+
+    final int stripeCount;
+    private final int stripeMask;
+    final AtomicLongArray[] stripes;
+    private final AtomicLongArray stripeTotalCounts;
+
+    private int stripeIndexForCurrentThread() {
+        return ((int) Thread.currentThread().getId()) & stripeMask;
+    }
+
+    @Override
+    long getCountAtIndex(final int index) {
+        long count = 0;
+        for (AtomicLongArray stripe : stripes) {
+            count += stripe.get(index);
+        }
+        return count;
+    }
+
+    @Override
+    long getCountAtNormalizedIndex(final int index) {
+        return getCountAtIndex(index);
+    }
+
+    @Override
+    void incrementCountAtIndex(final int index) {
+        stripes[stripeIndexForCurrentThread()].getAndIncrement(index);
+    }
+
+    @Override
+    int incrementCountsAtValues(final long[] values, final int offset, final int length) {
+        final AtomicLongArray stripe = stripes[stripeIndexForCurrentThread()];
+        for (int i = 0; i < length; i++) {
+            final long value = values[offset + i];
+            if (value < 0) {
+                return i;
+            }
+            final int index = countsArrayIndex(value);
+            if (index >= stripe.length()) {
+                return i;
+            }
+            stripe.getAndIncrement(index);
+        }
+        return length;
+    }
+
+    @Override
+    void addToCountAtIndex(final int index, final long value) {
+        stripes[stripeIndexForCurrentThread()].getAndAdd(index, value);
+    }
+
+    @Override
+    void setCountAtIndex(int index, long value) {
+        stripes[0].lazySet(index, value);
+        for (int i = 1; i < stripeCount; i++) {
+            stripes[i].lazySet(index, 0);
+        }
+    }
+
+    @Override
+    void setCountAtNormalizedIndex(int index, long value) {
+        setCountAtIndex(index, value);
+    }
+
+    @Override
+    int getNormalizingIndexOffset() {
+        return 0;
+    }
+
+    @Override
+    void setNormalizingIndexOffset(int normalizingIndexOffset) {
+        if (normalizingIndexOffset != 0) {
+            throw new IllegalStateException(
+                    "StripedConcurrentHistogram does not support non-zero normalizing index settings." +
+                            " Use ConcurrentHistogram Instead.");
+        }
+    }
+
+    @Override
+    void shiftNormalizingIndexByOffset(int offsetToAdd,
+                                       boolean lowestHalfBucketPopulated,
+                                       double newIntegerToDoubleValueConversionRatio) {
+        throw new IllegalStateException(
+                "StripedConcurrentHistogram does not support Shifting operations." +
+                        " Use ConcurrentHistogram Instead.");
+    }
+
+    @Override
+    void resize(long newHighestTrackableValue) {
+        throw new IllegalStateException(
+                "StripedConcurrentHistogram does not support resizing operations." +
+                        " Use ConcurrentHistogram Instead.");
+    }
+
+    @Override
+    public void setAutoResize(boolean autoResize) {
+        throw new IllegalStateException(
+                "StripedConcurrentHistogram does not support AutoResize operation." +
+                        " Use ConcurrentHistogram Instead.");
+    }
+
+    @Override
+    public boolean supportsAutoResize() { return false; }
+
+    @Override
+    void clearCounts() {
+        for (AtomicLongArray stripe : stripes) {
+            for (int i = 0; i < stripe.length(); i++) {
+                stripe.lazySet(i, 0);
+            }
+        }
+        for (int i = 0; i < stripeCount; i++) {
+            stripeTotalCounts.set(i * TOTAL_COUNT_STRIDE, 0);
+        }
+    }
+
+    @Override
+    public StripedConcurrentHistogram copy() {
+        StripedConcurrentHistogram copy = new StripedConcurrentHistogram(this);
+        copy.add(this);
+        return copy;
+    }
+
+    @Override
+    public StripedConcurrentHistogram copyCorrectedForCoordinatedOmission(
+            final long expectedIntervalBetweenValueSamples) {
+        StripedConcurrentHistogram toHistogram = new StripedConcurrentHistogram(this);
+        toHistogram.addWhileCorrectingForCoordinatedOmission(this, expectedIntervalBetweenValueSamples);
+        return toHistogram;
+    }
+
+    @Override
+    public long getTotalCount() {
+        long totalCount = 0;
+        for (int i = 0; i < stripeCount; i++) {
+            totalCount += stripeTotalCounts.get(i * TOTAL_COUNT_STRIDE);
+        }
+        return totalCount;
+    }
+
+    @Override
+    void setTotalCount(final long totalCount) {
+        if (stripeTotalCounts == null) {
+            // Called by AbstractHistogram deserialization, before the (serialized) stripe totals are restored.
+            return;
+        }
+        stripeTotalCounts.set(0, totalCount);
+        for (int i = 1; i < stripeCount; i++) {
+            stripeTotalCounts.set(i * TOTAL_COUNT_STRIDE, 0);
+        }
+    }
+
+    @Override
+    void incrementTotalCount() {
+        stripeTotalCounts.incrementAndGet(stripeIndexForCurrentThread() * TOTAL_COUNT_STRIDE);
+    }
+
+    @Override
+    void addToTotalCount(final long value) {
+        stripeTotalCounts.addAndGet(stripeIndexForCurrentThread() * TOTAL_COUNT_STRIDE, value);
+    }
+
+    @Override
+    int _getEstimatedFootprintInBytes() {
+        return (512 + (8 * stripeCount * (countsArrayLength + TOTAL_COUNT_STRIDE)));
+    }
+
+    /**
+     * Get the number of count stripes used by this histogram.
+     * @return the number of count stripes
+     */
+    public int getStripeCount() {
+        return stripeCount;
+    }
+
+    /**
+     * Construct a StripedConcurrentHistogram given the Highest value to be tracked and a number of significant
+     * decimal digits. The histogram will be constructed to implicitly track (distinguish from 0) values as low
+     * as 1, and will use a default number of stripes (the number of available processors, rounded up to the
+     * nearest power of 2, and capped at 16).
+     *
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} 2.
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public StripedConcurrentHistogram(final long highestTrackableValue, final int numberOfSignificantValueDigits) {
+        this(1, highestTrackableValue, numberOfSignificantValueDigits);
+    }
+
+    /**
+     * Construct a StripedConcurrentHistogram given the Lowest and Highest values to be tracked and a number of
+     * significant decimal digits, using a default number of stripes (the number of available processors,
+     * rounded up to the nearest power of 2, and capped at 16).
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     */
+    public StripedConcurrentHistogram(final long lowestDiscernibleValue, final long highestTrackableValue,
+                                      final int numberOfSignificantValueDigits) {
+        this(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits, defaultStripeCount());
+    }
+
+    /**
+     * Construct a StripedConcurrentHistogram given the Lowest and Highest values to be tracked, a number of
+     * significant decimal digits, and a number of stripes.
+     *
+     * @param lowestDiscernibleValue The lowest value that can be tracked (distinguished from 0) by the histogram.
+     *                               Must be a positive integer that is {@literal >=} 1. May be internally rounded
+     *                               down to nearest power of 2.
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} (2 * lowestDiscernibleValue).
+     * @param numberOfSignificantValueDigits Specifies the precision to use. This is the number of significant
+     *                                       decimal digits to which the histogram will maintain value resolution
+     *                                       and separation. Must be a non-negative integer between 0 and 5.
+     * @param stripeCount The number of count stripes to record into. Must be a positive integer. Will be
+     *                    rounded up to the nearest power of 2.
+     */
+    public StripedConcurrentHistogram(final long lowestDiscernibleValue, final long highestTrackableValue,
+                                      final int numberOfSignificantValueDigits, final int stripeCount) {
+        super(lowestDiscernibleValue, highestTrackableValue, numberOfSignificantValueDigits, false);
+        this.stripeCount = roundedUpStripeCount(stripeCount);
+        stripeMask = this.stripeCount - 1;
+        stripes = allocateStripes(this.stripeCount, countsArrayLength);
+        stripeTotalCounts = new AtomicLongArray(this.stripeCount * TOTAL_COUNT_STRIDE);
+        wordSizeInBytes = 8;
+    }
+
+    /**
+     * Construct a histogram with the same range settings as a given source histogram,
+     * duplicating the source's start/end timestamps (but NOT it's contents). If the source is a
+     * StripedConcurrentHistogram, its stripe count will be used. Otherwise a default number of
+     * stripes will be used.
+     * @param source The source histogram to duplicate
+     */
+    public StripedConcurrentHistogram(final AbstractHistogram source) {
+        this(source, (source instanceof StripedConcurrentHistogram) ?
+                ((StripedConcurrentHistogram) source).stripeCount : defaultStripeCount());
+    }
+
+    /**
+     * Construct a histogram with the same range settings as a given source histogram,
+     * duplicating the source's start/end timestamps (but NOT it's contents), and using
+     * the given number of stripes.
+     * @param source The source histogram to duplicate
+     * @param stripeCount The number of count stripes to record into. Must be a positive integer. Will be
+     *                    rounded up to the nearest power of 2.
+     */
+    public StripedConcurrentHistogram(final AbstractHistogram source, final int stripeCount) {
+        super(source, false);
+        this.stripeCount = roundedUpStripeCount(stripeCount);
+        stripeMask = this.stripeCount - 1;
+        stripes = allocateStripes(this.stripeCount, countsArrayLength);
+        stripeTotalCounts = new AtomicLongArray(this.stripeCount * TOTAL_COUNT_STRIDE);
+        wordSizeInBytes = 8;
+    }
+
+    static int defaultStripeCount() {
+        return Math.min(roundedUpStripeCount(Runtime.getRuntime().availableProcessors()), MAX_DEFAULT_STRIPE_COUNT);
+    }
+
+    private static int roundedUpStripeCount(final int stripeCount) {
+        if (stripeCount < 1) {
+            throw new IllegalArgumentException("stripeCount must be >= 1");
+        }
+        if (stripeCount > (1 << 30)) {
+            throw new IllegalArgumentException("stripeCount must be <= 2^30");
+        }
+        return (stripeCount == 1) ? 1 : Integer.highestOneBit(stripeCount - 1) << 1;
+    }
+
+    private static AtomicLongArray[] allocateStripes(final int stripeCount, final int length) {
+        AtomicLongArray[] stripes = new AtomicLongArray[stripeCount];
+        for (int i = 0; i < stripeCount; i++) {
+            stripes[i] = new AtomicLongArray(length);
+        }
+        return stripes;
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     */
+    public static StripedConcurrentHistogram decodeFromByteBuffer(final ByteBuffer buffer,
+                                                                  final long minBarForHighestTrackableValue) {
+        return decodeFromByteBuffer(buffer, StripedConcurrentHistogram.class, minBarForHighestTrackableValue);
+    }
+
+    /**
+     * Construct a new histogram by decoding it from a compressed form in a ByteBuffer.
+     * @param buffer The buffer to decode from
+     * @param minBarForHighestTrackableValue Force highestTrackableValue to be set at least this high
+     * @return The newly constructed histogram
+     * @throws DataFormatException on error parsing/decompressing the buffer
+     */
+    public static StripedConcurrentHistogram decodeFromCompressedByteBuffer(final ByteBuffer buffer,
+                                                                            final long minBarForHighestTrackableValue)
+            throws DataFormatException {
+        return decodeFromCompressedByteBuffer(buffer, StripedConcurrentHistogram.class,
+                minBarForHighestTrackableValue);
+    }
+
+    /**
+     * Construct a new StripedConcurrentHistogram by decoding it from a String containing a base64 encoded
+     * compressed histogram representation.
+     *
+     * @param base64CompressedHistogramString A string containing a base64 encoding of a compressed histogram
+     * @return A StripedConcurrentHistogram decoded from the string
+     * @throws DataFormatException on error parsing/decompressing the input
+     */
+    public static StripedConcurrentHistogram fromString(final String base64CompressedHistogramString)
+            throws DataFormatException {
+        return decodeFromCompressedByteBuffer(
+                ByteBuffer.wrap(Base64Helper.parseBase64Binary(base64CompressedHistogramString)),
+                0);
+    }
+
+    private void readObject(final ObjectInputStream o)
+            throws IOException, ClassNotFoundException {
+        o.defaultReadObject();
+    }
+}
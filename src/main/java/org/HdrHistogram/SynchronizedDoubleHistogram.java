@@ -9,6 +9,7 @@ package org.HdrHistogram;
 
 import java.io.PrintStream;
 import java.nio.ByteBuffer;
+import java.nio.DoubleBuffer;
 
 /**
  * <h3>A floating point values High Dynamic Range (HDR) Histogram that is synchronized as a whole</h3>
@@ -99,6 +100,16 @@ public class SynchronizedDoubleHistogram extends DoubleHistogram {
         super.setAutoResize(autoResize);
     }
 
+    @Override
+    public synchronized boolean isCumulativeCountIndexEnabled() {
+        return super.isCumulativeCountIndexEnabled();
+    }
+
+    @Override
+    public synchronized void setCumulativeCountIndexEnabled(final boolean enabled) {
+        super.setCumulativeCountIndexEnabled(enabled);
+    }
+
     @Override
     public synchronized void recordValue(final double value) throws ArrayIndexOutOfBoundsException {
         super.recordValue(value);
@@ -115,6 +126,17 @@ public class SynchronizedDoubleHistogram extends DoubleHistogram {
         super.recordValueWithExpectedInterval(value, expectedIntervalBetweenValueSamples);
     }
 
+    @Override
+    public synchronized void recordValues(final double[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        super.recordValues(values, offset, length);
+    }
+
+    @Override
+    public synchronized void recordValues(final DoubleBuffer values) throws ArrayIndexOutOfBoundsException {
+        super.recordValues(values);
+    }
+
     @Override
     public synchronized void reset() {
         super.reset();
@@ -373,6 +395,12 @@ public class SynchronizedDoubleHistogram extends DoubleHistogram {
         return super.getValueAtPercentile(percentile);
     }
 
+    @Override
+    public synchronized void getValuesAtPercentiles(final double[] sortedPercentiles,
+                                                    final double[] valuesAtPercentiles) {
+        super.getValuesAtPercentiles(sortedPercentiles, valuesAtPercentiles);
+    }
+
     @Override
     public synchronized double getPercentileAtOrBelowValue(final double value) {
         return super.getPercentileAtOrBelowValue(value);
@@ -461,4 +489,17 @@ public class SynchronizedDoubleHistogram extends DoubleHistogram {
     public synchronized int encodeIntoCompressedByteBuffer(final ByteBuffer targetBuffer) {
         return super.encodeIntoCompressedByteBuffer(targetBuffer);
     }
+
+    @Override
+    public synchronized int encodeIntoCompressedByteBuffer(
+            final ByteBuffer targetBuffer,
+            final HistogramCompressionCodec codec,
+            final int compressionLevel) {
+        return super.encodeIntoCompressedByteBuffer(targetBuffer, codec, compressionLevel);
+    }
+
+    @Override
+    public synchronized int getNeededCompressedByteBufferCapacity(final HistogramCompressionCodec codec) {
+        return super.getNeededCompressedByteBufferCapacity(codec);
+    }
 }
@@ -11,6 +11,7 @@ import java.io.IOException;
 import java.io.ObjectInputStream;
 import java.io.PrintStream;
 import java.nio.ByteBuffer;
+import java.nio.LongBuffer;
 import java.util.zip.DataFormatException;
 
 /**
@@ -141,6 +142,16 @@ public class SynchronizedHistogram extends Histogram {
         super.setAutoResize(autoResize);
     }
 
+    @Override
+    public synchronized boolean isCumulativeCountIndexEnabled() {
+        return super.isCumulativeCountIndexEnabled();
+    }
+
+    @Override
+    public synchronized void setCumulativeCountIndexEnabled(final boolean enabled) {
+        super.setCumulativeCountIndexEnabled(enabled);
+    }
+
     @Override
     public synchronized void recordValue(final long value) throws ArrayIndexOutOfBoundsException {
         super.recordValue(value);
@@ -157,6 +168,17 @@ public class SynchronizedHistogram extends Histogram {
         super.recordValueWithExpectedInterval(value, expectedIntervalBetweenValueSamples);
     }
 
+    @Override
+    public synchronized void recordValues(final long[] values, final int offset, final int length)
+            throws ArrayIndexOutOfBoundsException {
+        super.recordValues(values, offset, length);
+    }
+
+    @Override
+    public synchronized void recordValues(final LongBuffer values) throws ArrayIndexOutOfBoundsException {
+        super.recordValues(values);
+    }
+
     /**
      * @deprecated
      */
@@ -436,6 +458,12 @@ public class SynchronizedHistogram extends Histogram {
         return super.getValueAtPercentile(percentile);
     }
 
+    @Override
+    public synchronized void getValuesAtPercentiles(final double[] sortedPercentiles,
+                                                    final long[] valuesAtPercentiles) {
+        super.getValuesAtPercentiles(sortedPercentiles, valuesAtPercentiles);
+    }
+
     @Override
     public synchronized double getPercentileAtOrBelowValue(final long value) {
         return super.getPercentileAtOrBelowValue(value);
@@ -520,6 +548,29 @@ public class SynchronizedHistogram extends Histogram {
         return super.encodeIntoCompressedByteBuffer(targetBuffer);
     }
 
+    @Override
+    public synchronized int encodeIntoCompressedByteBuffer(
+            final ByteBuffer targetBuffer,
+            final HistogramCompressionCodec codec,
+            final int compressionLevel) {
+        return super.encodeIntoCompressedByteBuffer(targetBuffer, codec, compressionLevel);
+    }
+
+    @Override
+    public synchronized int getNeededCompressedByteBufferCapacity(final HistogramCompressionCodec codec) {
+        return super.getNeededCompressedByteBufferCapacity(codec);
+    }
+
+    @Override
+    public synchronized void addFromEncodedByteBuffer(final ByteBuffer buffer) {
+        super.addFromEncodedByteBuffer(buffer);
+    }
+
+    @Override
+    public synchronized void addFromCompressedByteBuffer(final ByteBuffer buffer) throws DataFormatException {
+        super.addFromCompressedByteBuffer(buffer);
+    }
+
     private void readObject(final ObjectInputStream o)
             throws IOException, ClassNotFoundException {
         o.defaultReadObject();
@@ -0,0 +1,150 @@
+/**
+ * Written by Gil Tene of Azul Systems, and released to the public domain,
+ * as explained at http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * @author Gil Tene
+ */
+
+package org.HdrHistogram;
+
+/**
+ * <h3>A {@link Histogram} specialized for a lowest discernible value of 1 and 3 significant value digits.</h3>
+ * <p>
+ * A 1 unit, 3 digit configuration (e.g. tracking nanosecond latencies between 1 nanosecond and 1 hour,
+ * the default range of a {@link ThreeDigitHistogram}) is by far the most commonly used histogram configuration.
+ * {@link ThreeDigitHistogram} computes value-to-index translations from static final constants for that
+ * configuration, rather than from per-instance configuration fields, allowing the JIT to constant-fold the index
+ * math in {@link #recordValue}, {@link #recordValueWithCount} and {@link #getCountAtValue} down to a handful of
+ * instructions. (Index-to-value translations, as used in iteration and queries, are those of all histograms, and
+ * are not specialized, such that they remain non-virtual for all histogram types.) It is otherwise identical in behavior to a {@link Histogram} of the
+ * same configuration (with which it is equal, and interchangeable in adding, subtracting, encoding and decoding),
+ * including support for auto-resizing of the highest trackable value.
+ * <p>
+ * See package description for {@link org.HdrHistogram} for details.
+ */
+public final class ThreeDigitHistogram extends Histogram {
+    /**
+     * The highest trackable value of a default constructed {@link ThreeDigitHistogram}: 1 hour in nanosecond units
+     */
+    public static final long DEFAULT_HIGHEST_TRACKABLE_VALUE = 3600L * 1000 * 1000 * 1000;
+
+    private static final int NUMBER_OF_SIGNIFICANT_VALUE_DIGITS = 3;
+
+    // The values of the index math configuration fields of AbstractHistogram for a lowestDiscernibleValue of 1
+    // and 3 significant value digits (2 * 10^3 rounds up to a sub bucket count of 2048):
+    private static final int UNIT_MAGNITUDE = 0;
+    private static final int SUB_BUCKET_COUNT_MAGNITUDE = 11;
+    private static final int SUB_BUCKET_HALF_COUNT_MAGNITUDE = SUB_BUCKET_COUNT_MAGNITUDE - 1;
+    private static final int SUB_BUCKET_HALF_COUNT = 1 << SUB_BUCKET_HALF_COUNT_MAGNITUDE;
+    private static final long SUB_BUCKET_MASK = ((1L << SUB_BUCKET_COUNT_MAGNITUDE) - 1) << UNIT_MAGNITUDE;
+    private static final int LEADING_ZERO_COUNT_BASE = 64 - UNIT_MAGNITUDE - SUB_BUCKET_COUNT_MAGNITUDE;
+
+    /**
+     * Construct a {@link ThreeDigitHistogram} tracking values between 1 and {@link #DEFAULT_HIGHEST_TRACKABLE_VALUE}
+     * (e.g. 1 nanosecond to 1 hour, in nanosecond units).
+     */
+    public ThreeDigitHistogram() {
+        this(DEFAULT_HIGHEST_TRACKABLE_VALUE);
+    }
+
+    /**
+     * Construct a {@link ThreeDigitHistogram} given the highest value to be tracked. The histogram will track
+     * (distinguish from 0) values as low as 1, with 3 significant decimal digits of precision.
+     *
+     * @param highestTrackableValue The highest value to be tracked by the histogram. Must be a positive
+     *                              integer that is {@literal >=} 2.
+     */
+    public ThreeDigitHistogram(final long highestTrackableValue) {
+        super(1, highestTrackableValue, NUMBER_OF_SIGNIFICANT_VALUE_DIGITS);
+    }
+
+    /**
+     * Construct a histogram with the same range settings as a given source histogram,
+     * duplicating the source's start/end timestamps (but NOT its contents)
+     * @param source The source histogram to duplicate
+     * @throws IllegalArgumentException if the source does not have a lowest discernible value of 1 and
+     * 3 significant value digits
+     */
+    public ThreeDigitHistogram(final AbstractHistogram source) {
+        super(requireThreeDigitConfiguration(source));
+    }
+
+    private static AbstractHistogram requireThreeDigitConfiguration(final AbstractHistogram source) {
+        if ((source.getLowestDiscernibleValue() != 1) ||
+                (source.getNumberOfSignificantValueDigits() != NUMBER_OF_SIGNIFICANT_VALUE_DIGITS)) {
+            throw new IllegalArgumentException("A ThreeDigitHistogram can only be constructed from a source with a " +
+                    "lowestDiscernibleValue of 1 and " + NUMBER_OF_SIGNIFICANT_VALUE_DIGITS +
+                    " significant value digits");
+        }
+        return source;
+    }
+
+    @Override
+    public void recordValue(final long value) throws ArrayIndexOutOfBoundsException {
+        final int countsIndex = threeDigitCountsArrayIndex(value);
+        try {
+            counts[normalizeIndex(countsIndex, normalizingIndexOffset, countsArrayLength)]++;
+        } catch (IndexOutOfBoundsException ex) {
+            // Let the general path auto-resize (or report the value as outside of the covered range):
+            super.recordValue(value);
+            return;
+        }
+        updateMinAndMax(value);
+        totalCount++;
+        if (cumulativeCountIndexIsValid) {
+            cumulativeCountIndexIsValid = false;
+        }
+    }
+
+    @Override
+    public void recordValueWithCount(final long value, final long count) throws ArrayIndexOutOfBoundsException {
+        final int countsIndex = threeDigitCountsArrayIndex(value);
+        try {
+            counts[normalizeIndex(countsIndex, normalizingIndexOffset, countsArrayLength)] += count;
+        } catch (IndexOutOfBoundsException ex) {
+            super.recordValueWithCount(value, count);
+            return;
+        }
+        updateMinAndMax(value);
+        totalCount += count;
+        if (cumulativeCountIndexIsValid) {
+            cumulativeCountIndexIsValid = false;
+        }
+    }
+
+    @Override
+    public long getCountAtValue(final long value) throws ArrayIndexOutOfBoundsException {
+        final int index = Math.min(Math.max(0, threeDigitCountsArrayIndex(value)), (countsArrayLength - 1));
+        return counts[normalizeIndex(index, normalizingIndexOffset, countsArrayLength)];
+    }
+
+    @Override
+    int countsArrayIndex(final long value) {
+        return threeDigitCountsArrayIndex(value);
+    }
+
+    // The index math of AbstractHistogram.countsArrayIndex(), with the configuration's constants folded in. Called
+    // directly (rather than through the overridable countsArrayIndex()) from the recording and lookup paths above:
+    private static int threeDigitCountsArrayIndex(final long value) {
+        if (value < 0) {
+            throw new ArrayIndexOutOfBoundsException("Histogram recorded value cannot be negative.");
+        }
+        final int bucketIndex = LEADING_ZERO_COUNT_BASE - Long.numberOfLeadingZeros(value | SUB_BUCKET_MASK);
+        final int subBucketIndex = (int) (value >>> (bucketIndex + UNIT_MAGNITUDE));
+        return ((bucketIndex + 1) << SUB_BUCKET_HALF_COUNT_MAGNITUDE) + (subBucketIndex - SUB_BUCKET_HALF_COUNT);
+    }
+
+    @Override
+    public ThreeDigitHistogram copy() {
+        ThreeDigitHistogram copy = new ThreeDigitHistogram(this);
+        copy.add(this);
+        return copy;
+    }
+
+    @Override
+    public ThreeDigitHistogram copyCorrectedForCoordinatedOmission(final long expectedIntervalBetweenValueSamples) {
+        ThreeDigitHistogram copy = new ThreeDigitHistogram(this);
+        copy.addWhileCorrectingForCoordinatedOmission(this, expectedIntervalBetweenValueSamples);
+        return copy;
+    }
+}
@@ -1,5 +1,7 @@
 package org.HdrHistogram;
 
+import java.nio.LongBuffer;
+
 public interface ValueRecorder {
 
     /**
@@ -40,6 +42,27 @@ public interface ValueRecorder {
     void recordValueWithExpectedInterval(long value, long expectedIntervalBetweenValueSamples)
             throws ArrayIndexOutOfBoundsException;
 
+    /**
+     * Record a batch of values. Equivalent to recording each of the values with {@link #recordValue(long)},
+     * but with per-recording overheads (e.g. synchronization, and total count and min/max tracking)
+     * paid once per batch.
+     *
+     * @param values The array containing the values to be recorded
+     * @param offset The offset in the array of the first value to be recorded
+     * @param length The number of values to be recorded
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value cannot be covered by the histogram's range
+     */
+    void recordValues(long[] values, int offset, int length) throws ArrayIndexOutOfBoundsException;
+
+    /**
+     * Record a batch of values, consisting of the values remaining in a buffer. Equivalent to
+     * {@link #recordValues(long[], int, int)}. The buffer's position is advanced to its limit.
+     *
+     * @param values The buffer containing the values to be recorded (from its position to its limit)
+     * @throws ArrayIndexOutOfBoundsException (may throw) if a value cannot be covered by the histogram's range
+     */
+    void recordValues(LongBuffer values) throws ArrayIndexOutOfBoundsException;
+
     /**
      * Reset the contents and collected stats
      */
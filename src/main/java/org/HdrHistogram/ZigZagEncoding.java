@@ -8,6 +8,7 @@
 package org.HdrHistogram;
 
 import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 
 /**
  * This class provides encoding and decoding methods for writing and reading
@@ -151,6 +152,52 @@ class ZigZagEncoding {
         return value;
     }
 
+    /**
+     * Read a block of LEB128-64b9B ZigZag encoded long values from the given buffer, from its position
+     * and up to (but not past) the given end position, or until the block is full. Produces the same values
+     * (and leaves the buffer at the same position) as the equivalent sequence of {@link #getLong(ByteBuffer)}
+     * calls would, but decodes runs of single byte values (e.g. small counts, and short zero runs) a word
+     * at a time.
+     * @param buffer the buffer to read from
+     * @param endPosition the buffer position at which to stop reading
+     * @param block the block to read values into
+     * @return the number of values read into the block
+     */
+    static int getLongs(final ByteBuffer buffer, final int endPosition, final long[] block) {
+        final int fastPathEndPosition = Math.min(endPosition, buffer.limit());
+        final boolean bigEndian = (buffer.order() == ByteOrder.BIG_ENDIAN);
+        int position = buffer.position();
+        int blockLength = 0;
+        while ((blockLength < block.length) && (position < endPosition)) {
+            if ((position + 8 <= fastPathEndPosition) && (blockLength + 8 <= block.length)) {
+                final long word = buffer.getLong(position);
+                if ((word & 0x8080808080808080L) == 0) {
+                    // Eight single byte values:
+                    for (int i = 0; i < 8; i++) {
+                        final long v = (word >>> (bigEndian ? (56 - (i << 3)) : (i << 3))) & 0x7F;
+                        block[blockLength++] = (v >>> 1) ^ (-(v & 1));
+                    }
+                    position += 8;
+                    continue;
+                }
+            }
+            if (position < fastPathEndPosition) {
+                final long v = buffer.get(position);
+                if (v >= 0) {
+                    // A single byte value:
+                    block[blockLength++] = (v >>> 1) ^ (-(v & 1));
+                    position++;
+                    continue;
+                }
+            }
+            buffer.position(position);
+            block[blockLength++] = getLong(buffer);
+            position = buffer.position();
+        }
+        buffer.position(position);
+        return blockLength;
+    }
+
     /**
      * Read an LEB128-64b9B ZigZag encoded int value from the given buffer
      * @param buffer the buffer to read from
@@ -2,8 +2,16 @@ package org.HdrHistogram.packedarray;
 
 import java.util.concurrent.atomic.AtomicIntegerFieldUpdater;
 import java.util.concurrent.atomic.AtomicLongArray;
-
-
+import java.util.concurrent.atomic.AtomicReferenceFieldUpdater;
+
+/**
+ * A concurrent array context, using atomic operations on its storage.
+ * <p>
+ * The physical storage is segmented: an initial segment (of the context's initial physical length) is followed
+ * by fixed size growth segments. Growing the storage (see {@link #resizeArray(int)}) appends segments, and never
+ * copies or moves existing contents, such that a packed context can grow in place while writers concurrently
+ * record into it.
+ */
 class ConcurrentPackedArrayContext extends PackedArrayContext {
 
     ConcurrentPackedArrayContext(final int virtualLength,
@@ -12,6 +20,7 @@ class ConcurrentPackedArrayContext extends PackedArrayContext {
         super(virtualLength, initialPhysicalLength, false);
         if (allocateArray) {
             array = new AtomicLongArray(getPhysicalLength());
+            arrayLength = array.length();
             init(virtualLength);
         }
     }
@@ -30,15 +39,40 @@ class ConcurrentPackedArrayContext extends PackedArrayContext {
         }
     }
 
+    private static final int GROWTH_SEGMENT_LENGTH_MAGNITUDE = 6;
+    private static final int GROWTH_SEGMENT_LENGTH = 1 << GROWTH_SEGMENT_LENGTH_MAGNITUDE;
+    private static final int GROWTH_SEGMENT_MASK = GROWTH_SEGMENT_LENGTH - 1;
+    private static final AtomicLongArray[] NO_GROWTH_SEGMENTS = new AtomicLongArray[0];
+
+    // The initial segment, holding long indexes [0, arrayLength):
     private AtomicLongArray array;
+    private int arrayLength;
+    // Growth segment i holds long indexes [arrayLength + (i * GROWTH_SEGMENT_LENGTH), ...). Only ever replaced
+    // (atomically) by a longer copy of itself, such that all versions share the same segments:
+    private volatile AtomicLongArray[] growthSegments = NO_GROWTH_SEGMENTS;
     private volatile int populatedShortLength;
 
     private static final AtomicIntegerFieldUpdater<ConcurrentPackedArrayContext> populatedShortLengthUpdater =
             AtomicIntegerFieldUpdater.newUpdater(ConcurrentPackedArrayContext.class, "populatedShortLength");
 
+    private static final AtomicReferenceFieldUpdater<ConcurrentPackedArrayContext, AtomicLongArray[]>
+            growthSegmentsUpdater = AtomicReferenceFieldUpdater.newUpdater(
+                    ConcurrentPackedArrayContext.class, AtomicLongArray[].class, "growthSegments");
+
     @Override
     int length() {
-        return array.length();
+        final int length = arrayLength + (growthSegments.length << GROWTH_SEGMENT_LENGTH_MAGNITUDE);
+        // Packed contents are addressed with short indexes, and cannot make use of storage beyond their reach:
+        return isPacked() ? Math.min(length, MAX_SUPPORTED_PACKED_COUNTS_ARRAY_LENGTH) : length;
+    }
+
+    // The segment holding the given long index, which is then at (longIndex & GROWTH_SEGMENT_MASK) within it:
+    private AtomicLongArray growthSegmentFor(final int longIndex) {
+        return growthSegments[(longIndex - arrayLength) >> GROWTH_SEGMENT_LENGTH_MAGNITUDE];
+    }
+
+    private int growthSegmentOffsetFor(final int longIndex) {
+        return (longIndex - arrayLength) & GROWTH_SEGMENT_MASK;
     }
 
     @Override
@@ -61,35 +95,71 @@ class ConcurrentPackedArrayContext extends PackedArrayContext {
 
     @Override
     long getAtLongIndex(final int longIndex) {
-        return array.get(longIndex);
+        if (longIndex < arrayLength) {
+            return array.get(longIndex);
+        }
+        return growthSegmentFor(longIndex).get(growthSegmentOffsetFor(longIndex));
     }
 
     @Override
     boolean casAtLongIndex(final int longIndex, final long expectedValue, final long newValue) {
-        return array.compareAndSet(longIndex, expectedValue, newValue);
+        if (longIndex < arrayLength) {
+            return array.compareAndSet(longIndex, expectedValue, newValue);
+        }
+        return growthSegmentFor(longIndex).compareAndSet(growthSegmentOffsetFor(longIndex), expectedValue, newValue);
     }
 
     @Override
     void lazySetAtLongIndex(final int longIndex, final long newValue) {
-        array.lazySet(longIndex, newValue);
+        if (longIndex < arrayLength) {
+            array.lazySet(longIndex, newValue);
+            return;
+        }
+        growthSegmentFor(longIndex).lazySet(growthSegmentOffsetFor(longIndex), newValue);
     }
 
     @Override
     void clearContents() {
-        for (int i = 0; i < array.length(); i++) {
+        for (int i = 0; i < arrayLength; i++) {
             array.lazySet(i, 0);
         }
+        for (AtomicLongArray segment : growthSegments) {
+            for (int i = 0; i < GROWTH_SEGMENT_LENGTH; i++) {
+                segment.lazySet(i, 0);
+            }
+        }
         init(getVirtualLength());
     }
 
+    /**
+     * Grow the storage to (at least) the given length, by appending growth segments. Existing contents stay
+     * where they are, and may be concurrently accessed and modified during growth. Safe to call concurrently,
+     * and has no effect if the storage is already long enough.
+     * @param newLength The needed length (in longs)
+     */
     @Override
     void resizeArray(final int newLength) {
-        final AtomicLongArray newArray = new AtomicLongArray(newLength);
-        int copyLength = Math.min(array.length(), newLength);
-        for (int i = 0; i < copyLength; i++) {
-            newArray.lazySet(i, array.get(i));
+        if (isPacked() && (newLength > MAX_SUPPORTED_PACKED_COUNTS_ARRAY_LENGTH)) {
+            throw new IllegalStateException("A packed context cannot grow beyond a length of " +
+                    MAX_SUPPORTED_PACKED_COUNTS_ARRAY_LENGTH);
         }
-        array = newArray;
+        final int neededSegmentCount =
+                Math.max(newLength - arrayLength + GROWTH_SEGMENT_MASK, 0) >> GROWTH_SEGMENT_LENGTH_MAGNITUDE;
+        AtomicLongArray[] segments;
+        do {
+            segments = growthSegments;
+            if (segments.length >= neededSegmentCount) {
+                return; // Already grown (possibly by a concurrent resize)
+            }
+            final AtomicLongArray[] newSegments = new AtomicLongArray[neededSegmentCount];
+            System.arraycopy(segments, 0, newSegments, 0, segments.length);
+            for (int i = segments.length; i < neededSegmentCount; i++) {
+                newSegments[i] = new AtomicLongArray(GROWTH_SEGMENT_LENGTH);
+            }
+            if (growthSegmentsUpdater.compareAndSet(this, segments, newSegments)) {
+                return;
+            }
+        } while (true);
     }
 
     @Override
@@ -119,6 +189,7 @@ class ConcurrentPackedArrayContext extends PackedArrayContext {
 
     @Override
     String unpackedToString() {
+        // Unpacked contexts are never grown, and are held in the initial segment:
         return array.toString();
     }
 }
@@ -20,6 +20,12 @@ import java.io.ObjectInputStream;
  * current implementation) of non-wait-free add or increment operations during the lifetime of an array, regardless of
  * the number of operations done.
  * </p>
+ * <p>
+ * The array's physical storage grows in place (in segments) as it is populated, without stalling concurrent
+ * {@link #add add()} and {@link #increment increment()} operations. Only the (one time) transition from packed to
+ * unpacked storage, and changes to the virtual length that add levels to the packed representation, replace the
+ * array's storage and re-record its contents.
+ * </p>
  */
 public class ConcurrentPackedLongArray extends PackedLongArray {
 
@@ -36,6 +42,18 @@ public class ConcurrentPackedLongArray extends PackedLongArray {
 
     @Override
     void resizeStorageArray(final int newPhysicalLengthInLongs) {
+        final AbstractPackedArrayContext currentArrayContext = getArrayContext();
+        if (currentArrayContext.isPacked() &&
+                (newPhysicalLengthInLongs <= AbstractPackedArrayContext.MAX_SUPPORTED_PACKED_COUNTS_ARRAY_LENGTH)) {
+            // Grow the storage of the live context in place (see ConcurrentPackedArrayContext), with no copying,
+            // no re-recording of contents and no phase flip, such that writers keep recording during growth.
+            // (If the context has been concurrently replaced, growing the replaced one is harmless, and the
+            // caller will retry against the new one.)
+            currentArrayContext.resizeArray(newPhysicalLengthInLongs);
+            return;
+        }
+
+        // Growing beyond the reach of packed contents: move to an unpacked context.
         AbstractPackedArrayContext inactiveArrayContext;
         try {
             wrp.readerLock();
@@ -9,6 +9,7 @@ package org.HdrHistogram.packedarray;
 
 import org.HdrHistogram.*;
 
+import java.util.Arrays;
 import java.util.concurrent.atomic.AtomicLong;
 
 /**
@@ -46,6 +47,8 @@ import java.util.concurrent.atomic.AtomicLong;
  */
 
 public class PackedArrayRecorder {
+    static final int DEFAULT_INTERVAL_ARRAY_POOL_CAPACITY = 2;
+
     private static AtomicLong instanceIdSequencer = new AtomicLong(1);
     private final long instanceId = instanceIdSequencer.getAndIncrement();
 
@@ -53,6 +56,9 @@ public class PackedArrayRecorder {
 
     private volatile PackedLongArray activeArray;
 
+    private PackedLongArray[] intervalArrayPool = new PackedLongArray[DEFAULT_INTERVAL_ARRAY_POOL_CAPACITY];
+    private int pooledIntervalArrayCount = 0;
+
     /**
      * Construct a {@link PackedArrayRecorder} with a given (virtual) array length.
      *
@@ -210,10 +216,73 @@ public class PackedArrayRecorder {
                                                          final boolean enforceContainingInstance) {
         // Verify that replacement array can validly be used as an inactive array replacement:
         validateFitAsReplacementArray(arrayToRecycle, enforceContainingInstance);
-        PackedLongArray sampledArray = performIntervalSample(arrayToRecycle);
+        PackedLongArray sampledArray = performIntervalSample(
+                (arrayToRecycle != null) ? arrayToRecycle : takePooledIntervalArray());
         return sampledArray;
     }
 
+    /**
+     * Release an interval array previously obtained from this PackedArrayRecorder (via {@link #getIntervalArray()} or one
+     * of its recycling variants) back into this PackedArrayRecorder's bounded pool of interval arrays. Pooled interval
+     * arrays are used by subsequent getIntervalArray() calls that are not provided with a array to recycle, such
+     * that steady-state interval sampling with explicit releases does not allocate.
+     * <p>
+     * NOTE: The caller must not access a released interval array after releasing it. Releasing the same
+     * interval array instance more than once (without obtaining it again) is disallowed.
+     *
+     * @param intervalArray a previously returned interval array (from this instance of {@link PackedArrayRecorder}).
+     * @return true if the interval array was pooled, false if it was dropped because the pool is full
+     * (or the provided interval array is null)
+     * @throws IllegalArgumentException if the interval array was not obtained from this instance, or if it
+     * has already been released
+     */
+    public synchronized boolean releaseIntervalArray(final PackedLongArray intervalArray) {
+        if (intervalArray == null) {
+            return false;
+        }
+        validateFitAsReplacementArray(intervalArray, true);
+        for (int i = 0; i < pooledIntervalArrayCount; i++) {
+            if (intervalArrayPool[i] == intervalArray) {
+                throw new IllegalArgumentException("interval array has already been released");
+            }
+        }
+        if (pooledIntervalArrayCount == intervalArrayPool.length) {
+            return false;
+        }
+        intervalArrayPool[pooledIntervalArrayCount++] = intervalArray;
+        return true;
+    }
+
+    /**
+     * Get the capacity of this PackedArrayRecorder's pool of released interval arrays.
+     * @return the interval array pool capacity
+     */
+    public synchronized int getIntervalArrayPoolCapacity() {
+        return intervalArrayPool.length;
+    }
+
+    /**
+     * Set the capacity of this PackedArrayRecorder's pool of released interval arrays (see
+     * {@link #releaseIntervalArray}). Pooled interval arrays beyond the new capacity are dropped.
+     * @param capacity the interval array pool capacity. Must be non-negative.
+     */
+    public synchronized void setIntervalArrayPoolCapacity(final int capacity) {
+        if (capacity < 0) {
+            throw new IllegalArgumentException("capacity must be >= 0");
+        }
+        pooledIntervalArrayCount = Math.min(pooledIntervalArrayCount, capacity);
+        intervalArrayPool = Arrays.copyOf(intervalArrayPool, capacity);
+    }
+
+    private PackedLongArray takePooledIntervalArray() {
+        if (pooledIntervalArrayCount == 0) {
+            return null;
+        }
+        PackedLongArray pooledArray = intervalArrayPool[--pooledIntervalArrayCount];
+        intervalArrayPool[pooledIntervalArrayCount] = null;
+        return pooledArray;
+    }
+
     /**
      * Reset the array contents to all zeros.
      */
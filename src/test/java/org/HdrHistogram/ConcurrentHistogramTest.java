@@ -68,6 +68,107 @@ public class ConcurrentHistogramTest {
         doRun = false;
     }
 
+    @Test
+    public void testConcurrentPackedRecordingDuringGrowth() throws Exception {
+        for (int round = 0; round < 20; round++) {
+            final PackedConcurrentHistogram histogram = new PackedConcurrentHistogram(1L << 41, 3);
+            final Histogram expectedHistogram = new Histogram(1L << 41, 3);
+            final Thread writers[] = new Thread[8];
+            final long seed = round;
+            for (int w = 0; w < writers.length; w++) {
+                final Random random = new Random(seed + (1000 * w));
+                final long[] values = new long[20000];
+                for (int i = 0; i < values.length; i++) {
+                    // Spread across many magnitudes, such that the packed storage grows while being recorded into:
+                    values[i] = (long) Math.pow(2, 40 * random.nextDouble());
+                    expectedHistogram.recordValue(values[i]);
+                }
+                writers[w] = new Thread() {
+                    public void run() {
+                        for (long value : values) {
+                            histogram.recordValue(value);
+                        }
+                    }
+                };
+            }
+            for (Thread writer : writers) {
+                writer.start();
+            }
+            for (Thread writer : writers) {
+                writer.join();
+            }
+            Assert.assertEquals(expectedHistogram.getTotalCount(), histogram.getTotalCount());
+            Assert.assertEquals(expectedHistogram, histogram);
+        }
+    }
+
+    @Test
+    public void testConcurrentDirectRecording() throws Exception {
+        final DirectConcurrentHistogram histogram = new DirectConcurrentHistogram(highestTrackableValue, 3);
+        final Histogram expectedHistogram = new Histogram(highestTrackableValue, 3);
+        final Thread writers[] = new Thread[8];
+        for (int w = 0; w < writers.length; w++) {
+            final long[] values = new long[50000];
+            for (int i = 0; i < values.length; i++) {
+                // Few distinct values, such that concurrent writers update the same counts:
+                values[i] = 1000 + (i % 16);
+                expectedHistogram.recordValue(values[i]);
+            }
+            writers[w] = new Thread() {
+                public void run() {
+                    for (long value : values) {
+                        histogram.recordValue(value);
+                    }
+                }
+            };
+        }
+        for (Thread writer : writers) {
+            writer.start();
+        }
+        for (Thread writer : writers) {
+            writer.join();
+        }
+        Assert.assertEquals(expectedHistogram.getTotalCount(), histogram.getTotalCount());
+        Assert.assertEquals(expectedHistogram, histogram);
+    }
+
+    @Test
+    public void testConcurrentDoubleRecordingDuringRangeChanges() throws Exception {
+        for (int round = 0; round < 20; round++) {
+            final ConcurrentDoubleHistogram histogram = new ConcurrentDoubleHistogram(3);
+            final DoubleHistogram expectedHistogram = new DoubleHistogram(3);
+            final Thread writers[] = new Thread[8];
+            final long seed = round;
+            for (int w = 0; w < writers.length; w++) {
+                final Random random = new Random(seed + (1000 * w));
+                final double[] values = new double[5000];
+                for (int i = 0; i < values.length; i++) {
+                    // Spread across many magnitudes, such that the covered range shifts while being recorded into:
+                    values[i] = Math.pow(2, 30 * random.nextDouble() - 15);
+                    expectedHistogram.recordValue(values[i]);
+                }
+                writers[w] = new Thread() {
+                    public void run() {
+                        for (double value : values) {
+                            histogram.recordValue(value);
+                        }
+                    }
+                };
+            }
+            for (Thread writer : writers) {
+                writer.start();
+            }
+            for (Thread writer : writers) {
+                writer.join();
+            }
+            Assert.assertEquals(expectedHistogram.getTotalCount(), histogram.getTotalCount());
+            for (double percentile = 0.0; percentile <= 100.0; percentile += 12.5) {
+                double expectedValue = expectedHistogram.getValueAtPercentile(percentile);
+                Assert.assertEquals(expectedValue, histogram.getValueAtPercentile(percentile), expectedValue * 0.01);
+            }
+        }
+    }
+
     static AtomicLong valueRecorderId = new AtomicLong(42);
 
     class ValueRecorder extends Thread {
@@ -218,6 +218,19 @@ public class DoubleHistogramDataAccessTest {
     }
 
 
+    @Test
+    public void testGetValuesAtPercentiles() throws Exception {
+        double[] percentiles = {0.0, 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0};
+        double[] values = new double[percentiles.length];
+        for (DoubleHistogram h : new DoubleHistogram[] {histogram, rawHistogram, postCorrectedHistogram}) {
+            h.getValuesAtPercentiles(percentiles, values);
+            for (int i = 0; i < percentiles.length; i++) {
+                Assert.assertEquals("value at percentile " + percentiles[i],
+                        h.getValueAtPercentile(percentiles[i]), values[i], 0.0);
+            }
+        }
+    }
+
     @Test
     public void testGetPercentileAtOrBelowValue() throws Exception {
         Assert.assertEquals("Raw percentile at or below 5 msec is 99.99% +/- 0.0001",
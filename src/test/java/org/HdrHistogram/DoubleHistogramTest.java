@@ -32,6 +32,86 @@ public class DoubleHistogramTest {
     // static final long testValueLevel = 12340;
     static final double testValueLevel = 4.0;
 
+    @ParameterizedTest
+    @ValueSource(classes = {
+            DoubleHistogram.class,
+            ConcurrentDoubleHistogram.class,
+            SynchronizedDoubleHistogram.class,
+            PackedDoubleHistogram.class,
+            PackedConcurrentDoubleHistogram.class,
+    })
+    public void testRecordValues(final Class histoClass) throws Exception {
+        DoubleHistogram histogram =
+                constructDoubleHistogram(histoClass, trackableValueRangeSize, numberOfSignificantValueDigits);
+        DoubleHistogram expected =
+                constructDoubleHistogram(histoClass, trackableValueRangeSize, numberOfSignificantValueDigits);
+        // Values spanning beyond the initial auto range, forcing range adjustments mid-batch:
+        double[] values = new double[3000];
+        for (int i = 0; i < values.length; i++) {
+            values[i] = (i % 1000) * 0.25 + ((i >= 2000) ? 100000.0 : 0.0);
+        }
+        histogram.recordValues(values, 0, 2500);
+        histogram.recordValues(java.nio.DoubleBuffer.wrap(values, 2500, 500));
+        for (double value : values) {
+            expected.recordValue(value);
+        }
+        assertEquals(expected, histogram);
+        assertEquals(expected.getMaxValue(), histogram.getMaxValue(), 0.0);
+        assertEquals(expected.getMinNonZeroValue(), histogram.getMinNonZeroValue(), 0.0);
+        assertEquals(expected.getValueAtPercentile(99.0), histogram.getValueAtPercentile(99.0), 0.0);
+    }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            DoubleHistogram.class,
+            ConcurrentDoubleHistogram.class,
+    })
+    public void testRangeHeadroom(final Class histoClass) throws Exception {
+        final int headroom = 8;
+        final double headroomRatio = 1 << headroom;
+        DoubleHistogram histogram = (DoubleHistogram) histoClass.getConstructor(long.class, int.class, int.class)
+                .newInstance(1000L, numberOfSignificantValueDigits, headroom);
+        assertEquals(1000L << (2 * headroom), histogram.getHighestToLowestValueRatio());
+        histogram.recordValue(1.0);
+        final double initialLowestValue = histogram.getCurrentLowestTrackableNonZeroValue();
+        final double initialHighestValue = histogram.getCurrentHighestTrackableValue();
+
+        // First values above and below the covered range are each placed in the middle of the newly covered range:
+        for (double firstValue : new double[] { initialHighestValue * 1000.0, initialLowestValue / 1000.0 }) {
+            DoubleHistogram placedHistogram = (DoubleHistogram) histoClass.getConstructor(DoubleHistogram.class)
+                    .newInstance(histogram);
+            assertEquals(0, placedHistogram.getTotalCount());
+            Assert.assertEquals(initialLowestValue, placedHistogram.getCurrentLowestTrackableNonZeroValue(), 0.0);
+            placedHistogram.recordValue(0.0); // Zero values do not place the covered range
+            placedHistogram.recordValue(firstValue);
+            Assert.assertTrue(placedHistogram.getCurrentLowestTrackableNonZeroValue() <= firstValue / headroomRatio);
+            Assert.assertTrue(placedHistogram.getCurrentHighestTrackableValue() >= firstValue * headroomRatio);
+            final double conversionRatio = placedHistogram.getIntegerToDoubleValueConversionRatio();
+
+            // Values within the headroom, both below and above, are recorded without adjusting the covered range:
+            placedHistogram.recordValue(firstValue / (headroomRatio / 2));
+            placedHistogram.recordValue(firstValue * (headroomRatio / 2));
+            assertEquals(conversionRatio, placedHistogram.getIntegerToDoubleValueConversionRatio(), 0.0);
+            assertEquals(4, placedHistogram.getTotalCount());
+            assertEquals(1, placedHistogram.getCountAtValue(firstValue));
+            assertEquals(1, placedHistogram.getCountAtValue(firstValue / (headroomRatio / 2)));
+            Assert.assertTrue(placedHistogram.valuesAreEquivalent(firstValue * (headroomRatio / 2),
+                    placedHistogram.getMaxValue()));
+
+            // Values beyond the covered range still adjust (shift) the covered range:
+            placedHistogram.recordValue(placedHistogram.getCurrentLowestTrackableNonZeroValue() / 4);
+            Assert.assertNotEquals(conversionRatio, placedHistogram.getIntegerToDoubleValueConversionRatio(), 0.0);
+            assertEquals(5, placedHistogram.getTotalCount());
+            assertEquals(1, placedHistogram.getCountAtValue(firstValue));
+
+            // The headroom is applied again when the histogram is reset and placed anew:
+            placedHistogram.reset();
+            placedHistogram.recordValue(firstValue);
+            Assert.assertTrue(placedHistogram.getCurrentLowestTrackableNonZeroValue() <= firstValue / headroomRatio);
+            Assert.assertTrue(placedHistogram.getCurrentHighestTrackableValue() >= firstValue * headroomRatio);
+        }
+    }
+
     @ParameterizedTest
     @ValueSource(classes = {
             DoubleHistogram.class,
@@ -27,7 +27,10 @@ public class HistogramAutosizingTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -47,7 +50,10 @@ public class HistogramAutosizingTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -73,7 +79,10 @@ public class HistogramAutosizingTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -93,7 +102,10 @@ public class HistogramAutosizingTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -117,7 +129,10 @@ public class HistogramAutosizingTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
     })
     public void testAutoSizingAcrossContinuousRange(Class c) {
@@ -13,6 +13,8 @@ import org.junit.jupiter.api.Test;
 
 import java.util.ArrayList;
 import java.util.List;
+import java.util.Locale;
+import java.util.Random;
 
 /**
  * JUnit test for {@link org.HdrHistogram.Histogram}
@@ -241,6 +243,36 @@ public class HistogramDataAccessTest {
     }
 
 
+    @Test
+    public void testGetValuesAtPercentiles() throws Exception {
+        double[] percentiles = {0.0, 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0};
+        long[] values = new long[percentiles.length];
+        for (Histogram h : new Histogram[] {histogram, rawHistogram, postCorrectedHistogram, scaledHistogram}) {
+            h.getValuesAtPercentiles(percentiles, values);
+            for (int i = 0; i < percentiles.length; i++) {
+                Assert.assertEquals("value at percentile " + percentiles[i],
+                        h.getValueAtPercentile(percentiles[i]), values[i]);
+            }
+        }
+
+        Histogram empty = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
+        empty.getValuesAtPercentiles(percentiles, values);
+        for (long value : values) {
+            Assert.assertEquals(0, value);
+        }
+
+        try {
+            histogram.getValuesAtPercentiles(new double[] {50.0, 10.0}, values);
+            Assert.fail("Unsorted percentiles should be rejected");
+        } catch (IllegalArgumentException expected) {
+        }
+        try {
+            histogram.getValuesAtPercentiles(percentiles, new long[2]);
+            Assert.fail("A too short output array should be rejected");
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
     @Test
     public void testGetPercentileAtOrBelowValue() throws Exception {
         Assert.assertEquals("Raw percentile at or below 5 msec is 99.99% +/- 0.0001",
@@ -264,6 +296,65 @@ public class HistogramDataAccessTest {
                 10000, histogram.getCountBetweenValues(5000L, 150000000L));
     }
 
+    @Test
+    public void testCumulativeCountIndexQueries() throws Exception {
+        Histogram indexed = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
+        indexed.setCumulativeCountIndexEnabled(true);
+        verifyCumulativeCountIndexQueries(indexed, histogram);
+        verifyCumulativeCountIndexQueries(indexed, rawHistogram);
+        verifyCumulativeCountIndexQueries(indexed, postCorrectedHistogram);
+
+        // Recording into an indexed histogram must invalidate the index:
+        indexed.reset();
+        Histogram reference = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
+        Random random = new Random(42);
+        for (int i = 0; i < 10; i++) {
+            for (int j = 0; j < 1000; j++) {
+                long value = (long) (Math.abs(random.nextGaussian()) * 1000000);
+                indexed.recordValue(value);
+                reference.recordValue(value);
+            }
+            assertEquivalentQueryResults(indexed, reference);
+        }
+        indexed.add(histogram);
+        reference.add(histogram);
+        assertEquivalentQueryResults(indexed, reference);
+
+        indexed.reset();
+        Assert.assertEquals(0, indexed.getValueAtPercentile(50.0));
+        Assert.assertEquals(0, indexed.getCountBetweenValues(0, highestTrackableValue));
+        indexed.recordValueWithCount(1000, 3);
+        Assert.assertEquals(indexed.highestEquivalentValue(1000), indexed.getValueAtPercentile(50.0));
+        Assert.assertEquals(3, indexed.getCountBetweenValues(0, highestTrackableValue));
+
+        indexed.setCumulativeCountIndexEnabled(false);
+        Assert.assertFalse(indexed.isCumulativeCountIndexEnabled());
+        Assert.assertEquals(indexed.highestEquivalentValue(1000), indexed.getValueAtPercentile(50.0));
+    }
+
+    private void verifyCumulativeCountIndexQueries(Histogram indexed, Histogram source) {
+        indexed.reset();
+        indexed.add(source);
+        assertEquivalentQueryResults(indexed, source);
+    }
+
+    private void assertEquivalentQueryResults(AbstractHistogram indexed, AbstractHistogram reference) {
+        for (double percentile = 0.0; percentile <= 100.0; percentile += 0.25) {
+            Assert.assertEquals("value at percentile " + percentile,
+                    reference.getValueAtPercentile(percentile), indexed.getValueAtPercentile(percentile));
+        }
+        Assert.assertEquals(reference.getValueAtPercentile(99.999), indexed.getValueAtPercentile(99.999));
+        for (long value = 1; value < highestTrackableValue; value *= 3) {
+            Assert.assertEquals("percentile at or below " + value,
+                    reference.getPercentileAtOrBelowValue(value), indexed.getPercentileAtOrBelowValue(value), 0.0);
+            Assert.assertEquals("count between " + (value / 2) + " and " + value,
+                    reference.getCountBetweenValues(value / 2, value), indexed.getCountBetweenValues(value / 2, value));
+            Assert.assertEquals("count between " + value + " and max",
+                    reference.getCountBetweenValues(value, highestTrackableValue),
+                    indexed.getCountBetweenValues(value, highestTrackableValue));
+        }
+    }
+
     @Test
     public void testGetCountAtValue() throws Exception {
         Assert.assertEquals("Count of raw values at 10 msec is 0",
@@ -697,4 +788,107 @@ public class HistogramDataAccessTest {
 
         Assert.assertEquals(4104, snapshots.size());
     }
+
+    @Test
+    public void testForEachVisitsSameStepsAsIterators() {
+        Histogram[] histograms = {histogram, scaledHistogram, rawHistogram, postCorrectedHistogram,
+                new Histogram(highestTrackableValue, numberOfSignificantValueDigits)};
+        for (Histogram h : histograms) {
+            final List<String> expected = new ArrayList<String>();
+            final List<String> visited = new ArrayList<String>();
+
+            for (HistogramIterationValue v : h.percentiles(5)) {
+                expected.add(v.getValueIteratedTo() + "," + v.getPercentileLevelIteratedTo() + "," +
+                        v.getTotalCountToThisValue());
+            }
+            h.forEachPercentile(5, new PercentileConsumer() {
+                @Override
+                public void accept(long valueIteratedTo, double percentileLevelIteratedTo, long totalCountToThisValue) {
+                    visited.add(valueIteratedTo + "," + percentileLevelIteratedTo + "," + totalCountToThisValue);
+                }
+            });
+            Assert.assertEquals(expected, visited);
+
+            final BucketConsumer bucketConsumer = new BucketConsumer() {
+                @Override
+                public void accept(long valueIteratedTo, long countAddedInThisIterationStep, long totalCountToThisValue) {
+                    visited.add(valueIteratedTo + "," + countAddedInThisIterationStep + "," + totalCountToThisValue);
+                }
+            };
+
+            expected.clear();
+            visited.clear();
+            for (HistogramIterationValue v : h.linearBucketValues(100000)) {
+                expected.add(v.getValueIteratedTo() + "," + v.getCountAddedInThisIterationStep() + "," +
+                        v.getTotalCountToThisValue());
+            }
+            h.forEachLinearBucket(100000, bucketConsumer);
+            Assert.assertEquals(expected, visited);
+
+            expected.clear();
+            visited.clear();
+            for (HistogramIterationValue v : h.logarithmicBucketValues(10000, 2)) {
+                expected.add(v.getValueIteratedTo() + "," + v.getCountAddedInThisIterationStep() + "," +
+                        v.getTotalCountToThisValue());
+            }
+            h.forEachLogarithmicBucket(10000, 2, bucketConsumer);
+            Assert.assertEquals(expected, visited);
+
+            expected.clear();
+            visited.clear();
+            for (HistogramIterationValue v : h.recordedValues()) {
+                expected.add(v.getValueIteratedTo() + "," + v.getCountAtValueIteratedTo());
+            }
+            h.forEachRecordedValue(new RecordedValueConsumer() {
+                @Override
+                public void accept(long valueIteratedTo, long countAtValue) {
+                    visited.add(valueIteratedTo + "," + countAtValue);
+                }
+            });
+            Assert.assertEquals(expected, visited);
+        }
+    }
+
+    @Test
+    public void testPercentileDistributionFormatterMatchesFormatter() {
+        Histogram fractionalHistogram = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
+        fractionalHistogram.recordValue(0);
+        for (long value = 1; value < 1000000; value = (value * 7) + 3) {
+            fractionalHistogram.recordValueWithCount(value, value % 13 + 1);
+        }
+        Histogram[] histograms = {histogram, scaledHistogram, postCorrectedHistogram, fractionalHistogram};
+        double[] scalingRatios = {1.0, 512.0, 1000.0, 3.0, 0.1, -7.0};
+        for (Histogram h : histograms) {
+            for (double scalingRatio : scalingRatios) {
+                for (boolean useCsvFormat : new boolean[] {false, true}) {
+                    final String percentileFormatString;
+                    final String lastLinePercentileFormatString;
+                    if (useCsvFormat) {
+                        percentileFormatString = "%." + numberOfSignificantValueDigits + "f,%.12f,%d,%.2f\n";
+                        lastLinePercentileFormatString = "%." + numberOfSignificantValueDigits + "f,%.12f,%d,Infinity\n";
+                    } else {
+                        percentileFormatString = "%12." + numberOfSignificantValueDigits + "f %2.12f %10d %14.2f\n";
+                        lastLinePercentileFormatString = "%12." + numberOfSignificantValueDigits + "f %2.12f %10d\n";
+                    }
+                    StringBuilder expected = new StringBuilder();
+                    for (HistogramIterationValue v : h.percentiles(5)) {
+                        double percentile = v.getPercentileLevelIteratedTo() / 100.0D;
+                        if (v.getPercentileLevelIteratedTo() != 100.0D) {
+                            expected.append(String.format(Locale.US, percentileFormatString,
+                                    v.getValueIteratedTo() / scalingRatio, percentile, v.getTotalCountToThisValue(),
+                                    1 / (1.0D - percentile)));
+                        } else {
+                            expected.append(String.format(Locale.US, lastLinePercentileFormatString,
+                                    v.getValueIteratedTo() / scalingRatio, percentile, v.getTotalCountToThisValue()));
+                        }
+                    }
+
+                    PercentileDistributionFormatter formatter =
+                            new PercentileDistributionFormatter(numberOfSignificantValueDigits, scalingRatio, useCsvFormat);
+                    h.forEachPercentile(5, formatter);
+                    Assert.assertEquals(expected.toString(), formatter.getOutput().toString());
+                }
+            }
+        }
+    }
 }
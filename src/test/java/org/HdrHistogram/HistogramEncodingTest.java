@@ -18,11 +18,17 @@ import org.junit.jupiter.params.provider.ValueSource;
 import org.junit.runner.RunWith;
 
 import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Random;
+import java.util.zip.DataFormatException;
+import java.util.zip.Deflater;
+import java.util.zip.Inflater;
 
 import static org.HdrHistogram.HistogramTestUtils.constructHistogram;
 import static org.HdrHistogram.HistogramTestUtils.constructDoubleHistogram;
 import static org.HdrHistogram.HistogramTestUtils.decodeFromCompressedByteBuffer;
 import static org.HdrHistogram.HistogramTestUtils.decodeDoubleHistogramFromCompressedByteBuffer;
+import static org.HdrHistogram.HistogramTestUtils.assertPopulatedSpanBoundsCounts;
 
 /**
  * JUnit test for {@link org.HdrHistogram.Histogram}
@@ -287,10 +293,14 @@ public class HistogramEncodingTest {
     @ValueSource(classes = {
             Histogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -383,7 +393,10 @@ public class HistogramEncodingTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -404,4 +417,434 @@ public class HistogramEncodingTest {
         AbstractHistogram histogram2 = decodeFromCompressedByteBuffer(histoClass, targetCompressedBuffer, 0);
         Assert.assertEquals(histogram, histogram2);
     }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            ConcurrentHistogram.class,
+            SynchronizedHistogram.class,
+            PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
+            IntCountsHistogram.class,
+            ShortCountsHistogram.class,
+    })
+    public void testRepeatedCompressedEncodingIntoOffsetBuffers(final Class histoClass) throws Exception {
+        AbstractHistogram histogram = constructHistogram(histoClass, highestTrackableValue, 3);
+        for (int i = 0; i < 10000; i++) {
+            histogram.recordValue(1000 * i);
+        }
+        int capacity = histogram.getNeededByteBufferCapacity() + 100;
+
+        // A heap buffer slice (with a non-zero array offset), and a direct buffer written at a non-zero position:
+        ByteBuffer heapBuffer = ((ByteBuffer) ByteBuffer.allocate(capacity + 16).position(16)).slice();
+        ByteBuffer directBuffer = ByteBuffer.allocateDirect(capacity + 16);
+        for (int round = 0; round < 3; round++) {
+            heapBuffer.clear();
+            histogram.encodeIntoCompressedByteBuffer(heapBuffer);
+            heapBuffer.rewind();
+            Assert.assertEquals(histogram, decodeFromCompressedByteBuffer(histoClass, heapBuffer, 0));
+
+            directBuffer.clear();
+            directBuffer.position(16);
+            int bytesWritten = histogram.encodeIntoCompressedByteBuffer(directBuffer);
+            Assert.assertEquals(16 + bytesWritten, directBuffer.position());
+            directBuffer.position(16);
+            Assert.assertEquals(histogram, decodeFromCompressedByteBuffer(histoClass, directBuffer, 0));
+
+            histogram.recordValue(round);
+        }
+    }
+
+    static final HistogramCompressionCodec testUserCodec = new HistogramCompressionCodec() {
+        @Override
+        public int getCodecId() {
+            return 100;
+        }
+
+        @Override
+        public int getMaxCompressedLength(int uncompressedLength) {
+            return HistogramCompressionCodecs.DEFLATE.getMaxCompressedLength(uncompressedLength);
+        }
+
+        @Override
+        public int compress(ByteBuffer source, ByteBuffer target, int compressionLevel) {
+            return HistogramCompressionCodecs.DEFLATE.compress(source, target, compressionLevel);
+        }
+
+        @Override
+        public void decompress(ByteBuffer source, ByteBuffer target) throws DataFormatException {
+            HistogramCompressionCodecs.DEFLATE.decompress(source, target);
+        }
+    };
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            ConcurrentHistogram.class,
+            PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
+            IntCountsHistogram.class,
+            ShortCountsHistogram.class,
+    })
+    public void testCompressionCodecEncoding(final Class histoClass) throws Exception {
+        HistogramCompressionCodecs.register(testUserCodec);
+        AbstractHistogram histogram = constructHistogram(histoClass, highestTrackableValue, 3);
+        DoubleHistogram doubleHistogram = new DoubleHistogram(3);
+        for (int i = 0; i < 10000; i++) {
+            histogram.recordValue(1000 * i);
+            doubleHistogram.recordValue(0.001 * i);
+        }
+
+        HistogramCompressionCodec[] codecs = {
+                HistogramCompressionCodecs.DEFLATE, HistogramCompressionCodecs.NONE, testUserCodec
+        };
+        for (HistogramCompressionCodec codec : codecs) {
+            ByteBuffer targetBuffer = ByteBuffer.allocate(histogram.getNeededCompressedByteBufferCapacity(codec));
+            int bytesWritten = histogram.encodeIntoCompressedByteBuffer(targetBuffer, codec, Deflater.BEST_SPEED);
+            Assert.assertEquals(bytesWritten, targetBuffer.position());
+            targetBuffer.rewind();
+            Assert.assertEquals(histogram, decodeFromCompressedByteBuffer(histoClass, targetBuffer, 0));
+
+            targetBuffer = ByteBuffer.allocateDirect(doubleHistogram.getNeededCompressedByteBufferCapacity(codec));
+            doubleHistogram.encodeIntoCompressedByteBuffer(targetBuffer, codec, Deflater.BEST_SPEED);
+            targetBuffer.rewind();
+            Assert.assertEquals(doubleHistogram, EncodableHistogram.decodeFromCompressedByteBuffer(targetBuffer, 0));
+        }
+    }
+
+    @Test
+    public void testCodecEncodingWithImplausibleUncompressedLength() throws Exception {
+        Histogram histogram = new Histogram(highestTrackableValue, 3);
+        histogram.recordValue(42);
+        ByteBuffer targetBuffer = ByteBuffer.allocate(
+                histogram.getNeededCompressedByteBufferCapacity(HistogramCompressionCodecs.NONE));
+        histogram.encodeIntoCompressedByteBuffer(targetBuffer, HistogramCompressionCodecs.NONE, 0);
+        // A corrupt uncompressed length must be rejected, rather than allocated for:
+        targetBuffer.putInt(8, Integer.MAX_VALUE - 8);
+        targetBuffer.rewind();
+        try {
+            Histogram.decodeFromCompressedByteBuffer(targetBuffer, 0);
+            Assert.fail("Expected an IllegalArgumentException");
+        } catch (IllegalArgumentException expected) {
+        }
+        targetBuffer.rewind();
+        try {
+            histogram.addFromCompressedByteBuffer(targetBuffer);
+            Assert.fail("Expected an IllegalArgumentException");
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
+    @Test
+    public void testCodecEncodingDefaultsToDeflate() throws Exception {
+        final Histogram histogram = new Histogram(highestTrackableValue, 3);
+        histogram.recordValue(42);
+        // An EncodableHistogram subclass that does not implement codec support encodes with DEFLATE:
+        EncodableHistogram encodable = new EncodableHistogram() {
+            public int getNeededByteBufferCapacity() { return histogram.getNeededByteBufferCapacity(); }
+            public int encodeIntoCompressedByteBuffer(ByteBuffer targetBuffer, int compressionLevel) {
+                return histogram.encodeIntoCompressedByteBuffer(targetBuffer, compressionLevel);
+            }
+            public long getStartTimeStamp() { return histogram.getStartTimeStamp(); }
+            public void setStartTimeStamp(long startTimeStamp) { histogram.setStartTimeStamp(startTimeStamp); }
+            public long getEndTimeStamp() { return histogram.getEndTimeStamp(); }
+            public void setEndTimeStamp(long endTimestamp) { histogram.setEndTimeStamp(endTimestamp); }
+            public String getTag() { return histogram.getTag(); }
+            public void setTag(String tag) { histogram.setTag(tag); }
+            public double getMaxValueAsDouble() { return histogram.getMaxValueAsDouble(); }
+        };
+        HistogramCompressionCodecs.register(testUserCodec);
+        ByteBuffer targetBuffer =
+                ByteBuffer.allocate(encodable.getNeededCompressedByteBufferCapacity(testUserCodec));
+        encodable.encodeIntoCompressedByteBuffer(targetBuffer, testUserCodec, Deflater.BEST_SPEED);
+        targetBuffer.rewind();
+        Assert.assertEquals(histogram, Histogram.decodeFromCompressedByteBuffer(targetBuffer, 0));
+    }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            ConcurrentHistogram.class,
+            SynchronizedHistogram.class,
+            PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
+            IntCountsHistogram.class,
+            ShortCountsHistogram.class,
+    })
+    public void testAddFromEncodedByteBuffer(final Class histoClass) throws Exception {
+        // Sources with a matching layout, a differing precision and unit magnitude, and a normalizing offset:
+        Histogram matchingSource = new Histogram(1, highestTrackableValue, 3);
+        Histogram differingSource = new Histogram(1000, highestTrackableValue * 1000, 2);
+        Histogram shiftedSource = new Histogram(1, highestTrackableValue, 3);
+        for (int i = 0; i < 1000; i++) {
+            matchingSource.recordValue(i * 7);
+            differingSource.recordValue(i * 7000);
+            shiftedSource.recordValue(i * 3);
+        }
+        matchingSource.recordValue(0);
+        shiftedSource.shiftValuesLeft(3);
+
+        AbstractHistogram expected = constructHistogram(histoClass, 1, highestTrackableValue, 3);
+        AbstractHistogram histogram = constructHistogram(histoClass, 1, highestTrackableValue, 3);
+        histogram.recordValue(42);
+        expected.recordValue(42);
+        for (Histogram source : new Histogram[] { matchingSource, differingSource, shiftedSource }) {
+            expected.add(source);
+
+            ByteBuffer buffer = ByteBuffer.allocate(source.getNeededByteBufferCapacity());
+            source.encodeIntoByteBuffer(buffer);
+            buffer.rewind();
+            histogram.addFromEncodedByteBuffer(buffer);
+            Assert.assertEquals(expected, histogram);
+            Assert.assertEquals(expected.getMinNonZeroValue(), histogram.getMinNonZeroValue());
+            Assert.assertEquals(expected.getMaxValue(), histogram.getMaxValue());
+
+            expected.add(source);
+            for (HistogramCompressionCodec codec :
+                    new HistogramCompressionCodec[] { HistogramCompressionCodecs.DEFLATE, HistogramCompressionCodecs.NONE }) {
+                buffer = ByteBuffer.allocate(source.getNeededCompressedByteBufferCapacity(codec));
+                source.encodeIntoCompressedByteBuffer(buffer, codec, Deflater.BEST_SPEED);
+                buffer.rewind();
+                histogram.addFromCompressedByteBuffer(buffer);
+            }
+            expected.add(source);
+            Assert.assertEquals(expected, histogram);
+            Assert.assertEquals(expected.getValueAtPercentile(99.0), histogram.getValueAtPercentile(99.0));
+        }
+    }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            ConcurrentHistogram.class,
+            PackedHistogram.class,
+    })
+    public void testCompressedEncodingMatchesUncompressedEncoding(final Class histoClass) throws Exception {
+        final AbstractHistogram histogram = constructHistogram(histoClass, highestTrackableValue, 3);
+        for (int i = 0; i < 20000; i++) {
+            // Enough distinct counts for the uncompressed encoding to outgrow the deflater's initial buffer:
+            histogram.recordValueWithCount(1000L * i, 1 + (i % 1000));
+        }
+        final ByteBuffer uncompressedBuffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+        final int uncompressedLength = histogram.encodeIntoByteBuffer(uncompressedBuffer);
+        Assert.assertTrue(uncompressedLength > SharedDeflater.INITIAL_UNCOMPRESSED_BUFFER_CAPACITY);
+
+        // Encode on several threads, each through its own (thread-local) deflater:
+        final ByteBuffer[] compressedBuffers = new ByteBuffer[4];
+        final Thread[] encoders = new Thread[compressedBuffers.length];
+        for (int t = 0; t < encoders.length; t++) {
+            final int bufferIndex = t;
+            encoders[t] = new Thread() {
+                public void run() {
+                    ByteBuffer buffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+                    histogram.encodeIntoCompressedByteBuffer(buffer);
+                    buffer.flip();
+                    compressedBuffers[bufferIndex] = buffer;
+                }
+            };
+            encoders[t].start();
+        }
+        for (Thread encoder : encoders) {
+            encoder.join();
+        }
+        for (ByteBuffer compressedBuffer : compressedBuffers) {
+            // The (single pass) compressed encoding inflates into exactly the uncompressed encoding:
+            Inflater inflater = new Inflater();
+            inflater.setInput(compressedBuffer.array(), 8, compressedBuffer.limit() - 8);
+            byte[] inflated = new byte[uncompressedLength + 1];
+            Assert.assertEquals(uncompressedLength, inflater.inflate(inflated));
+            Assert.assertTrue(inflater.finished());
+            inflater.end();
+            for (int i = 0; i < uncompressedLength; i++) {
+                Assert.assertEquals(uncompressedBuffer.get(i), inflated[i]);
+            }
+            Assert.assertEquals(histogram, decodeFromCompressedByteBuffer(histoClass, compressedBuffer, 0));
+        }
+    }
+
+    @Test
+    public void testZigZagBlockDecodingMatchesPerValueDecoding() throws Exception {
+        long[] values = new long[1000];
+        for (int i = 0; i < values.length; i++) {
+            // Mostly single byte values (small counts and short zero runs), with some longer words mixed in:
+            values[i] = ((i % 17) == 0) ? (1L << (i % 63)) : ((i % 11) == 0) ? -(i * 31L) : (i % 64) - 32;
+        }
+        values[500] = Long.MAX_VALUE;
+        values[501] = Long.MIN_VALUE;
+        for (ByteOrder order : new ByteOrder[] { ByteOrder.BIG_ENDIAN, ByteOrder.LITTLE_ENDIAN }) {
+            ByteBuffer buffer = ByteBuffer.allocate(values.length * 9 + 3).order(order);
+            buffer.position(3);
+            for (long value : values) {
+                ZigZagEncoding.putLong(buffer, value);
+            }
+            int endPosition = buffer.position();
+            for (int blockLength : new int[] { 1, 7, 256 }) {
+                buffer.position(3);
+                long[] block = new long[blockLength];
+                int valueIndex = 0;
+                while (buffer.position() < endPosition) {
+                    int blockCount = ZigZagEncoding.getLongs(buffer, endPosition, block);
+                    Assert.assertTrue(blockCount > 0);
+                    for (int i = 0; i < blockCount; i++) {
+                        Assert.assertEquals(values[valueIndex++], block[i]);
+                    }
+                }
+                Assert.assertEquals(values.length, valueIndex);
+                Assert.assertEquals(endPosition, buffer.position());
+            }
+        }
+    }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            IntCountsHistogram.class,
+            ShortCountsHistogram.class,
+            ConcurrentHistogram.class,
+    })
+    public void testDecodingIntoCountsArrays(final Class histoClass) throws Exception {
+        AbstractHistogram histogram = constructHistogram(histoClass, 1, highestTrackableValue, 3);
+        for (int i = 0; i < 5000; i++) {
+            // Dense small counts at the low end, and sparse larger counts (with long zero runs) above them:
+            histogram.recordValueWithCount(i % 2000, 1 + (i % 3));
+            histogram.recordValueWithCount(i * 557L, 1 + (i % 300));
+        }
+        ByteBuffer buffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+        histogram.encodeIntoCompressedByteBuffer(buffer);
+        buffer.rewind();
+        AbstractHistogram decodedHistogram = decodeFromCompressedByteBuffer(histoClass, buffer, 0);
+        Assert.assertEquals(histogram, decodedHistogram);
+        assertPopulatedSpanBoundsCounts(histogram, decodedHistogram);
+
+        // A histogram with a normalizing index offset decodes through its (normalizing) per-count path:
+        histogram.shiftValuesLeft(2);
+        buffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+        histogram.encodeIntoCompressedByteBuffer(buffer);
+        buffer.rewind();
+        decodedHistogram = decodeFromCompressedByteBuffer(histoClass, buffer, 0);
+        Assert.assertEquals(histogram, decodedHistogram);
+        assertPopulatedSpanBoundsCounts(histogram, decodedHistogram);
+    }
+
+    @Test
+    public void testDeltaEncodingRoundTrip() throws Exception {
+        HistogramDeltaEncoder encoder = new HistogramDeltaEncoder();
+        HistogramDeltaDecoder decoder = new HistogramDeltaDecoder();
+        Histogram histogram = new Histogram(highestTrackableValue, 3);
+        ByteBuffer buffer = ByteBuffer.allocate(encoder.getNeededCompressedByteBufferCapacity(histogram));
+        Random random = new Random(42);
+        int fullLength = 0;
+        for (int interval = 0; interval < 10; interval++) {
+            histogram.reset();
+            // A stable distribution, with a few values that differ from one interval to the next:
+            for (int i = 0; i < 10000; i++) {
+                histogram.recordValue(1000 + (i % 5000));
+            }
+            histogram.recordValue(random.nextInt(1000000));
+            histogram.setStartTimeStamp(interval * 1000);
+            histogram.setEndTimeStamp((interval + 1) * 1000);
+            buffer.clear();
+            int length = encoder.encodeIntoCompressedByteBuffer(histogram, buffer);
+            Assert.assertEquals(length, buffer.position());
+            if (interval == 0) {
+                fullLength = length;
+            } else {
+                Assert.assertTrue("a delta of a stable distribution must be small", length < fullLength / 4);
+            }
+            buffer.flip();
+            Histogram decodedHistogram = decoder.decodeFromCompressedByteBuffer(buffer);
+            Assert.assertEquals(histogram, decodedHistogram);
+            Assert.assertEquals(histogram.getStartTimeStamp(), decodedHistogram.getStartTimeStamp());
+            Assert.assertEquals(histogram.getEndTimeStamp(), decodedHistogram.getEndTimeStamp());
+            assertPopulatedSpanBoundsCounts(histogram, decodedHistogram);
+            Assert.assertEquals(length, buffer.position());
+        }
+
+        // A lost encoding makes the next delta undecodable, until the encoder is reset:
+        buffer.clear();
+        encoder.encodeIntoCompressedByteBuffer(histogram, buffer);
+        histogram.recordValue(7);
+        buffer.clear();
+        encoder.encodeIntoCompressedByteBuffer(histogram, buffer);
+        buffer.flip();
+        try {
+            decoder.decodeFromCompressedByteBuffer(buffer);
+            Assert.fail("a delta from a lost interval must not be decoded");
+        } catch (IllegalStateException expected) {
+        }
+        encoder.reset();
+        buffer.clear();
+        encoder.encodeIntoCompressedByteBuffer(histogram, buffer);
+        buffer.flip();
+        Assert.assertEquals(histogram, decoder.decodeFromCompressedByteBuffer(buffer));
+    }
+
+    @Test
+    public void testDeltaEncodedRecorderIntervals() throws Exception {
+        Recorder recorder = new Recorder(3);
+        HistogramDeltaEncoder encoder = new HistogramDeltaEncoder();
+        HistogramDeltaDecoder decoder = new HistogramDeltaDecoder();
+        ByteBuffer buffer = ByteBuffer.allocate(1 << 20);
+        for (int interval = 0; interval < 10; interval++) {
+            Histogram expectedHistogram = new Histogram(3);
+            for (int i = 0; i < 1000; i++) {
+                // The covered range grows every few intervals, such that some intervals are encoded in full:
+                long value = (i * 17L) << interval;
+                recorder.recordValue(value);
+                expectedHistogram.recordValue(value);
+            }
+            buffer.clear();
+            encoder.encodeNextIntervalIntoCompressedByteBuffer(recorder, buffer);
+            buffer.flip();
+            Assert.assertEquals(expectedHistogram, decoder.decodeFromCompressedByteBuffer(buffer));
+        }
+    }
+
+    @Test
+    public void testDeltaEncodedAggregationTree() throws Exception {
+        final int leafCount = 6;
+        final HistogramAggregator rootAggregator = new HistogramAggregator(3);
+        final HistogramAggregator[] intermediateAggregators = {
+                new HistogramAggregator(3), new HistogramAggregator(3) };
+        final HistogramDeltaEncoder[] intermediateEncoders = {
+                new HistogramDeltaEncoder(), new HistogramDeltaEncoder() };
+        final HistogramDeltaEncoder[] leafEncoders = new HistogramDeltaEncoder[leafCount];
+        for (int leaf = 0; leaf < leafCount; leaf++) {
+            leafEncoders[leaf] = new HistogramDeltaEncoder();
+        }
+        final Histogram[] intermediateIntervals = new Histogram[intermediateAggregators.length];
+        Histogram rootInterval = null;
+        ByteBuffer buffer = ByteBuffer.allocate(1 << 20);
+        Random random = new Random(7);
+        for (int interval = 0; interval < 5; interval++) {
+            Histogram expectedHistogram = new Histogram(3);
+            for (int leaf = 0; leaf < leafCount; leaf++) {
+                Histogram leafHistogram = new Histogram(3);
+                for (int i = 0; i < 1000; i++) {
+                    leafHistogram.recordValue((long) Math.pow(2, 20 * random.nextDouble()));
+                }
+                expectedHistogram.add(leafHistogram);
+                buffer.clear();
+                leafEncoders[leaf].encodeIntoCompressedByteBuffer(leafHistogram, buffer);
+                buffer.flip();
+                intermediateAggregators[leaf % intermediateAggregators.length]
+                        .addEncodedInterval("leaf" + leaf, buffer);
+            }
+            for (int i = 0; i < intermediateAggregators.length; i++) {
+                Assert.assertEquals(leafCount / intermediateAggregators.length,
+                        intermediateAggregators[i].getSourceCount());
+                intermediateIntervals[i] =
+                        intermediateAggregators[i].getAggregatedIntervalHistogram(intermediateIntervals[i]);
+                buffer.clear();
+                intermediateEncoders[i].encodeIntoCompressedByteBuffer(intermediateIntervals[i], buffer);
+                buffer.flip();
+                rootAggregator.addEncodedInterval("intermediate" + i, buffer);
+            }
+            rootInterval = rootAggregator.getAggregatedIntervalHistogram(rootInterval);
+            Assert.assertEquals(expectedHistogram, rootInterval);
+        }
+    }
 }
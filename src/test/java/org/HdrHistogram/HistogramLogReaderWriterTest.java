@@ -3,10 +3,17 @@ package org.HdrHistogram;
 import org.junit.Assert;
 import org.junit.jupiter.api.Test;
 
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
 import java.io.File;
 import java.io.FileInputStream;
 import java.io.FileOutputStream;
 import java.io.InputStream;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+import java.util.Locale;
+import java.util.zip.Deflater;
 
 public class HistogramLogReaderWriterTest {
 
@@ -30,6 +37,141 @@ public class HistogramLogReaderWriterTest {
         Assert.assertEquals(1.0, reader.getStartTimeSec(), 0.000001);
     }
 
+    @Test
+    public void nonDeflateCompressionCodecLog() throws Exception {
+        File temp = File.createTempFile("hdrhistogramtesting", "hist");
+        temp.deleteOnExit();
+        FileOutputStream writerStream = new FileOutputStream(temp);
+        HistogramLogWriter writer = new HistogramLogWriter(writerStream);
+        writer.setCompressionCodec(HistogramCompressionCodecs.NONE, 0);
+        writer.outputLogFormatVersion();
+        writer.outputLegend();
+        Histogram histogram = new Histogram(3);
+        DoubleHistogram doubleHistogram = new DoubleHistogram(3);
+        for (int i = 0; i < 1000; i++) {
+            histogram.recordValue(1000 * i);
+            doubleHistogram.recordValue(0.5 * i);
+        }
+        histogram.setStartTimeStamp(1000);
+        histogram.setEndTimeStamp(2000);
+        doubleHistogram.setStartTimeStamp(2000);
+        doubleHistogram.setEndTimeStamp(3000);
+        writer.outputIntervalHistogram(histogram);
+        writer.outputIntervalHistogram(doubleHistogram);
+        writerStream.close();
+
+        FileInputStream readerStream = new FileInputStream(temp);
+        HistogramLogReader reader = new HistogramLogReader(readerStream);
+        Assert.assertEquals(histogram, reader.nextIntervalHistogram());
+        Assert.assertEquals(doubleHistogram, reader.nextIntervalHistogram());
+        Assert.assertNull(reader.nextIntervalHistogram());
+    }
+
+    @Test
+    public void intervalLinesMatchFormattedLines() throws Exception {
+        ByteArrayOutputStream logStream = new ByteArrayOutputStream();
+        HistogramLogWriter writer = new HistogramLogWriter(logStream);
+        Histogram histogram = new Histogram(3);
+        for (int i = 0; i < 1000; i++) {
+            histogram.recordValue(1234567 * i);
+        }
+        histogram.setTag("A");
+        writer.outputIntervalHistogram(12.3456789, 13.5, histogram, 1000000.0);
+        histogram.setTag(null);
+        writer.outputIntervalHistogram(0.0005, 1.0, histogram, 7.0);
+
+        ByteBuffer targetBuffer = ByteBuffer.allocate(
+                histogram.getNeededCompressedByteBufferCapacity(HistogramCompressionCodecs.DEFLATE));
+        int compressedLength = histogram.encodeIntoCompressedByteBuffer(targetBuffer, Deflater.BEST_COMPRESSION);
+        String payload = Base64Helper.printBase64Binary(Arrays.copyOf(targetBuffer.array(), compressedLength));
+        String expectedLog = String.format(Locale.US, "Tag=A,%.3f,%.3f,%.3f,%s\n",
+                12.3456789, 13.5 - 12.3456789, histogram.getMaxValue() / 1000000.0, payload) +
+                String.format(Locale.US, "%.3f,%.3f,%.3f,%s\n",
+                0.0005, 1.0 - 0.0005, histogram.getMaxValue() / 7.0, payload);
+        Assert.assertEquals(expectedLog, new String(logStream.toByteArray(), StandardCharsets.US_ASCII));
+    }
+
+    @Test
+    public void base64EncodingRoundTrips() throws Exception {
+        for (int length = 0; length < 6; length++) {
+            byte[] bytes = new byte[length];
+            for (int i = 0; i < length; i++) {
+                bytes[i] = (byte) (0xfb - (37 * i));
+            }
+            String encoded = Base64Helper.printBase64Binary(bytes);
+            Assert.assertEquals(Base64Helper.getEncodedLength(length), encoded.length());
+            Assert.assertArrayEquals(bytes, Base64Helper.parseBase64Binary(encoded));
+        }
+        Assert.assertEquals("TWFu", Base64Helper.printBase64Binary("Man".getBytes(StandardCharsets.US_ASCII)));
+        Assert.assertEquals("TWE=", Base64Helper.printBase64Binary("Ma".getBytes(StandardCharsets.US_ASCII)));
+        Assert.assertEquals("TQ==", Base64Helper.printBase64Binary("M".getBytes(StandardCharsets.US_ASCII)));
+    }
+
+    @Test
+    public void binaryLog() throws Exception {
+        ByteArrayOutputStream logStream = new ByteArrayOutputStream();
+        BinaryHistogramLogWriter writer = new BinaryHistogramLogWriter(logStream);
+        writer.outputComment("A binary log");
+        writer.outputStartTime(1000000);
+        Histogram histogram = new Histogram(3);
+        DoubleHistogram doubleHistogram = new DoubleHistogram(3);
+        Histogram taggedHistogram = new Histogram(3);
+        taggedHistogram.setTag("A");
+        for (int interval = 0; interval < 3; interval++) {
+            for (int i = 0; i < 1000; i++) {
+                histogram.recordValue(1000 * i + interval);
+                doubleHistogram.recordValue(0.5 * i + interval);
+                taggedHistogram.recordValue(7 * i);
+            }
+            histogram.setStartTimeStamp(1000000 + (1000 * interval));
+            histogram.setEndTimeStamp(1000000 + (1000 * (interval + 1)));
+            taggedHistogram.setStartTimeStamp(histogram.getStartTimeStamp());
+            taggedHistogram.setEndTimeStamp(histogram.getEndTimeStamp());
+            doubleHistogram.setStartTimeStamp(histogram.getStartTimeStamp());
+            doubleHistogram.setEndTimeStamp(histogram.getEndTimeStamp());
+            writer.outputIntervalHistogram(histogram);
+            writer.outputIntervalHistogram(taggedHistogram);
+            writer.outputIntervalHistogram(doubleHistogram);
+        }
+        writer.close();
+        byte[] log = logStream.toByteArray();
+
+        HistogramLogReader reader = new HistogramLogReader(new ByteArrayInputStream(log));
+        for (int interval = 0; interval < 3; interval++) {
+            Histogram readHistogram = (Histogram) reader.nextIntervalHistogram();
+            Assert.assertNotNull(readHistogram);
+            Assert.assertNull(readHistogram.getTag());
+            Assert.assertEquals(1000000 + (1000 * interval), readHistogram.getStartTimeStamp());
+            Assert.assertEquals(1000000 + (1000 * (interval + 1)), readHistogram.getEndTimeStamp());
+            Histogram readTaggedHistogram = (Histogram) reader.nextIntervalHistogram();
+            Assert.assertEquals("A", readTaggedHistogram.getTag());
+            Assert.assertNotNull(reader.nextIntervalHistogram());
+        }
+        Assert.assertNull(reader.nextIntervalHistogram());
+        Assert.assertEquals(1000.0, reader.getStartTimeSec(), 0.000001);
+        Assert.assertFalse(reader.hasNext());
+
+        // The last intervals (2 seconds into the log) match what was logged, also when read in encoded form:
+        reader = new HistogramLogReader(new ByteArrayInputStream(log));
+        HistogramLogReader.EncodedInterval lastInterval = null;
+        HistogramLogReader.EncodedInterval interval;
+        int intervalCount = 0;
+        while ((interval = reader.nextEncodedIntervalHistogram(2.0, Double.MAX_VALUE)) != null) {
+            lastInterval = interval;
+            if ("A".equals(interval.tag)) {
+                Assert.assertEquals(taggedHistogram, interval.decode());
+            } else if (intervalCount == 0) {
+                Histogram recycledHistogram = new Histogram(3);
+                recycledHistogram.addFromCompressedByteBuffer(interval.getCompressedBuffer());
+                Assert.assertEquals(histogram, recycledHistogram);
+            }
+            intervalCount++;
+        }
+        Assert.assertEquals(3, intervalCount);
+        Assert.assertEquals(doubleHistogram, lastInterval.decode());
+        Assert.assertEquals(1000000 + 3000, lastInterval.endTimeStampMsec);
+    }
+
     @Test
     public void taggedV2LogTest() throws Exception {
         InputStream readerStream = HistogramLogReaderWriterTest.class.getResourceAsStream("tagged-Log.logV2.hlog");
@@ -55,6 +197,216 @@ public class HistogramLogReaderWriterTest {
         Assert.assertEquals(accumulatedHistogramWithTagA, accumulatedHistogramWithNoTag);
     }
 
+    @Test
+    public void encodedIntervalsTaggedV2Log() throws Exception {
+        HistogramLogReader reader = new HistogramLogReader(
+                HistogramLogReaderWriterTest.class.getResourceAsStream("tagged-Log.logV2.hlog"));
+        HistogramLogReader encodedReader = new HistogramLogReader(
+                HistogramLogReaderWriterTest.class.getResourceAsStream("tagged-Log.logV2.hlog"));
+        Histogram recycledHistogram = new Histogram(3);
+        int intervalCount = 0;
+        EncodableHistogram histogram;
+        while ((histogram = reader.nextIntervalHistogram(5, 20)) != null) {
+            HistogramLogReader.EncodedInterval interval = encodedReader.nextEncodedIntervalHistogram(5, 20);
+            Assert.assertNotNull(interval);
+            Assert.assertEquals(histogram.getTag(), interval.tag);
+            Assert.assertEquals(histogram.getStartTimeStamp(), interval.startTimeStampMsec);
+            Assert.assertEquals(histogram.getEndTimeStamp(), interval.endTimeStampMsec);
+            EncodableHistogram decodedHistogram = interval.decode();
+            Assert.assertEquals(histogram, decodedHistogram);
+            Assert.assertEquals(histogram.getTag(), decodedHistogram.getTag());
+            // The encoded form can also be decoded into a recycled histogram:
+            recycledHistogram.reset();
+            recycledHistogram.addFromCompressedByteBuffer(interval.getCompressedBuffer());
+            Assert.assertEquals(histogram, recycledHistogram);
+            intervalCount++;
+        }
+        Assert.assertNull(encodedReader.nextEncodedIntervalHistogram(5, 20));
+        Assert.assertTrue(intervalCount > 0);
+    }
+
+    @Test
+    public void indexedLog() throws Exception {
+        File temp = File.createTempFile("hdrhistogramtesting", "hlog");
+        temp.deleteOnExit();
+        File indexFile = HistogramLogIndex.indexFileFor(temp);
+        indexFile.deleteOnExit();
+        HistogramLogWriter writer = new HistogramLogWriter(temp);
+        writer.outputIndexTo(indexFile);
+        writer.outputLogFormatVersion();
+        long startTimeWritten = 1000000;
+        writer.outputStartTime(startTimeWritten);
+        writer.setBaseTime(startTimeWritten);
+        writer.outputLegend();
+        Histogram histogram = new Histogram(3);
+        for (int i = 0; i < 100; i++) {
+            histogram.recordValue(1000 * i);
+            histogram.setStartTimeStamp(startTimeWritten + (1000 * i));
+            histogram.setEndTimeStamp(startTimeWritten + (1000 * i) + 1000);
+            histogram.setTag(null);
+            writer.outputIntervalHistogram(histogram);
+            histogram.setTag("A");
+            writer.outputIntervalHistogram(histogram);
+        }
+        writer.close();
+
+        HistogramLogIndex index = HistogramLogIndex.read(indexFile);
+        Assert.assertEquals(200, index.getEntryCount());
+        Assert.assertEquals(1000.0, index.getStartTimeSec(), 0.000001);
+        Assert.assertEquals(3, index.getLineNumber(0));
+        Assert.assertEquals("A", index.getTag(1));
+        Assert.assertEquals(10.0, index.getTimestampSec(20), 0.000001);
+        Assert.assertEquals(20, index.findFirstEntryAtOrAfter(10.0));
+        java.io.RandomAccessFile logFile = new java.io.RandomAccessFile(temp, "r");
+        logFile.seek(index.getByteOffset(21));
+        Assert.assertTrue(logFile.readLine().startsWith("Tag=A,10.000,"));
+        logFile.close();
+
+        HistogramLogReader reader = new HistogramLogReader(temp);
+        HistogramLogReader indexedReader = new HistogramLogReader(temp, index);
+        // Read a few intervals from the start, then ranges further along the log:
+        for (int i = 0; i < 3; i++) {
+            Assert.assertEquals(reader.nextIntervalHistogram(), indexedReader.nextIntervalHistogram());
+        }
+        double[][] ranges = { { 10.0, 12.0 }, { 50.5, 60.0 }, { 20.0, 30.0 } };
+        for (double[] range : ranges) {
+            EncodableHistogram expected;
+            do {
+                expected = reader.nextIntervalHistogram(range[0], range[1]);
+                EncodableHistogram actual = indexedReader.nextIntervalHistogram(range[0], range[1]);
+                Assert.assertEquals(expected, actual);
+                if (expected != null) {
+                    Assert.assertEquals(expected.getStartTimeStamp(), actual.getStartTimeStamp());
+                    Assert.assertEquals(expected.getTag(), actual.getTag());
+                }
+            } while (expected != null);
+        }
+        Assert.assertEquals(reader.getStartTimeSec(), indexedReader.getStartTimeSec(), 0.000001);
+        reader.close();
+        indexedReader.close();
+    }
+
+    @Test
+    public void parallelLogReader() throws Exception {
+        File logFile = new File(HistogramLogReaderWriterTest.class.getResource("tagged-Log.logV2.hlog").toURI());
+
+        HistogramLogReader reader = new HistogramLogReader(logFile);
+        java.util.List<EncodableHistogram> expectedTagA = new java.util.ArrayList<>();
+        Histogram expectedNoTagAccumulated = new Histogram(3);
+        int expectedNoTagCount = 0;
+        EncodableHistogram encodeableHistogram;
+        while ((encodeableHistogram = reader.nextIntervalHistogram(5, 20)) != null) {
+            if ("A".equals(encodeableHistogram.getTag())) {
+                expectedTagA.add(encodeableHistogram);
+            } else if (encodeableHistogram.getTag() == null) {
+                expectedNoTagAccumulated.add((Histogram) encodeableHistogram);
+                expectedNoTagCount++;
+            }
+        }
+        Assert.assertTrue(expectedNoTagCount > 0);
+        reader.close();
+
+        for (int chunkSize : new int[] { 100, 1000, ParallelHistogramLogReader.DEFAULT_CHUNK_SIZE_IN_BYTES }) {
+            ParallelHistogramLogReader parallelReader = new ParallelHistogramLogReader(logFile, null, chunkSize);
+            Assert.assertEquals(1441812279.474, parallelReader.getStartTimeSec(), 0.000001);
+
+            java.util.List<EncodableHistogram> tagA = parallelReader.readIntervalHistograms(5, 20, "A");
+            Assert.assertEquals(expectedTagA.size(), tagA.size());
+            for (int i = 0; i < tagA.size(); i++) {
+                Assert.assertEquals(expectedTagA.get(i), tagA.get(i));
+                Assert.assertEquals(expectedTagA.get(i).getStartTimeStamp(), tagA.get(i).getStartTimeStamp());
+                Assert.assertEquals("A", tagA.get(i).getTag());
+            }
+
+            Histogram noTagAccumulated = new Histogram(3);
+            int addedCount = parallelReader.addIntervalHistogramsTo(noTagAccumulated, 5, 20, null);
+            Assert.assertEquals(expectedNoTagCount, addedCount);
+            Assert.assertEquals(expectedNoTagAccumulated, noTagAccumulated);
+            parallelReader.close();
+        }
+    }
+
+    @Test
+    public void binaryLogWithOversizedRecord() throws Exception {
+        ByteArrayOutputStream logStream = new ByteArrayOutputStream();
+        BinaryHistogramLogWriter writer = new BinaryHistogramLogWriter(logStream);
+        Histogram histogram = new Histogram(3);
+        histogram.recordValue(42);
+        writer.outputIntervalHistogram(histogram);
+        writer.close();
+        // Follow the valid record with a (corrupt) record length far beyond any histogram encoding:
+        ByteBuffer corruptRecord = ByteBuffer.allocate(16);
+        corruptRecord.putInt(HistogramLogScanner.MAX_BINARY_RECORD_LENGTH + 1);
+        corruptRecord.put(BinaryHistogramLogWriter.INTERVAL_RECORD);
+        logStream.write(corruptRecord.array());
+
+        HistogramLogReader reader = new HistogramLogReader(new ByteArrayInputStream(logStream.toByteArray()));
+        Assert.assertEquals(histogram, reader.nextIntervalHistogram());
+        try {
+            reader.nextIntervalHistogram();
+            Assert.fail("Expected the oversized record to be reported");
+        } catch (RuntimeException expected) {
+            Assert.assertTrue(expected.getCause() instanceof java.io.IOException);
+        }
+        reader.close();
+    }
+
+    @Test
+    public void perTagLogProcessing() throws Exception {
+        String logFileName = new File(
+                HistogramLogReaderWriterTest.class.getResource("tagged-Log.logV2.hlog").toURI()).getPath();
+        File outputDir = java.nio.file.Files.createTempDirectory("hdrhistogramtesting").toFile();
+        String perTagOutput = new File(outputDir, "perTag").getPath();
+        String noTagOutput = new File(outputDir, "noTag").getPath();
+        String tagAOutput = new File(outputDir, "tagA").getPath();
+
+        new HistogramLogProcessor(new String[] {"-i", logFileName, "-o", perTagOutput, "-pertag"}).run();
+        new HistogramLogProcessor(new String[] {"-i", logFileName, "-o", noTagOutput}).run();
+        new HistogramLogProcessor(new String[] {"-i", logFileName, "-o", tagAOutput, "-tag", "A"}).run();
+
+        int noTagIntervalCount = 0;
+        int tagAIntervalCount = 0;
+        HistogramLogReader reader = new HistogramLogReader(logFileName);
+        EncodableHistogram histogram;
+        while ((histogram = reader.nextIntervalHistogram()) != null) {
+            if (histogram.getTag() == null) {
+                noTagIntervalCount++;
+            } else if ("A".equals(histogram.getTag())) {
+                tagAIntervalCount++;
+            }
+        }
+        reader.close();
+        Assert.assertTrue(noTagIntervalCount > 0);
+        Assert.assertTrue(tagAIntervalCount > 0);
+        Assert.assertEquals(noTagIntervalCount, countIntervalLines(readFileAsString(perTagOutput)));
+        Assert.assertEquals(tagAIntervalCount, countIntervalLines(readFileAsString(perTagOutput + ".A")));
+
+        // Each tag's outputs (including those of the no-tag intervals) must match those of a run for that tag alone:
+        for (String suffix : new String[] {"", ".hgrm"}) {
+            Assert.assertEquals(readFileAsString(noTagOutput + suffix), readFileAsString(perTagOutput + suffix));
+            Assert.assertEquals(readFileAsString(tagAOutput + suffix),
+                    readFileAsString(perTagOutput + ".A" + suffix));
+        }
+        for (File outputFile : outputDir.listFiles()) {
+            outputFile.delete();
+        }
+        outputDir.delete();
+    }
+
+    private static String readFileAsString(String fileName) throws Exception {
+        return new String(java.nio.file.Files.readAllBytes(new File(fileName).toPath()), StandardCharsets.UTF_8);
+    }
+
+    private static int countIntervalLines(String intervalLog) {
+        int count = 0;
+        for (String line : intervalLog.split("\n")) {
+            if (line.contains(" I:")) {
+                count++;
+            }
+        }
+        return count;
+    }
+
     @Test
     public void jHiccupV2Log() throws Exception {
         InputStream readerStream = HistogramLogReaderWriterTest.class.getResourceAsStream("jHiccup-2.0.7S.logV2.hlog");
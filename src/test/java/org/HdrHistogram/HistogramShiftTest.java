@@ -24,7 +24,8 @@ public class HistogramShiftTest {
     static final Class[] histogramClassesNoAtomic = {
             Histogram.class, ConcurrentHistogram.class,
             SynchronizedHistogram.class,
-            PackedHistogram.class, PackedConcurrentHistogram.class
+            PackedHistogram.class, PagedHistogram.class, PackedConcurrentHistogram.class,
+            DirectHistogram.class, DirectConcurrentHistogram.class
     };
 
     @ParameterizedTest
@@ -33,7 +34,10 @@ public class HistogramShiftTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
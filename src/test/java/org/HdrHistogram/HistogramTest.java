@@ -18,6 +18,8 @@ import org.junit.jupiter.params.provider.CsvSource;
 import org.junit.jupiter.params.provider.ValueSource;
 
 import java.io.*;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.zip.Deflater;
 
 import static org.junit.Assert.assertEquals;
@@ -39,9 +41,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -87,9 +93,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -129,9 +139,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -180,9 +194,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -230,9 +248,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -252,9 +274,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -280,9 +306,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -309,7 +339,10 @@ public class HistogramTest {
             ConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -333,9 +366,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -356,6 +393,7 @@ public class HistogramTest {
             Histogram.class,
             AtomicHistogram.class,
             SynchronizedHistogram.class,
+            DirectHistogram.class,
     })
     public void testGetEstimatedFootprintInBytes(Class histoClass) throws Exception {
             // Histogram histogram = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
@@ -386,14 +424,109 @@ public class HistogramTest {
             verifyMaxValue(histogram);
     }
 
+    @Test
+    public void testPagedHistogramAllocatesTouchedPagesOnly() throws Exception {
+        // e.g. nanosecond latencies, up to ~3 hours:
+        PagedHistogram histogram = new PagedHistogram(10000L * 1000 * 1000 * 1000, numberOfSignificantValueDigits);
+        Histogram denseHistogram = new Histogram(10000L * 1000 * 1000 * 1000, numberOfSignificantValueDigits);
+        Assert.assertEquals(0, histogram.getAllocatedPageCount());
+        for (int i = 0; i < 100; i++) {
+            histogram.recordValue(250000 + i);
+            denseHistogram.recordValue(250000 + i);
+        }
+        histogram.recordValueWithCount(5L * 1000 * 1000 * 1000, 3);
+        denseHistogram.recordValueWithCount(5L * 1000 * 1000 * 1000, 3);
+        Assert.assertEquals(2, histogram.getAllocatedPageCount());
+        Assert.assertTrue(histogram.getEstimatedFootprintInBytes() < denseHistogram.getEstimatedFootprintInBytes() / 10);
+        Assert.assertEquals(denseHistogram, histogram);
+        Assert.assertEquals(denseHistogram.getValueAtPercentile(50.0), histogram.getValueAtPercentile(50.0));
+
+        // Pages are kept (and zeroed) across resets:
+        histogram.reset();
+        Assert.assertEquals(2, histogram.getAllocatedPageCount());
+        Assert.assertEquals(0, histogram.getTotalCount());
+        Assert.assertEquals(0, histogram.getCountAtValue(250000));
+    }
+
+    @Test
+    public void testThreeDigitHistogramMatchesHistogram() throws Exception {
+        ThreeDigitHistogram histogram = new ThreeDigitHistogram();
+        Histogram referenceHistogram = new Histogram(1, ThreeDigitHistogram.DEFAULT_HIGHEST_TRACKABLE_VALUE, 3);
+        Assert.assertEquals(referenceHistogram.countsArrayLength, histogram.countsArrayLength);
+        for (int i = 0; i < histogram.countsArrayLength; i++) {
+            Assert.assertEquals(referenceHistogram.valueFromIndex(i), histogram.valueFromIndex(i));
+        }
+        for (long value = 0; value < ThreeDigitHistogram.DEFAULT_HIGHEST_TRACKABLE_VALUE; value = (value * 3) + 1) {
+            Assert.assertEquals(referenceHistogram.countsArrayIndex(value), histogram.countsArrayIndex(value));
+            histogram.recordValue(value);
+            referenceHistogram.recordValue(value);
+            histogram.recordValueWithCount(value + 1, 3);
+            referenceHistogram.recordValueWithCount(value + 1, 3);
+            Assert.assertEquals(referenceHistogram.getCountAtValue(value), histogram.getCountAtValue(value));
+        }
+        Assert.assertEquals(referenceHistogram, histogram);
+        Assert.assertEquals(referenceHistogram.getValueAtPercentile(99.0), histogram.getValueAtPercentile(99.0));
+
+        ThreeDigitHistogram copy = histogram.copy();
+        Assert.assertEquals(referenceHistogram, copy);
+
+        // Values beyond the range are rejected, unless auto-resizing:
+        try {
+            histogram.recordValue(ThreeDigitHistogram.DEFAULT_HIGHEST_TRACKABLE_VALUE * 4);
+            fail("Value beyond highestTrackableValue should have thrown");
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        histogram.setAutoResize(true);
+        referenceHistogram.setAutoResize(true);
+        histogram.recordValue(ThreeDigitHistogram.DEFAULT_HIGHEST_TRACKABLE_VALUE * 4);
+        referenceHistogram.recordValue(ThreeDigitHistogram.DEFAULT_HIGHEST_TRACKABLE_VALUE * 4);
+        Assert.assertEquals(referenceHistogram, histogram);
+
+        try {
+            new ThreeDigitHistogram(new Histogram(1, highestTrackableValue, 2));
+            fail("Construction from a differently configured source should have thrown");
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
+    @Test
+    public void testDirectHistogramWithCallerProvidedCountsBuffer() throws Exception {
+        ByteBuffer sharedBuffer = ByteBuffer.allocateDirect(
+                DirectHistogram.getCountsBufferCapacity(1, highestTrackableValue, numberOfSignificantValueDigits));
+        DirectHistogram histogram =
+                new DirectHistogram(1, highestTrackableValue, numberOfSignificantValueDigits, sharedBuffer);
+        Histogram referenceHistogram = new Histogram(highestTrackableValue, numberOfSignificantValueDigits);
+        for (int i = 0; i < 1000; i++) {
+            histogram.recordValue(i * 7);
+            referenceHistogram.recordValue(i * 7);
+        }
+        histogram.recordValueWithCount(testValueLevel, 5);
+        referenceHistogram.recordValueWithCount(testValueLevel, 5);
+        Assert.assertEquals(referenceHistogram, histogram);
+
+        // The counts are visible through the shared buffer, at their counts index positions:
+        ByteBuffer counts = sharedBuffer.duplicate().order(ByteOrder.nativeOrder());
+        Assert.assertEquals(5, counts.getLong(8 * histogram.countsArrayIndex(testValueLevel)));
+
+        // A histogram attached to a previously populated buffer picks up its contents:
+        DirectHistogram attachedHistogram =
+                new DirectHistogram(1, highestTrackableValue, numberOfSignificantValueDigits, sharedBuffer);
+        Assert.assertEquals(referenceHistogram, attachedHistogram);
+        Assert.assertFalse(attachedHistogram.isAutoResize());
+    }
+
     @ParameterizedTest
     @ValueSource(classes = {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -411,9 +544,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -434,9 +571,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -458,9 +599,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -491,9 +636,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -526,9 +675,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -560,9 +713,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -589,9 +746,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -642,9 +803,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -679,9 +844,74 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
+            SynchronizedHistogram.class,
+            PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
+            PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
+            IntCountsHistogram.class,
+            ShortCountsHistogram.class,
+    })
+    public void testNarrowlyPopulatedAddSubtractAndReset(Class histoClass) {
+        AbstractHistogram histogram = constructHistogram(histoClass, highestTrackableValue, numberOfSignificantValueDigits);
+        AbstractHistogram other = constructHistogram(histoClass, highestTrackableValue, numberOfSignificantValueDigits);
+        // Narrow, partially overlapping, bands of values (which only populate a small span of the counts):
+        for (long value = 1000; value < 1100; value++) {
+            histogram.recordValue(value);
+        }
+        for (long value = 1050; value < 1200; value++) {
+            other.recordValue(value);
+        }
+        other.recordValue(0);
+        histogram.add(other);
+        Assert.assertEquals(251L, histogram.getTotalCount());
+        Assert.assertEquals(2L, histogram.getCountAtValue(1075));
+        Assert.assertEquals(1L, histogram.getCountAtValue(0));
+        Assert.assertEquals(0L, histogram.getMinValue());
+        Assert.assertEquals(1199L, histogram.getMaxValue());
+
+        histogram.subtract(other);
+        Assert.assertEquals(100L, histogram.getTotalCount());
+        Assert.assertEquals(1L, histogram.getCountAtValue(1075));
+        Assert.assertEquals(0L, histogram.getCountAtValue(1150));
+        Assert.assertEquals(0L, histogram.getCountAtValue(0));
+        Assert.assertEquals(1000L, histogram.getMinValue());
+        Assert.assertEquals(1099L, histogram.getMaxValue());
+
+        // Reset must clear the populated span, leaving no stale counts behind:
+        histogram.reset();
+        histogram.recordValue(5);
+        histogram.recordValue(100000);
+        Assert.assertEquals(2L, histogram.getTotalCount());
+        Assert.assertEquals(0L, histogram.getCountAtValue(1050));
+        Assert.assertEquals(5L, histogram.getMinValue());
+        Assert.assertEquals(histogram.highestEquivalentValue(100000), histogram.getMaxValue());
+
+        // As must encoding (which skips the known-zero counts below the populated span):
+        ByteBuffer buffer = ByteBuffer.allocate(histogram.getNeededByteBufferCapacity());
+        histogram.encodeIntoByteBuffer(buffer);
+        buffer.rewind();
+        Histogram decodedHistogram = Histogram.decodeFromByteBuffer(buffer, 0);
+        Assert.assertEquals(2L, decodedHistogram.getTotalCount());
+        Assert.assertEquals(1L, decodedHistogram.getCountAtValue(5));
+        Assert.assertEquals(1L, decodedHistogram.getCountAtValue(100000));
+        Assert.assertEquals(5L, decodedHistogram.getMinValue());
+    }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            ConcurrentHistogram.class,
+            AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -710,7 +940,132 @@ public class HistogramTest {
             AtomicHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
+            StripedConcurrentHistogram.class,
+            IntCountsHistogram.class,
+            ShortCountsHistogram.class,
+    })
+    public void testRecordValues(Class histoClass) {
+            AbstractHistogram histogram = constructHistogram(histoClass, highestTrackableValue, numberOfSignificantValueDigits);
+            AbstractHistogram expected = constructHistogram(histoClass, highestTrackableValue, numberOfSignificantValueDigits);
+            long[] values = new long[2000];
+            for (int i = 0; i < values.length; i++) {
+                values[i] = (i * 7919L) % 1000000;
+            }
+            histogram.recordValues(values, 100, 1000);
+            for (int i = 100; i < 1100; i++) {
+                expected.recordValue(values[i]);
+            }
+            Assert.assertEquals(expected, histogram);
+            Assert.assertEquals(expected.getMaxValue(), histogram.getMaxValue());
+            Assert.assertEquals(expected.getMinNonZeroValue(), histogram.getMinNonZeroValue());
+
+            // Heap and direct buffers, recorded from their positions:
+            java.nio.LongBuffer heapBuffer = java.nio.LongBuffer.wrap(values);
+            heapBuffer.position(1100);
+            histogram.recordValues(heapBuffer);
+            Assert.assertEquals(values.length, heapBuffer.position());
+            java.nio.LongBuffer directBuffer =
+                    java.nio.ByteBuffer.allocateDirect(8 * values.length).asLongBuffer().put(values);
+            directBuffer.flip();
+            histogram.recordValues(directBuffer);
+            for (int i = 1100; i < values.length; i++) {
+                expected.recordValue(values[i]);
+            }
+            for (long value : values) {
+                expected.recordValue(value);
+            }
+            Assert.assertEquals(expected, histogram);
+            verifyMaxValue(histogram);
+
+            // Values out of range stop the batch, with the values preceding them recorded:
+            long[] outOfRangeValues = { 5, 10, highestTrackableValue * 2, 20 };
+            try {
+                histogram.recordValues(outOfRangeValues, 0, outOfRangeValues.length);
+                fail("Expected an ArrayIndexOutOfBoundsException");
+            } catch (ArrayIndexOutOfBoundsException ex) {
+                // expected
+            }
+            expected.recordValue(5);
+            expected.recordValue(10);
+            Assert.assertEquals(expected, histogram);
+            Assert.assertEquals(expected.getTotalCount(), histogram.getTotalCount());
+            Assert.assertEquals(expected.getMinNonZeroValue(), histogram.getMinNonZeroValue());
+    }
+
+    @Test
+    public void testRecordValuesWithAutoResizeAndNormalizingIndexOffset() {
+            Histogram histogram = new Histogram(3);
+            Histogram expected = new Histogram(3);
+            histogram.recordValue(1000);
+            expected.recordValue(1000);
+            histogram.shiftValuesLeft(2);
+            expected.shiftValuesLeft(2);
+            long[] values = { 0, 1, 4000, 1L << 40, 17, 1L << 20 };
+            histogram.recordValues(values, 0, values.length);
+            for (long value : values) {
+                expected.recordValue(value);
+            }
+            Assert.assertEquals(expected, histogram);
+            Assert.assertEquals(expected.getMaxValue(), histogram.getMaxValue());
+            Assert.assertEquals(expected.getMinNonZeroValue(), histogram.getMinNonZeroValue());
+    }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            ConcurrentHistogram.class,
+            AtomicHistogram.class,
+            SynchronizedHistogram.class,
+            IntCountsHistogram.class,
+            ShortCountsHistogram.class,
+    })
+    public void testAddAndSubtractWithNormalizingIndexOffset(Class histoClass) {
+            AbstractHistogram histogram = constructHistogram(histoClass, highestTrackableValue, numberOfSignificantValueDigits);
+            AbstractHistogram other = constructHistogram(histoClass, highestTrackableValue, numberOfSignificantValueDigits);
+            histogram.recordValue(10000);
+            histogram.recordValueWithCount(20000, 3);
+            histogram.recordValue(10000000);
+            other.recordValueWithCount(20000, 2);
+            other.recordValue(10000000);
+
+            // Shifting both by the same amount leaves them with identical (non-zero) normalizing index offsets:
+            histogram.shiftValuesLeft(2);
+            other.shiftValuesLeft(2);
+
+            histogram.subtract(other);
+            Assert.assertEquals(1L, histogram.getCountAtValue(40000));
+            Assert.assertEquals(1L, histogram.getCountAtValue(80000));
+            Assert.assertEquals(0L, histogram.getCountAtValue(40000000));
+            Assert.assertEquals(2L, histogram.getTotalCount());
+            Assert.assertEquals(histogram.highestEquivalentValue(80000), histogram.getMaxValue());
+            Assert.assertEquals(histogram.lowestEquivalentValue(40000), histogram.getMinNonZeroValue());
+
+            histogram.add(other);
+            Assert.assertEquals(3L, histogram.getCountAtValue(80000));
+            Assert.assertEquals(1L, histogram.getCountAtValue(40000000));
+            Assert.assertEquals(5L, histogram.getTotalCount());
+            Assert.assertEquals(histogram.highestEquivalentValue(40000000), histogram.getMaxValue());
+            Assert.assertEquals(histogram.lowestEquivalentValue(40000), histogram.getMinNonZeroValue());
+
+            verifyMaxValue(histogram);
+    }
+
+    @ParameterizedTest
+    @ValueSource(classes = {
+            Histogram.class,
+            ConcurrentHistogram.class,
+            AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
+            SynchronizedHistogram.class,
+            PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
+            PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -740,9 +1095,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -774,9 +1133,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -814,9 +1177,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -847,9 +1214,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -874,9 +1245,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -895,9 +1270,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -916,9 +1295,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -945,9 +1328,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -974,9 +1361,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -1001,9 +1392,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -1028,9 +1423,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -1135,6 +1534,49 @@ public class HistogramTest {
         }
     }
 
+    @Test
+    public void testPackedQueriesMatchDenseQueries() {
+        Histogram histogram = new Histogram(highestTrackableValue, 3);
+        PackedHistogram packedHistogram = new PackedHistogram(highestTrackableValue, 3);
+        // A sparse population, with a long tail:
+        for (long value = 1; value < highestTrackableValue; value *= 7) {
+            histogram.recordValueWithCount(value, 1 + (value % 5));
+            packedHistogram.recordValueWithCount(value, 1 + (value % 5));
+        }
+        histogram.recordValueWithCount(0, 3);
+        packedHistogram.recordValueWithCount(0, 3);
+
+        double[] percentiles = {0.0, 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 100.0};
+        long[] values = new long[percentiles.length];
+        long[] packedValues = new long[percentiles.length];
+        histogram.getValuesAtPercentiles(percentiles, values);
+        packedHistogram.getValuesAtPercentiles(percentiles, packedValues);
+        for (int i = 0; i < percentiles.length; i++) {
+            assertEquals(histogram.getValueAtPercentile(percentiles[i]),
+                    packedHistogram.getValueAtPercentile(percentiles[i]));
+            assertEquals(values[i], packedValues[i]);
+        }
+        for (long value = 1; value < highestTrackableValue; value *= 3) {
+            assertEquals(histogram.getPercentileAtOrBelowValue(value),
+                    packedHistogram.getPercentileAtOrBelowValue(value), 0.0);
+            assertEquals(histogram.getCountBetweenValues(value / 2, value * 5),
+                    packedHistogram.getCountBetweenValues(value / 2, value * 5));
+        }
+        assertEquals(histogram.getMean(), packedHistogram.getMean(), histogram.getMean() * 1e-12);
+        assertEquals(histogram.getStdDeviation(), packedHistogram.getStdDeviation(),
+                histogram.getStdDeviation() * 1e-12);
+
+        Histogram sum = new Histogram(highestTrackableValue, 3);
+        sum.add(packedHistogram);
+        sum.add(packedHistogram);
+        Histogram expectedSum = new Histogram(highestTrackableValue, 3);
+        expectedSum.add(histogram);
+        expectedSum.add(histogram);
+        assertEquals(expectedSum, sum);
+        assertEquals(histogram.getTotalCount() * 2, sum.getTotalCount());
+        assertEquals(histogram.getMaxValue(), sum.getMaxValue());
+    }
+
     @ParameterizedTest
     @CsvSource({
             "Histogram, 3",
@@ -1202,9 +1644,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -1222,9 +1668,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -1244,9 +1694,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -1274,9 +1728,13 @@ public class HistogramTest {
             Histogram.class,
             ConcurrentHistogram.class,
             AtomicHistogram.class,
+            StripedConcurrentHistogram.class,
             SynchronizedHistogram.class,
             PackedHistogram.class,
+            PagedHistogram.class,
+            DirectHistogram.class,
             PackedConcurrentHistogram.class,
+            DirectConcurrentHistogram.class,
             IntCountsHistogram.class,
             ShortCountsHistogram.class,
     })
@@ -1,5 +1,7 @@
 package org.HdrHistogram;
 
+import org.junit.Assert;
+
 import java.lang.reflect.InvocationTargetException;
 import java.lang.reflect.Method;
 import java.nio.ByteBuffer;
@@ -102,4 +104,22 @@ public class HistogramTestUtils {
             throw new RuntimeException("Re-throwing: ", ex);
         }
     }
+
+    /**
+     * Assert that a histogram whose counts were written directly (rather than recorded) has re-established
+     * tracking values that bound its non-zero counts, and that they match those of the reference.
+     */
+    static void assertPopulatedSpanBoundsCounts(final AbstractHistogram reference,
+                                                final AbstractHistogram histogram) {
+        Assert.assertEquals(reference.getMinNonZeroValue(), histogram.getMinNonZeroValue());
+        Assert.assertEquals(reference.getMaxValue(), histogram.getMaxValue());
+        final int lowestPopulatedIndex = histogram.getLowestPopulatedIndex();
+        final int highestPopulatedIndex = histogram.getHighestPopulatedIndex();
+        for (int i = 0; i < histogram.countsArrayLength; i++) {
+            if ((i < lowestPopulatedIndex) || (i > highestPopulatedIndex)) {
+                Assert.assertEquals("count at index " + i + " is outside of the populated span",
+                        0, histogram.getCountAtIndex(i));
+            }
+        }
+    }
 }
@@ -17,6 +17,11 @@ import org.junit.jupiter.api.function.Executable;
 import org.junit.jupiter.params.ParameterizedTest;
 import org.junit.jupiter.params.provider.ValueSource;
 
+import java.nio.ByteBuffer;
+import java.util.Map;
+
+import static org.HdrHistogram.HistogramTestUtils.assertPopulatedSpanBoundsCounts;
+
 /**
  * JUnit test for {@link Histogram}
  */
@@ -145,6 +150,301 @@ public class RecorderTest {
         Assert.assertEquals(arraysAreEqual, true);
     }
 
+    @Test
+    public void testStripedIntervalRecording() throws Exception {
+        final Recorder recorder = new Recorder(1, highestTrackableValue, 3, 4);
+        Histogram histogram = new Histogram(highestTrackableValue, 3);
+        for (int i = 0; i < 1000; i++) {
+            histogram.recordValueWithCount(3000 * i, 4);
+        }
+
+        Thread[] recordingThreads = new Thread[4];
+        for (int t = 0; t < recordingThreads.length; t++) {
+            recordingThreads[t] = new Thread() {
+                @Override
+                public void run() {
+                    for (int i = 0; i < 1000; i++) {
+                        recorder.recordValue(3000 * i);
+                    }
+                }
+            };
+            recordingThreads[t].start();
+        }
+        for (Thread thread : recordingThreads) {
+            thread.join();
+        }
+
+        Histogram intervalHistogram = recorder.getIntervalHistogram();
+        Assert.assertFalse(intervalHistogram instanceof StripedConcurrentHistogram);
+        Assert.assertEquals(histogram, intervalHistogram);
+        Assert.assertEquals(4000, intervalHistogram.getTotalCount());
+
+        recorder.recordValue(17);
+        intervalHistogram = recorder.getIntervalHistogram(intervalHistogram);
+        Assert.assertEquals(1, intervalHistogram.getTotalCount());
+        Assert.assertEquals(1, intervalHistogram.getCountAtValue(17));
+
+        final Histogram histogramFromOtherRecorder = new Recorder(1, highestTrackableValue, 3, 4).getIntervalHistogram();
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.getIntervalHistogram(histogramFromOtherRecorder);
+                    }
+                });
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.getIntervalHistogram(new Histogram(highestTrackableValue, 3));
+                    }
+                });
+    }
+
+    @Test
+    public void testBulkRecording() throws Exception {
+        long[] values = new long[1000];
+        double[] doubleValues = new double[1000];
+        for (int i = 0; i < values.length; i++) {
+            values[i] = i * 1000L;
+            doubleValues[i] = i * 0.5;
+        }
+        Histogram expected = new Histogram(highestTrackableValue, 3);
+        DoubleHistogram expectedDouble = new DoubleHistogram(highestTrackableValue, 3);
+        for (int i = 0; i < values.length; i++) {
+            expected.recordValue(values[i]);
+            expectedDouble.recordValue(doubleValues[i]);
+        }
+
+        Recorder recorder = new Recorder(highestTrackableValue, 3);
+        SingleWriterRecorder singleWriterRecorder =
+                new SingleWriterRecorder(highestTrackableValue, 3);
+        recorder.recordValues(values, 0, 500);
+        recorder.recordValues(java.nio.LongBuffer.wrap(values, 500, 500));
+        singleWriterRecorder.recordValues(values, 0, values.length);
+        Assert.assertEquals(expected, recorder.getIntervalHistogram());
+        Assert.assertEquals(expected, singleWriterRecorder.getIntervalHistogram());
+
+        DoubleRecorder doubleRecorder = new DoubleRecorder(highestTrackableValue, 3);
+        SingleWriterDoubleRecorder singleWriterDoubleRecorder =
+                new SingleWriterDoubleRecorder(highestTrackableValue, 3);
+        doubleRecorder.recordValues(doubleValues, 0, 500);
+        doubleRecorder.recordValues(java.nio.DoubleBuffer.wrap(doubleValues, 500, 500));
+        singleWriterDoubleRecorder.recordValues(doubleValues, 0, doubleValues.length);
+        Assert.assertEquals(expectedDouble, doubleRecorder.getIntervalHistogram());
+        Assert.assertEquals(expectedDouble, singleWriterDoubleRecorder.getIntervalHistogram());
+    }
+
+    @ParameterizedTest
+    @ValueSource(booleans = {false, true})
+    public void testWriteCombiningRecording(final boolean usePacked) throws Exception {
+        final Recorder recorder = new Recorder(3, usePacked, 64);
+        final int threadCount = 4;
+        final int valuesPerThread = 10000 + 17; // Leave partially filled buffers behind
+        Thread[] threads = new Thread[threadCount];
+        for (int t = 0; t < threadCount; t++) {
+            final long threadValueBase = (t + 1) * 1000L;
+            threads[t] = new Thread(new Runnable() {
+                @Override
+                public void run() {
+                    for (int i = 0; i < valuesPerThread; i++) {
+                        recorder.recordValue(threadValueBase + (i % 100));
+                    }
+                }
+            });
+            threads[t].start();
+        }
+        for (Thread thread : threads) {
+            thread.join();
+        }
+
+        Histogram expected = new Histogram(3);
+        for (int t = 0; t < threadCount; t++) {
+            for (int i = 0; i < valuesPerThread; i++) {
+                expected.recordValue((t + 1) * 1000L + (i % 100));
+            }
+        }
+        Histogram intervalHistogram = recorder.getIntervalHistogram();
+        Assert.assertEquals(expected, intervalHistogram);
+
+        // Values buffered by a live thread are drained into the next interval:
+        recorder.recordValue(5);
+        recorder.recordValue(7);
+        intervalHistogram = recorder.getIntervalHistogram(intervalHistogram);
+        Assert.assertEquals(2, intervalHistogram.getTotalCount());
+        Assert.assertEquals(1, intervalHistogram.getCountAtValue(7));
+
+        recorder.recordValue(9);
+        recorder.reset();
+        Assert.assertEquals(0, recorder.getIntervalHistogram().getTotalCount());
+
+        Assertions.assertThrows(ArrayIndexOutOfBoundsException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.recordValue(-1);
+                    }
+                });
+    }
+
+    @Test
+    public void testIntervalHistogramPool() throws Exception {
+        final Recorder recorder = new Recorder(highestTrackableValue, 3);
+        recorder.recordValue(1);
+        final Histogram firstHistogram = recorder.getIntervalHistogram();
+        Assert.assertTrue(recorder.releaseIntervalHistogram(firstHistogram));
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(firstHistogram);
+                    }
+                });
+
+        // The released histogram becomes the next active histogram, and is handed back one interval later:
+        recorder.recordValue(2);
+        Histogram secondHistogram = recorder.getIntervalHistogram();
+        Assert.assertNotSame(firstHistogram, secondHistogram);
+        Assert.assertEquals(1, secondHistogram.getCountAtValue(2));
+        Assert.assertTrue(recorder.releaseIntervalHistogram(secondHistogram));
+        recorder.recordValue(3);
+        Histogram thirdHistogram = recorder.getIntervalHistogram();
+        Assert.assertSame(firstHistogram, thirdHistogram);
+        Assert.assertEquals(1, thirdHistogram.getTotalCount());
+        Assert.assertEquals(1, thirdHistogram.getCountAtValue(3));
+
+        recorder.setIntervalHistogramPoolCapacity(0);
+        Assert.assertEquals(0, recorder.getIntervalHistogramPoolCapacity());
+        Assert.assertFalse(recorder.releaseIntervalHistogram(thirdHistogram));
+        Assert.assertFalse(recorder.releaseIntervalHistogram(null));
+
+        final Histogram histogramFromOtherRecorder = new Recorder(highestTrackableValue, 3).getIntervalHistogram();
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(histogramFromOtherRecorder);
+                    }
+                });
+    }
+
+    @Test
+    public void testSingleWriterIntervalHistogramPool() throws Exception {
+        final SingleWriterRecorder recorder = new SingleWriterRecorder(highestTrackableValue, 3);
+        recorder.recordValue(1);
+        final Histogram firstHistogram = recorder.getIntervalHistogram();
+        Assert.assertTrue(recorder.releaseIntervalHistogram(firstHistogram));
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(firstHistogram);
+                    }
+                });
+
+        recorder.recordValue(2);
+        Histogram secondHistogram = recorder.getIntervalHistogram();
+        Assert.assertTrue(recorder.releaseIntervalHistogram(secondHistogram));
+        recorder.recordValue(3);
+        Histogram thirdHistogram = recorder.getIntervalHistogram();
+        Assert.assertSame(firstHistogram, thirdHistogram);
+        Assert.assertEquals(1, thirdHistogram.getTotalCount());
+        Assert.assertEquals(1, thirdHistogram.getCountAtValue(3));
+
+        recorder.setIntervalHistogramPoolCapacity(0);
+        Assert.assertEquals(0, recorder.getIntervalHistogramPoolCapacity());
+        Assert.assertFalse(recorder.releaseIntervalHistogram(thirdHistogram));
+        Assert.assertFalse(recorder.releaseIntervalHistogram(null));
+
+        final Histogram histogramFromOtherRecorder =
+                new SingleWriterRecorder(highestTrackableValue, 3).getIntervalHistogram();
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(histogramFromOtherRecorder);
+                    }
+                });
+    }
+
+    @Test
+    public void testDoubleIntervalHistogramPool() throws Exception {
+        final DoubleRecorder recorder = new DoubleRecorder(highestTrackableValue, 3);
+        recorder.recordValue(1.0);
+        final DoubleHistogram firstHistogram = recorder.getIntervalHistogram();
+        Assert.assertTrue(recorder.releaseIntervalHistogram(firstHistogram));
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(firstHistogram);
+                    }
+                });
+
+        recorder.recordValue(2.0);
+        DoubleHistogram secondHistogram = recorder.getIntervalHistogram();
+        Assert.assertTrue(recorder.releaseIntervalHistogram(secondHistogram));
+        recorder.recordValue(3.0);
+        DoubleHistogram thirdHistogram = recorder.getIntervalHistogram();
+        Assert.assertSame(firstHistogram, thirdHistogram);
+        Assert.assertEquals(1, thirdHistogram.getTotalCount());
+        Assert.assertEquals(1, thirdHistogram.getCountAtValue(3.0));
+
+        recorder.setIntervalHistogramPoolCapacity(0);
+        Assert.assertEquals(0, recorder.getIntervalHistogramPoolCapacity());
+        Assert.assertFalse(recorder.releaseIntervalHistogram(thirdHistogram));
+        Assert.assertFalse(recorder.releaseIntervalHistogram(null));
+
+        final DoubleHistogram histogramFromOtherRecorder =
+                new DoubleRecorder(highestTrackableValue, 3).getIntervalHistogram();
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(histogramFromOtherRecorder);
+                    }
+                });
+    }
+
+    @Test
+    public void testSingleWriterDoubleIntervalHistogramPool() throws Exception {
+        final SingleWriterDoubleRecorder recorder = new SingleWriterDoubleRecorder(highestTrackableValue, 3);
+        recorder.recordValue(1.0);
+        final DoubleHistogram firstHistogram = recorder.getIntervalHistogram();
+        Assert.assertTrue(recorder.releaseIntervalHistogram(firstHistogram));
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(firstHistogram);
+                    }
+                });
+
+        recorder.recordValue(2.0);
+        DoubleHistogram secondHistogram = recorder.getIntervalHistogram();
+        Assert.assertTrue(recorder.releaseIntervalHistogram(secondHistogram));
+        recorder.recordValue(3.0);
+        DoubleHistogram thirdHistogram = recorder.getIntervalHistogram();
+        Assert.assertSame(firstHistogram, thirdHistogram);
+        Assert.assertEquals(1, thirdHistogram.getTotalCount());
+        Assert.assertEquals(1, thirdHistogram.getCountAtValue(3.0));
+
+        recorder.setIntervalHistogramPoolCapacity(0);
+        Assert.assertEquals(0, recorder.getIntervalHistogramPoolCapacity());
+        Assert.assertFalse(recorder.releaseIntervalHistogram(thirdHistogram));
+        Assert.assertFalse(recorder.releaseIntervalHistogram(null));
+
+        final DoubleHistogram histogramFromOtherRecorder =
+                new SingleWriterDoubleRecorder(highestTrackableValue, 3).getIntervalHistogram();
+        Assertions.assertThrows(IllegalArgumentException.class,
+                new Executable() {
+                    @Override
+                    public void execute() throws Throwable {
+                        recorder.releaseIntervalHistogram(histogramFromOtherRecorder);
+                    }
+                });
+    }
+
     @ParameterizedTest
     @ValueSource(booleans = {false, true})
     public void testSimpleAutosizingRecorder(boolean usePacked) throws Exception {
@@ -396,4 +696,183 @@ public class RecorderTest {
         DoubleHistogram histToRecycle = recorder1.getIntervalHistogram();
         DoubleHistogram histToRecycle2 = recorder2.getIntervalHistogram(histToRecycle, false);
     }
+
+    @Test
+    public void testHistogramRegistry() throws Exception {
+        final HistogramRegistry<String> registry = new HistogramRegistry<>(2, 1, highestTrackableValue, 3);
+        final HistogramRegistry<String>.Handle handleA = registry.handleFor("A");
+        Assert.assertSame(handleA, registry.handleFor("A"));
+
+        Histogram referenceA = new Histogram(highestTrackableValue, 3);
+        Histogram referenceB = new Histogram(highestTrackableValue, 3);
+        for (int i = 0; i < 1000; i++) {
+            handleA.recordValue(i * 10);
+            referenceA.recordValue(i * 10);
+            registry.handleFor("B").recordValueWithExpectedInterval(3000 + i, 1000);
+            referenceB.recordValueWithExpectedInterval(3000 + i, 1000);
+        }
+        // Values beyond the range must not bleed into a neighbouring key's counts:
+        try {
+            handleA.recordValue(highestTrackableValue * 4);
+            Assert.fail("Expected an ArrayIndexOutOfBoundsException");
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        try {
+            registry.handleFor("C");
+            Assert.fail("Expected an IllegalStateException");
+        } catch (IllegalStateException expected) {
+        }
+
+        Map<String, Histogram> intervalHistograms = registry.getIntervalHistograms();
+        Assert.assertEquals(2, intervalHistograms.size());
+        Assert.assertEquals(referenceA, intervalHistograms.get("A"));
+        Assert.assertEquals(referenceB, intervalHistograms.get("B"));
+        assertPopulatedSpanBoundsCounts(referenceA, intervalHistograms.get("A"));
+        assertPopulatedSpanBoundsCounts(referenceB, intervalHistograms.get("B"));
+
+        // Interval histograms only contain counts recorded since the previous interval:
+        handleA.recordValue(42);
+        intervalHistograms = registry.getIntervalHistograms();
+        Assert.assertEquals(1, intervalHistograms.get("A").getTotalCount());
+        Assert.assertEquals(42, intervalHistograms.get("A").getMaxValue());
+        Assert.assertEquals(0, intervalHistograms.get("B").getTotalCount());
+    }
+
+    @Test
+    public void testHistogramRegistrySegments() throws Exception {
+        // Slab segments are only allocated for registered keys, so a large capacity costs nothing up front:
+        final HistogramRegistry<Integer> registry = new HistogramRegistry<>(1000000, 1, highestTrackableValue, 3);
+        final int keyCount = 200; // Enough keys to span several segments
+        final Histogram[] references = new Histogram[keyCount];
+        for (int key = 0; key < keyCount; key++) {
+            references[key] = new Histogram(highestTrackableValue, 3);
+            for (int i = 0; i <= key; i++) {
+                registry.handleFor(key).recordValue(1000L * (key + i));
+                references[key].recordValue(1000L * (key + i));
+            }
+        }
+        Assert.assertEquals(keyCount, registry.getKeyCount());
+        final Map<Integer, Histogram> intervalHistograms = registry.getIntervalHistograms();
+        for (int key = 0; key < keyCount; key++) {
+            Assert.assertEquals(references[key], intervalHistograms.get(key));
+            assertPopulatedSpanBoundsCounts(references[key], intervalHistograms.get(key));
+        }
+    }
+
+    @Test
+    public void testSharedHistogramPublishing() throws Exception {
+        ByteBuffer region = ByteBuffer.allocateDirect(
+                SharedHistogramPublisher.getNeededRegionCapacity(1, highestTrackableValue, 3));
+        SharedHistogramPublisher publisher = new SharedHistogramPublisher(region, 1, highestTrackableValue, 3);
+        SharedHistogramReader reader = new SharedHistogramReader(region);
+        Assert.assertEquals(0, reader.getHistogram().getTotalCount());
+
+        Recorder recorder = new Recorder(highestTrackableValue, 3);
+        Histogram referenceHistogram = new Histogram(highestTrackableValue, 3);
+        for (int i = 0; i < 10000; i++) {
+            recorder.recordValue(3000 * i);
+            referenceHistogram.recordValue(3000 * i);
+        }
+        long sequenceBeforePublishing = reader.getPublishedSequence();
+        publisher.publishIntervalHistogram(recorder);
+        Assert.assertEquals(sequenceBeforePublishing + 2, reader.getPublishedSequence());
+
+        Histogram publishedHistogram = reader.getHistogram();
+        Assert.assertEquals(referenceHistogram, publishedHistogram);
+        assertPopulatedSpanBoundsCounts(referenceHistogram, publishedHistogram);
+        Assert.assertTrue(publishedHistogram.getEndTimeStamp() >= publishedHistogram.getStartTimeStamp());
+
+        // Each publication replaces the previous one:
+        recorder.recordValue(42);
+        publisher.publishIntervalHistogram(recorder);
+        publishedHistogram = reader.getHistogram(publishedHistogram);
+        Assert.assertEquals(1, publishedHistogram.getTotalCount());
+        Assert.assertEquals(42, publishedHistogram.getMaxValue());
+        // Reading into a previously populated histogram must not leave counts outside the new populated span:
+        referenceHistogram.reset();
+        referenceHistogram.recordValue(42);
+        assertPopulatedSpanBoundsCounts(referenceHistogram, publishedHistogram);
+
+        // Counts of a previous publication are cleared also when they are below the next publication's span:
+        recorder.recordValue(1000000);
+        publisher.publishIntervalHistogram(recorder);
+        publishedHistogram = reader.getHistogram(publishedHistogram);
+        referenceHistogram.reset();
+        referenceHistogram.recordValue(1000000);
+        Assert.assertEquals(referenceHistogram, publishedHistogram);
+        assertPopulatedSpanBoundsCounts(referenceHistogram, publishedHistogram);
+
+        // Histograms of non-matching configurations are rejected:
+        try {
+            publisher.publish(new Histogram(1, highestTrackableValue, 2));
+            Assert.fail("Expected an IllegalArgumentException");
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
+    @Test
+    public void testSlidingWindowHistogram() throws Exception {
+        final int slotCount = 4;
+        SlidingWindowHistogram slidingWindow = new SlidingWindowHistogram(slotCount, highestTrackableValue, 3);
+        Histogram[] intervals = new Histogram[10];
+        for (int interval = 0; interval < intervals.length; interval++) {
+            intervals[interval] = new Histogram(highestTrackableValue, 3);
+            for (int i = 0; i < 1000; i++) {
+                // Each interval covers a different value range, so expiring slots move the window's min and max:
+                long value = (interval * 100000L) + (i * (interval + 1));
+                slidingWindow.recordValue(value);
+                intervals[interval].recordValue(value);
+            }
+            Histogram expectedWindow = new Histogram(highestTrackableValue, 3);
+            for (int i = Math.max(0, interval - slotCount + 1); i <= interval; i++) {
+                expectedWindow.add(intervals[i]);
+            }
+            Histogram window = slidingWindow.getWindowHistogram();
+            Assert.assertEquals(expectedWindow, window);
+            Assert.assertEquals(expectedWindow.getMinNonZeroValue(), window.getMinNonZeroValue());
+            Assert.assertEquals(expectedWindow.getValueAtPercentile(99.0), window.getValueAtPercentile(99.0));
+            slidingWindow.advance();
+        }
+    }
+
+    @Test
+    public void testSlidingWindowRecorder() throws Exception {
+        SlidingWindowRecorder recorder = new SlidingWindowRecorder(2, 3);
+        recorder.recordValue(10);
+        Assert.assertEquals(0, recorder.getTotalCount());
+        recorder.advance();
+        recorder.recordValue(20);
+        recorder.recordValue(30);
+        recorder.advance();
+        Assert.assertEquals(3, recorder.getTotalCount());
+        Histogram windowHistogram = recorder.getWindowHistogram();
+        Assert.assertEquals(10, windowHistogram.getMinNonZeroValue());
+        recorder.advance();
+        windowHistogram = recorder.getWindowHistogram(windowHistogram);
+        Assert.assertEquals(2, windowHistogram.getTotalCount());
+        Assert.assertEquals(20, windowHistogram.getMinNonZeroValue());
+        Assert.assertEquals(30, recorder.getValueAtPercentile(100.0));
+        Assert.assertEquals(2, recorder.getSlotCount());
+    }
+
+    @Test
+    public void testSlidingWindowRecorderTimeStamps() throws Exception {
+        SlidingWindowRecorder recorder = new SlidingWindowRecorder(2, 3);
+        recorder.recordValue(10);
+        long firstIntervalEnd = System.currentTimeMillis();
+        Thread.sleep(5);
+        recorder.advance();
+        recorder.recordValue(20);
+        recorder.advance();
+        // The window covers the two completed intervals, and starts where the first of them did:
+        Histogram windowHistogram = recorder.getWindowHistogram();
+        Assert.assertEquals(2, windowHistogram.getTotalCount());
+        Assert.assertTrue(windowHistogram.getStartTimeStamp() <= firstIntervalEnd);
+        recorder.advance();
+        // Once the first interval has expired, the window starts no earlier than where the second one did:
+        windowHistogram = recorder.getWindowHistogram(windowHistogram);
+        Assert.assertEquals(1, windowHistogram.getTotalCount());
+        Assert.assertEquals(20, windowHistogram.getMinNonZeroValue());
+        Assert.assertTrue(windowHistogram.getStartTimeStamp() > firstIntervalEnd);
+    }
 }